@@ -26,13 +26,383 @@
 static CS_NOINLINE void auxchprint(CSOUND *, INSDS *);
 static CS_NOINLINE void fdchprint(CSOUND *, INSDS *);
 
+/* Aux spaces of AUX_POOLMIN bytes or more come from size class pools
+   shared by the whole engine, so that a delay line freed by one
+   instrument is reused by the next.  A pooled block remembers how
+   much of it may have been written ("dirty"), and only that much is
+   cleared when it is handed out again; a new block is zero already.
+   Unless the opcode using a space reports how far it has written it
+   with csoundAuxTouched(), all of the size handed out counts as
+   written, and reuse clears as much as a plain memset() would.
+   With --aux-zero-async=N, blocks of N KiB or more are cleared by a
+   thread of their own when released, and an instance that
+   reinitialises such a space swaps it for a clean one.
+   The space of a pooled block is an ordinary memalloc allocation,
+   tagged CS_MEM_AUX; the pool keeps what it knows of it in a table
+   keyed by address, and mfree() and mrealloc() drop a block from
+   the table, so that a plugin may still free or resize its space. */
+
+#define AUX_POOLMIN   ((size_t) 16384)
+#define AUX_MINSHIFT  12                /* log2(AUX_POOLMIN) - 2        */
+#define AUX_NCLASS    112
+
+typedef struct auxBlock_s {
+    struct auxBlock_s *nxt;             /* free list or clearing queue  */
+    void    *data;                      /* the space                    */
+    size_t  cap;                        /* usable bytes                 */
+    size_t  dirty;                      /* bytes its user may have written */
+    size_t  stale;                      /* and bytes left from before   */
+    int32_t cls;
+    int32_t reported;                   /* dirty set by csoundAuxTouched */
+} auxBlock_t;
+
+typedef struct {
+    spin_lock_t lock;
+    auxBlock_t  *freel[AUX_NCLASS];
+    auxBlock_t  *zq;                    /* blocks to be cleared         */
+    auxBlock_t  **blocks;               /* every block, by address      */
+    size_t      nblocks, blockcap;
+    size_t      zmin;                   /* size cleared by the thread   */
+    void        *zthread, *zready;
+    volatile int zstop;
+} auxPool_t;
+
+/* classes step by a quarter octave: (4..7) << e */
+
+/* bytes of the block that may not be zero */
+
+static inline size_t aux_dirty(auxBlock_t *b)
+{
+    return (b->dirty > b->stale ? b->dirty : b->stale);
+}
+
+/* clears what a new user of nbytes needs cleared, and makes it b's user */
+
+static void aux_reuse(auxBlock_t *b, size_t nbytes)
+{
+    size_t  d = aux_dirty(b);
+
+    memset(b->data, 0, (nbytes < d ? nbytes : d));
+    b->stale = (d > nbytes ? d : 0);
+    b->dirty = nbytes;
+    b->reported = 0;
+}
+
+static int aux_class(size_t n, size_t *cap)
+{
+    int     e = AUX_MINSHIFT;
+    size_t  s;
+
+    while ((n - 1) >> (e + 3))
+      e++;
+    s = (n + ((size_t) 1 << e) - 1) >> e;       /* 4..8 */
+    if (s == 8)
+      s = 4, e++;
+    *cap = s << e;
+    return (e - AUX_MINSHIFT) * 4 + (int) (s - 4);
+}
+
+/* table of the pool's blocks, open addressed by data address */
+
+static inline size_t aux_hash(void *auxp, size_t mask)
+{
+    return (size_t) ((((uintptr_t) auxp >> 12) * 2654435761u) & mask);
+}
+
+/* called with the pool locked; the slot of auxp, or -1 */
+static long aux_slot(auxPool_t *pool, void *auxp)
+{
+    size_t  mask = pool->blockcap - 1, i;
+
+    if (pool->blockcap == 0)
+      return -1L;
+    for (i = aux_hash(auxp, mask); pool->blocks[i] != NULL;
+         i = (i + 1) & mask)
+      if (pool->blocks[i]->data == auxp)
+        return (long) i;
+    return -1L;
+}
+
+static auxBlock_t *aux_find(auxPool_t *pool, void *auxp)
+{
+    long    i = aux_slot(pool, auxp);
+    return (i < 0L ? NULL : pool->blocks[i]);
+}
+
+/* called with the pool locked; empties slot i, moving back the
+   entries after it that would no longer be found */
+static void aux_unrecord(auxPool_t *pool, size_t i)
+{
+    size_t  mask = pool->blockcap - 1, j = i, k;
+
+    pool->blocks[i] = NULL;
+    pool->nblocks--;
+    for (;;) {
+      j = (j + 1) & mask;
+      if (pool->blocks[j] == NULL)
+        return;
+      k = aux_hash(pool->blocks[j]->data, mask);
+      /* leave it if its home slot is cyclically in (i, j] */
+      if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+        continue;
+      pool->blocks[i] = pool->blocks[j];
+      pool->blocks[j] = NULL;
+      i = j;
+    }
+}
+
+/* called with the pool locked; returns 0 if out of memory */
+static int aux_record(auxPool_t *pool, auxBlock_t *b)
+{
+    size_t  mask, i;
+
+    if ((pool->nblocks + 1) * 2 > pool->blockcap) {
+      size_t      n = pool->blockcap ? pool->blockcap * 2 : 64, j;
+      auxBlock_t  **t = (auxBlock_t**) calloc(n, sizeof(auxBlock_t*));
+      if (UNLIKELY(t == NULL))
+        return 0;
+      for (j = 0; j < pool->blockcap; j++) {
+        if (pool->blocks[j] == NULL)
+          continue;
+        for (i = aux_hash(pool->blocks[j]->data, n - 1); t[i] != NULL;
+             i = (i + 1) & (n - 1))
+          ;
+        t[i] = pool->blocks[j];
+      }
+      free(pool->blocks);
+      pool->blocks = t;
+      pool->blockcap = n;
+    }
+    mask = pool->blockcap - 1;
+    for (i = aux_hash(b->data, mask); pool->blocks[i] != NULL;
+         i = (i + 1) & mask)
+      ;
+    pool->blocks[i] = b;
+    pool->nblocks++;
+    return 1;
+}
+
+static uintptr_t aux_zero_thread(void *p)
+{
+    CSOUND    *csound = (CSOUND*) p;
+    auxPool_t *pool = (auxPool_t*) csound->auxpool;
+    auxBlock_t *b;
+
+    for (;;) {
+      csoundSpinLock(&pool->lock);
+      if ((b = pool->zq) != NULL)
+        pool->zq = b->nxt;
+      csoundSpinUnLock(&pool->lock);
+      if (b == NULL) {
+        if (ATOMIC_GET(pool->zstop))
+          break;
+        csoundWaitThreadLockNoTimeout(pool->zready);
+        continue;
+      }
+      memset(b->data, 0, aux_dirty(b));
+      b->dirty = b->stale = 0;
+      csoundSpinLock(&pool->lock);
+      b->nxt = pool->freel[b->cls];
+      pool->freel[b->cls] = b;
+      csoundSpinUnLock(&pool->lock);
+    }
+    return 0;
+}
+
+static auxPool_t *aux_pool(CSOUND *csound)
+{
+    auxPool_t *pool = (auxPool_t*) csound->auxpool;
+
+    if (LIKELY(pool != NULL))
+      return pool;
+    csoundSpinLock(&csound->memlock);
+    if ((pool = (auxPool_t*) csound->auxpool) == NULL) {
+      pool = (auxPool_t*) calloc(1, sizeof(auxPool_t));
+      if (UNLIKELY(pool == NULL)) {
+        csoundSpinUnLock(&csound->memlock);
+        csound->Die(csound, Str("memory allocate failure for %zd"),
+                    sizeof(auxPool_t));
+      }
+      csoundSpinLockInit(&pool->lock);
+      csound->auxpool = pool;
+      if (csound->oparms->aux_zero_async > 0) {
+        pool->zmin = (size_t) csound->oparms->aux_zero_async << 10;
+        if (pool->zmin < AUX_POOLMIN)
+          pool->zmin = AUX_POOLMIN;
+        pool->zready = csoundCreateThreadLock();
+        csoundWaitThreadLockNoTimeout(pool->zready);
+        pool->zthread = csoundCreateThread(aux_zero_thread, csound);
+        if (UNLIKELY(pool->zthread == NULL)) {
+          csoundDestroyThreadLock(pool->zready);
+          pool->zready = NULL;
+        }
+      }
+    }
+    csoundSpinUnLock(&csound->memlock);
+    return pool;
+}
+
+/* nbytes of zeroed space */
+
+static void *aux_get(CSOUND *csound, size_t nbytes)
+{
+    auxPool_t   *pool;
+    auxBlock_t  *b;
+    size_t      cap;
+    int         cls;
+
+    if (nbytes < AUX_POOLMIN)
+      return mcalloc_tag(csound, nbytes, CS_MEM_AUX);
+    if (UNLIKELY((cls = aux_class(nbytes, &cap)) >= AUX_NCLASS))
+      return mcalloc_tag(csound, nbytes, CS_MEM_AUX);
+    pool = aux_pool(csound);
+    csoundSpinLock(&pool->lock);
+    if ((b = pool->freel[cls]) != NULL)
+      pool->freel[cls] = b->nxt;
+    csoundSpinUnLock(&pool->lock);
+    if (b == NULL) {
+      void  *data = mcalloc_tag(csound, cap, CS_MEM_AUX);
+      int   ok = 0;
+      if (LIKELY((b = (auxBlock_t*) calloc(1, sizeof(auxBlock_t))) != NULL)) {
+        b->data = data;
+        b->cap = cap;
+        b->cls = cls;
+        csoundSpinLock(&pool->lock);
+        ok = aux_record(pool, b);
+        csoundSpinUnLock(&pool->lock);
+      }
+      if (UNLIKELY(!ok)) {                      /* not pooled after all */
+        free(b);
+        return data;
+      }
+    }
+    aux_reuse(b, nbytes);
+    return b->data;
+}
+
+/* the pool's block for auxp, or NULL if it is not one */
+
+static auxBlock_t *aux_block(CSOUND *csound, void *auxp, size_t size)
+{
+    auxPool_t   *pool = (auxPool_t*) csound->auxpool;
+    auxBlock_t  *b;
+
+    if (size < AUX_POOLMIN || pool == NULL)
+      return NULL;
+    csoundSpinLock(&pool->lock);
+    b = aux_find(pool, auxp);
+    csoundSpinUnLock(&pool->lock);
+    return b;
+}
+
+/* return space from aux_get() */
+
+static void aux_put(CSOUND *csound, void *auxp, size_t size)
+{
+    auxPool_t   *pool = (auxPool_t*) csound->auxpool;
+    auxBlock_t  *b;
+
+    if (auxp == NULL)
+      return;
+    if ((b = aux_block(csound, auxp, size)) == NULL) {
+      csound->Free(csound, auxp);
+      return;
+    }
+    csoundSpinLock(&pool->lock);
+    if (pool->zthread != NULL && aux_dirty(b) >= pool->zmin) {
+      b->nxt = pool->zq;
+      pool->zq = b;
+      csoundSpinUnLock(&pool->lock);
+      csoundNotifyThreadLock(pool->zready);
+      return;
+    }
+    b->nxt = pool->freel[b->cls];
+    pool->freel[b->cls] = b;
+    csoundSpinUnLock(&pool->lock);
+}
+
+/* stops the clearing thread; the blocks go with the rest at memRESET */
+
+void auxRESET(CSOUND *csound)
+{
+    auxPool_t *pool = (auxPool_t*) csound->auxpool;
+
+    if (pool == NULL)
+      return;
+    if (pool->zthread != NULL) {
+      ATOMIC_SET(pool->zstop, 1);
+      csoundNotifyThreadLock(pool->zready);
+      csoundJoinThread(pool->zthread);
+      csoundDestroyThreadLock(pool->zready);
+    }
+    while (pool->blockcap > 0)
+      free(pool->blocks[--pool->blockcap]);
+    free(pool->blocks);
+    free(pool);
+    csound->auxpool = NULL;
+}
+
+/* called by mfree() and mrealloc() for CS_MEM_AUX spaces: the space
+   stops being the pool's */
+
+void auxForget(CSOUND *csound, void *auxp, size_t size)
+{
+    auxPool_t   *pool = (auxPool_t*) csound->auxpool;
+    auxBlock_t  *b = NULL;
+    long        i;
+
+    if (size < AUX_POOLMIN || pool == NULL)
+      return;
+    csoundSpinLock(&pool->lock);
+    if ((i = aux_slot(pool, auxp)) >= 0L) {
+      b = pool->blocks[i];
+      aux_unrecord(pool, (size_t) i);
+    }
+    csoundSpinUnLock(&pool->lock);
+    free(b);
+}
+
+/* the first nbytes of an aux space are all that has been written
+   since csoundAuxAlloc(); an opcode that says so once must say so
+   again whenever it writes further */
+
+void csoundAuxTouched(CSOUND *csound, AUXCH *auxchp, size_t nbytes)
+{
+    auxBlock_t  *b = aux_block(csound, auxchp->auxp, auxchp->size);
+
+    if (b == NULL)
+      return;
+    if (nbytes > auxchp->size)
+      nbytes = auxchp->size;
+    if (!b->reported || nbytes > b->dirty)
+      b->dirty = nbytes;
+    b->reported = 1;
+}
+
 /* allocate an auxds, or expand an old one */
 /*    call only from init (xxxset) modules */
 
 void csoundAuxAlloc(CSOUND *csound, size_t nbytes, AUXCH *auxchp)
 {
     if (auxchp->auxp != NULL) {
-      /* if allocd with same size, just clear to zero */
+      auxBlock_t  *b = aux_block(csound, auxchp->auxp, auxchp->size);
+      size_t      cap;
+      /* if allocd with same size, or same class, just clear to zero */
+      if (b != NULL && nbytes >= AUX_POOLMIN &&
+          aux_class(nbytes, &cap) == b->cls) {
+        auxPool_t *pool = (auxPool_t*) csound->auxpool;
+        if (pool->zthread != NULL && aux_dirty(b) >= pool->zmin) {
+          /* swap for a clean one, and have this one cleared */
+          void  *tmp = auxchp->auxp;
+          auxchp->auxp = aux_get(csound, nbytes);
+          aux_put(csound, tmp, auxchp->size);
+        }
+        else
+          aux_reuse(b, nbytes);
+        auxchp->size = nbytes;
+        auxchp->endp = (char*)auxchp->auxp + nbytes;
+        return;
+      }
       if (nbytes == (size_t)auxchp->size) {
         memset(auxchp->auxp, 0, nbytes);
         return;
@@ -41,7 +411,7 @@ void csoundAuxAlloc(CSOUND *csound, size_t nbytes, AUXCH *auxchp)
         void  *tmp = auxchp->auxp;
         /* if size change only, free the old space and re-allocate */
         auxchp->auxp = NULL;
-        csound->Free(csound, tmp);
+        aux_put(csound, tmp, auxchp->size);
       }
     }
     else {                                  /* else link in new auxch blk */
@@ -50,7 +420,7 @@ void csoundAuxAlloc(CSOUND *csound, size_t nbytes, AUXCH *auxchp)
     }
     /* now alloc the space and update the internal data */
     auxchp->size = nbytes;
-    auxchp->auxp = csound->Calloc(csound, nbytes);
+    auxchp->auxp = aux_get(csound, nbytes);
     auxchp->endp = (char*)auxchp->auxp + nbytes;
     if (UNLIKELY(csound->oparms->odebug))
       auxchprint(csound, csound->curip);
@@ -65,7 +435,7 @@ static uintptr_t alloc_thread(void *p) {
     if (pp->auxchp->auxp == NULL) {
       /* Allocate new memory */
       newm.size = pp->nbytes;
-      newm.auxp = csound->Calloc(csound, pp->nbytes);
+      newm.auxp = aux_get(csound, pp->nbytes);
       newm.endp = (char*) newm.auxp + pp->nbytes;
       ptr = (char *) newm.auxp;
       newm  = *(pp->notify(csound, pp->userData, &newm));
@@ -75,7 +445,7 @@ static uintptr_t alloc_thread(void *p) {
          never swapped back.
       */
       if (newm.auxp != NULL && newm.auxp != ptr)
-        csound->Free(csound, newm.auxp);
+        aux_put(csound, newm.auxp, newm.size);
     } else {
       csoundAuxAlloc(csound,pp->nbytes,pp->auxchp);
       pp->notify(csound, pp->userData, pp->auxchp);
@@ -153,9 +523,10 @@ void auxchfree(CSOUND *csound, INSDS *ip)
       auxchprint(csound, ip);
     while (LIKELY(ip->auxchp != NULL)) {        /* for all auxp's in chain: */
       void  *auxp = (void*) ip->auxchp->auxp;
+      size_t size = ip->auxchp->size;
       AUXCH *nxt = ip->auxchp->nxtchp;
       memset((void*) ip->auxchp, 0, sizeof(AUXCH)); /*  delete the pntr     */
-      csound->Free(csound, auxp);                   /*  & free the space    */
+      aux_put(csound, auxp, size);                  /*  & free the space    */
       ip->auxchp = nxt;
     }
     if (UNLIKELY(csound->oparms->odebug))
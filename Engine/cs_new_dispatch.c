@@ -39,9 +39,22 @@
 #include "cs_par_base.h"
 #include "cs_par_orc_semantics.h"
 
-#if defined(_MSC_VER)
-/* For InterlockedCompareExchange */
+#if defined(_MSC_VER) || defined(WIN32)
+/* For InterlockedCompareExchange and SwitchToThread */
 #include <windows.h>
+#elif defined(LINUX)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
+#include <sched.h>
+#endif
+#if defined(__i386__) || defined(__x86_64__) || \
+    defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#define CPU_RELAX() _mm_pause()
+#else
+#define CPU_RELAX()
 #endif
 
 /* Used as an error value */
@@ -75,6 +88,15 @@
 #define INIT_SIZE (100)
 //static int task_max_size;
 
+/* Dependencies of task j are a bitset over the earlier tasks 0..j-1 */
+#define DEP_BYTES(n)     (((n)+7)>>3)
+#define DEP_TEST(row,k)  ((row)[(k)>>3] & (1<<((k)&7)))
+#define DEP_SET(row,k)   ((row)[(k)>>3] |= (char)(1<<((k)&7)))
+
+/* Bounds for the adaptive spin before an idle thread blocks */
+#define SPIN_MIN  (64)
+#define SPIN_MAX  (8192)
+
 static void dag_print_state(CSOUND *csound)
 {
     int i;
@@ -106,7 +128,7 @@ static void dag_print_state(CSOUND *csound)
           char *tt = csound->dag_task_dep[i];
           int j;
           printf("status=WAITING for tasks [");
-          for (j=0; j<i; j++) if (tt[j]) printf("%d ", j);
+          for (j=0; j<i; j++) if (DEP_TEST(tt, j)) printf("%d ", j);
           printf("]\n");
         }
         break;
@@ -116,34 +138,238 @@ static void dag_print_state(CSOUND *csound)
     }
 }
 
-/* For now allocate a fixed maximum number of tasks; FIXME */
-static void create_dag(CSOUND *csound)
+static char **dag_alloc_dep(CSOUND *csound, int max, int bytes)
+{
+    char **rows = (char **)csound->Calloc(csound, sizeof(char*)*max);
+    char *blk = (char *)csound->Calloc(csound, (size_t)max*bytes);
+    int i;
+    for (i=0; i<max; i++) rows[i] = blk + (size_t)i*bytes;
+    return rows;
+}
+
+static void dag_free_dep(CSOUND *csound, char **rows)
+{
+    if (rows == NULL) return;
+    csound->Free(csound, rows[0]);
+    csound->Free(csound, rows);
+}
+
+/* (Re)allocate for dag_task_max_size tasks; previous edges are lost */
+static void dag_alloc(CSOUND *csound)
 {
-    /* Allocate the main task status and watchlists */
     int max = csound->dag_task_max_size;
-    csound->dag_task_status = csound->Calloc(csound, sizeof(stateWithPadding)*max);
+    int bytes = DEP_BYTES(max);
+    if (csound->dag_task_status != NULL) {
+      csound->Free(csound, (void *)csound->dag_task_status);
+      csound->Free(csound, (void *)csound->dag_task_watch);
+      csound->Free(csound, csound->dag_task_map);
+      csound->Free(csound, csound->dag_prev_map);
+      csound->Free(csound, csound->dag_wlmm);
+      csound->Free(csound, csound->dag_remap);
+      dag_free_dep(csound, csound->dag_task_dep);
+      dag_free_dep(csound, csound->dag_prev_dep);
+    }
+    csound->dag_task_status =
+      csound->Calloc(csound, sizeof(stateWithPadding)*max);
     csound->dag_task_watch  = csound->Calloc(csound, sizeof(watchList*)*max);
     csound->dag_task_map    = csound->Calloc(csound, sizeof(INSDS*)*max);
-    csound->dag_task_dep    = (char **)csound->Calloc(csound, sizeof(char*)*max);
-    csound->dag_wlmm = (watchList *)csound->Calloc(csound, sizeof(watchList)*max);
+    csound->dag_prev_map    = csound->Calloc(csound, sizeof(INSDS*)*max);
+    csound->dag_wlmm =
+      (watchList *)csound->Calloc(csound, sizeof(watchList)*max);
+    /* old->new, new->old and the list of new tasks */
+    csound->dag_remap = (int *)csound->Calloc(csound, 3*sizeof(int)*max);
+    csound->dag_task_dep = dag_alloc_dep(csound, max, bytes);
+    csound->dag_prev_dep = dag_alloc_dep(csound, max, bytes);
+    csound->dag_dep_bytes = bytes;
+    csound->dag_num_active = 0;
+}
+
+//#define ATOMIC_READ(x) __sync_fetch_and_or(&(x), 0)
+//#define ATOMIC_WRITE(x,v) __sync_fetch_and_and(&(x), v)
+#define ATOMIC_READ(x) x
+#define ATOMIC_WRITE(x,v) x = v;
+#if defined(_MSC_VER)
+#define ATOMIC_CAS(x,current,new) \
+  (current == InterlockedCompareExchange(x, new, current))
+#else
+#define ATOMIC_CAS(x,current,new)  __sync_bool_compare_and_swap(x,current,new)
+#endif
+
+#if defined(_MSC_VER)
+#define ATOMIC_CAS_PTR(x,current,new) \
+  (current == InterlockedCompareExchangePointer(x, new, current))
+#else
+#define ATOMIC_CAS_PTR(x,current,new)  __sync_bool_compare_and_swap(x,current,new)
+#endif
+
+/* Work-stealing deques (Chase and Lev).  Only the owning thread calls
+   deque_push and deque_pop; any thread may call deque_steal. */
+
+static inline void deque_push(taskDeque *d, taskID task)
+{
+    int b = d->bottom;
+    d->tasks[b] = task;
+    ATOMIC_STORE_REL(d->bottom, b + 1);
 }
 
-static void recreate_dag(CSOUND *csound)
+static inline taskID deque_pop(taskDeque *d)
 {
-    /* Allocate the main task status and watchlists */
-    int max = csound->dag_task_max_size;
-    csound->dag_task_status =
-      csound->ReAlloc(csound, (stateWithPadding *)csound->dag_task_status,
-               sizeof(stateWithPadding)*max);
-    csound->dag_task_watch  =
-      csound->ReAlloc(csound, (struct watchList *)csound->dag_task_watch,
-               sizeof(watchList*)*max);
-    csound->dag_task_map    =
-      csound->ReAlloc(csound, (INSDS *)csound->dag_task_map, sizeof(INSDS*)*max);
-    csound->dag_task_dep    =
-      (char **)csound->ReAlloc(csound, csound->dag_task_dep, sizeof(char*)*max);
-    csound->dag_wlmm        =
-      (watchList *)csound->ReAlloc(csound, csound->dag_wlmm, sizeof(watchList)*max);
+    int b = d->bottom - 1, t;
+    taskID task;
+    d->bottom = b;
+    ATOMIC_FENCE();
+    t = d->top;
+    if (t > b) {                /* empty */
+      d->bottom = b + 1;
+      return INVALID;
+    }
+    task = d->tasks[b];
+    if (t == b) {               /* last entry: race any thief for it */
+      if (!ATOMIC_CAS(&(d->top), t, t + 1)) task = INVALID;
+      d->bottom = b + 1;
+    }
+    return task;
+}
+
+/* Returns WAIT if it lost a race and the deque may still hold work */
+static inline taskID deque_steal(taskDeque *d)
+{
+    int t = ATOMIC_LOAD_ACQ(d->top), b;
+    taskID task;
+    ATOMIC_FENCE();
+    b = ATOMIC_LOAD_ACQ(d->bottom);
+    if (t >= b) return INVALID;
+    task = d->tasks[t];
+    if (!ATOMIC_CAS(&(d->top), t, t + 1)) return WAIT;
+    return task;
+}
+
+static inline int deque_empty(taskDeque *d)
+{
+    return ATOMIC_LOAD_ACQ(d->top) >= ATOMIC_LOAD_ACQ(d->bottom);
+}
+
+/* Idle threads spin for a while and then block on the wake_epoch word.
+   Anyone making work available bumps the epoch if there are sleepers. */
+static void dag_sched_park(dagScheduler *s, int epoch)
+{
+#if defined(LINUX)
+    syscall(SYS_futex, &(s->wake_epoch), FUTEX_WAIT_PRIVATE, epoch,
+            NULL, NULL, 0);
+#elif defined(WIN32)
+    IGN(s); IGN(epoch);
+    SwitchToThread();
+#else
+    IGN(s); IGN(epoch);
+    sched_yield();
+#endif
+}
+
+static inline void dag_sched_wake(dagScheduler *s, int all)
+{
+    ATOMIC_FENCE();             /* order the push against the read below */
+    if (ATOMIC_GET(s->sleepers) > 0) {
+      ATOMIC_INCR(s->wake_epoch);
+#if defined(LINUX)
+      syscall(SYS_futex, &(s->wake_epoch), FUTEX_WAKE_PRIVATE,
+              all ? INT_MAX : 1, NULL, NULL, 0);
+#else
+      IGN(all);
+#endif
+    }
+}
+
+static void dag_sched_create(CSOUND *csound)
+{
+    dagScheduler *s = csound->dag_sched;
+    int n = csound->oparms->numThreads, i;
+    if (n < 1) n = 1;
+    if (s == NULL) {
+      s = csound->dag_sched =
+        (dagScheduler *) csound->Calloc(csound, sizeof(dagScheduler));
+    }
+    if (s->num_deques != n) {
+      if (s->deques) csound->Free(csound, s->deques);
+      s->deques = (taskDeque *) csound->Calloc(csound, sizeof(taskDeque)*n);
+      s->num_deques = n;
+      s->capacity = 0;
+    }
+    if (s->capacity < csound->dag_task_max_size) {
+      s->capacity = csound->dag_task_max_size;
+      for (i=0; i<n; i++) {
+        s->deques[i].tasks =
+          csound->ReAlloc(csound, s->deques[i].tasks,
+                          sizeof(taskID)*s->capacity);
+        if (s->deques[i].spin == 0) s->deques[i].spin = SPIN_MIN;
+      }
+    }
+}
+
+/* Distribute the initially available tasks round-robin over the deques.
+   Called from the main thread before the workers are released. */
+static void dag_sched_seed(CSOUND *csound)
+{
+    dagScheduler *s;
+    int i, k = 0;
+    dag_sched_create(csound);
+    s = csound->dag_sched;
+    for (i=0; i<s->num_deques; i++) {
+      s->deques[i].top = s->deques[i].bottom = 0;
+      s->deques[i].executed = s->deques[i].stolen = s->deques[i].idle = 0;
+    }
+    for (i=0; i<csound->dag_num_active; i++) {
+      if (csound->dag_task_status[i].s == AVAILABLE) {
+        taskDeque *d = &(s->deques[k]);
+        d->tasks[d->bottom++] = i;
+        if (++k == s->num_deques) k = 0;
+      }
+    }
+    s->remaining = csound->dag_num_active;
+    s->sleepers = 0;
+    ATOMIC_FENCE();
+}
+
+/* Called by the main thread once all threads have passed the barrier */
+void dag_sched_collect(CSOUND *csound)
+{
+    dagScheduler *s = csound->dag_sched;
+    int i;
+    if (s == NULL) return;
+    s->executed = s->stolen = s->idle = 0;
+    for (i=0; i<s->num_deques; i++) {
+      s->executed += s->deques[i].executed;
+      s->stolen += s->deques[i].stolen;
+      s->idle += s->deques[i].idle;
+    }
+    s->total_executed += s->executed;
+    s->total_stolen += s->stolen;
+    s->total_idle += s->idle;
+    if (s->stolen > s->max_stolen) s->max_stolen = s->stolen;
+    if (s->idle > s->max_idle) s->max_idle = s->idle;
+    s->kcycles++;
+    if (UNLIKELY(csound->oparms->odebug))
+      csound->Message(csound,
+                      Str("kcycle %ld: %lu tasks executed, %lu stolen, "
+                          "%lu idle waits\n"),
+                      (long) csound->kcounter, s->executed, s->stolen, s->idle);
+}
+
+void dag_print_stats(CSOUND *csound)
+{
+    dagScheduler *s = csound->dag_sched;
+    if (s == NULL || s->kcycles == 0) return;
+    csound->Message(csound,
+                    Str("Multithread dispatch over %lu kcycles (%d threads):\n"
+                        "\ttasks executed %lu (%.2f per kcycle)\n"
+                        "\ttasks stolen %lu (%.2f per kcycle, max %lu)\n"
+                        "\tidle waits %lu (%.2f per kcycle, max %lu)\n"),
+                    s->kcycles, s->num_deques,
+                    s->total_executed,
+                    (double) s->total_executed / s->kcycles,
+                    s->total_stolen,
+                    (double) s->total_stolen / s->kcycles, s->max_stolen,
+                    s->total_idle,
+                    (double) s->total_idle / s->kcycles, s->max_idle);
 }
 
 static INSTR_SEMANTICS *dag_get_info(CSOUND* csound, int insno)
@@ -163,114 +389,210 @@ static INSTR_SEMANTICS *dag_get_info(CSOUND* csound, int insno)
     return current_instr;
 }
 
-static int dag_intersect(CSOUND *csound, struct set_t *current,
-                         struct set_t *later, int cnt)
+/* Non-allocating test for a common element */
+static int dag_meet(struct set_t *first, struct set_t *second)
 {
-    IGN(cnt);
-    struct set_t *ans;
-    int res = 0;
-    struct set_element_t *ele;
-    ans = csp_set_intersection(csound, current, later);
-    res = ans->count;
-    ele = ans->head;
-    while (ele != NULL) {
-      struct set_element_t *next = ele->next;
-      csound->Free(csound, ele);
-      ele = next; res++;
+    struct set_element_t *e1, *e2;
+    for (e1 = first->head; e1 != NULL; e1 = e1->next)
+      for (e2 = second->head; e2 != NULL; e2 = e2->next)
+        if (first->ele_eq_func(e1, e2)) return 1;
+    return 0;
+}
+
+/* Must an instance of later_insno wait for an earlier one of insno? */
+static int dag_depends(CSOUND *csound, int insno, int later_insno)
+{
+    INSTR_SEMANTICS *current_instr = dag_get_info(csound, insno);
+    INSTR_SEMANTICS *later_instr = dag_get_info(csound, later_insno);
+    //csp_set_print(csound, current_instr->read);
+    //csp_set_print(csound, current_instr->write);
+    return (dag_meet(current_instr->write, later_instr->read)       ||
+            dag_meet(current_instr->read_write, later_instr->read)  ||
+            dag_meet(current_instr->read, later_instr->write)       ||
+            dag_meet(current_instr->write, later_instr->write)      ||
+            dag_meet(current_instr->read_write, later_instr->write) ||
+            dag_meet(current_instr->read, later_instr->read_write)  ||
+            dag_meet(current_instr->write, later_instr->read_write));
+}
+
+/* Edges only depend on the pair of instrument numbers, so each pair is
+   classified once, in an open addressed table holding only the pairs
+   that have met: dep is 0 for an empty slot, 1 independent, 2
+   dependent.  The table is emptied whenever new instrument semantics
+   are compiled. */
+typedef struct {
+    int32_t insno, later_insno;
+    int32_t dep;
+} DAG_EDGE;
+
+typedef struct {
+    uint32_t  size, count;      /* size is a power of two */
+    DAG_EDGE  *slot;
+} DAG_EDGES;
+
+#define DAG_EDGES_INIT 256
+
+static inline uint32_t dag_edge_hash(int insno, int later_insno)
+{
+    uint64_t h = ((uint64_t) (uint32_t) insno << 32) | (uint32_t) later_insno;
+    h *= 0x9E3779B97F4A7C15ull;
+    return (uint32_t) (h >> 32);
+}
+
+/* Returns non-zero if the cache had to be reset. */
+static int dag_edge_check(CSOUND *csound)
+{
+    DAG_EDGES *e = (DAG_EDGES *) csound->dag_edge_cache;
+    if (e != NULL && csound->dag_edge_valid)
+      return 0;
+    if (e == NULL) {
+      e = (DAG_EDGES *) csound->Calloc(csound, sizeof(DAG_EDGES));
+      e->size = DAG_EDGES_INIT;
+      e->slot = (DAG_EDGE *) csound->Calloc(csound,
+                                            e->size * sizeof(DAG_EDGE));
+      csound->dag_edge_cache = e;
+    }
+    else {
+      memset(e->slot, 0, e->size * sizeof(DAG_EDGE));
+      e->count = 0;
+    }
+    csound->dag_edge_valid = 1;
+    return 1;
+}
+
+static void dag_edge_grow(CSOUND *csound, DAG_EDGES *e)
+{
+    DAG_EDGE *old = e->slot;
+    uint32_t i, j, mask, size = e->size;
+
+    e->size = size * 2;
+    mask = e->size - 1;
+    e->slot = (DAG_EDGE *) csound->Calloc(csound, e->size * sizeof(DAG_EDGE));
+    for (i = 0; i < size; i++) {
+      if (old[i].dep == 0) continue;
+      for (j = dag_edge_hash(old[i].insno, old[i].later_insno) & mask;
+           e->slot[j].dep != 0; j = (j + 1) & mask)
+        ;
+      e->slot[j] = old[i];
     }
-    csound->Free(csound, ans);
-    return res;
+    csound->Free(csound, old);
 }
 
+static int dag_edge(CSOUND *csound, int insno, int later_insno)
+{
+    DAG_EDGES *e = (DAG_EDGES *) csound->dag_edge_cache;
+    uint32_t  mask = e->size - 1;
+    uint32_t  j = dag_edge_hash(insno, later_insno) & mask;
+
+    for ( ; e->slot[j].dep != 0; j = (j + 1) & mask)
+      if (e->slot[j].insno == insno && e->slot[j].later_insno == later_insno)
+        return e->slot[j].dep == 2;
+    if ((e->count + 1) * 4 > e->size * 3) {
+      dag_edge_grow(csound, e);
+      mask = e->size - 1;
+      for (j = dag_edge_hash(insno, later_insno) & mask;
+           e->slot[j].dep != 0; j = (j + 1) & mask)
+        ;
+    }
+    e->slot[j].insno = insno;
+    e->slot[j].later_insno = later_insno;
+    e->slot[j].dep = dag_depends(csound, insno, later_insno) ? 2 : 1;
+    e->count++;
+    return e->slot[j].dep == 2;
+}
+
+void dag_reinit(CSOUND *csound);
+
+/* Update the DAG after the active chain changed.  Each instance keeps
+   its index from the previous build in dag_task, so edges between
+   surviving instances are only renumbered and edges are looked up
+   just for instances activated since then. */
 void dag_build(CSOUND *csound, INSDS *chain)
 {
-    INSDS *save = chain;
-    INSDS **task_map;
-    int i;
+    INSDS *ip;
+    INSDS **task_map, **prev_map;
+    char **dep, **prev_dep;
+    int *remap, *back, *added;
+    int i, j, k, n = 0, prev_n, num_added = 0, full;
 
     //printf("DAG BUILD***************************************\n");
-    csound->dag_num_active = 0;
-    while (chain != NULL) {
-      csound->dag_num_active++;
-      chain = chain->nxtact;
-    }
-    if (csound->dag_num_active>csound->dag_task_max_size) {
+    for (ip = chain; ip != NULL; ip = ip->nxtact) n++;
+    full = dag_edge_check(csound);
+    if (n > csound->dag_task_max_size || csound->dag_task_status == NULL) {
       //printf("**************need to extend task vector\n");
-      csound->dag_task_max_size = csound->dag_num_active+INIT_SIZE;
-      recreate_dag(csound);
+      if (n > csound->dag_task_max_size)
+        csound->dag_task_max_size = n+INIT_SIZE;
+      dag_alloc(csound);
+      full = 1;
     }
-    if (csound->dag_task_status == NULL)
-      create_dag(csound); /* Should move elsewhere */
-    else {
-      memset((void*)csound->dag_task_watch, '\0',
-             sizeof(watchList*)*csound->dag_task_max_size);
-      for (i=0; i<csound->dag_task_max_size; i++) {
-        if (csound->dag_task_dep[i]) {
-          csound->dag_task_dep[i]= NULL;
-        }
-        csound->dag_wlmm[i].id = INVALID;
+    prev_n = full ? 0 : csound->dag_num_active;
+    /* the last build becomes the previous one */
+    prev_map = csound->dag_task_map;
+    csound->dag_task_map = task_map = csound->dag_prev_map;
+    csound->dag_prev_map = prev_map;
+    prev_dep = csound->dag_task_dep;
+    csound->dag_task_dep = dep = csound->dag_prev_dep;
+    csound->dag_prev_dep = prev_dep;
+    remap = csound->dag_remap;
+    back = remap + csound->dag_task_max_size;
+    added = back + csound->dag_task_max_size;
+
+    for (i=0; i<prev_n; i++) remap[i] = INVALID;
+    for (ip = chain, j = 0; ip != NULL; ip = ip->nxtact, j++) {
+      int o = ip->dag_task;
+      task_map[j] = ip;
+      if (o >= 0 && o < prev_n && prev_map[o] == ip) remap[o] = j;
+      else {
+        o = INVALID;
+        added[num_added++] = j;
       }
+      back[j] = o;
     }
-    task_map = csound->dag_task_map;
-    for (i=0; i<csound->dag_num_active; i++) {
-      csound->dag_task_status[i].s = AVAILABLE;
-      csound->dag_wlmm[i].id=i;
-    }
+    csound->dag_num_active = n;
     csound->dag_changed = 0;
     if (UNLIKELY(csound->oparms->odebug))
-      printf("dag_num_active = %d\n", csound->dag_num_active);
-    i = 0; chain = save;
-    while (chain != NULL) {     /* for each instance check against later */
-      int j = i+1;              /* count of instance */
-      if (UNLIKELY(csound->oparms->odebug))
-        printf("\nWho depends on %d (instr %d)?\n", i, chain->insno);
-      INSDS *next = chain->nxtact;
-      INSTR_SEMANTICS *current_instr = dag_get_info(csound, chain->insno);
-      //csp_set_print(csound, current_instr->read);
-      //csp_set_print(csound, current_instr->write);
-      while (next) {
-        INSTR_SEMANTICS *later_instr = dag_get_info(csound, next->insno);
-        int cnt = 0;
-        if (UNLIKELY(csound->oparms->odebug)) printf("%d ", j);
-        //csp_set_print(csound, later_instr->read);
-        //csp_set_print(csound, later_instr->write);
-        //csp_set_print(csound, later_instr->read_write);
-        if (dag_intersect(csound, current_instr->write,
-                          later_instr->read, cnt++)       ||
-            dag_intersect(csound, current_instr->read_write,
-                          later_instr->read, cnt++)       ||
-            dag_intersect(csound, current_instr->read,
-                          later_instr->write, cnt++)      ||
-            dag_intersect(csound, current_instr->write,
-                          later_instr->write, cnt++)      ||
-            dag_intersect(csound, current_instr->read_write,
-                          later_instr->write, cnt++)      ||
-            dag_intersect(csound, current_instr->read,
-                          later_instr->read_write, cnt++) ||
-            dag_intersect(csound, current_instr->write,
-                          later_instr->read_write, cnt++)) {
-          char *tt = csound->dag_task_dep[j];
-          if (tt==NULL) {
-            /* get dep vector if missing and set watch first time */
-            tt = csound->dag_task_dep[j] =
-              (char*)csound->Calloc(csound, sizeof(char)*(j+1));
-            csound->dag_task_status[j].s = WAITING;
-            csound->dag_wlmm[j].next = csound->dag_task_watch[i];
-            csound->dag_wlmm[j].id = j;
-            csound->dag_task_watch[i] = &(csound->dag_wlmm[j]);
-            //printf("set watch %d to %d\n", j, i);
-          }
-          tt[i] = 1;
-          //printf("-yes ");
+      printf("dag_num_active = %d (%d new)\n", n, num_added);
+
+    for (j=0; j<n; j++) {
+      char *row = dep[j];
+      int o = back[j], insno = task_map[j]->insno;
+      memset(row, '\0', DEP_BYTES(j));
+      if (o != INVALID) {
+        /* surviving instances keep their relative order */
+        char *old = prev_dep[o];
+        for (i=0; i<DEP_BYTES(o); i++) {
+          if (old[i] == 0) continue;
+          for (k=i<<3; k<(i<<3)+8 && k<o; k++)
+            if (DEP_TEST(old, k) && remap[k] != INVALID)
+              DEP_SET(row, remap[k]);
         }
-        j++; next = next->nxtact;
+        for (i=0; i<num_added && added[i]<j; i++)
+          if (dag_edge(csound, task_map[added[i]]->insno, insno))
+            DEP_SET(row, added[i]);
+      }
+      else {
+        for (i=0; i<j; i++)
+          if (dag_edge(csound, task_map[i]->insno, insno))
+            DEP_SET(row, i);
       }
-      task_map[i] = chain;
-      i++; chain = chain->nxtact;
+      task_map[j]->dag_task = j;
     }
+    dag_reinit(csound);
     if (UNLIKELY(csound->oparms->odebug)) dag_print_state(csound);
 }
 
+/* Index of the first task that task j depends on, or INVALID */
+static inline int dag_first_dep(char *row, int j)
+{
+    int i, k;
+    for (i=0; i<DEP_BYTES(j); i++) {
+      if (row[i] == 0) continue;
+      for (k=i<<3; k<j; k++)
+        if (DEP_TEST(row, k)) return k;
+    }
+    return INVALID;
+}
+
 void dag_reinit(CSOUND *csound)
 {
     int i;
@@ -282,99 +604,78 @@ void dag_reinit(CSOUND *csound)
       printf("DAG REINIT************************\n");
     for (i=csound->dag_num_active; i<max; i++)
       task_status[i].s = DONE;
-    task_status[0].s = AVAILABLE;
-    task_watch[0] = NULL;
-    for (i=1; i<csound->dag_num_active; i++) {
-      int j;
+    for (i=0; i<csound->dag_num_active; i++) {
       task_status[i].s = AVAILABLE;
       task_watch[i] = NULL;
-      if (csound->dag_task_dep[i]==NULL) continue;
-      for (j=0; j<i; j++)
-        if (csound->dag_task_dep[i][j]) {
-          task_status[i].s = WAITING;
-          wlmm[i].id = i;
-          wlmm[i].next = task_watch[j];
-          task_watch[j] = &wlmm[i];
-          break;
-        }
+    }
+    for (i=1; i<csound->dag_num_active; i++) {
+      int j = dag_first_dep(csound->dag_task_dep[i], i);
+      if (j != INVALID) {
+        task_status[i].s = WAITING;
+        wlmm[i].id = i;
+        wlmm[i].next = task_watch[j];
+        task_watch[j] = &wlmm[i];
+      }
     }
     //dag_print_state(csound);
+    dag_sched_seed(csound);
 }
 
-//#define ATOMIC_READ(x) __sync_fetch_and_or(&(x), 0)
-//#define ATOMIC_WRITE(x,v) __sync_fetch_and_and(&(x), v)
-#define ATOMIC_READ(x) x
-#define ATOMIC_WRITE(x,v) x = v;
-#if defined(_MSC_VER)
-#define ATOMIC_CAS(x,current,new) \
-  (current == InterlockedCompareExchange(x, new, current))
-#else
-#define ATOMIC_CAS(x,current,new)  __sync_bool_compare_and_swap(x,current,new)
-#endif
-
-#if defined(_MSC_VER)
-#define ATOMIC_CAS_PTR(x,current,new) \
-  (current == InterlockedCompareExchangePointer(x, new, current))
-#else
-#define ATOMIC_CAS_PTR(x,current,new)  __sync_bool_compare_and_swap(x,current,new)
-#endif
-
 taskID dag_get_task(CSOUND *csound, int index, int numThreads, taskID next_task)
 {
-    int i;
-    int count_waiting = 0;
-    int active = csound->dag_num_active;
-    int start = (index * active) / numThreads;
-    volatile stateWithPadding *task_status = csound->dag_task_status;
-    enum state current_task_status;
+    dagScheduler *s = csound->dag_sched;
+    taskDeque *own = &(s->deques[index]);
+    int n = s->num_deques, spins = 0, i, k;
+    taskID task;
+    IGN(numThreads);
 
     if (next_task != INVALID) {
       // Have forwarded one task from the previous one
       // assert(ATOMIC_READ(task_status[next_task].s) == WAITING);
-      ATOMIC_WRITE(task_status[next_task].s,INPROGRESS);
+      ATOMIC_WRITE(csound->dag_task_status[next_task].s,INPROGRESS);
+      own->executed++;
       return next_task;
     }
 
-    //printf("**GetTask from %d\n", csound->dag_num_active);
-    i = start;
-    do {
-      current_task_status = ATOMIC_READ(task_status[i].s);
-
-      switch (current_task_status) {
-      case AVAILABLE :
-        // Need to CAS as the value may have changed
-        if (ATOMIC_CAS(&(task_status[i].s), AVAILABLE, INPROGRESS)) {
-          return (taskID)i;
+    while (1) {
+      int contended = 0;
+      if ((task = deque_pop(own)) != INVALID) goto found;
+      for (i=1, k=index+1; i<n; i++, k++) {   /* try to steal */
+        if (k == n) k = 0;
+        task = deque_steal(&(s->deques[k]));
+        if (task == WAIT) contended = 1;
+        else if (task != INVALID) {
+          own->stolen++;
+          goto found;
         }
-        break;
-
-      case WAITING :
-        //  printf("**%d waiting\n", i);
-        ++count_waiting;
-        break;
-
-      case INPROGRESS :
-        //  print(f"**%d active\n", i);
-        break;
-
-      case DONE :
-        //printf("**%d done\n", i);
-        break;
-
-      default :
-        // Enum corrupted!
-        //assert(0);
-        break;
       }
-
-      // Increment modulo active
-      i = (i+1 == active) ? 0 : i + 1;
-
-    } while (i != start);
-    //dag_print_state(csound);
-    if (count_waiting == 0) return (taskID)INVALID;
-    //printf("taskstodo=%d)\n", morework);
-    return (taskID)WAIT;
+      if (ATOMIC_GET(s->remaining) == 0) return (taskID)INVALID;
+      if (contended || ++spins < own->spin) {
+        CPU_RELAX();
+        continue;
+      }
+      /* Nothing to do for a while: block until woken */
+      {
+        int epoch;
+        ATOMIC_INCR(s->sleepers);
+        epoch = ATOMIC_GET(s->wake_epoch);
+        for (i=0; i<n; i++)
+          if (!deque_empty(&(s->deques[i]))) break;
+        if (i == n && ATOMIC_GET(s->remaining) != 0) {
+          own->idle++;
+          dag_sched_park(s, epoch);
+        }
+        ATOMIC_DECR(s->sleepers);
+      }
+      if (own->spin > SPIN_MIN) own->spin >>= 1;
+      spins = 0;
+    }
+ found:
+    /* work turned up while spinning, so spin longer next time */
+    if (spins > 0 && own->spin < SPIN_MAX) own->spin <<= 1;
+    ATOMIC_WRITE(csound->dag_task_status[task].s,INPROGRESS);
+    own->executed++;
+    return task;
 }
 
 /* This static is OK as not written */
@@ -401,7 +702,7 @@ inline static int moveWatch(CSOUND *csound, watchList * volatile *w,
     return 1;
 }
 
-taskID dag_end_task(CSOUND *csound, taskID i)
+taskID dag_end_task(CSOUND *csound, int index, taskID i)
 {
     watchList *to_notify, *next;
     int canQueue;
@@ -431,7 +732,7 @@ taskID dag_end_task(CSOUND *csound, taskID i)
       wait_on_current_tasks = 0;
 
       for (k=0; k<j; k++) {     /* seek next watch */
-        if (csound->dag_task_dep[j][k]==0) continue;
+        if (!DEP_TEST(csound->dag_task_dep[j], k)) continue;
         current_task_status = ATOMIC_READ(csound->dag_task_status[k].s);
         //printf("investigating task %d (%d)\n", k, current_task_status);
 
@@ -461,7 +762,7 @@ taskID dag_end_task(CSOUND *csound, taskID i)
       // Try the same thing again but this time waiting on active or available task
       if (wait_on_current_tasks == 1) {
         for (k=0; k<j; k++) {     /* seek next watch */
-          if (csound->dag_task_dep[j][k]==0) continue;
+          if (!DEP_TEST(csound->dag_task_dep[j], k)) continue;
           current_task_status = ATOMIC_READ(csound->dag_task_status[k].s);
           //printf("investigating task %d (%d)\n", k, current_task_status);
 
@@ -489,11 +790,15 @@ taskID dag_end_task(CSOUND *csound, taskID i)
           next_task = j; // Forward directly to the thread to save re-dispatch
         } else {
           ATOMIC_WRITE(csound->dag_task_status[j].s, AVAILABLE);
+          deque_push(&(csound->dag_sched->deques[index]), j);
+          dag_sched_wake(csound->dag_sched, 0);
         }
       }
       to_notify = next;
     }
     //dag_print_state(csound);
+    if (ATOMIC_DECR(csound->dag_sched->remaining) == 0)
+      dag_sched_wake(csound->dag_sched, 1);
     return next_task;
 }
 
@@ -272,6 +272,7 @@ void csp_orc_sa_instr_add(CSOUND *csound, char *name)
     name = cs_strdup(csound, name); // JPff:  leaks: necessary?? Think it is correct
     //printf("csp_orc_sa_instr_add name=%s\n", name);
     csound->inInstr = 1;
+    csound->dag_edge_valid = 0; /* cached DAG edge classes are now stale */
     if (csound->instRoot == NULL) {
       //printf("instRoot id NULL\n");
       csound->instRoot = instr_semantics_alloc(csound, name);
@@ -93,63 +93,106 @@ PUBLIC void cs_cons_free_complete(CSOUND* csound, CONS_CELL* head) {
 
 /* FUNCTION FOR HASH SET */
 
+#define CS_HASH_MIN_SIZE 16
+
 PUBLIC CS_HASH_TABLE* cs_hash_table_create(CSOUND* csound) {
-    return (CS_HASH_TABLE*) csound->Calloc(csound, sizeof(CS_HASH_TABLE));
+    CS_HASH_TABLE* hashTable = csound->Calloc(csound, sizeof(CS_HASH_TABLE));
+    hashTable->size = CS_HASH_MIN_SIZE;
+    hashTable->items = csound->Calloc(csound,
+                                      CS_HASH_MIN_SIZE *
+                                      sizeof(CS_HASH_TABLE_ITEM));
+    return hashTable;
 }
 
-static unsigned int cs_name_hash(char *s)
+/* FNV-1a, with the murmur3 finalizer so that the low bits used to
+   pick a slot depend on every character */
+static uint32_t cs_name_hash(const char *s)
 {
-    unsigned int h = 0;
+    uint32_t h = 2166136261u;
     while (*s != '\0') {
-      h = (h<<4) ^ *s++;
+      h ^= (unsigned char) *s++;
+      h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/* slot holding key, or the empty slot where it would go */
+static CS_HASH_TABLE_ITEM* cs_hash_table_find(CS_HASH_TABLE* hashTable,
+                                              const char* key, uint32_t hash) {
+    uint32_t mask = hashTable->size - 1;
+    uint32_t i = hash & mask;
+    CS_HASH_TABLE_ITEM* item;
+
+    while ((item = &hashTable->items[i])->key != NULL) {
+      if (item->hash == hash && strcmp(key, item->key) == 0) {
+        break;
+      }
+      i = (i + 1) & mask;
     }
-    return (h%HASH_SIZE);
+    return item;
+}
+
+static void cs_hash_table_grow(CSOUND* csound, CS_HASH_TABLE* hashTable) {
+    CS_HASH_TABLE_ITEM* old = hashTable->items;
+    uint32_t oldSize = hashTable->size;
+    uint32_t i;
+
+    hashTable->size = oldSize * 2;
+    hashTable->items = csound->Calloc(csound, hashTable->size *
+                                              sizeof(CS_HASH_TABLE_ITEM));
+    for (i = 0; i < oldSize; i++) {
+      if (old[i].key != NULL) {
+        *cs_hash_table_find(hashTable, old[i].key, old[i].hash) = old[i];
+      }
+    }
+    csound->Free(csound, old);
 }
 
 PUBLIC void* cs_hash_table_get(CSOUND* csound,
                                CS_HASH_TABLE* hashTable, char* key) {
     IGN(csound);
-    unsigned int index;
-    CS_HASH_TABLE_ITEM* item;
 
     if (key == NULL) {
       return NULL;
     }
 
-    index = cs_name_hash(key);
-    item = hashTable->buckets[index];
-
-    while (item != NULL) {
-      if (strcmp(key, item->key) == 0) {
-        return item->value;
-      }
-      item = item->next;
-    }
-
-    return NULL;
+    return cs_hash_table_find(hashTable, key, cs_name_hash(key))->value;
 }
 
 PUBLIC char* cs_hash_table_get_key(CSOUND* csound,
                                    CS_HASH_TABLE* hashTable, char* key) {
-    unsigned int index;
-    CS_HASH_TABLE_ITEM* item;
     IGN(csound);
 
     if (key == NULL) {
       return NULL;
     }
 
-    index = cs_name_hash(key);
-    item = hashTable->buckets[index];
+    return cs_hash_table_find(hashTable, key, cs_name_hash(key))->key;
+}
 
-    while (item != NULL) {
-      if (strcmp(key, item->key) == 0) {
-        return item->key;
-      }
-      item = item->next;
-    }
+static char* cs_hash_table_put_hashed(CSOUND* csound,
+                                      CS_HASH_TABLE* hashTable, char* key,
+                                      uint32_t hash, void* value) {
+    CS_HASH_TABLE_ITEM* item = cs_hash_table_find(hashTable, key, hash);
 
-    return NULL;
+    if (item->key != NULL) {
+      item->value = value;
+      return item->key;
+    }
+    if ((hashTable->count + 1) * 4 > hashTable->size * 3) {
+      cs_hash_table_grow(csound, hashTable);
+      item = cs_hash_table_find(hashTable, key, hash);
+    }
+    item->hash = hash;
+    item->key = key;
+    item->value = value;
+    hashTable->count++;
+    return key;
 }
 
 char* cs_hash_table_put_no_key_copy(CSOUND* csound,
@@ -159,90 +202,81 @@ char* cs_hash_table_put_no_key_copy(CSOUND* csound,
       return NULL;
     }
 
-    unsigned int index = cs_name_hash(key);
-
-    CS_HASH_TABLE_ITEM* item = hashTable->buckets[index];
-
-    if (item == NULL) {
-      CS_HASH_TABLE_ITEM* newItem = csound->Malloc(csound,
-                                                   sizeof(CS_HASH_TABLE_ITEM));
-      newItem->key = key;
-      newItem->value = value;
-      newItem->next = NULL;
-      hashTable->buckets[index] = newItem;
-      return newItem->key;
-    } else {
-      while (item != NULL) {
-        if (strcmp(key, item->key) == 0) {
-          item->value = value;
-          return item->key;
-        } else if (item->next == NULL) {
-          CS_HASH_TABLE_ITEM* newItem = csound->Malloc(csound,
-                                                       sizeof(CS_HASH_TABLE_ITEM));
-          newItem->key = key;
-          newItem->value = value;
-          newItem->next = NULL;
-          item->next = newItem;
-          return newItem->key;
-        }
-        item = item->next;
-      }
+    return cs_hash_table_put_hashed(csound, hashTable, key,
+                                    cs_name_hash(key), value);
+}
+
+/* only copies the key when it is new */
+static char* cs_hash_table_put_copy(CSOUND* csound,
+                                    CS_HASH_TABLE* hashTable,
+                                    char* key, void* value) {
+    CS_HASH_TABLE_ITEM* item;
+    uint32_t hash;
+
+    if (key == NULL) {
+      return NULL;
     }
-    return NULL;
+
+    hash = cs_name_hash(key);
+    item = cs_hash_table_find(hashTable, key, hash);
+    if (item->key != NULL) {
+      item->value = value;
+      return item->key;
+    }
+    return cs_hash_table_put_hashed(csound, hashTable,
+                                    cs_strdup(csound, key), hash, value);
 }
 
 PUBLIC void cs_hash_table_put(CSOUND* csound,
                               CS_HASH_TABLE* hashTable, char* key, void* value) {
-    cs_hash_table_put_no_key_copy(csound, hashTable,
-                                  cs_strdup(csound, key), value);
+    cs_hash_table_put_copy(csound, hashTable, key, value);
 }
 
 PUBLIC char* cs_hash_table_put_key(CSOUND* csound,
                                    CS_HASH_TABLE* hashTable, char* key) {
-    return cs_hash_table_put_no_key_copy(csound, hashTable,
-                                         cs_strdup(csound, key), NULL);
+    return cs_hash_table_put_copy(csound, hashTable, key, NULL);
 }
 
+/* empties the slot and moves back the entries that probed past it, so
+   that lookups never need tombstones */
 PUBLIC void cs_hash_table_remove(CSOUND* csound,
                                  CS_HASH_TABLE* hashTable, char* key) {
-    CS_HASH_TABLE_ITEM *previous, *item;
-    unsigned int index;
+    CS_HASH_TABLE_ITEM* items = hashTable->items;
+    uint32_t mask = hashTable->size - 1;
+    uint32_t i, j;
+    IGN(csound);
 
     if (key == NULL) {
       return;
     }
 
-    index = cs_name_hash(key);
-
-    previous = NULL;
-    item = hashTable->buckets[index];
-
-    while (item != NULL) {
-      if (strcmp(key, item->key) == 0) {
-        if (previous == NULL) {
-          hashTable->buckets[index] = item->next;
-        } else {
-          previous->next = item->next;
-        }
-        csound->Free(csound, item);
-        return;
+    i = (uint32_t) (cs_hash_table_find(hashTable, key,
+                                       cs_name_hash(key)) - items);
+    if (items[i].key == NULL) {
+      return;
+    }
+    hashTable->count--;
+
+    for (j = (i + 1) & mask; items[j].key != NULL; j = (j + 1) & mask) {
+      uint32_t home = items[j].hash & mask;
+      /* j may fill the hole at i unless its home lies in (i, j] */
+      if (((j - home) & mask) >= ((j - i) & mask)) {
+        items[i] = items[j];
+        i = j;
       }
-      previous = item;
-      item = item->next;
     }
+    items[i].key = NULL;
+    items[i].value = NULL;
 }
 
 PUBLIC CONS_CELL* cs_hash_table_keys(CSOUND* csound, CS_HASH_TABLE* hashTable) {
     CONS_CELL* head = NULL;
 
-    int i = 0;
+    uint32_t i = 0;
 
-    for (i = 0; i < HASH_SIZE; i++) {
-      CS_HASH_TABLE_ITEM* item = hashTable->buckets[i];
-
-      while (item != NULL) {
-        head = cs_cons(csound, item->key, head);
-        item = item->next;
+    for (i = 0; i < hashTable->size; i++) {
+      if (hashTable->items[i].key != NULL) {
+        head = cs_cons(csound, hashTable->items[i].key, head);
       }
     }
     return head;
@@ -251,14 +285,11 @@ PUBLIC CONS_CELL* cs_hash_table_keys(CSOUND* csound, CS_HASH_TABLE* hashTable) {
 PUBLIC CONS_CELL* cs_hash_table_values(CSOUND* csound, CS_HASH_TABLE* hashTable) {
     CONS_CELL* head = NULL;
 
-    int i = 0;
-
-    for (i = 0; i < HASH_SIZE; i++) {
-      CS_HASH_TABLE_ITEM* item = hashTable->buckets[i];
+    uint32_t i = 0;
 
-      while (item != NULL) {
-        head = cs_cons(csound, item->value, head);
-        item = item->next;
+    for (i = 0; i < hashTable->size; i++) {
+      if (hashTable->items[i].key != NULL) {
+        head = cs_cons(csound, hashTable->items[i].value, head);
       }
     }
     return head;
@@ -266,85 +297,241 @@ PUBLIC CONS_CELL* cs_hash_table_values(CSOUND* csound, CS_HASH_TABLE* hashTable)
 
 PUBLIC void cs_hash_table_merge(CSOUND* csound,
                                 CS_HASH_TABLE* target, CS_HASH_TABLE* source) {
-    // TODO - check if this is the best strategy for merging
-    int i = 0;
+    uint32_t i = 0;
 
-    for (i = 0; i < HASH_SIZE; i++) {
-      CS_HASH_TABLE_ITEM* item = source->buckets[i];
+    for (i = 0; i < source->size; i++) {
+      CS_HASH_TABLE_ITEM* item = &source->items[i];
 
-      while (item != NULL) {
-        CS_HASH_TABLE_ITEM* next = item->next;
+      if (item->key != NULL) {
         char* new_key =
-          cs_hash_table_put_no_key_copy(csound, target, item->key, item->value);
+          cs_hash_table_put_hashed(csound, target, item->key,
+                                   item->hash, item->value);
 
         if (new_key != item->key) {
           csound->Free(csound, item->key);
         }
-
-        csound->Free(csound, item);
-        item = next;
+        item->key = NULL;
+        item->value = NULL;
       }
-      source->buckets[i] = NULL;
     }
-
+    source->count = 0;
 }
 
 PUBLIC void cs_hash_table_free(CSOUND* csound, CS_HASH_TABLE* hashTable) {
-    int i;
-
-    for (i = 0; i < HASH_SIZE; i++) {
-      CS_HASH_TABLE_ITEM* item = hashTable->buckets[i];
+    uint32_t i;
 
-      while(item != NULL) {
-        CS_HASH_TABLE_ITEM* next = item->next;
-        csound->Free(csound, item->key);
-        csound->Free(csound, item);
-        item = next;
-      }
+    for (i = 0; i < hashTable->size; i++) {
+      csound->Free(csound, hashTable->items[i].key);
     }
+    csound->Free(csound, hashTable->items);
     csound->Free(csound, hashTable);
 }
 
 PUBLIC void cs_hash_table_mfree_complete(CSOUND* csound, CS_HASH_TABLE* hashTable) {
 
-    int i;
+    uint32_t i;
 
-    for (i = 0; i < HASH_SIZE; i++) {
-      CS_HASH_TABLE_ITEM* item = hashTable->buckets[i];
+    for (i = 0; i < hashTable->size; i++) {
+      CS_HASH_TABLE_ITEM* item = &hashTable->items[i];
 
-      while(item != NULL) {
-        CS_HASH_TABLE_ITEM* next = item->next;
+      if (item->key != NULL) {
         csound->Free(csound, item->key);
         csound->Free(csound, item->value);
-        csound->Free(csound, item);
-        item = next;
       }
     }
+    csound->Free(csound, hashTable->items);
     csound->Free(csound, hashTable);
 }
 
 PUBLIC void cs_hash_table_free_complete(CSOUND* csound, CS_HASH_TABLE* hashTable) {
 
-    int i;
+    uint32_t i;
 
-    for (i = 0; i < HASH_SIZE; i++) {
-      CS_HASH_TABLE_ITEM* item = hashTable->buckets[i];
+    for (i = 0; i < hashTable->size; i++) {
+      CS_HASH_TABLE_ITEM* item = &hashTable->items[i];
 
-      while(item != NULL) {
-        CS_HASH_TABLE_ITEM* next = item->next;
+      if (item->key != NULL) {
         csound->Free(csound, item->key);
 
         /* NOTE: This needs to be free, not csound->Free.
            To use mfree on keys, use cs_hash_table_mfree_complete
            TODO: Check if this is even necessary anymore... */
         free(item->value);
-        csound->Free(csound, item);
-        item = next;
       }
     }
+    csound->Free(csound, hashTable->items);
     csound->Free(csound, hashTable);
 }
 
+/* FUNCTIONS FOR TIMING WHEEL */
+
+#define CS_WHEEL_MASK ((uint64_t) CS_WHEEL_SLOTS - 1)
+
+static inline int wheel_empty(CS_WHEEL_NODE* head) {
+    return head->next == head;
+}
+
+static inline int wheel_later(CS_WHEEL_NODE* a, CS_WHEEL_NODE* b) {
+    return a->tick > b->tick || (a->tick == b->tick && a->when > b->when);
+}
+
+static void wheel_link_after(CS_WHEEL_NODE* prev, CS_WHEEL_NODE* node) {
+    node->prev = prev;
+    node->next = prev->next;
+    prev->next->prev = node;
+    prev->next = node;
+}
+
+/* level 0 slots are kept sorted; nodes are nearly always queued in
+   order, so the search starts from the end */
+static void wheel_place(CS_WHEEL* wheel, CS_WHEEL_NODE* node) {
+    uint64_t t = node->tick > wheel->now ? node->tick : wheel->now;
+    uint64_t d = t ^ wheel->now;
+    int level;
+
+    if (d < CS_WHEEL_SLOTS) {
+      CS_WHEEL_NODE* head = &wheel->slots[0][t & CS_WHEEL_MASK];
+      CS_WHEEL_NODE* prev = head->prev;
+      while (prev != head && wheel_later(prev, node))
+        prev = prev->prev;
+      wheel_link_after(prev, node);
+      return;
+    }
+    for (level = 1; level < CS_WHEEL_LEVELS; level++) {
+      if ((d >> (CS_WHEEL_BITS * (level + 1))) == 0) {
+        int n = (int) ((t >> (CS_WHEEL_BITS * level)) & CS_WHEEL_MASK);
+        wheel_link_after(wheel->slots[level][n].prev, node);
+        return;
+      }
+    }
+    wheel_link_after(wheel->overflow.prev, node);
+}
+
+/* moves the nodes of head to where they belong now, keeping their
+   order */
+static void wheel_cascade(CS_WHEEL* wheel, CS_WHEEL_NODE* head) {
+    CS_WHEEL_NODE* node = head->next;
+    head->next = head->prev = head;
+    while (node != head) {
+      CS_WHEEL_NODE* next = node->next;
+      wheel_place(wheel, node);
+      node = next;
+    }
+}
+
+/* the next tick at which a slot has to be emptied: the first non empty
+   slot after the current one on the lowest level that has one */
+static uint64_t wheel_next(CS_WHEEL* wheel) {
+    int level, n;
+
+    for (level = 0; level < CS_WHEEL_LEVELS; level++) {
+      uint64_t base = wheel->now >> (CS_WHEEL_BITS * level);
+      for (n = (int) (base & CS_WHEEL_MASK) + 1; n < CS_WHEEL_SLOTS; n++)
+        if (!wheel_empty(&wheel->slots[level][n]))
+          return ((base & ~CS_WHEEL_MASK) | (uint64_t) n)
+            << (CS_WHEEL_BITS * level);
+    }
+    return ((wheel->now >> (CS_WHEEL_BITS * CS_WHEEL_LEVELS)) + 1)
+      << (CS_WHEEL_BITS * CS_WHEEL_LEVELS);
+}
+
+/* turns the wheel to tick, which must not be past wheel_next() */
+static void wheel_move(CS_WHEEL* wheel, uint64_t tick) {
+    CS_WHEEL_NODE* old = &wheel->slots[0][wheel->now & CS_WHEEL_MASK];
+    CS_WHEEL_NODE* cur = &wheel->slots[0][tick & CS_WHEEL_MASK];
+    uint64_t changed = wheel->now ^ tick;
+    int level;
+
+    wheel->now = tick;
+    if (old != cur && !wheel_empty(old)) { /* still due, before the rest */
+      old->prev->next = cur->next;
+      cur->next->prev = old->prev;
+      cur->next = old->next;
+      old->next->prev = cur;
+      old->next = old->prev = old;
+    }
+    if (changed >> (CS_WHEEL_BITS * CS_WHEEL_LEVELS))
+      wheel_cascade(wheel, &wheel->overflow);
+    for (level = CS_WHEEL_LEVELS - 1; level > 0; level--) {
+      if (changed >> (CS_WHEEL_BITS * level)) {
+        int n = (int) ((tick >> (CS_WHEEL_BITS * level)) & CS_WHEEL_MASK);
+        wheel_cascade(wheel, &wheel->slots[level][n]);
+      }
+    }
+}
+
+/* earliest node of an unsorted slot, the first queued among equals */
+static CS_WHEEL_NODE* wheel_min(CS_WHEEL_NODE* head) {
+    CS_WHEEL_NODE *node, *min = NULL;
+    for (node = head->next; node != head; node = node->next)
+      if (min == NULL || wheel_later(min, node))
+        min = node;
+    return min;
+}
+
+PUBLIC CS_WHEEL* cs_wheel_create(CSOUND* csound) {
+    CS_WHEEL* wheel = csound->Calloc(csound, sizeof(CS_WHEEL));
+    int i, j;
+
+    for (i = 0; i < CS_WHEEL_LEVELS; i++)
+      for (j = 0; j < CS_WHEEL_SLOTS; j++)
+        wheel->slots[i][j].next = wheel->slots[i][j].prev =
+          &wheel->slots[i][j];
+    wheel->overflow.next = wheel->overflow.prev = &wheel->overflow;
+    return wheel;
+}
+
+PUBLIC void cs_wheel_insert(CS_WHEEL* wheel, CS_WHEEL_NODE* node) {
+    wheel_place(wheel, node);
+    wheel->count++;
+}
+
+PUBLIC void cs_wheel_remove(CS_WHEEL* wheel, CS_WHEEL_NODE* node) {
+    if (node->next == NULL)
+      return;
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = node->prev = NULL;
+    wheel->count--;
+}
+
+PUBLIC CS_WHEEL_NODE* cs_wheel_due(CS_WHEEL* wheel, uint64_t tick) {
+    CS_WHEEL_NODE* head;
+
+    if (wheel->count == 0) {        /* may also go back, on a rewind */
+      wheel->now = tick;
+      return NULL;
+    }
+    while (wheel->now < tick) {
+      uint64_t next = wheel_next(wheel);
+      wheel_move(wheel, next < tick ? next : tick);
+    }
+    head = &wheel->slots[0][wheel->now & CS_WHEEL_MASK];
+    return wheel_empty(head) ? NULL : head->next;
+}
+
+PUBLIC CS_WHEEL_NODE* cs_wheel_first(CS_WHEEL* wheel) {
+    int level, n;
+
+    if (wheel->count == 0)
+      return NULL;
+    for (n = (int) (wheel->now & CS_WHEEL_MASK); n < CS_WHEEL_SLOTS; n++)
+      if (!wheel_empty(&wheel->slots[0][n]))
+        return wheel->slots[0][n].next;
+    for (level = 1; level < CS_WHEEL_LEVELS; level++) {
+      n = (int) ((wheel->now >> (CS_WHEEL_BITS * level)) & CS_WHEEL_MASK);
+      for (n++; n < CS_WHEEL_SLOTS; n++)
+        if (!wheel_empty(&wheel->slots[level][n]))
+          return wheel_min(&wheel->slots[level][n]);
+    }
+    return wheel_min(&wheel->overflow);
+}
+
+PUBLIC void cs_wheel_free(CSOUND* csound, CS_WHEEL* wheel) {
+    csound->Free(csound, wheel);
+}
+
+
 
 
 #ifdef __cplusplus
@@ -42,6 +42,7 @@ static const char *INSTR_NAME_FIRST = "::^inm_first^::";
 static ARG *createArg(CSOUND *csound, INSTRTXT *ip, char *s,
                       ENGINE_STATE *engineState);
 static void insprep(CSOUND *, INSTRTXT *, ENGINE_STATE *engineState);
+static void udo_byref(CSOUND *, INSTRTXT *);
 static void lgbuild(CSOUND *, INSTRTXT *, char *, int inarg,
                     ENGINE_STATE *engineState);
 int pnum(char *s);
@@ -911,6 +912,7 @@ void close_instrument(CSOUND *csound, ENGINE_STATE *engineState, INSTRTXT *ip) {
 }
 
 void deleteVarPoolMemory(void *csound, CS_VAR_POOL *pool);
+void free_instance_memory(CSOUND *csound, INSTRTXT *tp);
 
 /**
    This function deletes an inactive instrument which has been replaced
@@ -924,12 +926,15 @@ void free_instrtxt(CSOUND *csound, INSTRTXT *instrtxt) {
       fdchclose(csound, active);
     if (active->auxchp != NULL)
       auxchfree(csound, active);
+    csoundRegionFree(csound, &active->region);
     free_instr_var_memory(csound, active);
     if (active->opcod_iobufs != NULL)
       csound->Free(csound, active->opcod_iobufs);
-    csound->Free(csound, active);
     active = nxt;
   }
+  free_instance_memory(csound, ip);
+  if (ip->udo_byref != NULL)
+    csound->Free(csound, ip->udo_byref);
   OPTXT *t = ip->nxtop;
   while (t) {
     OPTXT *s = t->nxtop;
@@ -1883,12 +1888,16 @@ extern void sanitize(CSOUND *csound);
 */
 int csoundCompileOrcInternal(CSOUND *csound, const char *str, int async) {
   TREE *root;
-  int retVal = 1;
+  int retVal = 1, tag = memalloc_tag(CS_MEM_COMPILER);
+  RTCLOCK clk;
   volatile jmp_buf tmpExitJmp;
 
+  csoundInitTimerStruct(&clk);
   memcpy((void *)&tmpExitJmp, (void *)&csound->exitjmp, sizeof(jmp_buf));
   if ((retVal = setjmp(csound->exitjmp))) {
     memcpy((void *)&csound->exitjmp, (void *)&tmpExitJmp, sizeof(jmp_buf));
+    memalloc_tag(tag);
+    csound->startup.compile += csoundGetRealTime(&clk);
     return retVal;
   }
   // retVal = 1;
@@ -1901,12 +1910,16 @@ int csoundCompileOrcInternal(CSOUND *csound, const char *str, int async) {
   } else {
     // csoundDeleteTree(csound, root);
     memcpy((void *)&csound->exitjmp, (void *)&tmpExitJmp, sizeof(jmp_buf));
+    memalloc_tag(tag);
+    csound->startup.compile += csoundGetRealTime(&clk);
     return CSOUND_ERROR;
   }
 
   if (UNLIKELY(csound->oparms->odebug))
     debugPrintCsound(csound);
   memcpy((void *)&csound->exitjmp, (void *)&tmpExitJmp, sizeof(jmp_buf));
+  memalloc_tag(tag);
+  csound->startup.compile += csoundGetRealTime(&clk);
   return retVal;
 }
 
@@ -2057,6 +2070,103 @@ static void insprep(CSOUND *csound, INSTRTXT *tp, ENGINE_STATE *engineState) {
     if (UNLIKELY(O->odebug))
       csound->Message(csound, "\n");
   }
+  if (tp->opcode_info != NULL)
+    udo_byref(csound, tp);
+}
+
+/* opcodes known to only read their array and string inputs; an input
+   given to any other opcode may be written in place, and is copied */
+static const char *udo_input_readers[] = {
+  "=", "##array_get", "##add", "##sub", "##mul", "##div", "##pow",
+  "##rem", "##rems", "##neg", "lenarray", "sumarray", "maxarray",
+  "minarray", "slicearray", "maparray", "printarray", "xout",
+  "printf", "printf_i", "prints", "printks", "printks2", "puts",
+  "sprintf", "sprintfk", "strcat", "strcatk", "strcmp", "strcmpk",
+  "strcpy", "strcpyk", "strlen", "strlenk", "strindex", "strindexk",
+  "strrindex", "strrindexk", "strsub", "strsubk", "strchar", "strchark",
+  "strtod", "strtodk", "strtol", "strtolk", "strupper", "strupperk",
+  "strlower", "strlowerk", NULL
+};
+
+static int udo_input_reader(OENTRY *ep) {
+  int i;
+
+  if (ep->useropinfo != NULL)
+    return 1;                   /* a UDO binds or copies it in turn */
+  for (i = 0; udo_input_readers[i] != NULL; i++) {
+    size_t n = strlen(udo_input_readers[i]);
+    if (strncmp(ep->opname, udo_input_readers[i], n) == 0 &&
+        (ep->opname[n] == '\0' || ep->opname[n] == '.'))
+      return 1;
+  }
+  return 0;
+}
+
+static int udo_arg_written(TEXT *ttp, CS_VARIABLE *var) {
+  ARG *arg;
+
+  for (arg = ttp->outArgs; arg != NULL; arg = arg->next)
+    if (arg->type == ARG_LOCAL && arg->argPtr == var)
+      return 1;
+  if (!udo_input_reader(ttp->oentry))
+    for (arg = ttp->inArgs; arg != NULL; arg = arg->next)
+      if (arg->type == ARG_LOCAL && arg->argPtr == var)
+        return 1;
+  return 0;
+}
+
+/* find the k-rate array and string inputs of a UDO that its body only
+   reads; these are bound to the caller's argument instead of copied
+   (see xinset() in insert.c) */
+static void udo_byref(CSOUND *csound, INSTRTXT *tp) {
+  OPCODINFO *inm = tp->opcode_info;
+  OPTXT *optxt, *xin = NULL;
+  CS_VARIABLE *invar;
+  ARG *arg;
+  char *byref;
+  int i, n = 0;
+
+  if (tp->udo_byref != NULL) {
+    csound->Free(csound, tp->udo_byref);
+    tp->udo_byref = NULL;
+  }
+  for (optxt = (OPTXT *)tp; (optxt = optxt->nxtop) != NULL;) {
+    if (strcmp(optxt->t.oentry->opname, "endop") == 0)
+      break;
+    if (strcmp(optxt->t.oentry->opname, "xin") == 0) {
+      if (xin != NULL)
+        return;                 /* more than one xin: always copy */
+      xin = optxt;
+    }
+  }
+  if (xin == NULL || inm->inchns == 0)
+    return;
+  byref = (char *)csound->Calloc(csound, inm->inchns);
+  invar = inm->in_arg_pool->head;
+  for (i = 0, arg = xin->t.outArgs; i < inm->inchns && arg != NULL && invar;
+       i++, arg = arg->next, invar = invar->next) {
+    if (arg->type != ARG_LOCAL || arg->argPtr == NULL)
+      continue;
+    if (invar->varType == &CS_VAR_TYPE_S)
+      byref[i] = 'S';
+    else if (invar->varType == &CS_VAR_TYPE_ARRAY &&
+             (invar->subType == &CS_VAR_TYPE_K ||
+              invar->subType == &CS_VAR_TYPE_S))
+      byref[i] = 'A';
+    else
+      continue;
+    for (optxt = (OPTXT *)tp; (optxt = optxt->nxtop) != NULL;)
+      if (optxt != xin && strcmp(optxt->t.oentry->opname, "endop") != 0 &&
+          udo_arg_written(&optxt->t, arg->argPtr)) {
+        byref[i] = 0;
+        break;
+      }
+    n += byref[i] != 0;
+  }
+  if (n == 0)
+    csound->Free(csound, byref);
+  else
+    tp->udo_byref = byref;
 }
 
 /* build pool of floating const values  */
@@ -24,6 +24,9 @@
 
 #include "csoundCore.h"
 #include "csound_orc.h"
+#include "aops.h"
+
+OENTRY *find_opcode(CSOUND *, char *);
 
 static TREE * create_fun_token(CSOUND *csound, TREE *right, char *fname)
 {
@@ -241,6 +244,228 @@ TREE* constant_fold(CSOUND *csound, TREE* root)
 }
 
 
+/* Audio-rate expression fusion.  The expression expander turns
+   a1 = (a2*k1 + a3*k2)*0.5 into a chain of ##mul.ak/##add.aa/... calls,
+   each of which runs over ksmps and writes a full synthetic a-rate
+   temporary.  Chains whose intermediate results are synthetic #a
+   variables read exactly once are collapsed into a single ##aexpr
+   (OOps/aops.c), which evaluates the whole tree in one pass over the
+   block.  Only runs of consecutive arithmetic statements are merged, so
+   no other opcode can observe the reordering. */
+
+typedef struct fuse_node {
+    TREE    *stmt;
+    struct fuse_node *kid[2];   /* fused operands, NULL for plain args */
+    char    op, rate[2];
+    int     nleaves, depth;     /* leaves and stack depth of the tree */
+    int     open;               /* result not yet consumed */
+} FUSE_NODE;
+
+static char fusable_op(TREE *t)
+{
+    OENTRY *ep = (OENTRY *) t->markup;
+    const char *s;
+
+    if ((t->type != T_OPCODE && t->type != T_OPCODE0) || ep == NULL ||
+        t->left == NULL || t->left->next != NULL ||
+        t->right == NULL || t->right->next == NULL ||
+        t->right->next->next != NULL)
+      return 0;
+    s = ep->opname;
+    if (strlen(s) != 8 || strncmp(s, "##", 2) != 0 || s[5] != '.' ||
+        (strcmp(s + 6, "aa") && strcmp(s + 6, "ak") && strcmp(s + 6, "ka")))
+      return 0;
+    if (!strncmp(s + 2, "add", 3)) return '+';
+    if (!strncmp(s + 2, "sub", 3)) return '-';
+    if (!strncmp(s + 2, "mul", 3)) return '*';
+    if (!strncmp(s + 2, "div", 3)) return '/';
+    return 0;
+}
+
+/* counts the appearances of each synthetic a-rate variable */
+static void count_synth_args(CSOUND *csound, CS_HASH_TABLE *counts, TREE *t)
+{
+    for ( ; t != NULL; t = t->next) {
+      if (t->value != NULL && t->value->lexeme != NULL &&
+          t->value->lexeme[0] == '#' && t->value->lexeme[1] == 'a') {
+        int *n = cs_hash_table_get(csound, counts, t->value->lexeme);
+        if (n == NULL) {
+          n = csound->Calloc(csound, sizeof(int));
+          cs_hash_table_put(csound, counts, t->value->lexeme, n);
+        }
+        (*n)++;
+      }
+      count_synth_args(csound, counts, t->left);
+      count_synth_args(csound, counts, t->right);
+    }
+}
+
+static void remove_synth_var(CSOUND *csound, CS_VAR_POOL *pool, char *name)
+{
+    CS_VARIABLE *var = pool->head, *prv = NULL;
+
+    while (var != NULL && strcmp(var->varName, name) != 0) {
+      prv = var;
+      var = var->next;
+    }
+    if (var == NULL) return;
+    if (prv == NULL) pool->head = var->next;
+    else prv->next = var->next;
+    if (pool->tail == var) pool->tail = prv;
+    cs_hash_table_remove(csound, pool->table, name);
+    pool->poolSize -= var->memBlockSize;
+    pool->varCount--;
+}
+
+/* appends the postfix program of node to prog and its leaves to args */
+static void fuse_emit(CSOUND *csound, CS_VAR_POOL *pool, FUSE_NODE *node,
+                      char *prog, TREE ***args)
+{
+    TREE *arg[2], *t = node->stmt;
+    int i;
+
+    arg[0] = t->right;
+    arg[1] = t->right->next;
+    for (i = 0; i < 2; i++) {
+      if (node->kid[i] != NULL) {
+        fuse_emit(csound, pool, node->kid[i], prog, args);
+        remove_synth_var(csound, pool, arg[i]->value->lexeme);
+      }
+      else {
+        strncat(prog, &node->rate[i], 1);
+        **args = arg[i];
+        *args = &arg[i]->next;
+      }
+    }
+    strncat(prog, &node->op, 1);
+    if (node->open == 0)            /* interior statement is dropped */
+      csound->Free(csound, t);
+}
+
+/* replaces the statement of the root node by a ##aexpr call */
+static void fuse_tree(CSOUND *csound, CS_VAR_POOL *pool, OENTRY *ep,
+                      FUSE_NODE *root)
+{
+    TREE *t = root->stmt, *args = NULL, **tail = &args;
+    char prog[2 * AEXPR_MAXARGS + 2] = "\"";
+
+    fuse_emit(csound, pool, root, prog, &tail);
+    *tail = NULL;
+    strcat(prog, "\"");
+    t->value = make_token(csound, "##aexpr");
+    t->value->type = T_OPCODE;
+    t->markup = ep;
+    t->right = make_leaf(csound, t->line, t->locn, STRING_TOKEN,
+                         make_token(csound, prog));
+    t->right->next = args;
+}
+
+/* merges the trees built over one run of arithmetic statements and
+   relinks the survivors between prv and nxt */
+static void fuse_flush(CSOUND *csound, CS_VAR_POOL *pool, OENTRY *ep,
+                       FUSE_NODE *nodes, int cnt, TREE *prv, TREE *nxt)
+{
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+      if (nodes[i].open) {
+        if (nodes[i].kid[0] != NULL || nodes[i].kid[1] != NULL)
+          fuse_tree(csound, pool, ep, &nodes[i]);
+        prv->next = nodes[i].stmt;
+        prv = nodes[i].stmt;
+      }
+    }
+    prv->next = nxt;
+}
+
+static void fuse_arithmetic(CSOUND *csound, TREE *instr)
+{
+    CS_VAR_POOL *pool = (CS_VAR_POOL *) instr->markup;
+    OENTRY *ep = find_opcode(csound, "##aexpr");
+    CS_HASH_TABLE *counts;
+    FUSE_NODE *nodes = NULL;
+    TREE head, *cur, *prv;
+    int cnt = 0, max = 0, barrier = -1;
+
+    if (ep == NULL || pool == NULL || instr->right == NULL)
+      return;
+    counts = cs_hash_table_create(csound);
+    count_synth_args(csound, counts, instr->right);
+    memset(&head, 0, sizeof(TREE));
+    head.next = instr->right;
+    prv = &head;                  /* statement before the current run */
+    for (cur = instr->right; cur != NULL; ) {
+      TREE *nxt = cur->next;
+      char op = fusable_op(cur);
+      if (op == 0) {
+        if (cnt > 0) {
+          fuse_flush(csound, pool, ep, nodes, cnt, prv, cur);
+          cnt = 0;
+          barrier = -1;
+        }
+        prv = cur;
+      }
+      else {
+        FUSE_NODE *node;
+        TREE *arg = cur->right;
+        const char *types = ((OENTRY *) cur->markup)->opname + 6;
+        int i, j;
+        if (cnt == max) {
+          max = (max == 0 ? 16 : 2 * max);
+          nodes = csound->ReAlloc(csound, nodes, max * sizeof(FUSE_NODE));
+        }
+        node = &nodes[cnt];
+        node->stmt = cur;
+        node->op = op;
+        node->open = 1;
+        node->nleaves = 0;
+        node->depth = 0;
+        for (i = 0; i < 2; i++, arg = arg->next) {
+          FUSE_NODE *kid = NULL;
+          int *n = cs_hash_table_get(csound, counts, arg->value->lexeme);
+          /* a temp defined and read once, and not moved past a
+             statement writing a named variable */
+          if (n != NULL && *n == 2 && types[i] == 'a') {
+            for (j = cnt - 1; j > barrier; j--) {
+              if (nodes[j].open &&
+                  !strcmp(nodes[j].stmt->left->value->lexeme,
+                          arg->value->lexeme)) {
+                kid = &nodes[j];
+                break;
+              }
+            }
+          }
+          if (kid != NULL &&
+              (node->nleaves + kid->nleaves + (i == 0 ? 1 : 0) >
+               AEXPR_MAXARGS ||
+               (i == 0 ? kid->depth : kid->depth + 1) > AEXPR_MAXREG + 1))
+            kid = NULL;
+          node->kid[i] = kid;
+          node->rate[i] = types[i];
+          if (kid != NULL) {
+            kid->open = 0;
+            node->nleaves += kid->nleaves;
+            j = (i == 0 ? kid->depth : kid->depth + 1);
+          }
+          else {
+            node->nleaves++;
+            j = i + 1;
+          }
+          if (j > node->depth) node->depth = j;
+        }
+        if (cur->left->value->lexeme[0] != '#')
+          barrier = cnt;
+        cnt++;
+      }
+      cur = nxt;
+    }
+    if (cnt > 0)
+      fuse_flush(csound, pool, ep, nodes, cnt, prv, NULL);
+    instr->right = head.next;
+    csound->Free(csound, nodes);
+    cs_hash_table_mfree_complete(csound, counts);
+}
+
 /* Optimizes tree (expressions, etc.) */
 TREE * csound_orc_optimize(CSOUND *csound, TREE *root)
 {
@@ -252,6 +477,8 @@ TREE * csound_orc_optimize(CSOUND *csound, TREE *root)
         if (last) last->next = xx;
         else original = xx;
       }
+      if (xx->type == INSTR_TOKEN || xx->type == UDO_TOKEN)
+        fuse_arithmetic(csound, xx);
       last = root;
       root = root->next;
     }
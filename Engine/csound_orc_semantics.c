@@ -34,6 +34,7 @@
 #include "csound_standard_types.h"
 #include "csound_orc_expressions.h"
 #include "csound_orc_semantics.h"
+#include "csmodule.h"
 
 extern char *csound_orcget_text ( void *scanner );
 static int is_label(char* ident, CONS_CELL* labelList);
@@ -67,7 +68,7 @@ char* cs_strdup(CSOUND* csound, char* str) {
     if (str == NULL) return NULL;
 
     len = strlen(str);
-    retVal = csound->Malloc(csound, len + 1);
+    retVal = mmalloc_tag(csound, len + 1, CS_MEM_STRING);
 
     if (len > 0) {
       strncpy(retVal, str, len);
@@ -88,7 +89,7 @@ char* cs_strndup(CSOUND* csound, char* str, size_t size) {
       return cs_strdup(csound, str);
     }
 
-    retVal = csound->Malloc(csound, size + 1);
+    retVal = mmalloc_tag(csound, size + 1, CS_MEM_STRING);
     memcpy(retVal, str, size);
     retVal[size] = '\0';
 
@@ -615,6 +616,7 @@ OENTRY* find_opcode(CSOUND *csound, char *opname)
       return 0;
 
     shortName = get_opcode_short_name(csound, opname);
+    csoundLoadDeferredOpcode(csound, shortName);
 
     head = cs_hash_table_get(csound, csound->opcodes, shortName);
 
@@ -646,6 +648,7 @@ OENTRIES* find_opcode2(CSOUND* csound, char* opname)
     }
 
     shortName = get_opcode_short_name(csound, opname);
+    csoundLoadDeferredOpcode(csound, shortName);
     head = cs_hash_table_get(csound, csound->opcodes, shortName);
     retVal = get_entries(csound, cs_cons_length(head));
     while (head != NULL) {
@@ -185,6 +185,7 @@ OENTRY opcodlst_1[] = {
   { "##mul.aa",  S(AOP),0,    2,      "a",    "aa",   NULL,   mulaa   },
   { "##div.aa",  S(AOP),0,    2,      "a",    "aa",   NULL,   divaa   },
   { "##mod.aa",  S(AOP),0,    2,      "a",    "aa",   NULL,   modaa   },
+  { "##aexpr",  S(AEXPR),0,  3,      "a",    "S*",   aexpr_set, aexpr },
   { "divz",   0xfffc                                                      },
   { "divz.ii", S(DIVZ),0,   1,      "i",    "iii",  divzkk, NULL,   NULL    },
   { "divz.kk", S(DIVZ),0,   2,      "k",    "kkk",  NULL,   divzkk, NULL    },
@@ -270,6 +271,7 @@ OENTRY opcodlst_1[] = {
   { "ampdbfs.a",S(EVAL),0,  2,      "a",    "a",    NULL,   aampdbfs },
   { "ampdbfs.i",S(EVAL),0,  1,      "i",    "i",    ampdbfs                 },
   { "ampdbfs.k",S(EVAL),0,  2,      "k",    "k",    NULL,   ampdbfs         },
+  { "dbamp.a",S(EVAL),0,    2,      "a",    "a",    NULL,   adbamp          },
   { "dbamp.i",S(EVAL),0,    1,      "i",    "i",    dbamp                   },
   { "dbamp.k",S(EVAL),0,    2,      "k",    "k",    NULL,   dbamp           },
   { "dbfsamp.i",S(EVAL),0,  1,      "i",    "i",    dbfsamp                 },
@@ -760,6 +762,7 @@ OENTRY opcodlst_1[] = {
   { "limit.a",  S(LIMIT),0, 2, "a",     "akk",  NULL,  (SUBR)limit },
   { "prealloc", S(AOP),0,   1, "",      "iio",  (SUBR)prealloc, NULL, NULL  },
    { "prealloc", S(AOP),0,   1, "",      "Sio",  (SUBR)prealloc_S, NULL, NULL  },
+  { "prewarm", S(AOP),0,    1, "",      "i",    (SUBR)prewarm, NULL, NULL  },
   /* opcode   dspace      thread  outarg  inargs  isub    ksub    asub    */
   { "inh",    S(INH),0,     2,      "aaaaaa","",    NULL,   inh     },
   { "ino",    S(INO),0,     2,      "aaaaaaaa","",  NULL,   ino     },
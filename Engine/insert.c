@@ -33,6 +33,7 @@
 #include "interlocks.h"
 #include "csound_type_system.h"
 #include "csound_standard_types.h"
+#include "profile.h"
 #include <inttypes.h>
 
 static  void    showallocs(CSOUND *);
@@ -41,6 +42,9 @@ static  void    schedofftim(CSOUND *, INSDS *);
 void    beatexpire(CSOUND *, double);
 void    timexpire(CSOUND *, double);
 static  void    instance(CSOUND *, int);
+static  void    instance_slab(CSOUND *, int, int);
+static  void    instance_reserve(CSOUND *, int, int);
+void    free_instance_memory(CSOUND *, INSTRTXT *);
 extern int argsRequired(char* argString);
 static int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn,
                        MEVENT *mep);
@@ -104,7 +108,8 @@ static void no_op(CSOUND *csound, int attr,
 
  /* do init pass for this instr */
 static int init_pass(CSOUND *csound, INSDS *ip) {
-  int error = 0;
+  int error = 0, tag = memalloc_tag(CS_MEM_INIT);
+  uint64_t t0 = csound->profile != NULL ? profile_ticks() : 0;
   if(csound->oparms->realtime)
     csoundLockMutex(csound->init_pass_threadlock);
   csound->curip = ip;
@@ -113,17 +118,21 @@ static int init_pass(CSOUND *csound, INSDS *ip) {
     if (UNLIKELY(csound->oparms->odebug))
       csound->Message(csound, "init %s:\n",
                       csound->ids->optext->t.oentry->opname);
-    error = (*csound->ids->iopadr)(csound, csound->ids);
+    PROFILE_INIT(csound, csound->ids, error);
   }
+  if (UNLIKELY(csound->profile != NULL))
+    profile_instr(csound, ip, profile_ticks() - t0, 1);
   if(csound->oparms->realtime)
     csoundUnlockMutex(csound->init_pass_threadlock);
+  memalloc_tag(tag);
   return error;
 }
 
 int rireturn(CSOUND *csound, void *p);
 /* do reinit pass */
 static int reinit_pass(CSOUND *csound, INSDS *ip, OPDS *ids) {
-  int error = 0;
+  int error = 0, tag = memalloc_tag(CS_MEM_INIT);
+  uint64_t t0 = csound->profile != NULL ? profile_ticks() : 0;
   if(csound->oparms->realtime) {
     csoundLockMutex(csound->init_pass_threadlock);
   }
@@ -134,13 +143,16 @@ static int reinit_pass(CSOUND *csound, INSDS *ip, OPDS *ids) {
    if (UNLIKELY(csound->oparms->odebug))
       csound->Message(csound, "reinit %s:\n",
                       csound->ids->optext->t.oentry->opname);
-    error = (*csound->ids->iopadr)(csound, csound->ids);
+    PROFILE_INIT(csound, csound->ids, error);
   }
+  if (UNLIKELY(csound->profile != NULL))
+    profile_instr(csound, ip, profile_ticks() - t0, 1);
 
   ATOMIC_SET8(ip->actflg, 1);
   csound->reinitflag = ip->reinitflag = 0;
   if(csound->oparms->realtime)
     csoundUnlockMutex(csound->init_pass_threadlock);
+  memalloc_tag(tag);
   return error;
 }
 
@@ -246,7 +258,9 @@ int init0(CSOUND *csound)
   ip->kicvt = csound->kicvt;
   csound->inerrcnt = 0;
   while ((csound->ids = csound->ids->nxti) != NULL) {
-    (*csound->ids->iopadr)(csound, csound->ids);  /*   run all i-code     */
+    int error;
+    PROFILE_INIT(csound, csound->ids, error);     /*   run all i-code     */
+    (void) error;
   }
   return csound->inerrcnt;                        /*   return errcnt      */
 }
@@ -282,6 +296,290 @@ static void set_xtratim(CSOUND *csound, INSDS *ip)
   csound->engineState.instrtxtp[ip->insno]->pending_release++;
 }
 
+/* Index over the active chain. The notes of one instrument number form
+   a run of actanchor (an ACT_GROUP), and the groups follow each other in
+   instrument order. Score notes are kept in p1 order within the group and
+   MIDI notes (and named instrument notes, whose p1 is a string code) are
+   appended to it. The notes with the same p1 share an ACT_KEY found by
+   hashing p1; its last field is the note after which a new score note
+   with that p1 belongs, or NULL when that has to be searched for, and its
+   held list has the indefinite notes a tied event may continue. */
+
+typedef struct act_key {
+  MYFLT   p1;
+  int     count;                /* active notes with this p1 */
+  INSDS   *last;
+  INSDS   *held;                /* linked by nxtheld, oldest first */
+  struct act_key *nxt;
+} ACT_KEY;
+
+typedef struct {
+  INSDS   *first, *last;
+  int     mixed;                /* has appended notes out of p1 order */
+} ACT_GROUP;
+
+typedef struct act_index {
+  ACT_GROUP *groups;
+  uint64_t  *used;              /* bit per group with active notes */
+  int       ngroups;
+  ACT_KEY   **keys;
+  uint32_t  keymask;
+  int       nkeys;
+  ACT_KEY   *freekeys;
+} ACT_INDEX;
+
+static inline uint32_t act_hash(MYFLT p1)
+{
+  uint64_t h = 0;
+  if (p1 != FL(0.0))            /* -0 == 0 */
+    memcpy(&h, &p1, sizeof(MYFLT));
+  h *= UINT64_C(0x9E3779B97F4A7C15);
+  return (uint32_t) (h >> 32);
+}
+
+static ACT_INDEX *act_index(CSOUND *csound, int insno)
+{
+  ACT_INDEX *x = csound->actindex;
+  if (UNLIKELY(x == NULL)) {
+    x = csound->actindex = csound->Calloc(csound, sizeof(ACT_INDEX));
+    x->keymask = 63;
+    x->keys = csound->Calloc(csound, (x->keymask + 1) * sizeof(ACT_KEY*));
+  }
+  if (UNLIKELY(insno >= x->ngroups)) {
+    int n = (insno | 63) + 1;
+    x->groups = csound->ReAlloc(csound, x->groups, n * sizeof(ACT_GROUP));
+    x->used = csound->ReAlloc(csound, x->used, (n >> 6) * sizeof(uint64_t));
+    memset(x->groups + x->ngroups, 0,
+           (n - x->ngroups) * sizeof(ACT_GROUP));
+    memset(x->used + (x->ngroups >> 6), 0,
+           ((n - x->ngroups) >> 6) * sizeof(uint64_t));
+    x->ngroups = n;
+  }
+  return x;
+}
+
+/* the key for p1, created if make is set; p1 is not a string code */
+static ACT_KEY *act_key(CSOUND *csound, ACT_INDEX *x, MYFLT p1, int make)
+{
+  ACT_KEY *k;
+  for (k = x->keys[act_hash(p1) & x->keymask]; k != NULL; k = k->nxt)
+    if (k->p1 == p1)
+      return k;
+  if (!make)
+    return NULL;
+  if (UNLIKELY((uint32_t) x->nkeys > x->keymask)) {
+    uint32_t  i, mask = 2 * x->keymask + 1;
+    ACT_KEY   **keys = csound->Calloc(csound, (mask + 1) * sizeof(ACT_KEY*));
+    for (i = 0; i <= x->keymask; i++)
+      while ((k = x->keys[i]) != NULL) {
+        x->keys[i] = k->nxt;
+        k->nxt = keys[act_hash(k->p1) & mask];
+        keys[act_hash(k->p1) & mask] = k;
+      }
+    csound->Free(csound, x->keys);
+    x->keys = keys;
+    x->keymask = mask;
+  }
+  if ((k = x->freekeys) != NULL)
+    x->freekeys = k->nxt;
+  else
+    k = csound->Malloc(csound, sizeof(ACT_KEY));
+  k->p1 = p1;
+  k->count = 0;
+  k->last = k->held = NULL;
+  k->nxt = x->keys[act_hash(p1) & x->keymask];
+  x->keys[act_hash(p1) & x->keymask] = k;
+  x->nkeys++;
+  return k;
+}
+
+static void act_key_release(ACT_INDEX *x, ACT_KEY *k)
+{
+  ACT_KEY **kp = &x->keys[act_hash(k->p1) & x->keymask];
+  while (*kp != k)
+    kp = &(*kp)->nxt;
+  *kp = k->nxt;
+  k->nxt = x->freekeys;
+  x->freekeys = k;
+  x->nkeys--;
+}
+
+/* last note of the nearest lower instrument with active notes */
+static INSDS *act_prev_group(CSOUND *csound, ACT_INDEX *x, int insno)
+{
+  int       w = insno >> 6;
+  uint64_t  bits = x->used[w] & ((UINT64_C(1) << (insno & 63)) - 1);
+  for (;;) {
+    if (bits != 0) {
+      int b = 63;
+      while (!(bits >> b))
+        b--;
+      return x->groups[(w << 6) + b].last;
+    }
+    if (--w < 0)
+      return &(csound->actanchor);
+    bits = x->used[w];
+  }
+}
+
+static inline int act_in_group(INSDS *ip, int insno)
+{
+  return ip != NULL && ip->prvact != NULL && ip->insno == insno;
+}
+
+/* splice ip into the active chain; score notes are placed after the
+   notes with a lower or equal p1, MIDI notes at the end of the group */
+static void act_link(CSOUND *csound, INSDS *ip, int append)
+{
+  int       insno = ip->insno;
+  ACT_INDEX *x = act_index(csound, insno);
+  ACT_GROUP *g = &x->groups[insno];
+  MYFLT     p1 = ip->p1.value;
+  ACT_KEY   *k = NULL;
+  INSDS     *prvp, *nxtp, *last = g->last;
+
+  if (LIKELY(!csound->ISSTRCOD(p1)))
+    k = act_key(csound, x, p1, 1);
+  else
+    append = 1;
+  if (last == NULL) {
+    prvp = act_prev_group(csound, x, insno);
+    append = 0;
+  }
+  else if (append)
+    prvp = last;
+  else if (k->last != NULL)
+    prvp = k->last;
+  else if (!g->mixed && !(last->p1.value > p1))
+    prvp = last;
+  else {
+    prvp = g->first->prvact;
+    for (nxtp = g->first;
+         act_in_group(nxtp, insno) && !(nxtp->p1.value > p1);
+         nxtp = nxtp->nxtact)
+      prvp = nxtp;
+  }
+  nxtp = prvp->nxtact;
+  ip->nxtact = nxtp;
+  ip->prvact = prvp;
+  prvp->nxtact = ip;
+  if (nxtp != NULL)
+    nxtp->prvact = ip;
+
+  if (last == NULL) {
+    g->first = g->last = ip;
+    x->used[insno >> 6] |= UINT64_C(1) << (insno & 63);
+  }
+  else {
+    if (nxtp == g->first)
+      g->first = ip;
+    if (prvp == last)
+      g->last = ip;
+  }
+  if (!append) {
+    if (k != NULL)
+      k->last = ip;
+  }
+  else {
+    ACT_KEY *lk = last->actkey;
+    if (k == NULL || last->actkey == NULL || p1 < last->p1.value)
+      g->mixed = 1;
+    if (lk != NULL && lk->last == last) {
+      if (k == NULL || p1 < lk->p1)
+        lk->last = NULL;
+      else if (k == lk)
+        lk->last = ip;
+    }
+  }
+  ip->actkey = k;
+  ip->nxtheld = NULL;
+  if (k != NULL)
+    k->count++;
+}
+
+/* take ip out of the active chain */
+static void act_unlink(CSOUND *csound, INSDS *ip)
+{
+  int       insno = ip->insno;
+  ACT_INDEX *x = csound->actindex;
+  ACT_GROUP *g = &x->groups[insno];
+  ACT_KEY   *k = ip->actkey;
+  INSDS     *prvp = ip->prvact, *nxtp = ip->nxtact;
+  int       pin = act_in_group(prvp, insno), nin = act_in_group(nxtp, insno);
+
+  if (k != NULL) {
+    INSDS **pp = &k->held;
+    if (k->last == ip)
+      k->last = (pin && prvp->actkey == k &&
+                 !(nin && !(nxtp->p1.value > k->p1))) ? prvp : NULL;
+    while (*pp != NULL && *pp != ip)
+      pp = &(*pp)->nxtheld;
+    if (*pp != NULL)
+      *pp = ip->nxtheld;
+    if (--k->count == 0)
+      act_key_release(x, k);
+  }
+  /* notes after ip with p1 not above prvp's now belong after prvp */
+  if (pin && nin && prvp->actkey != NULL && prvp->actkey->last == prvp &&
+      !(nxtp->p1.value > prvp->p1.value))
+    prvp->actkey->last = NULL;
+  if (g->first == ip)
+    g->first = nin ? nxtp : NULL;
+  if (g->last == ip)
+    g->last = pin ? prvp : NULL;
+  if (g->first == NULL) {
+    g->mixed = 0;
+    x->used[insno >> 6] &= ~(UINT64_C(1) << (insno & 63));
+  }
+  prvp->nxtact = nxtp;
+  if (nxtp != NULL)
+    nxtp->prvact = prvp;
+  ip->prvact = NULL;
+  ip->actkey = NULL;
+  ip->nxtheld = NULL;
+}
+
+/* record whether ip, just initialised, is an indefinite note */
+static void act_hold(INSDS *ip)
+{
+  INSDS **pp;
+  if (ip->actkey == NULL)
+    return;
+  pp = &ip->actkey->held;
+  while (*pp != NULL && *pp != ip)
+    pp = &(*pp)->nxtheld;
+  if (ip->offtim < 0.0) {
+    if (*pp == NULL) {
+      *pp = ip;
+      ip->nxtheld = NULL;
+    }
+  }
+  else if (*pp != NULL)
+    *pp = ip->nxtheld;
+}
+
+/* the oldest indefinite note of instr insno with this p1, if any */
+static INSDS *act_held(CSOUND *csound, int insno, MYFLT p1)
+{
+  ACT_KEY *k;
+  INSDS   **pp, *ip;
+  if (csound->actindex == NULL || csound->ISSTRCOD(p1) ||
+      (k = act_key(csound, csound->actindex, p1, 0)) == NULL)
+    return NULL;
+  for (pp = &k->held; (ip = *pp) != NULL; ) {
+    if (ip->offtim >= 0.0) {              /* released since */
+      *pp = ip->nxtheld;
+      ip->nxtheld = NULL;
+      continue;
+    }
+    if (ip->insno == insno &&
+        ip->instr == csound->engineState.instrtxtp[insno])
+      return ip;
+    pp = &ip->nxtheld;
+  }
+  return NULL;
+}
+
 /* insert an instr copy into active list */
 /*      then run an init pass            */
 int insert(CSOUND *csound, int insno, EVTBLK *newevtp) {
@@ -301,7 +599,7 @@ int insert(CSOUND *csound, int insno, EVTBLK *newevtp) {
 int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
 {
   INSTRTXT  *tp;
-  INSDS     *ip, *prvp, *nxtp;
+  INSDS     *ip;
   OPARMS    *O = csound->oparms;
   CS_VAR_MEM *pfields = NULL;        /* *** was uninitialised *** */
   int tie=0, i;
@@ -347,14 +645,11 @@ int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
     return(0);
   }
   /* if find this insno, active, with indef (tie) & matching p1 */
-  for (ip = tp->instance; ip != NULL; ip = ip->nxtinstance) {
-    if (ip->actflg && ip->offtim < 0.0 && ip->p1.value == newevtp->p[1]) {
-      csound->tieflag++;
-      ip->tieflag = 1;
-      tie = 1;
-      /* goto init; */ /*     continue that event */
-      break;
-    }
+  if ((ip = act_held(csound, insno, newevtp->p[1])) != NULL) {
+    csound->tieflag++;
+    ip->tieflag = 1;
+    tie = 1;
+    /* goto init; */ /*     continue that event */
   }
 
   if(!tie) {
@@ -389,17 +684,9 @@ int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
     tp->active++;
     tp->instcnt++;
     csound->dag_changed++;      /* Need to remake DAG */
-    nxtp = &(csound->actanchor);    /* now splice into activ lst */
-    while ((prvp = nxtp) && (nxtp = prvp->nxtact) != NULL) {
-      if (nxtp->insno > insno ||
-          (nxtp->insno == insno && nxtp->p1.value > newevtp->p[1])) {
-        nxtp->prvact = ip;
-        break;
-      }
-    }
-    ip->nxtact = nxtp;
-    ip->prvact = prvp;
-    prvp->nxtact = ip;
+    ip->dag_task = -1;          /* no edges yet */
+    ip->p1.value = newevtp->p[1];
+    act_link(csound, ip, 0);        /* now splice into activ lst */
     ip->tieflag = 0;
     ip->actflg++;                   /*    and mark the instr active */
   }
@@ -538,6 +825,7 @@ int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
     ip->offbet = -1.0;
     ip->offtim = -1.0;                        /*   else mark indef     */
   }
+  act_hold(ip);
   if (UNLIKELY(O->odebug)) {
     char *name = csound->engineState.instrtxtp[insno]->insname;
     if (UNLIKELY(name))
@@ -574,7 +862,7 @@ int MIDIinsert(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep) {
 int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
 {
   INSTRTXT  *tp;
-  INSDS     *ip, **ipp, *prvp, *nxtp;
+  INSDS     *ip, **ipp, *prvp;
   OPARMS    *O = csound->oparms;
   CS_VAR_MEM *pfields;
   EVTBLK  *evt;
@@ -647,16 +935,9 @@ int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
   /* turned off first as well */
   ip->nxtolap = NULL;
 
-  nxtp = &(csound->actanchor);          /* now splice into activ lst */
-  while ((prvp = nxtp) && (nxtp = prvp->nxtact) != NULL) {
-    if (nxtp->insno > insno) {
-      nxtp->prvact = ip;
-      break;
-    }
-  }
-  ip->nxtact       = nxtp;
-  ip->prvact       = prvp;
-  prvp->nxtact     = ip;
+  ip->dag_task = -1;                    /* no DAG edges yet */
+  ip->p1.value     = (MYFLT) insno;
+  act_link(csound, ip, 1);              /* now splice into activ lst */
   ip->actflg++;                         /* and mark the instr active */
   ip->m_chnbp      = chn;               /* rec address of chnl ctrl blk */
   ip->m_pitch      = (unsigned char) mep->dat1;    /* rec MIDI data   */
@@ -666,6 +947,7 @@ int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
   ip->relesing     = 0;
   ip->offbet       = -1.0;
   ip->offtim       = -1.0;              /* set indef duration */
+  act_hold(ip);                         /* for ties and i -N */
   ip->opcod_iobufs = NULL;              /* IV - Sep 8 2002:            */
   ip->p1.value     = (MYFLT) insno;     /* set these required p-fields */
   ip->p2.value     = (MYFLT) (csound->icurTime/csound->esr - csound->timeOffs);
@@ -831,19 +1113,44 @@ static void showallocs(CSOUND *csound)      /* debugging aid */
                         (int) p->insno, (void*) p,
                         (void*) p->nxtinstance, (void*) p->prvinstance,
                         (void*) p->nxtact, (void*) p->prvact,
-                        (void*) p->nxtoff, p->actflg, p->offtim);
+                        (void*) p->offnode.next, p->actflg, p->offtim);
       } while ((p = p->nxtinstance) != NULL);
     }
 }
 
+/* the earliest note in the turnoff queue that may be due in the
+   current k-cycle, or NULL; the caller checks offtim or offbet */
+INSDS *first_turnoff(CSOUND *csound)
+{
+  CS_WHEEL_NODE *n;
+
+  if (csound->turnoffs == NULL)
+    return NULL;
+  n = cs_wheel_due(csound->turnoffs,
+                   (uint64_t) (csound->icurTime / csound->ksmps));
+  return n != NULL ? (INSDS *) n->value : NULL;
+}
+
 static void schedofftim(CSOUND *csound, INSDS *ip)
 {                               /* put an active instr into offtime list  */
-  INSDS *prvp, *nxtp;         /* called by insert() & midioff + xtratim */
+  CS_WHEEL_NODE *n = &ip->offnode;  /* called by insert() & midioff + xtratim */
 
-  if ((nxtp = csound->frstoff) == NULL ||
-      nxtp->offtim > ip->offtim) {            /*   set into       */
-    csound->frstoff = ip;                     /*   firstoff chain */
-    ip->nxtoff = nxtp;
+  if (UNLIKELY(csound->turnoffs == NULL))
+    csound->turnoffs = cs_wheel_create(csound);
+  n->value = ip;
+  if (csound->oparms_.Beatmode) {
+    /* the tempo may change, so all are due and sorted by beat */
+    n->tick = 0;
+    n->when = ip->offbet;
+  }
+  else {
+    /* a k-cycle early, so that rounding never makes a note late */
+    double k = ip->offtim * csound->ekr;
+    n->tick = k >= 1.0 ? (uint64_t) k - 1 : 0;
+    n->when = ip->offtim;
+  }
+  cs_wheel_insert(csound->turnoffs, n);
+  if (first_turnoff(csound) == ip) {
     /* IV - Feb 24 2006: check if this note already needs to be turned off */
     /* the following comparisons must match those in sensevents() */
 #ifdef BETA
@@ -869,26 +1176,21 @@ static void schedofftim(CSOUND *csound, INSDS *ip)
                                     (0.505 * csound->ksmps))/csound->esr));
 #endif
   }
-  else {
-    while ((prvp = nxtp)
-           && (nxtp = nxtp->nxtoff) != NULL
-           && ip->offtim >= nxtp->offtim);
-    prvp->nxtoff = ip;
-    ip->nxtoff = nxtp;
-  }
 }
 
 /* csound.c */
 extern  int     csoundDeinitialiseOpcodes(CSOUND *csound, INSDS *ip);
 int     useropcd(CSOUND *, UOPCODE*);
+void    udo_unbind_inputs(INSDS *);
 
 static void deact(CSOUND *csound, INSDS *ip)
 {                               /* unlink single instr from activ chain */
-  INSDS  *nxtp;               /*      and mark it inactive            */
+                                /*      and mark it inactive            */
   /*   close any files in fd chain        */
 
   if (ip->nxtd != NULL)
     csoundDeinitialiseOpcodes(csound, ip);
+  udo_unbind_inputs(ip);
   /* remove an active instrument */
   csound->engineState.instrtxtp[ip->insno]->active--;
   if (ip->xtratim > 0)
@@ -917,8 +1219,8 @@ static void deact(CSOUND *csound, INSDS *ip)
       csound->Message(csound, Str("removed instance of instr %d\n"), ip->insno);
   }
   /* IV - Oct 24 2002: ip->prvact may be NULL, so need to check */
-  if (ip->prvact && (nxtp = ip->prvact->nxtact = ip->nxtact) != NULL)
-    nxtp->prvact = ip->prvact;
+  if (ip->prvact)
+    act_unlink(csound, ip);
   ip->actflg = 0;
   /* link into free instance chain */
   /* This also destroys ip->nxtact causing loops */
@@ -928,6 +1230,8 @@ static void deact(CSOUND *csound, INSDS *ip)
   }
   if (ip->fdchp != NULL)
     fdchclose(csound, ip);
+  if (ip->region != NULL)
+    csoundRegionReset(csound, &ip->region);
   csound->dag_changed++;
 }
 
@@ -967,18 +1271,8 @@ void xturnoff(CSOUND *csound, INSDS *ip)  /* turnoff a particular insalloc  */
     }
   }
   /* remove from schedoff chain first if finite duration */
-  if (csound->frstoff != NULL && ip->offtim >= 0.0) {
-    INSDS *prvip;
-    prvip = csound->frstoff;
-    if (prvip == ip)
-      csound->frstoff = ip->nxtoff;
-    else {
-      while (prvip != NULL && prvip->nxtoff != ip)
-        prvip = prvip->nxtoff;
-      if (prvip != NULL)
-        prvip->nxtoff = ip->nxtoff;
-    }
-  }
+  if (ip->offnode.next != NULL)
+    cs_wheel_remove(csound->turnoffs, &ip->offnode);
   /* if extra time needed: schedoff at new time */
   if (ip->xtratim > 0) {
     set_xtratim(csound, ip);
@@ -1012,6 +1306,7 @@ void free_instr_var_memory(CSOUND* csound, INSDS* ip) {
   CS_VAR_POOL* pool = instrDef->varPool;
   CS_VARIABLE* current = pool->head;
 
+  udo_unbind_inputs(ip);
   while (current != NULL) {
     CS_TYPE* varType = current->varType;
     if (varType->freeVariableMemory != NULL) {
@@ -1025,47 +1320,29 @@ void free_instr_var_memory(CSOUND* csound, INSDS* ip) {
 void orcompact(CSOUND *csound)          /* free all inactive instr spaces */
 {
   INSTRTXT  *txtp;
-  INSDS     *ip, *nxtip, *prvip, **prvnxtloc;
+  INSDS     *ip;
   int       cnt = 0;
   for (txtp = &(csound->engineState.instxtanchor);
        txtp != NULL;  txtp = txtp->nxtinstxt) {
-    if ((ip = txtp->instance) != NULL) {        /* if instance exists */
-
-      prvip = NULL;
-      prvnxtloc = &txtp->instance;
-      do {
-        if (!ip->actflg) {
-          cnt++;
-          if (ip->opcod_iobufs && ip->insno > csound->engineState.maxinsno)
-            csound->Free(csound, ip->opcod_iobufs);   /* IV - Nov 10 2002 */
-          if (ip->fdchp != NULL)
-            fdchclose(csound, ip);
-          if (ip->auxchp != NULL)
-            auxchfree(csound, ip);
-          free_instr_var_memory(csound, ip);
-          if ((nxtip = ip->nxtinstance) != NULL)
-            nxtip->prvinstance = prvip;
-          *prvnxtloc = nxtip;
-          csound->Free(csound, (char *)ip);
-        }
-        else {
-          prvip = ip;
-          prvnxtloc = &ip->nxtinstance;
-        }
-      }
-      while ((ip = *prvnxtloc) != NULL);
-    }
-
-    /* IV - Oct 31 2002 */
-    if (!txtp->instance)
-      txtp->lst_instance = NULL;              /* find last alloc */
-    else {
-      ip = txtp->instance;
-      while (ip->nxtinstance) ip = ip->nxtinstance;
-      txtp->lst_instance = ip;
-    }
-
-    txtp->act_instance = NULL;                /* no free instances */
+    /* instances share slabs, so an instr's memory can only be
+       returned when none of its instances is active */
+    for (ip = txtp->instance; ip != NULL; ip = ip->nxtinstance)
+      if (ip->actflg)
+        break;
+    if (ip != NULL || txtp->instance == NULL)
+      continue;
+    for (ip = txtp->instance; ip != NULL; ip = ip->nxtinstance) {
+      cnt++;
+      if (ip->fdchp != NULL)
+        fdchclose(csound, ip);
+      if (ip->auxchp != NULL)
+        auxchfree(csound, ip);
+      csoundRegionFree(csound, &ip->region);
+      free_instr_var_memory(csound, ip);
+      if (ip->opcod_iobufs && ip->insno > csound->engineState.maxinsno)
+        csound->Free(csound, ip->opcod_iobufs);   /* IV - Nov 10 2002 */
+    }
+    free_instance_memory(csound, txtp);
   }
   /* check current items in deadpool to see if they need deleting */
   {
@@ -1098,21 +1375,15 @@ void infoff(CSOUND *csound, MYFLT p1)   /* turn off an indef copy of instr p1 */
   int   insno;
 
   insno = (int) p1;
-  if (LIKELY((ip = (csound->engineState.instrtxtp[insno])->instance) != NULL)) {
-    do {
-      if (ip->insno == insno          /* if find the insno */
-          && ip->actflg               /*      active       */
-          && ip->offtim < 0.0         /*  but indef, VL: currently this condition
-                                          cannot be removed, as it breaks turning
-                                          off extratime instances */
-          && ip->p1.value == p1) {
-        if (UNLIKELY(csound->oparms->odebug))
-          csound->Message(csound, "turning off inf copy of instr %d\n",
-                          insno);
-        xturnoff(csound, ip);
-        return;                       /*      turn it off  */
-      }
-    } while ((ip = ip->nxtinstance) != NULL);
+  /* if find the insno, active but indef (VL: currently the indef
+     condition cannot be removed, as it breaks turning off extratime
+     instances) */
+  if (LIKELY((ip = act_held(csound, insno, p1)) != NULL)) {
+    if (UNLIKELY(csound->oparms->odebug))
+      csound->Message(csound, "turning off inf copy of instr %d\n",
+                      insno);
+    xturnoff(csound, ip);
+    return;                           /*      turn it off  */
   }
   csound->Message(csound,
                   Str("could not find playing instr %f\n"),
@@ -1267,17 +1538,19 @@ int subinstrset_(CSOUND *csound, SUBINST *p, int instno)
   } ch;
   int str_cnt = 0, len = 0;
   char *argstr;
+  /* the strings live as long as the instance */
+  for (n = 1; (unsigned int) n < p->INOCOUNT; n++)
+    if (IS_STR_ARG(p->ar[inarg_ofs + n]))
+      len += strlen(((STRINGDAT *)p->ar[inarg_ofs + n])->data)+1;
+  if (len > 0)
+    p->ip->strarg = csoundInstanceAlloc(csound, p->ip, len);
+  len = 0;
   for (n = 1; (unsigned int) n < p->INOCOUNT; n++){
     if (IS_STR_ARG(p->ar[inarg_ofs + n])) {
       ch.d = SSTRCOD;
       ch.i = str_cnt & 0xffff;
       (pfield + n)->value = ch.d;
       argstr = ((STRINGDAT *)p->ar[inarg_ofs + n])->data;
-      if (str_cnt == 0)
-        p->ip->strarg = csound->Calloc(csound, strlen(argstr)+1);
-      else
-        p->ip->strarg = csound->ReAlloc(csound, p->ip->strarg,
-                                        len+strlen(argstr)+1);
       strcpy(p->ip->strarg + len, argstr);
       len += strlen(argstr)+1;
       str_cnt++;
@@ -1293,7 +1566,9 @@ int subinstrset_(CSOUND *csound, SUBINST *p, int instno)
   p->ip->init_done = 0;
   csound->ids = (OPDS *)p->ip;
   while ((csound->ids = csound->ids->nxti) != NULL) {
-    (*csound->ids->iopadr)(csound, csound->ids);
+    int error;
+    PROFILE_INIT(csound, csound->ids, error);
+    (void) error;
   }
   p->ip->init_done = 1;
   /* copy length related parameters back to caller instr */
@@ -1355,6 +1630,7 @@ int subinstrset(CSOUND *csound, SUBINST *p){
 
 */
 int useropcd1(CSOUND *, UOPCODE*), useropcd2(CSOUND *, UOPCODE*);
+int useropcd1_profile(CSOUND *, UOPCODE*), useropcd2_profile(CSOUND *, UOPCODE*);
 
 int useropcdset(CSOUND *csound, UOPCODE *p)
 {
@@ -1500,7 +1776,9 @@ int useropcdset(CSOUND *csound, UOPCODE *p)
   csound->ids = (OPDS *) (lcurip->nxti);
   ATOMIC_SET(p->ip->init_done, 0);
   while (csound->ids != NULL) {
-    (*csound->ids->iopadr)(csound, csound->ids);
+    int error;
+    PROFILE_INIT(csound, csound->ids, error);
+    (void) error;
     csound->ids = csound->ids->nxti;
   }
   ATOMIC_SET(p->ip->init_done, 1);
@@ -1519,11 +1797,13 @@ int useropcdset(CSOUND *csound, UOPCODE *p)
   if (local_ksmps != CS_KSMPS) {
     ksmps_scale = CS_KSMPS / local_ksmps;
     parent_ip->xtratim = lcurip->xtratim / ksmps_scale;
-    p->h.opadr = (SUBR) useropcd1;
+    p->h.opadr = (SUBR) (csound->profile != NULL ? useropcd1_profile
+                                                  : useropcd1);
   }
   else {
     parent_ip->xtratim = lcurip->xtratim;
-    p->h.opadr = (SUBR) useropcd2;
+    p->h.opadr = (SUBR) (csound->profile != NULL ? useropcd2_profile
+                                                  : useropcd2);
   }
   if (UNLIKELY(csound->oparms->odebug))
     csound->Message(csound, "EXTRATIM=> cur(%p): %d, parent(%p): %d\n",
@@ -1543,6 +1823,35 @@ int useropcd(CSOUND *csound, UOPCODE *p)
     return OK;
 }
 
+/* Array and string inputs that the UDO body never writes (see
+   udo_byref() in csound_orc_compile.c) are passed by pointing the
+   UDO's header at the caller's data instead of copying it.  The
+   header is refreshed every cycle, which follows any resizing by
+   the caller, and the UDO's own header is put back when the
+   instance is deactivated or freed. */
+
+typedef union {
+  ARRAYDAT  a;
+  STRINGDAT s;
+} UDO_BYREF;
+
+#define UDO_BYREF_SIZE(c) ((c) == 'S' ? sizeof(STRINGDAT) : sizeof(ARRAYDAT))
+
+void udo_unbind_inputs(INSDS *ip)
+{
+  OPCOD_IOBUFS *buf = (OPCOD_IOBUFS*) ip->opcod_iobufs;
+  char *byref = ip->instr != NULL ? ip->instr->udo_byref : NULL;
+  int i;
+
+  if (byref == NULL || buf == NULL || !buf->byref_bound)
+    return;
+  for (i = 0; i < buf->opcode_info->inchns; i++)
+    if (byref[i])
+      memcpy(buf->iobufp_ptrs[i + buf->opcode_info->outchns],
+             (UDO_BYREF*) buf->byref_save + i, UDO_BYREF_SIZE(byref[i]));
+  buf->byref_bound = 0;
+}
+
 /* IV - Sep 1 2002: new opcodes: xin, xout */
 
 int xinset(CSOUND *csound, XIN *p)
@@ -1552,6 +1861,7 @@ int xinset(CSOUND *csound, XIN *p)
   MYFLT **bufs, **tmp;
   int i;
   CS_VARIABLE* current;
+  char *byref;
 
   (void) csound;
   buf = (OPCOD_IOBUFS*) p->h.insdshead->opcod_iobufs;
@@ -1560,14 +1870,24 @@ int xinset(CSOUND *csound, XIN *p)
   tmp = buf->iobufp_ptrs; // this is used to record the UDO's internal vars
   // for copying at perf-time
   current = inm->in_arg_pool->head;
+  byref = p->h.insdshead->instr->udo_byref;
 
   for (i = 0; i < inm->inchns; i++) {
     void* in = (void*)bufs[i];
     void* out = (void*)p->args[i];
     tmp[i + inm->outchns] = out;
-    current->varType->copyValue(csound, out, in);
+    if (byref != NULL && byref[i]) {
+      /* put the UDO's own header aside the first time only (reinit) */
+      if (!buf->byref_bound)
+        memcpy((UDO_BYREF*) buf->byref_save + i, out, UDO_BYREF_SIZE(byref[i]));
+      memcpy(out, in, UDO_BYREF_SIZE(byref[i]));
+    }
+    else
+      current->varType->copyValue(csound, out, in);
     current = current->next;
   }
+  if (byref != NULL)
+    buf->byref_bound = 1;
 
   return OK;
 }
@@ -1686,30 +2006,25 @@ int nstrnumset_S(CSOUND *csound, NSTRNUM *p)
 void beatexpire(CSOUND *csound, double beat)
 {
   INSDS  *ip;
- strt:
-  if ((ip = csound->frstoff) != NULL && ip->offbet <= beat) {
-    do {
-      if (!ip->relesing && ip->xtratim) {
-        /* IV - Nov 30 2002: */
-        /*   allow extra time for finite length (p3 > 0) score notes */
-        set_xtratim(csound, ip);      /* enter release stage */
-        csound->frstoff = ip->nxtoff; /* update turnoff list */
+
+  while ((ip = first_turnoff(csound)) != NULL && ip->offbet <= beat) {
+    cs_wheel_remove(csound->turnoffs, &ip->offnode);
+    if (!ip->relesing && ip->xtratim) {
+      /* IV - Nov 30 2002: */
+      /*   allow extra time for finite length (p3 > 0) score notes */
+      set_xtratim(csound, ip);        /* enter release stage */
 #ifdef BETA
-        if (UNLIKELY(csound->oparms->odebug))
-          csound->Message(csound, "Calling schedofftim line %d\n", __LINE__);
+      if (UNLIKELY(csound->oparms->odebug))
+        csound->Message(csound, "Calling schedofftim line %d\n", __LINE__);
 #endif
-        schedofftim(csound, ip);
-        goto strt;                    /* and start again */
-      }
-      else
-        deact(csound, ip);    /* IV - Sep 5 2002: use deact() as it also */
-    }                         /* deactivates subinstrument instances */
-    while ((ip = ip->nxtoff) != NULL && ip->offbet <= beat);
-    csound->frstoff = ip;
-    if (UNLIKELY(csound->oparms->odebug)) {
-      csound->Message(csound, "deactivated all notes to beat %7.3f\n", beat);
-      csound->Message(csound, "frstoff = %p\n", (void*) csound->frstoff);
+      schedofftim(csound, ip);        /* update turnoff list */
     }
+    else
+      deact(csound, ip);    /* IV - Sep 5 2002: use deact() as it also */
+  }                         /* deactivates subinstrument instances */
+  if (UNLIKELY(csound->oparms->odebug)) {
+    csound->Message(csound, "deactivated all notes to beat %7.3f\n", beat);
+    csound->Message(csound, "frstoff = %p\n", (void*) first_turnoff(csound));
   }
 }
 
@@ -1723,32 +2038,25 @@ void timexpire(CSOUND *csound, double time)
 {
   INSDS  *ip;
 
- strt:
-  if ((ip = csound->frstoff) != NULL && ip->offtim <= time) {
-    do {
-      if (!ip->relesing && ip->xtratim) {
-        /* IV - Nov 30 2002: */
-        /*   allow extra time for finite length (p3 > 0) score notes */
-        set_xtratim(csound, ip);      /* enter release stage */
-        csound->frstoff = ip->nxtoff; /* update turnoff list */
+  while ((ip = first_turnoff(csound)) != NULL && ip->offtim <= time) {
+    cs_wheel_remove(csound->turnoffs, &ip->offnode);
+    if (!ip->relesing && ip->xtratim) {
+      /* IV - Nov 30 2002: */
+      /*   allow extra time for finite length (p3 > 0) score notes */
+      set_xtratim(csound, ip);        /* enter release stage */
 #ifdef BETA
-        if (UNLIKELY(csound->oparms->odebug))
-          csound->Message(csound, "Calling schedofftim line %d\n", __LINE__);
+      if (UNLIKELY(csound->oparms->odebug))
+        csound->Message(csound, "Calling schedofftim line %d\n", __LINE__);
 #endif
-        schedofftim(csound, ip);
-
-        goto strt;                    /* and start again */
-      }
-      else {
-        deact(csound, ip);    /* IV - Sep 5 2002: use deact() as it also */
-      }
-    }                         /* deactivates subinstrument instances */
-    while ((ip = ip->nxtoff) != NULL && ip->offtim <= time);
-    csound->frstoff = ip;
-    if (UNLIKELY(csound->oparms->odebug)) {
-      csound->Message(csound, "deactivated all notes to time %7.3f\n", time);
-      csound->Message(csound, "frstoff = %p\n", (void*) csound->frstoff);
+      schedofftim(csound, ip);        /* update turnoff list */
     }
+    else {
+      deact(csound, ip);    /* IV - Sep 5 2002: use deact() as it also */
+    }                       /* deactivates subinstrument instances */
+  }
+  if (UNLIKELY(csound->oparms->odebug)) {
+    csound->Message(csound, "deactivated all notes to time %7.3f\n", time);
+    csound->Message(csound, "frstoff = %p\n", (void*) first_turnoff(csound));
   }
 }
 
@@ -1863,7 +2171,8 @@ int subinstr(CSOUND *csound, SUBINST *p)
 
 /* IV - Sep 17 2002 -- case 1: local ksmps is used */
 
-int useropcd1(CSOUND *csound, UOPCODE *p)
+/* prof (a constant) times the opcodes of the body, see profile.c */
+PROFILE_INLINE int useropcd1_run(CSOUND *csound, UOPCODE *p, const int prof)
 {
   OPDS    *saved_pds = CS_PDS;
   int    g_ksmps, ofs, early, offset, i;
@@ -1872,6 +2181,7 @@ int useropcd1(CSOUND *csound, UOPCODE *p)
   INSDS    *this_instr = p->ip;
   MYFLT** internal_ptrs = p->buf->iobufp_ptrs;
   MYFLT** external_ptrs = p->ar;
+  char *byref;
   int done;
 
   done = ATOMIC_GET(p->ip->init_done);
@@ -1897,6 +2207,7 @@ int useropcd1(CSOUND *csound, UOPCODE *p)
   */
   this_instr->ksmps_offset = 0;
   this_instr->ksmps_no_end = 0;
+  byref = p->buf->byref_bound ? this_instr->instr->udo_byref : NULL;
 
   if (this_instr->ksmps == 1) {           /* special case for local kr == sr */
     do {
@@ -1914,7 +2225,10 @@ int useropcd1(CSOUND *csound, UOPCODE *p)
           // This one checks if an array has a subtype of 'i'
           void* in = (void*)external_ptrs[i + inm->outchns];
           void* out = (void*)internal_ptrs[i + inm->outchns];
-          current->varType->copyValue(csound, out, in);
+          if (byref != NULL && byref[i])
+            memcpy(out, in, UDO_BYREF_SIZE(byref[i]));
+          else
+            current->varType->copyValue(csound, out, in);
         } else if (current->varType == &CS_VAR_TYPE_A) {
           MYFLT* in = (void*)external_ptrs[i + inm->outchns];
           MYFLT* out = (void*)internal_ptrs[i + inm->outchns];
@@ -1946,7 +2260,7 @@ int useropcd1(CSOUND *csound, UOPCODE *p)
         CS_PDS->insdshead->pds = NULL;
         do {
           if(UNLIKELY(!ATOMIC_GET8(p->ip->actflg))) goto endop;
-          error = (*CS_PDS->opadr)(csound, CS_PDS);
+          PROFILE_PERF(csound, prof, CS_PDS, error);
           if (CS_PDS->insdshead->pds != NULL &&
               CS_PDS->insdshead->pds->insdshead) {
             CS_PDS = CS_PDS->insdshead->pds;
@@ -2024,7 +2338,10 @@ int useropcd1(CSOUND *csound, UOPCODE *p)
           // This one checks if an array has a subtype of 'i'
           void* in = (void*)external_ptrs[i + inm->outchns];
           void* out = (void*)internal_ptrs[i + inm->outchns];
-          current->varType->copyValue(csound, out, in);
+          if (byref != NULL && byref[i])
+            memcpy(out, in, UDO_BYREF_SIZE(byref[i]));
+          else
+            current->varType->copyValue(csound, out, in);
         } else if (current->varType == &CS_VAR_TYPE_A) {
           MYFLT* in = (void*)external_ptrs[i + inm->outchns];
           MYFLT* out = (void*)internal_ptrs[i + inm->outchns];
@@ -2057,7 +2374,7 @@ int useropcd1(CSOUND *csound, UOPCODE *p)
         CS_PDS->insdshead->pds = NULL;
         do {
           if(UNLIKELY(!ATOMIC_GET8(p->ip->actflg))) goto endop;
-          error = (*CS_PDS->opadr)(csound, CS_PDS);
+          PROFILE_PERF(csound, prof, CS_PDS, error);
           if (CS_PDS->insdshead->pds != NULL &&
               CS_PDS->insdshead->pds->insdshead) {
             CS_PDS = CS_PDS->insdshead->pds;
@@ -2171,7 +2488,7 @@ int useropcd1(CSOUND *csound, UOPCODE *p)
 
 /* IV - Sep 17 2002 -- case 2: simplified routine for no local ksmps */
 
-int useropcd2(CSOUND *csound, UOPCODE *p)
+PROFILE_INLINE int useropcd2_run(CSOUND *csound, UOPCODE *p, const int prof)
 {
   OPDS    *saved_pds = CS_PDS;
   MYFLT   **tmp;
@@ -2200,6 +2517,7 @@ int useropcd2(CSOUND *csound, UOPCODE *p)
 
   MYFLT** internal_ptrs = tmp;
   MYFLT** external_ptrs = p->ar;
+  char *byref = p->buf->byref_bound ? this_instr->instr->udo_byref : NULL;
 
   /* copy inputs */
   current = inm->in_arg_pool->head;
@@ -2214,8 +2532,10 @@ int useropcd2(CSOUND *csound, UOPCODE *p)
       } else {
         void* in = (void*)external_ptrs[i + inm->outchns];
         void* out = (void*)internal_ptrs[i + inm->outchns];
-        current->varType->copyValue(csound, out, in);
-        //                memcpy(out, in, p->buf->in_arg_sizes[i]);
+        if (byref != NULL && byref[i])
+          memcpy(out, in, UDO_BYREF_SIZE(byref[i]));
+        else
+          current->varType->copyValue(csound, out, in);
       }
     }
     current = current->next;
@@ -2227,7 +2547,7 @@ int useropcd2(CSOUND *csound, UOPCODE *p)
   CS_PDS->insdshead->pds = NULL;
   do {
     if(UNLIKELY(!ATOMIC_GET8(p->ip->actflg))) goto endop;
-    error = (*CS_PDS->opadr)(csound, CS_PDS);
+    PROFILE_PERF(csound, prof, CS_PDS, error);
     if (CS_PDS->insdshead->pds != NULL &&
         CS_PDS->insdshead->pds->insdshead) {
       CS_PDS = CS_PDS->insdshead->pds;
@@ -2272,6 +2592,26 @@ int useropcd2(CSOUND *csound, UOPCODE *p)
   return OK;
 }
 
+int useropcd1(CSOUND *csound, UOPCODE *p)
+{
+  return useropcd1_run(csound, p, 0);
+}
+
+int useropcd2(CSOUND *csound, UOPCODE *p)
+{
+  return useropcd2_run(csound, p, 0);
+}
+
+int useropcd1_profile(CSOUND *csound, UOPCODE *p)
+{
+  return useropcd1_run(csound, p, 1);
+}
+
+int useropcd2_profile(CSOUND *csound, UOPCODE *p)
+{
+  return useropcd2_run(csound, p, 1);
+}
+
 /* UTILITY FUNCTIONS FOR LABELS */
 
 int findLabelMemOffset(CSOUND* csound, INSTRTXT* ip, char* labelName) {
@@ -2294,9 +2634,52 @@ int findLabelMemOffset(CSOUND* csound, INSTRTXT* ip, char* labelName) {
 /* create instance of an instr template */
 /*   allocates and sets up all pntrs    */
 
-static void instance(CSOUND *csound, int insno)
+/*
+  The first instance of an instrument is laid out once, into an image
+  that is kept with the instrument (tp->tmpl) together with the offsets
+  of every pointer in it that points back into the instance (opcode
+  chains, insdshead, label links and args that are locals, pfields or
+  labels).  Further instances are a copy of the image with those
+  pointers moved by the distance between the image and the copy, and
+  are carved out of slabs holding several instances each, so that a
+  burst of new notes costs one allocation per slab rather than one per
+  note.  Slabs are only given back when the instrument is freed.
+*/
+
+#define INST_SLAB_MAX   (16)    /* instances per slab, at most */
+
+typedef struct inst_slab {
+  struct inst_slab *nxt;
+} INST_SLAB;
+
+typedef struct inst_tmpl {
+  char      *image;             /* the instance as laid out by instance() */
+  size_t    size;               /* bytes per instance, aligned */
+  size_t    *reloc;             /* offsets of the pointers into it */
+  int       nreloc, maxreloc;
+  int       count;              /* instances allocated */
+  INST_SLAB *slabs;
+} INST_TMPL;
+
+#define INST_SLAB_HDR   CS_FLOAT_ALIGN(sizeof(INST_SLAB))
+
+/* records *p if it points into the image */
+static void tmpl_reloc(CSOUND *csound, INST_TMPL *t, void *p)
 {
-  INSTRTXT  *tp;
+  char *q = *(char **) p;
+  if (q < t->image || q >= t->image + t->size)
+    return;
+  if (t->nreloc == t->maxreloc) {
+    t->maxreloc = t->maxreloc ? t->maxreloc * 2 : 64;
+    t->reloc = (size_t *) csound->ReAlloc(csound, t->reloc,
+                                          t->maxreloc * sizeof(size_t));
+  }
+  t->reloc[t->nreloc++] = (size_t) ((char *) p - t->image);
+}
+
+static INST_TMPL *instance_template(CSOUND *csound, INSTRTXT *tp, int insno)
+{
+  INST_TMPL *t;
   INSDS     *ip;
   OPTXT     *optxt;
   OPDS      *opds, *prvids, *prvpds;
@@ -2306,6 +2689,7 @@ static void instance(CSOUND *csound, int insno)
   MYFLT     **argpp, *lclbas;
   CS_VAR_MEM *lcloffbas; // start of pfields
   char*     opMemStart;
+  size_t    size;
 
   OPARMS    *O = csound->oparms;
   int       odebug = O->odebug;
@@ -2313,7 +2697,6 @@ static void instance(CSOUND *csound, int insno)
   int       argStringCount;
   CS_VARIABLE* current;
 
-  tp = csound->engineState.instrtxtp[insno];
   n = 3;
   if (O->midiKey>n) n = O->midiKey;
   if (O->midiKeyCps>n) n = O->midiKeyCps;
@@ -2325,53 +2708,27 @@ static void instance(CSOUND *csound, int insno)
   pextrab = ((i = tp->pmax - 3L) > 0 ? (int) i * sizeof(CS_VAR_MEM) : 0);
   /* alloc new space,  */
   pextent = sizeof(INSDS) + pextrab + pextra*sizeof(CS_VAR_MEM);
-  ip =
-    (INSDS*) csound->Calloc(csound,
-                            (size_t) pextent + tp->varPool->poolSize +
-                            (tp->varPool->varCount *
-                             CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET)) +
-                            (tp->varPool->varCount * sizeof(CS_VARIABLE*)) +
-                            tp->opdstot);
+  size = (size_t) pextent + tp->varPool->poolSize +
+    (tp->varPool->varCount * CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET)) +
+    (tp->varPool->varCount * sizeof(CS_VARIABLE*)) + tp->opdstot;
+  t = (INST_TMPL *) csound->Calloc(csound, sizeof(INST_TMPL));
+  t->size = CS_FLOAT_ALIGN(size);
+  t->image = (char *) csound->Calloc(csound, t->size);
+  ip = (INSDS *) t->image;
   ip->csound = csound;
   ip->m_chnbp = (MCHNBLK*) NULL;
   ip->instr = tp;
-  /* IV - Oct 26 2002: replaced with faster version (no search) */
-  ip->prvinstance = tp->lst_instance;
-  if (tp->lst_instance)
-    tp->lst_instance->nxtinstance = ip;
-  else
-    tp->instance = ip;
-  tp->lst_instance = ip;
-  /* link into free instance chain */
-  ip->nxtact = tp->act_instance;
-  tp->act_instance = ip;
   ip->insno = insno;
-  if (UNLIKELY(csound->oparms->odebug))
-    csoundMessage(csound,"instance(): tp->act_instance = %p\n",
-                  tp->act_instance);
-
-
-  if (insno > csound->engineState.maxinsno) {
-    //      size_t pcnt = (size_t) tp->opcode_info->perf_incnt;
-    //      pcnt += (size_t) tp->opcode_info->perf_outcnt;
-    OPCODINFO* info = tp->opcode_info;
-    size_t pcnt = sizeof(OPCOD_IOBUFS) +
-      sizeof(MYFLT*) * (info->inchns + info->outchns);
-    ip->opcod_iobufs = (void*) csound->Malloc(csound, pcnt);
-  }
 
   /* gbloffbas = csound->globalVarPool; */
   lcloffbas = (CS_VAR_MEM*)&ip->p0;
   lclbas = (MYFLT*) ((char*) ip + pextent);   /* split local space */
-  initializeVarPool((void *)csound, lclbas, tp->varPool);
+  ip->lclbas = lclbas;
+  tmpl_reloc(csound, t, &ip->lclbas);
 
   opMemStart = nxtopds = (char*) lclbas + tp->varPool->poolSize +
     (tp->varPool->varCount * CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET));
   opdslim = nxtopds + tp->opdstot;
-  if (UNLIKELY(odebug))
-    csound->Message(csound,
-                    Str("instr %d allocated at %p\n\tlclbas %p, opds %p\n"),
-                    insno, ip, lclbas, nxtopds);
   optxt = (OPTXT*) tp;
   prvids = prvpds = (OPDS*) ip;
   //    prvids->insdshead = ip;
@@ -2396,37 +2753,45 @@ static void instance(CSOUND *csound, int insno)
       ip->p1.value = (MYFLT) insno;
       continue;
     }
-    if (UNLIKELY(odebug))
-      csound->Message(csound, Str("op (%s) allocated at %p\n"),
-                      ep->opname, opds);
     opds->optext = optxt;                     /* set common headata */
     opds->insdshead = ip;
+    tmpl_reloc(csound, t, &opds->insdshead);
     if (strcmp(ep->opname, "$label") == 0) {     /* LABEL:       */
       LBLBLK  *lblbp = (LBLBLK *) opds;
       lblbp->prvi = prvids;                   /*    save i/p links */
       lblbp->prvp = prvpds;
+      tmpl_reloc(csound, t, &lblbp->prvi);
+      tmpl_reloc(csound, t, &lblbp->prvp);
       continue;                               /*    for later refs */
     }
     // ******** This needs revisipn with no distinction between k- anda- rate ****
     if ((ep->thread & 07) == 0) {             /* thread 1 OR 2:  */
       if (ttp->pftype == 'b') {
-        prvids = prvids->nxti = opds;
+        prvids->nxti = opds;
+        tmpl_reloc(csound, t, &prvids->nxti);
+        prvids = opds;
         opds->iopadr = ep->iopadr;
       }
       else {
-        prvpds = prvpds->nxtp = opds;
+        prvpds->nxtp = opds;
+        tmpl_reloc(csound, t, &prvpds->nxtp);
+        prvpds = opds;
         opds->opadr = ep->kopadr;
       }
       goto args;
     }
     if ((ep->thread & 01) != 0) {             /* thread 1:        */
-      prvids = prvids->nxti = opds;           /* link into ichain */
+      prvids->nxti = opds;                    /* link into ichain */
+      tmpl_reloc(csound, t, &prvids->nxti);
+      prvids = opds;
       opds->iopadr = ep->iopadr;              /*   & set exec adr */
       if (UNLIKELY(opds->iopadr == NULL))
         csoundDie(csound, Str("null iopadr"));
     }
     if ((n = ep->thread & 06) != 0) {         /* thread 2 OR 4:   */
-      prvpds = prvpds->nxtp = opds;           /* link into pchain */
+      prvpds->nxtp = opds;                    /* link into pchain */
+      tmpl_reloc(csound, t, &prvpds->nxtp);
+      prvpds = opds;
       if (!(n & 04) ||
           ((ttp->pftype == 'k' || ttp->pftype == 'c') && ep->kopadr != NULL))
         opds->opadr = ep->kopadr;             /*      krate or    */
@@ -2462,6 +2827,7 @@ static void instance(CSOUND *csound, int insno)
         fltp = NULL;
       }
       argpp[n] = fltp;
+      tmpl_reloc(csound, t, &argpp[n]);
       arg = arg->next;
     }
 
@@ -2471,7 +2837,6 @@ static void instance(CSOUND *csound, int insno)
       argpp[n] = NULL;
 
     arg = ttp->inArgs;
-    ip->lclbas = lclbas;
     for (; arg != NULL; n++, arg = arg->next) {
       CS_VARIABLE* var = (CS_VARIABLE*)(arg->argPtr);
       if (arg->type == ARG_CONSTANT) {
@@ -2499,29 +2864,141 @@ static void instance(CSOUND *csound, int insno)
         csound->Message(csound, Str("FIXME: instance unexpected arg: %d\n"),
                         arg->type);
       }
+      tmpl_reloc(csound, t, &argpp[n]);
     }
 
   }
 
+  if (UNLIKELY(nxtopds > opdslim))
+    csoundDie(csound, Str("inconsistent opds total"));
+  if (UNLIKELY(odebug))
+    csound->Message(csound, Str("instr %d template: %d bytes, %d pointers\n"),
+                    insno, (int) t->size, t->nreloc);
+  return t;
+}
+
+/* sets up a copy of the template at mem as a new, free instance */
+static void instance_init(CSOUND *csound, INSTRTXT *tp, int insno, char *mem)
+{
+  INST_TMPL *t = tp->tmpl;
+  uintptr_t delta = (uintptr_t) mem - (uintptr_t) t->image;
+  INSDS     *ip = (INSDS *) mem;
+  CS_VARIABLE *var;
+  int       i;
+
+  memcpy(mem, t->image, t->size);
+  for (i = 0; i < t->nreloc; i++) {
+    uintptr_t *p = (uintptr_t *) (mem + t->reloc[i]);
+    *p += delta;
+  }
+  ip->insno = insno;           /* named instrs may share a template */
+  /* IV - Oct 26 2002: replaced with faster version (no search) */
+  ip->prvinstance = tp->lst_instance;
+  if (tp->lst_instance)
+    tp->lst_instance->nxtinstance = ip;
+  else
+    tp->instance = ip;
+  tp->lst_instance = ip;
+  /* link into free instance chain */
+  ip->nxtact = tp->act_instance;
+  tp->act_instance = ip;
+  if (UNLIKELY(csound->oparms->odebug))
+    csoundMessage(csound,"instance(): tp->act_instance = %p\n",
+                  tp->act_instance);
+
+  if (insno > csound->engineState.maxinsno) {
+    //      size_t pcnt = (size_t) tp->opcode_info->perf_incnt;
+    //      pcnt += (size_t) tp->opcode_info->perf_outcnt;
+    OPCODINFO* info = tp->opcode_info;
+    size_t pcnt = sizeof(OPCOD_IOBUFS) +
+      sizeof(MYFLT*) * (info->inchns + info->outchns);
+    OPCOD_IOBUFS *buf;
+    buf = (OPCOD_IOBUFS*) csound->Malloc(csound,
+                                         pcnt + sizeof(UDO_BYREF) * info->inchns);
+    buf->byref_save = (char*) buf + pcnt;
+    buf->byref_bound = 0;
+    ip->opcod_iobufs = (void*) buf;
+  }
+  initializeVarPool((void *)csound, ip->lclbas, tp->varPool);
+  if (UNLIKELY(csound->oparms->odebug))
+    csound->Message(csound,
+                    Str("instr %d allocated at %p\n\tlclbas %p\n"),
+                    insno, ip, ip->lclbas);
+
   /* VL 13-12-13: point the memory to the local ksmps & kr variables,
      and initialise them */
-  CS_VARIABLE* var = csoundFindVariableWithName(csound,
-                                                ip->instr->varPool, "ksmps");
+  var = csoundFindVariableWithName(csound, tp->varPool, "ksmps");
   if (var) {
-    char* temp = (char*)(lclbas + var->memBlockIndex);
+    char* temp = (char*)(ip->lclbas + var->memBlockIndex);
     var->memBlock = (CS_VAR_MEM*)(temp - CS_VAR_TYPE_OFFSET);
     var->memBlock->value = csound->ksmps;
   }
-  var = csoundFindVariableWithName(csound, ip->instr->varPool, "kr");
+  var = csoundFindVariableWithName(csound, tp->varPool, "kr");
   if (var) {
-    char* temp = (char*)(lclbas + var->memBlockIndex);
+    char* temp = (char*)(ip->lclbas + var->memBlockIndex);
     var->memBlock = (CS_VAR_MEM*)(temp - CS_VAR_TYPE_OFFSET);
     var->memBlock->value = csound->ekr;
   }
+}
 
-  if (UNLIKELY(nxtopds > opdslim))
-    csoundDie(csound, Str("inconsistent opds total"));
+/* adds n free instances of instr insno, in one slab */
+static void instance_slab(CSOUND *csound, int insno, int n)
+{
+  INSTRTXT  *tp = csound->engineState.instrtxtp[insno];
+  INST_TMPL *t;
+  INST_SLAB *s;
+  char      *mem;
+
+  if (tp->tmpl == NULL)
+    tp->tmpl = instance_template(csound, tp, insno);
+  t = tp->tmpl;
+  s = (INST_SLAB *) csound->Malloc(csound, INST_SLAB_HDR + n * t->size);
+  s->nxt = t->slabs;
+  t->slabs = s;
+  t->count += n;
+  for (mem = (char *) s + INST_SLAB_HDR; n > 0; n--, mem += t->size)
+    instance_init(csound, tp, insno, mem);
+}
 
+/* adds at least one free instance of instr insno; the slabs double in
+   size as the instrument is used, up to INST_SLAB_MAX instances */
+static void instance(CSOUND *csound, int insno)
+{
+  INSTRTXT  *tp = csound->engineState.instrtxtp[insno];
+  int       n = tp->tmpl == NULL ? 1 : tp->tmpl->count;
+
+  instance_slab(csound, insno, n < 1 ? 1 : n > INST_SLAB_MAX ?
+                INST_SLAB_MAX : n);
+}
+
+/* makes sure instr insno has at least count instances */
+static void instance_reserve(CSOUND *csound, int insno, int count)
+{
+  INSTRTXT  *tp = csound->engineState.instrtxtp[insno];
+  int       n = count - (tp->tmpl == NULL ? 0 : tp->tmpl->count);
+
+  if (n > 0)
+    instance_slab(csound, insno, n);
+}
+
+/* frees the template and slabs of an instrument, once its instances
+   have been cleaned up */
+void free_instance_memory(CSOUND *csound, INSTRTXT *tp)
+{
+  INST_TMPL *t = tp->tmpl;
+
+  tp->instance = tp->lst_instance = tp->act_instance = NULL;
+  if (t == NULL)
+    return;
+  while (t->slabs != NULL) {
+    INST_SLAB *nxt = t->slabs->nxt;
+    csound->Free(csound, t->slabs);
+    t->slabs = nxt;
+  }
+  csound->Free(csound, t->reloc);
+  csound->Free(csound, t->image);
+  csound->Free(csound, t);
+  tp->tmpl = NULL;
 }
 
 int prealloc_(CSOUND *csound, AOP *p, int instname)
@@ -2542,8 +3019,8 @@ int prealloc_(CSOUND *csound, AOP *p, int instname)
     if (csound->oparms->realtime)
       csoundSpinLock(&csound->alloc_spinlock);
     a = (int) *p->a - csound->engineState.instrtxtp[n]->active;
-    for ( ; a > 0; a--)
-      instance(csound, n);
+    if (a > 0)
+      instance_slab(csound, n, a);
     if (csound->oparms->realtime)
       csoundSpinUnLock(&csound->alloc_spinlock);
     return OK;
@@ -2557,6 +3034,40 @@ int prealloc_S(CSOUND *csound, AOP *p){
   return prealloc_(csound,p,1);
 }
 
+/* makes sure every instr and UDO has at least count instances */
+static void prewarm_instances(CSOUND *csound, int count)
+{
+    ENGINE_STATE *es = &csound->engineState;
+    int     i, end;
+
+    if (es->instrtxtp == NULL)
+      return;
+    end = es->maxinsno < es->maxopcno ? es->maxopcno : es->maxinsno;
+    if (csound->oparms->realtime)
+      csoundSpinLock(&csound->alloc_spinlock);
+    for (i = 1; i <= end; i++)
+      if (es->instrtxtp[i] != NULL)
+        instance_reserve(csound, i, count);
+    if (csound->oparms->realtime)
+      csoundSpinUnLock(&csound->alloc_spinlock);
+}
+
+int prewarm(CSOUND *csound, AOP *p)
+{
+    prewarm_instances(csound, (int) *p->r);
+    return OK;
+}
+
+int csoundPrewarmInstances(CSOUND *csound, int count)
+{
+    if (UNLIKELY(csound->engineState.instrtxtp == NULL))
+      return CSOUND_ERROR;
+    csoundLockMutex(csound->API_lock);
+    prewarm_instances(csound, count);
+    csoundUnlockMutex(csound->API_lock);
+    return CSOUND_SUCCESS;
+}
+
 int delete_instr(CSOUND *csound, DELETEIN *p)
 {
   int       n;
@@ -2594,10 +3105,11 @@ int delete_instr(CSOUND *csound, DELETEIN *p)
       fdchclose(csound, active);
     if (active->auxchp != NULL)
       auxchfree(csound, active);
+    csoundRegionFree(csound, &active->region);
     free_instr_var_memory(csound, active);
-    csound->Free(csound, active);
     active = nxt;
   }
+  free_instance_memory(csound, ip);
   csound->engineState.instrtxtp[n] = NULL;
   /* Now patch it out */
   for (txtp = &(csound->engineState.instxtanchor);
@@ -27,6 +27,14 @@
 /* This code wraps malloc etc with maintaining a list of allocated memory
    so it can be freed on a reset.  It would not be necessary with a zoned
    allocator.
+
+   Blocks of up to MEM_SMALLMAX bytes are not linked individually: they
+   come in size classes out of large chunks, which are freed together on
+   a reset.  Freed blocks go to a cache of the freeing thread, and
+   move to the instance's free list per class, under a lock of its own,
+   in batches, and all of them when a thread made by csoundCreateThread()
+   ends; its cache then goes to the next new thread.  Larger blocks are
+   still malloc()ed one by one and kept in the list under memlock.
 */
 #if defined(BETA) && !defined(MEMDEBUG)
 #define MEMDEBUG  1
@@ -37,6 +45,14 @@
 #define CSOUND_MEM_SPINLOCK csoundSpinLock(&csound->memlock);
 #define CSOUND_MEM_SPINUNLOCK csoundSpinUnLock(&csound->memlock);
 
+#if !defined(MEMALLOC_NO_TLS)
+#  if defined(_MSC_VER)
+#    define MEM_TLS __declspec(thread)
+#  elif defined(__GNUC__)
+#    define MEM_TLS __thread
+#  endif
+#endif
+
 typedef struct memAllocBlock_s {
 #ifdef MEMDEBUG
     int                     magic;      /* 0x6D426C6B ("mBlk")          */
@@ -46,13 +62,93 @@ typedef struct memAllocBlock_s {
     struct memAllocBlock_s  *nxt;       /* next structure in chain      */
 } memAllocBlock_t;
 
+/* large blocks have their size and tag before the header; small ones
+   have prv == SMALL_MARK and their class and tag in nxt, which links
+   them while they are free */
+typedef struct {
+    size_t  size;
+    int     tag;
+} memLargeHdr_t;
+
 #define HDR_SIZE    (((int) sizeof(memAllocBlock_t) + 7) & (~7))
-#define ALLOC_BYTES(n)  ((size_t) HDR_SIZE + (size_t) (n))
+#define LHDR_SIZE   (((int) sizeof(memLargeHdr_t) + 15) & (~15))
+#define ALLOC_BYTES(n)  ((size_t) LHDR_SIZE + HDR_SIZE + (size_t) (n))
 #define DATA_PTR(p) ((void*) ((unsigned char*) (p) + (int) HDR_SIZE))
 #define HDR_PTR(p)  ((memAllocBlock_t*) ((unsigned char*) (p) - (int) HDR_SIZE))
+#define LHDR_PTR(h) ((memLargeHdr_t*) ((unsigned char*) (h) - LHDR_SIZE))
+#define BASE_HDR(b) ((memAllocBlock_t*) ((unsigned char*) (b) + LHDR_SIZE))
 
 #define MEMALLOC_DB (csound->memalloc_db)
 
+#define MEM_NCLASS    24
+#define MEM_SMALLMAX  2048
+#define MEM_CHUNK     65536
+#define MEM_TLSLOTS   4
+
+static const int classize[MEM_NCLASS] = {
+    16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256,
+    320, 384, 448, 512, 640, 768, 896, 1024, 1280, 1536, 1792, 2048
+};
+
+static char small_mark;
+#define SMALL_MARK  ((memAllocBlock_t*) &small_mark)
+#define SMALL_INFO(cls, tag) \
+    ((memAllocBlock_t*) (uintptr_t) ((cls) | ((tag) << 8)))
+#define SMALL_CLS(h)  ((int) ((uintptr_t) (h)->nxt & 0xFF))
+#define SMALL_TAG(h)  ((int) ((uintptr_t) (h)->nxt >> 8))
+#define BLK_BYTES(c)  ((size_t) HDR_SIZE + (size_t) classize[c])
+
+typedef struct {
+    int64_t   allocs, frees, bytes;
+} memStat_t;
+
+/* a thread's blocks of one Csound instance */
+typedef struct memCache_s {
+    struct memCache_s *nxt;
+    void              *owner;           /* the thread's TLS slots       */
+    memAllocBlock_t   *head[MEM_NCLASS];
+    int               cnt[MEM_NCLASS];
+    memStat_t         stat[CS_MEM_NTAGS];
+} memCache_t;
+
+typedef struct memChunk_s {
+    struct memChunk_s *nxt;
+} memChunk_t;
+
+typedef struct memPool_s {
+    int32_t           id;               /* unique over all instances    */
+    spin_lock_t       lock[MEM_NCLASS];
+    memAllocBlock_t   *head[MEM_NCLASS];
+    spin_lock_t       chunklock;        /* for the fields below         */
+    memChunk_t        *chunks;
+    unsigned char     *bump, *bumpend;
+    memCache_t        *caches;
+    memStat_t         stat[CS_MEM_NTAGS]; /* large blocks, under memlock  */
+    struct memPool_s  *nxtpool;         /* list of live pools           */
+} memPool_t;
+
+#define MEM_CHUNK_HDR ((sizeof(memChunk_t) + 15) & ~((size_t) 15))
+
+static volatile int32_t mem_ids = 0;
+
+#ifdef MEM_TLS
+static MEM_TLS struct {
+    int32_t     id;
+    memCache_t  *cache;
+} mem_slot[MEM_TLSLOTS];
+static MEM_TLS int  mem_nxtslot;
+static MEM_TLS int  mem_tag;
+/* the pools of all instances, for threads that end */
+static spin_lock_t  mem_poolslock = SPINLOCK_INIT;
+static memPool_t    *mem_pools = NULL;
+#else
+static int          mem_tag;
+#endif
+
+static const char *tagnames[CS_MEM_NTAGS] = {
+    "other", "compiler", "init", "perf", "aux", "strings", "regions"
+};
+
 static void memdie(CSOUND *csound, size_t nbytes)
 {
     csound->ErrorMsg(csound, Str("memory allocate failure for %zd"),
@@ -60,73 +156,356 @@ static void memdie(CSOUND *csound, size_t nbytes)
     csound->LongJmp(csound, CSOUND_MEMORY);
 }
 
-void *mmalloc(CSOUND *csound, size_t size)
+static inline int size_class(size_t size)
 {
-    void  *p;
+    int c;
+    if (size <= 128)
+      return (int) ((size + 15) >> 4) - (size != 0);
+    for (c = 8; classize[c] < (int) size; c++)
+      ;
+    return c;
+}
 
-#ifdef MEMDEBUG
-    if (UNLIKELY(size == (size_t) 0)) {
-      csound->DebugMsg(csound,
-              " *** internal error: mmalloc() called with zero nbytes\n");
-      return NULL;
-    }
+static memPool_t *mem_pool(CSOUND *csound)
+{
+    memPool_t *pool = (memPool_t*) csound->memalloc_pool;
+    int       i;
+
+    if (LIKELY(pool != NULL))
+      return pool;
+    CSOUND_MEM_SPINLOCK
+    if ((pool = (memPool_t*) csound->memalloc_pool) == NULL) {
+      pool = (memPool_t*) calloc(1, sizeof(memPool_t));
+      if (UNLIKELY(pool == NULL)) {
+        CSOUND_MEM_SPINUNLOCK
+        memdie(csound, sizeof(memPool_t));
+      }
+      do {                              /* 0 marks a free TLS slot */
+        pool->id = ATOMIC_INCR(mem_ids);
+      } while (pool->id == 0);
+      for (i = 0; i < MEM_NCLASS; i++)
+        csoundSpinLockInit(&pool->lock[i]);
+      csoundSpinLockInit(&pool->chunklock);
+#ifdef MEM_TLS
+      csoundSpinLock(&mem_poolslock);
+      pool->nxtpool = mem_pools;
+      mem_pools = pool;
+      csoundSpinUnLock(&mem_poolslock);
 #endif
+      csound->memalloc_pool = pool;
+    }
+    CSOUND_MEM_SPINUNLOCK
+    return pool;
+}
+
+/* n new blocks of class cls, linked through nxt */
+
+static memAllocBlock_t *carve(CSOUND *csound, memPool_t *pool, int cls, int n)
+{
+    size_t          bsize = BLK_BYTES(cls);
+    memAllocBlock_t *head = NULL, *h;
+
+    csoundSpinLock(&pool->chunklock);
+    while (n--) {
+      if ((size_t) (pool->bumpend - pool->bump) < bsize) {
+        memChunk_t *c = (memChunk_t*) malloc(MEM_CHUNK);
+        if (UNLIKELY(c == NULL)) {
+          csoundSpinUnLock(&pool->chunklock);
+          if (head != NULL)
+            break;
+          memdie(csound, bsize);
+        }
+        c->nxt = pool->chunks;
+        pool->chunks = c;
+        pool->bump = (unsigned char*) c + MEM_CHUNK_HDR;
+        pool->bumpend = (unsigned char*) c + MEM_CHUNK;
+      }
+      h = (memAllocBlock_t*) pool->bump;
+      pool->bump += bsize;
+      h->prv = SMALL_MARK;
+      h->nxt = head;
+      head = h;
+    }
+    csoundSpinUnLock(&pool->chunklock);
+    return head;
+}
+
+static inline int batch_size(int cls)
+{
+    int n = 8192 / (int) BLK_BYTES(cls);
+    return n < 2 ? 2 : n > 32 ? 32 : n;
+}
+
+#ifdef MEM_TLS
+
+static memCache_t *thread_cache(CSOUND *csound, memPool_t *pool)
+{
+    memCache_t  *c;
+    int         i;
+
+    for (i = 0; i < MEM_TLSLOTS; i++)
+      if (mem_slot[i].id == pool->id)
+        return mem_slot[i].cache;
+    /* this thread may have had a cache before its slot was reused */
+    csoundSpinLock(&pool->chunklock);
+    for (c = pool->caches; c != NULL; c = c->nxt)
+      if (c->owner == (void*) mem_slot)
+        break;
+    if (c == NULL) {
+      /* else the cache of a thread that has ended, or a new one */
+      for (c = pool->caches; c != NULL; c = c->nxt)
+        if (c->owner == NULL)
+          break;
+      if (c == NULL) {
+        c = (memCache_t*) calloc(1, sizeof(memCache_t));
+        if (UNLIKELY(c == NULL)) {
+          csoundSpinUnLock(&pool->chunklock);
+          memdie(csound, sizeof(memCache_t));
+        }
+        c->nxt = pool->caches;
+        pool->caches = c;
+      }
+      c->owner = (void*) mem_slot;
+    }
+    csoundSpinUnLock(&pool->chunklock);
+    i = mem_nxtslot++ & (MEM_TLSLOTS - 1);
+    mem_slot[i].id = pool->id;
+    mem_slot[i].cache = c;
+    return c;
+}
+
+static void *small_alloc(CSOUND *csound, int cls, int tag)
+{
+    memPool_t       *pool = mem_pool(csound);
+    memCache_t      *c = thread_cache(csound, pool);
+    memAllocBlock_t *h;
+
+    if (UNLIKELY((h = c->head[cls]) == NULL)) {
+      /* refill from the instance's free list, or new blocks */
+      int n = batch_size(cls), k = 0;
+      memAllocBlock_t *last = NULL;
+      csoundSpinLock(&pool->lock[cls]);
+      for (h = pool->head[cls]; h != NULL && k < n; k++)
+        last = h, h = h->nxt;
+      if (k > 0) {
+        c->head[cls] = pool->head[cls];
+        pool->head[cls] = h;
+        last->nxt = NULL;
+      }
+      csoundSpinUnLock(&pool->lock[cls]);
+      if (k == 0) {
+        c->head[cls] = carve(csound, pool, cls, n);
+        for (h = c->head[cls]; h != NULL; h = h->nxt)
+          k++;
+      }
+      c->cnt[cls] = k;
+      h = c->head[cls];
+    }
+    c->head[cls] = h->nxt;
+    c->cnt[cls]--;
+    c->stat[tag].allocs++;
+    c->stat[tag].bytes += classize[cls];
+    h->nxt = SMALL_INFO(cls, tag);
+    return DATA_PTR(h);
+}
+
+static void small_free(CSOUND *csound, memAllocBlock_t *h)
+{
+    memPool_t   *pool = mem_pool(csound);
+    memCache_t  *c = thread_cache(csound, pool);
+    int         cls = SMALL_CLS(h), tag = SMALL_TAG(h);
+
+    c->stat[tag].frees++;
+    c->stat[tag].bytes -= classize[cls];
+    h->nxt = c->head[cls];
+    c->head[cls] = h;
+    if (UNLIKELY(++c->cnt[cls] >= 2 * batch_size(cls))) {
+      /* give a batch back to the instance */
+      int n = batch_size(cls), k;
+      memAllocBlock_t *first = c->head[cls], *last = first;
+      for (k = 1; k < n; k++)
+        last = last->nxt;
+      c->head[cls] = last->nxt;
+      c->cnt[cls] -= n;
+      csoundSpinLock(&pool->lock[cls]);
+      last->nxt = pool->head[cls];
+      pool->head[cls] = first;
+      csoundSpinUnLock(&pool->lock[cls]);
+    }
+}
+
+/* called by threads made with csoundCreateThread() as they end: the
+   thread's blocks go back to the free lists, and its caches are left
+   for new threads */
+
+void memalloc_thread_exit(void)
+{
+    memPool_t   *pool;
+    memCache_t  *c;
+    int         cls, i;
+
+    csoundSpinLock(&mem_poolslock);
+    for (pool = mem_pools; pool != NULL; pool = pool->nxtpool) {
+      csoundSpinLock(&pool->chunklock);
+      for (c = pool->caches; c != NULL; c = c->nxt)
+        if (c->owner == (void*) mem_slot)
+          break;
+      csoundSpinUnLock(&pool->chunklock);
+      if (c == NULL)
+        continue;
+      for (cls = 0; cls < MEM_NCLASS; cls++) {
+        memAllocBlock_t *last = c->head[cls];
+        if (last == NULL)
+          continue;
+        while (last->nxt != NULL)
+          last = last->nxt;
+        csoundSpinLock(&pool->lock[cls]);
+        last->nxt = pool->head[cls];
+        pool->head[cls] = c->head[cls];
+        csoundSpinUnLock(&pool->lock[cls]);
+        c->head[cls] = NULL;
+        c->cnt[cls] = 0;
+      }
+      csoundSpinLock(&pool->chunklock);
+      c->owner = NULL;
+      csoundSpinUnLock(&pool->chunklock);
+    }
+    csoundSpinUnLock(&mem_poolslock);
+    for (i = 0; i < MEM_TLSLOTS; i++)
+      mem_slot[i].id = 0;
+}
+
+#else   /* no thread local storage: straight to the free lists */
+
+static void *small_alloc(CSOUND *csound, int cls, int tag)
+{
+    memPool_t       *pool = mem_pool(csound);
+    memAllocBlock_t *h, *last;
+
+    csoundSpinLock(&pool->lock[cls]);
+    if (UNLIKELY((h = pool->head[cls]) == NULL)) {
+      csoundSpinUnLock(&pool->lock[cls]);
+      h = carve(csound, pool, cls, batch_size(cls));
+      /* keep one, the rest go on top of what was freed meanwhile */
+      if (h->nxt != NULL) {
+        for (last = h->nxt; last->nxt != NULL; last = last->nxt)
+          ;
+        csoundSpinLock(&pool->lock[cls]);
+        last->nxt = pool->head[cls];
+        pool->head[cls] = h->nxt;
+        csoundSpinUnLock(&pool->lock[cls]);
+      }
+    }
+    else {
+      pool->head[cls] = h->nxt;
+      csoundSpinUnLock(&pool->lock[cls]);
+    }
+    CSOUND_MEM_SPINLOCK
+    pool->stat[tag].allocs++;
+    pool->stat[tag].bytes += classize[cls];
+    CSOUND_MEM_SPINUNLOCK
+    h->nxt = SMALL_INFO(cls, tag);
+    return DATA_PTR(h);
+}
+
+static void small_free(CSOUND *csound, memAllocBlock_t *h)
+{
+    memPool_t   *pool = mem_pool(csound);
+    int         cls = SMALL_CLS(h), tag = SMALL_TAG(h);
+
+    CSOUND_MEM_SPINLOCK
+    pool->stat[tag].frees++;
+    pool->stat[tag].bytes -= classize[cls];
+    CSOUND_MEM_SPINUNLOCK
+    csoundSpinLock(&pool->lock[cls]);
+    h->nxt = pool->head[cls];
+    pool->head[cls] = h;
+    csoundSpinUnLock(&pool->lock[cls]);
+}
+
+void memalloc_thread_exit(void)
+{
+}
+
+#endif  /* MEM_TLS */
+
+static void *large_alloc(CSOUND *csound, size_t size, int tag, int zero)
+{
+    memPool_t       *pool = mem_pool(csound);
+    void            *b;
+    memAllocBlock_t *p;
+
     /* allocate memory */
-    if (UNLIKELY((p = malloc(ALLOC_BYTES(size))) == NULL)) {
-        memdie(csound, size);     /* does a long jump */
+    b = zero ? calloc(ALLOC_BYTES(size), (size_t) 1) : malloc(ALLOC_BYTES(size));
+    if (UNLIKELY(b == NULL)) {
+      memdie(csound, size);     /* does a long jump */
     }
+    p = BASE_HDR(b);
+    LHDR_PTR(p)->size = size;
+    LHDR_PTR(p)->tag = tag;
     /* link into chain */
-#ifdef MEMDEBUG
-    ((memAllocBlock_t*) p)->magic = MEMALLOC_MAGIC;
-    ((memAllocBlock_t*) p)->ptr = DATA_PTR(p);
-#endif
     CSOUND_MEM_SPINLOCK
-    ((memAllocBlock_t*) p)->prv = (memAllocBlock_t*) NULL;
-    ((memAllocBlock_t*) p)->nxt = (memAllocBlock_t*) MEMALLOC_DB;
+    p->prv = (memAllocBlock_t*) NULL;
+    p->nxt = (memAllocBlock_t*) MEMALLOC_DB;
     if (MEMALLOC_DB != NULL)
-      ((memAllocBlock_t*) MEMALLOC_DB)->prv = (memAllocBlock_t*) p;
+      ((memAllocBlock_t*) MEMALLOC_DB)->prv = p;
     MEMALLOC_DB = (void*) p;
+    pool->stat[tag].allocs++;
+    pool->stat[tag].bytes += size;
     CSOUND_MEM_SPINUNLOCK
-    /* return with data pointer */
     return DATA_PTR(p);
 }
 
-void *mmallocDebug(CSOUND *csound, size_t size, char *file, int line)
-{
-    void *ans = mmalloc(csound,size);
-    printf("Alloc %p (%zu) %s:%d\n", ans, size, file, line);
-    return ans;
-}
-
-void *mcalloc(CSOUND *csound, size_t size)
+static void *mem_alloc(CSOUND *csound, size_t size, int tag, int zero)
 {
     void  *p;
 
 #ifdef MEMDEBUG
     if (UNLIKELY(size == (size_t) 0)) {
       csound->DebugMsg(csound,
-              " *** internal error: csound->Calloc() called with zero nbytes\n");
+              " *** internal error: mmalloc() called with zero nbytes\n");
       return NULL;
     }
 #endif
-    /* allocate memory */
-    if (UNLIKELY((p = calloc(ALLOC_BYTES(size), (size_t) 1)) == NULL)) {
-      memdie(csound, size);     /* does longjump */
+    if (size <= MEM_SMALLMAX) {
+      int cls = size_class(size);
+      p = small_alloc(csound, cls, tag);
+      if (zero)
+        memset(p, 0, classize[cls]);
     }
-    /* link into chain */
+    else
+      p = large_alloc(csound, size, tag, zero);
 #ifdef MEMDEBUG
-    ((memAllocBlock_t*) p)->magic = MEMALLOC_MAGIC;
-    ((memAllocBlock_t*) p)->ptr = DATA_PTR(p);
+    HDR_PTR(p)->magic = MEMALLOC_MAGIC;
+    HDR_PTR(p)->ptr = p;
 #endif
-    CSOUND_MEM_SPINLOCK
-    ((memAllocBlock_t*) p)->prv = (memAllocBlock_t*) NULL;
-    ((memAllocBlock_t*) p)->nxt = (memAllocBlock_t*) MEMALLOC_DB;
-    if (MEMALLOC_DB != NULL)
-      ((memAllocBlock_t*) MEMALLOC_DB)->prv = (memAllocBlock_t*) p;
-    MEMALLOC_DB = (void*) p;
-    CSOUND_MEM_SPINUNLOCK
     /* return with data pointer */
-    return DATA_PTR(p);
+    return p;
+}
+
+void *mmalloc(CSOUND *csound, size_t size)
+{
+#ifdef MEM_TLS
+    return mem_alloc(csound, size, mem_tag, 0);
+#else
+    return mem_alloc(csound, size, CS_MEM_OTHER, 0);
+#endif
+}
+
+void *mmallocDebug(CSOUND *csound, size_t size, char *file, int line)
+{
+    void *ans = mmalloc(csound,size);
+    printf("Alloc %p (%zu) %s:%d\n", ans, size, file, line);
+    return ans;
+}
+
+void *mcalloc(CSOUND *csound, size_t size)
+{
+#ifdef MEM_TLS
+    return mem_alloc(csound, size, mem_tag, 1);
+#else
+    return mem_alloc(csound, size, CS_MEM_OTHER, 1);
+#endif
 }
 
 void *mcallocDebug(CSOUND *csound, size_t size, char *file, int line)
@@ -136,6 +515,28 @@ void *mcallocDebug(CSOUND *csound, size_t size, char *file, int line)
     return ans;
 }
 
+/* as mmalloc() and mcalloc(), counted against subsystem tag rather
+   than the thread's current one */
+
+void *mmalloc_tag(CSOUND *csound, size_t size, int tag)
+{
+    return mem_alloc(csound, size, tag, 0);
+}
+
+void *mcalloc_tag(CSOUND *csound, size_t size, int tag)
+{
+    return mem_alloc(csound, size, tag, 1);
+}
+
+/* sets the subsystem this thread's allocations are counted against,
+   and returns the previous one */
+
+int memalloc_tag(int tag)
+{
+    int old = mem_tag;
+    mem_tag = tag;
+    return old;
+}
 
 void mfree(CSOUND *csound, void *p)
 {
@@ -157,6 +558,12 @@ void mfree(CSOUND *csound, void *p)
     }
     pp->magic = 0;
  #endif
+    if (pp->prv == SMALL_MARK) {
+      small_free(csound, pp);
+      return;
+    }
+    if (LHDR_PTR(pp)->tag == CS_MEM_AUX)        /* may be a pooled space */
+      auxForget(csound, p, LHDR_PTR(pp)->size);
     CSOUND_MEM_SPINLOCK
     /* unlink from chain */
     {
@@ -168,10 +575,16 @@ void mfree(CSOUND *csound, void *p)
       else
         MEMALLOC_DB = (void*)nxt;
     }
+    {
+      memPool_t *pool = (memPool_t*) csound->memalloc_pool;
+      int       tag = LHDR_PTR(pp)->tag;
+      pool->stat[tag].frees++;
+      pool->stat[tag].bytes -= LHDR_PTR(pp)->size;
+    }
+    CSOUND_MEM_SPINUNLOCK
     //csound->Message(csound, "free\n");
     /* free memory */
-    free((void*) pp);
-    CSOUND_MEM_SPINUNLOCK
+    free((void*) LHDR_PTR(pp));
 }
 
 void mfreeDebug(CSOUND *csound, void *ans, char *file, int line)
@@ -183,7 +596,10 @@ void mfreeDebug(CSOUND *csound, void *ans, char *file, int line)
 void *mrealloc(CSOUND *csound, void *oldp, size_t size)
 {
     memAllocBlock_t *pp;
+    memLargeHdr_t   *lp;
     void            *p;
+    size_t          oldsize;
+    int             tag;
 
     if (UNLIKELY(oldp == NULL))
       return mmalloc(csound, size);
@@ -200,26 +616,43 @@ void *mrealloc(CSOUND *csound, void *oldp, size_t size)
       /* as a result of a bug */
       exit(-1);
     }
+#endif
+    if (pp->prv == SMALL_MARK) {
+      /* a small block is kept if it is big enough, else moved */
+      oldsize = (size_t) classize[SMALL_CLS(pp)];
+      if (size <= oldsize)
+        return oldp;
+      p = mem_alloc(csound, size, SMALL_TAG(pp), 0);
+      memcpy(p, oldp, oldsize);
+      mfree(csound, oldp);
+      return p;
+    }
+#ifdef MEMDEBUG
     /* mark old header as invalid */
     pp->magic = 0;
     pp->ptr = NULL;
 #endif
-    /* allocate memory */
-    p = realloc((void*) pp, ALLOC_BYTES(size));
+    lp = LHDR_PTR(pp);
+    oldsize = lp->size;
+    tag = lp->tag;
+    if (tag == CS_MEM_AUX)
+      auxForget(csound, oldp, oldsize);
+    /* allocate memory; the chain is locked while the block may move */
+    CSOUND_MEM_SPINLOCK
+    p = realloc((void*) lp, ALLOC_BYTES(size));
     if (UNLIKELY(p == NULL)) {
 #ifdef MEMDEBUG
-      CSOUND_MEM_SPINLOCK
       /* alloc failed, restore original header */
       pp->magic = MEMALLOC_MAGIC;
       pp->ptr = oldp;
-      CSOUND_MEM_SPINUNLOCK
 #endif
+      CSOUND_MEM_SPINUNLOCK
       memdie(csound, size);
       return NULL;
     }
-    CSOUND_MEM_SPINLOCK
     /* create new header and update chain pointers */
-    pp = (memAllocBlock_t*) p;
+    pp = BASE_HDR(p);
+    LHDR_PTR(pp)->size = size;
 #ifdef MEMDEBUG
     pp->magic = MEMALLOC_MAGIC;
     pp->ptr = DATA_PTR(pp);
@@ -233,6 +666,10 @@ void *mrealloc(CSOUND *csound, void *oldp, size_t size)
       else
         MEMALLOC_DB = (void*) pp;
     }
+    {
+      memPool_t *pool = (memPool_t*) csound->memalloc_pool;
+      pool->stat[tag].bytes += (int64_t) size - (int64_t) oldsize;
+    }
     CSOUND_MEM_SPINUNLOCK
     /* return with data pointer */
     return DATA_PTR(pp);
@@ -248,6 +685,7 @@ void *mreallocDebug(CSOUND *csound, void *oldp, size_t size, char *file, int lin
 void memRESET(CSOUND *csound)
 {
     memAllocBlock_t *pp, *nxtp;
+    memPool_t       *pool = (memPool_t*) csound->memalloc_pool;
 
     pp = (memAllocBlock_t*) MEMALLOC_DB;
     MEMALLOC_DB = NULL;
@@ -256,7 +694,130 @@ void memRESET(CSOUND *csound)
 #ifdef MEMDEBUG
       pp->magic = 0;
 #endif
-      free((void*) pp);
+      free((void*) LHDR_PTR(pp));
       pp = nxtp;
     }
+    /* a new pool gets a new id, so no thread uses the old caches */
+    if (pool != NULL) {
+#ifdef MEM_TLS
+      memPool_t **pl;
+      csoundSpinLock(&mem_poolslock);
+      for (pl = &mem_pools; *pl != pool; pl = &(*pl)->nxtpool)
+        ;
+      *pl = pool->nxtpool;
+      csoundSpinUnLock(&mem_poolslock);
+#endif
+      while (pool->chunks != NULL) {
+        memChunk_t *c = pool->chunks->nxt;
+        free(pool->chunks);
+        pool->chunks = c;
+      }
+      while (pool->caches != NULL) {
+        memCache_t *c = pool->caches->nxt;
+        free(pool->caches);
+        pool->caches = c;
+      }
+      free(pool);
+      csound->memalloc_pool = NULL;
+    }
+}
+
+/* Regions: memory that is only ever freed all at once.  Allocation
+   bumps a pointer in the newest chunk; a reset keeps that chunk, so a
+   region that is reset and refilled with the same things stops
+   allocating.  A region is not locked: only one thread may use it. */
+
+typedef struct memRegion_s {
+    struct memRegion_s *nxt;            /* older chunks                 */
+    size_t             size, used;
+} memRegion_t;
+
+#define RGN_HDR   ((sizeof(memRegion_t) + 15) & ~((size_t) 15))
+#define RGN_MIN   ((size_t) 4096)
+
+void *csoundRegionAlloc(CSOUND *csound, void **region, size_t size)
+{
+    memRegion_t *r = (memRegion_t*) *region;
+    void        *p;
+
+    size = (size + 15) & ~((size_t) 15);
+    if (r == NULL || r->used + size > r->size) {
+      size_t n = (r == NULL ? RGN_MIN : r->size << 1);
+      memRegion_t *nr;
+      while (n < size)
+        n <<= 1;
+      nr = (memRegion_t*) mem_alloc(csound, RGN_HDR + n, CS_MEM_REGION, 0);
+      nr->nxt = r;
+      nr->size = n;
+      nr->used = 0;
+      *region = (void*) (r = nr);
+    }
+    p = (void*) ((unsigned char*) r + RGN_HDR + r->used);
+    r->used += size;
+    memset(p, 0, size);
+    return p;
+}
+
+void csoundRegionReset(CSOUND *csound, void **region)
+{
+    memRegion_t *r = (memRegion_t*) *region, *o;
+
+    if (r == NULL)
+      return;
+    while ((o = r->nxt) != NULL) {
+      r->nxt = o->nxt;
+      mfree(csound, o);
+    }
+    r->used = 0;
+}
+
+void csoundRegionFree(CSOUND *csound, void **region)
+{
+    memRegion_t *r = (memRegion_t*) *region;
+
+    while (r != NULL) {
+      memRegion_t *o = r->nxt;
+      mfree(csound, r);
+      r = o;
+    }
+    *region = NULL;
+}
+
+/* memory for an instrument instance until it is deactivated */
+
+void *csoundInstanceAlloc(CSOUND *csound, INSDS *ip, size_t size)
+{
+    return csoundRegionAlloc(csound, &ip->region, size);
+}
+
+PUBLIC int csoundGetMemoryStats(CSOUND *csound, CSOUND_MEMSTAT *stats, int max)
+{
+    memPool_t   *pool = (memPool_t*) csound->memalloc_pool;
+    memCache_t  *c;
+    int         i, n = (max < CS_MEM_NTAGS ? max : CS_MEM_NTAGS);
+
+    for (i = 0; i < n; i++) {
+      stats[i].name = tagnames[i];
+      stats[i].allocs = stats[i].frees = 0;
+      stats[i].bytes = 0;
+    }
+    if (pool == NULL)
+      return n;
+    CSOUND_MEM_SPINLOCK
+    for (i = 0; i < n; i++) {
+      stats[i].allocs += pool->stat[i].allocs;
+      stats[i].frees += pool->stat[i].frees;
+      stats[i].bytes += pool->stat[i].bytes;
+    }
+    CSOUND_MEM_SPINUNLOCK
+    /* other threads' counts may be a little behind */
+    csoundSpinLock(&pool->chunklock);
+    for (c = pool->caches; c != NULL; c = c->nxt)
+      for (i = 0; i < n; i++) {
+        stats[i].allocs += c->stat[i].allocs;
+        stats[i].frees += c->stat[i].frees;
+        stats[i].bytes += c->stat[i].bytes;
+      }
+    csoundSpinUnLock(&pool->chunklock);
+    return n;
 }
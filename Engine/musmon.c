@@ -43,11 +43,15 @@ int     MIDIinsert(CSOUND *, int, MCHNBLK*, MEVENT*);
 //  char *  scsortstr(CSOUND *, CORFIL *);
   void    infoff(CSOUND*, MYFLT), orcompact(CSOUND*);
   void    beatexpire(CSOUND *, double), timexpire(CSOUND *, double);
+  INSDS   *first_turnoff(CSOUND *);
   void    sfopenin(CSOUND *), sfopenout(CSOUND*), sfnopenout(CSOUND*);
   void    iotranset(CSOUND *), sfclosein(CSOUND*), sfcloseout(CSOUND*);
   void    MidiClose(CSOUND *);
   void    RTclose(CSOUND *);
   void    remote_Cleanup(CSOUND *);
+  void    dag_print_stats(CSOUND *);
+  void    profile_start(CSOUND *);
+  void    profile_print(CSOUND *);
   char    **csoundGetSearchPathFromEnv(CSOUND *, const char *);
 void    openMIDIout(CSOUND *);
 
@@ -250,6 +254,8 @@ int musmon(CSOUND *csound)
     csound->cyclesRemaining = 0;
     memset(&(csound->evt), 0, sizeof(EVTBLK));
 
+    if (O->profile)
+      profile_start(csound);
     /* run instr 0 inits */
     if (UNLIKELY(init0(csound) != 0))
       csoundDie(csound, Str("header init errors"));
@@ -416,10 +422,13 @@ static void deactivate_all_notes(CSOUND *csound)
 
 static void delete_pending_rt_events(CSOUND *csound)
 {
-  EVTNODE *ep = csound->OrcTrigEvts;
+  CS_WHEEL_NODE *n;
 
-  while (ep != NULL) {
-    EVTNODE *nxt = ep->nxt;
+  if (csound->OrcTrigEvts == NULL)
+    return;
+  while ((n = cs_wheel_first(csound->OrcTrigEvts)) != NULL) {
+    EVTNODE *ep = (EVTNODE *) n->value;
+    cs_wheel_remove(csound->OrcTrigEvts, n);
     if (ep->evt.strarg != NULL) {
       csound->Free(csound,ep->evt.strarg);
       ep->evt.strarg = NULL;
@@ -427,9 +436,7 @@ static void delete_pending_rt_events(CSOUND *csound)
     /* push to stack of free event nodes */
     ep->nxt = csound->freeEvtNodes;
     csound->freeEvtNodes = ep;
-    ep = nxt;
   }
-  csound->OrcTrigEvts = NULL;
 }
 
 static inline void cs_beep(CSOUND *csound)
@@ -513,6 +520,11 @@ PUBLIC int csoundCleanup(CSOUND *csound)
       }
       csound->Message(csound, Str("\n%d errors in performance\n"),
                       csound->perferrcnt);
+      if (csound->dag_sched != NULL &&
+          (csound->oparms->odebug || (csound->oparms->msglevel & TIMEMSG)))
+        dag_print_stats(csound);
+      if (csound->profile != NULL)
+        profile_print(csound);
       print_benchmark_info(csound, Str("end of performance"));
     }
     /* close line input (-L) */
@@ -717,10 +729,12 @@ static int process_score_event(CSOUND *csound, EVTBLK *evt, int rtEvt)
     /* fall through */
   case 'l':
   case 's':
-    while (csound->frstoff != NULL) {
-      INSDS *nxt = csound->frstoff->nxtoff;
-      xturnoff_now(csound, csound->frstoff);
-      csound->frstoff = nxt;
+    if (csound->turnoffs != NULL) {
+      CS_WHEEL_NODE *n;
+      while ((n = cs_wheel_first(csound->turnoffs)) != NULL) {
+        cs_wheel_remove(csound->turnoffs, n);
+        xturnoff_now(csound, (INSDS *) n->value);
+      }
     }
     csound->currevent = saved_currevent;
     return (evt->opcod == 'l' ? 3 : (evt->opcod == 's' ? 1 : 2));
@@ -891,7 +905,9 @@ static int process_rt_event(CSOUND *csound, int sensType)
       print_amp_values(csound, 0);
   }
   if (sensType == 4) {                  /* RM: Realtime orc event   */
-    EVTNODE *e = csound->OrcTrigEvts;
+    CS_WHEEL_NODE *n = cs_wheel_due(csound->OrcTrigEvts,
+                                    (uint64_t) csound->global_kcounter);
+    EVTNODE *e = (EVTNODE *) n->value;
     /* RM: Events are sorted on insertion, so just check the first */
     evt = &(e->evt);
     insno = MYFLT2LONG(evt->p[1]);
@@ -902,8 +918,8 @@ static int process_rt_event(CSOUND *csound, int sensType)
         insSendevt(csound, evt, rfd);  /* RM: or send to single remote Csound */
       return 0;
     }
-    /* pop from the list */
-    csound->OrcTrigEvts = e->nxt;
+    /* pop from the queue */
+    cs_wheel_remove(csound->OrcTrigEvts, n);
     retval = process_score_event(csound, evt, 1);
     if (evt->strarg != NULL) {
       csound->Free(csound, evt->strarg);
@@ -943,6 +959,8 @@ extern  int     sensMidi(CSOUND *);
 int sensevents(CSOUND *csound)
 {
   EVTBLK  *e;
+  INSDS   *ip;
+  CS_WHEEL_NODE *n;
   OPARMS  *O = csound->oparms;
   int     retval =  0, sensType;
   int     conn, *sinp, end_check=1;
@@ -958,16 +976,16 @@ int sensevents(CSOUND *csound)
   }
   /* if turnoffs pending, remove any expired instrs */
   RT_SPIN_TRYLOCK
-  if (UNLIKELY(csound->frstoff != NULL)) {
+  if (UNLIKELY((ip = first_turnoff(csound)) != NULL)) {
     double  tval;
     /* the following comparisons must match those in schedofftim() */
     if (O->Beatmode) {
       tval = csound->curBeat + (0.505 * csound->curBeat_inc);
-      if (csound->frstoff->offbet <= tval) beatexpire(csound, tval);
+      if (ip->offbet <= tval) beatexpire(csound, tval);
     }
     else {
       tval = ((double)csound->icurTime + csound->ksmps * 0.505)/csound->esr;
-      if (csound->frstoff->offtim <= tval)
+      if (ip->offtim <= tval)
         timexpire(csound, tval);
     }
   }
@@ -998,12 +1016,14 @@ int sensevents(CSOUND *csound)
       case 'e':                     /* end of score, */
       case 'l':                     /* lplay list,   */
       case 's':                     /* or section:   */
-        if (csound->frstoff != NULL) {    /* if still have notes
+        if (csound->turnoffs != NULL &&
+            (n = cs_wheel_first(csound->turnoffs)) != NULL) {
+                                          /* if still have notes
                                              with finite length, wait
                                              until all are turned off */
           RT_SPIN_TRYLOCK
-          csound->nxtim = csound->frstoff->offtim;
-          csound->nxtbt = csound->frstoff->offbet;
+          csound->nxtim = ((INSDS *) n->value)->offtim;
+          csound->nxtbt = ((INSDS *) n->value)->offbet;
           RT_SPIN_UNLOCK
           break;
         }
@@ -1111,8 +1131,8 @@ int sensevents(CSOUND *csound)
 
     /* check for pending real time events */
     while (csound->OrcTrigEvts != NULL &&
-           csound->OrcTrigEvts->start_kcnt <=
-           (uint32) csound->global_kcounter) {
+           cs_wheel_due(csound->OrcTrigEvts,
+                        (uint64_t) csound->global_kcounter) != NULL) {
 
       if ((retval = process_rt_event(csound, 4)) != 0){
         goto scode;
@@ -1238,10 +1258,10 @@ static inline uint64_t time2kcnt(CSOUND *csound, double tval)
 int insert_score_event_at_sample(CSOUND *csound, EVTBLK *evt, int64_t time_ofs)
 {
   double        start_time;
-  EVTNODE       *e, *prv;
+  EVTNODE       *e;
   CSOUND        *st = csound;
   MYFLT         *p;
-  uint32        start_kcnt;
+  uint64_t      start_kcnt;
   int           i, retval;
 
   retval = -1;
@@ -1369,20 +1389,13 @@ int insert_score_event_at_sample(CSOUND *csound, EVTBLK *evt, int64_t time_ofs)
                   evt->opcod);
     goto err_return;
   }
-  /* queue new event */
-  e->start_kcnt = start_kcnt;
-  prv = csound->OrcTrigEvts;
-  /* if list is empty, or at beginning of list: */
-  if (prv == NULL || start_kcnt < prv->start_kcnt) {
-    e->nxt = prv;
-    csound->OrcTrigEvts = e;
-  }
-  else {                                      /* otherwise sort by time */
-    while (prv->nxt != NULL && start_kcnt >= prv->nxt->start_kcnt)
-      prv = prv->nxt;
-    e->nxt = prv->nxt;
-    prv->nxt = e;
-  }
+  /* queue new event, after any others due in the same k-cycle */
+  if (UNLIKELY(csound->OrcTrigEvts == NULL))
+    csound->OrcTrigEvts = cs_wheel_create(csound);
+  e->node.tick = start_kcnt;
+  e->node.when = 0.0;
+  e->node.value = e;
+  cs_wheel_insert(csound->OrcTrigEvts, &e->node);
   /* Make sure sensevents() looks for RT events */
   csound->oparms->RTevents = 1;
   return 0;
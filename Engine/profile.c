@@ -0,0 +1,232 @@
+/*
+  profile.c:
+
+  Per-opcode and per-instrument timing of the init and perf passes
+
+  This file is part of Csound.
+
+  The Csound Library is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Csound is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+
+/* With --profile, kperf is swapped for kperf_profile(), which times
+   every perf call and every instrument instance with profile_ticks(),
+   and the init passes time every init call. The times are summed per
+   OENTRY and per instrument in an open addressed table that perf
+   threads update without locking; a slot is only locked when it is
+   claimed. Opcode times are inclusive, so a user-defined opcode is
+   charged with its whole body, and the opcodes of the body are
+   charged as well. Without --profile none of this code runs. */
+
+#include "csoundCore.h"
+#include "profile.h"
+
+#define PROFILE_BITS    (12)
+#define PROFILE_SLOTS   (1 << PROFILE_BITS)
+
+typedef struct {
+    const void  *key;           /* OENTRY or INSTRTXT */
+    const char  *name;
+    int32_t     instr;          /* instrument number, 0 for opcodes */
+    uint64_t    inits, perfs;
+    uint64_t    init_ticks, perf_ticks;
+} PROFSLOT;
+
+typedef struct {
+    PROFSLOT    slot[PROFILE_SLOTS];
+    spin_lock_t lock;           /* for claiming slots */
+    uint64_t    lost;           /* samples dropped with the table full */
+    uint64_t    start;          /* ticks at profile_start() */
+    RTCLOCK     clock;          /* real time at profile_start() */
+} PROFILE;
+
+void profile_start(CSOUND *csound)
+{
+    PROFILE *p = (PROFILE *) csound->profile;
+    if (p == NULL) {
+      p = (PROFILE *) csound->Calloc(csound, sizeof(PROFILE));
+      csoundSpinLockInit(&p->lock);
+      csound->profile = p;
+    }
+    p->start = profile_ticks();
+    csoundInitTimerStruct(&p->clock);
+    if (csound->kperf == kperf_nodebug)
+      csound->kperf = kperf_profile;
+}
+
+static PROFSLOT *profile_slot(PROFILE *p, const void *key,
+                              const char *name, int32_t instr)
+{
+    uint32_t h = (uint32_t) (((uintptr_t) key >> 4) * 2654435761u)
+                   >> (32 - PROFILE_BITS);
+    uint32_t n;
+
+    for (n = 0; n < PROFILE_SLOTS; n++, h = (h + 1) & (PROFILE_SLOTS - 1)) {
+      const void *k = ATOMIC_LOAD_PTR_ACQ(p->slot[h].key);
+      if (k == key)
+        return &p->slot[h];
+      if (k == NULL) {
+        csoundSpinLock(&p->lock);
+        k = p->slot[h].key;
+        if (k == NULL) {
+          p->slot[h].name = name;
+          p->slot[h].instr = instr;
+          ATOMIC_STORE_PTR_REL(p->slot[h].key, key);
+          k = key;
+        }
+        csoundSpinUnLock(&p->lock);
+        if (k == key)
+          return &p->slot[h];
+      }
+    }
+    return NULL;
+}
+
+void profile_op(CSOUND *csound, OPDS *op, uint64_t ticks, int init)
+{
+    PROFILE *p = (PROFILE *) csound->profile;
+    OENTRY  *ep = op->optext->t.oentry;
+    PROFSLOT *s = profile_slot(p, ep, ep->opname, 0);
+
+    if (UNLIKELY(s == NULL))
+      ATOMIC_ADD64(p->lost, 1);
+    else if (init) {
+      ATOMIC_ADD64(s->inits, 1);
+      ATOMIC_ADD64(s->init_ticks, ticks);
+    }
+    else {
+      ATOMIC_ADD64(s->perfs, 1);
+      ATOMIC_ADD64(s->perf_ticks, ticks);
+    }
+}
+
+void profile_instr(CSOUND *csound, INSDS *ip, uint64_t ticks, int init)
+{
+    PROFILE *p = (PROFILE *) csound->profile;
+    PROFSLOT *s = profile_slot(p, ip->instr, ip->instr->insname,
+                               ip->insno > 0 ? ip->insno : 0);
+
+    if (UNLIKELY(s == NULL))
+      ATOMIC_ADD64(p->lost, 1);
+    else if (init) {
+      ATOMIC_ADD64(s->inits, 1);
+      ATOMIC_ADD64(s->init_ticks, ticks);
+    }
+    else {
+      ATOMIC_ADD64(s->perfs, 1);
+      ATOMIC_ADD64(s->perf_ticks, ticks);
+    }
+}
+
+static int profile_cmp(const void *a, const void *b)
+{
+    const CSOUND_PROFILE *x = (const CSOUND_PROFILE *) a;
+    const CSOUND_PROFILE *y = (const CSOUND_PROFILE *) b;
+    double  tx = x->perf_time + x->init_time, ty = y->perf_time + y->init_time;
+    return (tx < ty) - (tx > ty);
+}
+
+/**
+ * Fills entries with the time spent in each opcode and instrument
+ * since performance started with --profile, most expensive first,
+ * writing at most max entries, and returns the number written.
+ */
+PUBLIC int csoundGetProfile(CSOUND *csound, CSOUND_PROFILE *entries, int max)
+{
+    PROFILE *p = (PROFILE *) csound->profile;
+    CSOUND_PROFILE *all;
+    double  secs;
+    uint64_t ticks;
+    int     i, n = 0;
+
+    if (p == NULL || max <= 0)
+      return 0;
+    /* ticks to seconds over the whole run */
+    secs = csoundGetRealTime(&p->clock);
+    ticks = profile_ticks() - p->start;
+    secs = (ticks > 0 ? secs / (double) ticks : 0.0);
+    all = (CSOUND_PROFILE *) csound->Malloc(csound, PROFILE_SLOTS *
+                                                    sizeof(CSOUND_PROFILE));
+    for (i = 0; i < PROFILE_SLOTS; i++) {
+      const PROFSLOT *s = &p->slot[i];
+      if (ATOMIC_LOAD_PTR_ACQ(p->slot[i].key) == NULL)
+        continue;
+      all[n].name = s->name;
+      all[n].instr = s->instr;
+      all[n].inits = s->inits;
+      all[n].perfs = s->perfs;
+      all[n].init_time = (double) s->init_ticks * secs;
+      all[n].perf_time = (double) s->perf_ticks * secs;
+      n++;
+    }
+    qsort(all, n, sizeof(CSOUND_PROFILE), profile_cmp);
+    if (n > max) n = max;
+    memcpy(entries, all, n * sizeof(CSOUND_PROFILE));
+    csound->Free(csound, all);
+    return n;
+}
+
+static void profile_section(CSOUND *csound, const CSOUND_PROFILE *e,
+                            int n, int instr, double total)
+{
+    int i;
+    csound->Message(csound, "%12s %7s %10s %9s %12s  %s\n",
+                    Str("perf (s)"), "%", Str("perfs"), Str("ns/perf"),
+                    Str("init (s)"), instr ? Str("instr") : Str("opcode"));
+    for (i = 0; i < n; i++) {
+      char    num[32];
+      const char *name = e[i].name;
+      if ((e[i].instr != 0) != instr)
+        continue;
+      if (instr && name == NULL) {
+        snprintf(num, sizeof(num), "%d", e[i].instr);
+        name = num;
+      }
+      csound->Message(csound, "%12.6f %6.2f%% %10llu %9.1f %12.6f  %s\n",
+                      e[i].perf_time,
+                      total > 0.0 ? 100.0 * e[i].perf_time / total : 0.0,
+                      (unsigned long long) e[i].perfs,
+                      e[i].perfs ? 1.0e9 * e[i].perf_time / e[i].perfs : 0.0,
+                      e[i].init_time, name);
+    }
+}
+
+void profile_print(CSOUND *csound)
+{
+    PROFILE *p = (PROFILE *) csound->profile;
+    CSOUND_PROFILE *e;
+    double  total = 0.0;
+    int     i, n;
+
+    if (p == NULL)
+      return;
+    e = (CSOUND_PROFILE *) csound->Malloc(csound, PROFILE_SLOTS *
+                                                  sizeof(CSOUND_PROFILE));
+    n = csoundGetProfile(csound, e, PROFILE_SLOTS);
+    /* the instruments' perf time is the time of the whole orchestra */
+    for (i = 0; i < n; i++)
+      if (e[i].instr != 0)
+        total += e[i].perf_time;
+    csound->Message(csound, Str("\nProfile: %.6f s in instrument perf "
+                                "passes\n"), total);
+    profile_section(csound, e, n, 1, total);
+    csound->Message(csound, "\n");
+    profile_section(csound, e, n, 0, total);
+    if (UNLIKELY(p->lost))
+      csound->Message(csound, Str("%llu timings not recorded, "
+                                  "profile table full\n"),
+                      (unsigned long long) p->lost);
+    csound->Free(csound, e);
+}
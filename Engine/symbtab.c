@@ -32,6 +32,7 @@
 #include "namedins.h"
 #include "interlocks.h"
 #include "csound_orc_semantics.h"
+#include "csmodule.h"
 #include "csound_standard_types.h"
 
 #ifndef PARSER_DEBUG
@@ -487,6 +488,7 @@ OENTRY* csound_find_internal_oentry(CSOUND* csound, OENTRY* oentry) {
         return NULL;
     }
     shortName = get_opcode_short_name(csound, oentry->opname);
+    csoundLoadDeferredOpcode(csound, shortName);
 
     items = cs_hash_table_get(csound, csound->opcodes, shortName);
 
@@ -83,6 +83,27 @@ typedef struct {
     MYFLT   *r, *a, *b;
 } AOP;
 
+/* fused a-rate expression (##aexpr), built by csound_orc_optimize() */
+#define AEXPR_MAXARGS  (32)     /* leaves per expression */
+#define AEXPR_MAXREG   (8)      /* intermediate results live at once */
+#define AEXPR_CHUNK    (64)     /* samples evaluated per pass */
+
+enum { AEXPR_VV, AEXPR_VS, AEXPR_SV };  /* vector/scalar operand kinds */
+
+typedef struct {
+    int16_t op, kind;           /* operator and AEXPR_VV/VS/SV */
+    int16_t dst, a, b;          /* operands: arg index >= 0, register < 0 */
+} AEXPR_INSN;
+
+typedef struct {
+    OPDS    h;
+    MYFLT   *r;
+    STRINGDAT *prog;
+    MYFLT   *args[AEXPR_MAXARGS];
+    int32_t ninsn;
+    AEXPR_INSN insn[AEXPR_MAXARGS];
+} AEXPR;
+
 typedef struct {
     OPDS    h;
     MYFLT   *r, *a, *b, *def;
@@ -0,0 +1,95 @@
+/*
+  aops_simd.h:
+
+  Vector kernels for the arithmetic and conversion opcodes in aops.c,
+  with the instruction set picked at runtime
+
+  This file is part of Csound.
+
+  The Csound Library is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Csound is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+
+#ifndef CSOUND_AOPS_SIMD_H
+#define CSOUND_AOPS_SIMD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* powerof2 table used by csoundPow2() */
+#define POW2TABSIZI 4096
+#if ULONG_MAX == 18446744073709551615UL
+#  define POW2MAX   (24.0)
+#else
+#  define POW2MAX   (15.0)
+#endif
+
+enum { AOPS_ADD, AOPS_SUB, AOPS_MUL, AOPS_DIV };
+
+/**
+ * One set of kernels. All of them work on n contiguous samples and give
+ * the same results as the scalar code in aops.c; the arithmetic kernels
+ * and pow2/cpsoct are exact, exp and log are within 2 ulp of libm.
+ */
+typedef struct {
+    /* r[i] = a[i] op b[i], a[i] op b and a op b[i], indexed by AOPS_ADD.. */
+    void (*vv[4])(MYFLT *r, const MYFLT *a, const MYFLT *b, uint32_t n);
+    void (*vs[4])(MYFLT *r, const MYFLT *a, MYFLT b, uint32_t n);
+    void (*sv[4])(MYFLT *r, MYFLT a, const MYFLT *b, uint32_t n);
+    /* r[i] = csoundPow2(a[i]), tab is csound->powerof2 */
+    void (*pow2)(MYFLT *r, const MYFLT *a, const MYFLT *tab, uint32_t n);
+    /* r[i] = CPSOCTL(a[i] * OCTRES), tab is csound->cpsocfrc */
+    void (*cpsoct)(MYFLT *r, const MYFLT *a, const MYFLT *tab, uint32_t n);
+    /* r[i] = s * exp(a[i] * k) */
+    void (*expk)(MYFLT *r, const MYFLT *a, MYFLT k, MYFLT s, uint32_t n);
+    /* r[i] = log(fabs(a[i])) / k */
+    void (*logk)(MYFLT *r, const MYFLT *a, MYFLT k, uint32_t n);
+    /* output stage for one channel of n frames: sp[i*stride] = a[i] and,
+       unless out is NULL, out[i*stride] = a[i] * s; raises *peak to the
+       largest |a[i]| and adds the number of |a[i]| > lim to *nover.
+       Returns the first i at a new peak, or n if *peak is unchanged */
+    uint32_t (*outchn)(MYFLT *sp, MYFLT *out, uint32_t stride,
+                       const MYFLT *a, MYFLT s, MYFLT lim,
+                       MYFLT *peak, int32_t *nover, uint32_t n);
+    const char *name;
+} AOPS_KERNELS;
+
+/**
+ * The best kernel set for this machine ("avx512", "avx2", "sse2" or
+ * "scalar").
+ */
+const AOPS_KERNELS *aops_kernels(void);
+
+/**
+ * Stores up to max kernel sets usable on this machine in sets, the
+ * scalar set first and the one returned by aops_kernels() last, and
+ * returns their number.
+ */
+int32_t aops_kernel_sets(const AOPS_KERNELS **sets, int32_t max);
+
+enum { AOPS_CPU_AVX2, AOPS_CPU_AVX512F, AOPS_CPU_FMA };
+
+/**
+ * Non-zero if the CPU and the OS support the given AOPS_CPU_ feature,
+ * for the other vector code in the library. Always 0 off x86.
+ */
+int32_t aops_cpu_has(int32_t feature);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* CSOUND_AOPS_SIMD_H */
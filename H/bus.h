@@ -56,6 +56,21 @@ typedef struct {
     int32_t     evtbuf;
 } KSENSE;
 
+/* host side of an audio channel with a handle: each direction is a
+   triple buffer, one slot owned by the host, one by the performance
+   thread and one in the middle exchanged atomically (CHNAUDIO_DIRTY set
+   when it holds data the other side has not seen yet) */
+#define CHNAUDIO_DIRTY  4
+
+typedef struct {
+    MYFLT   *in[3];                  /* host -> performance */
+    int32_t in_host, in_perf;
+    volatile int32_t in_mid;
+    MYFLT   *out[3];                 /* performance -> host */
+    int32_t out_host, out_perf;
+    volatile int32_t out_mid;
+} CHNAUDIO;
+
 typedef struct channelEntry_s {
     struct channelEntry_s *nxt;
     controlChannelHints_t hints;
@@ -63,6 +78,8 @@ typedef struct channelEntry_s {
     spin_lock_t  lock;               /* Multi-thread protection */
     int32_t     type;
     int32_t     datasize;  /* size of allocated chn data */
+    CHNAUDIO    *audio;    /* host buffers, once a handle has been taken */
+    struct channelEntry_s *audio_nxt;   /* csound->chn_audio list */
     char    name[1];
 } CHNENTRY;
 
@@ -103,6 +103,17 @@ extern "C" {
    */
   int csoundDestroyModules(CSOUND *csound);
 
+  /**
+   * Open the plugin libraries deferred by the plugin manifest that provide
+   * an opcode named 'shortName', replacing their stubs in the opcode list.
+   */
+  void csoundLoadDeferredOpcode(CSOUND *csound, const char *shortName);
+
+  /**
+   * Print the startup time breakdown collected since csoundReset().
+   */
+  void csoundPrintStartupTimes(CSOUND *csound);
+
   /**
    * Initialise opcodes not in entry1.c
    */
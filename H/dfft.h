@@ -0,0 +1,63 @@
+/*
+  dfft.h:
+
+  Double precision real FFT with runtime-selected SIMD kernels
+
+  This file is part of Csound.
+
+  The Csound Library is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Csound is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+
+#ifndef CSOUND_DFFT_H
+#define CSOUND_DFFT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct DFFT_SETUP_ DFFT_SETUP;
+
+/* smallest transform handled by dfft; sizes must be powers of two */
+#define DFFT_MIN_SIZE 32
+
+/**
+ * Creates a setup for a real FFT of N (a power of two, >= DFFT_MIN_SIZE)
+ * points in direction d (FFT_FWD or FFT_INV), or returns the one made
+ * before for the same size and direction; a setup may be executed on
+ * several threads at once. Memory is allocated with csound->Malloc() and
+ * released with the Csound instance. Returns NULL if N is not supported.
+ */
+DFFT_SETUP *dfft_new_setup(CSOUND *csound, int32_t N, int32_t d);
+
+/**
+ * Transforms sig in place, using the same packed format and scaling as
+ * csoundRealFFT() and csoundInverseRealFFT(): sig[0] is the DC and sig[1]
+ * the Nyquist component, followed by real/imaginary pairs; the inverse
+ * transform includes the 1/N scaling.
+ */
+void dfft_execute(DFFT_SETUP *setup, double *sig);
+
+/**
+ * Name of the kernel set picked for this machine ("avx2", "sse2" or
+ * "scalar").
+ */
+const char *dfft_simd_name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* CSOUND_DFFT_H */
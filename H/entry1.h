@@ -86,6 +86,7 @@ int32_t modak(CSOUND *, void *);
 int32_t addaa(CSOUND *, void *), subaa(CSOUND *, void *);
 int32_t mulaa(CSOUND *, void *), divaa(CSOUND *, void *);
 int32_t modaa(CSOUND *, void *);
+int32_t aexpr_set(CSOUND *, void *), aexpr(CSOUND *, void *);
 int32_t divzkk(CSOUND *, void *), divzka(CSOUND *, void *);
 int32_t divzak(CSOUND *, void *), divzaa(CSOUND *, void *);
 int32_t int1(CSOUND *, void *), int1a(CSOUND *, void *);
@@ -114,6 +115,7 @@ int32_t tanha(CSOUND *, void *), log10a(CSOUND *, void *), log2a(CSOUND *, void
 int32_t dbamp(CSOUND *, void *), ampdb(CSOUND *, void *);
 int32_t aampdb(CSOUND *, void *), dbfsamp(CSOUND *, void *);
 int32_t ampdbfs(CSOUND *, void *), aampdbfs(CSOUND *, void *);
+int32_t adbamp(CSOUND *, void *);
 int32_t ftlen(CSOUND *, void *), ftlptim(CSOUND *, void *);
 int32_t ftchnls(CSOUND *, void *), ftcps(CSOUND *, void *);
 int32_t signum(CSOUND *, void *), asignum(CSOUND *, void *);
@@ -322,6 +324,7 @@ int32_t phaser1set(CSOUND *, void *), phaser1(CSOUND *, void *);
 int32_t balnset(CSOUND *, void *), balance(CSOUND *, void *);
 int32_t prealloc(CSOUND *, void *);
 int32_t prealloc_S(CSOUND *, void *), active_alloc(CSOUND*, void*);
+int32_t prewarm(CSOUND *, void *);
 int32_t cpsxpch(CSOUND *, void *), cps2pch(CSOUND *, void *);
 int32_t cpstmid(CSOUND *, void *);
 int32_t cpstun(CSOUND *, void *), cpstun_i(CSOUND *, void *);
@@ -0,0 +1,105 @@
+/*
+  profile.h:
+
+  Per-opcode and per-instrument timing of the init and perf passes,
+  enabled by --profile
+
+  This file is part of Csound.
+
+  The Csound Library is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Csound is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+
+#ifndef CSOUND_PROFILE_H
+#define CSOUND_PROFILE_H
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#elif !defined(__aarch64__)
+#  include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* a cheap, monotonic counter; profile.c converts it to seconds against
+   the real time clock over the whole profiled run */
+static inline uint64_t profile_ticks(void)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return (uint64_t) __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return (uint64_t) __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t t;
+    __asm__ volatile ("mrs %0, cntvct_el0" : "=r" (t));
+    return t;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+#else
+    return (uint64_t) clock();
+#endif
+}
+
+void    profile_start(CSOUND *);
+void    profile_print(CSOUND *);
+void    profile_op(CSOUND *, OPDS *, uint64_t ticks, int init);
+void    profile_instr(CSOUND *, INSDS *, uint64_t ticks, int init);
+
+/* for loops instantiated with and without timing */
+#if defined(__GNUC__)
+#  define PROFILE_INLINE static inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#  define PROFILE_INLINE static __forceinline
+#else
+#  define PROFILE_INLINE static inline
+#endif
+
+/* Run the perf routine of op, storing its return value in err. prof
+   should be a constant, so that the timing is compiled out of the
+   loops that are built without it. */
+#define PROFILE_PERF(csound, prof, op, err)                             \
+  do {                                                                  \
+    OPDS *op_ = (op);                                                   \
+    if (prof) {                                                         \
+      uint64_t t0_ = profile_ticks();                                   \
+      err = (*op_->opadr)(csound, op_);                                 \
+      profile_op(csound, op_, profile_ticks() - t0_, 0);                \
+    }                                                                   \
+    else err = (*op_->opadr)(csound, op_);                              \
+  } while (0)
+
+/* the same for the init routine, which is timed whenever profiling */
+#define PROFILE_INIT(csound, op, err)                                   \
+  do {                                                                  \
+    OPDS *op_ = (op);                                                   \
+    if (UNLIKELY((csound)->profile != NULL)) {                          \
+      uint64_t t0_ = profile_ticks();                                   \
+      err = (*op_->iopadr)(csound, op_);                                \
+      profile_op(csound, op_, profile_ticks() - t0_, 1);                \
+    }                                                                   \
+    else err = (*op_->iopadr)(csound, op_);                             \
+  } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* CSOUND_PROFILE_H */
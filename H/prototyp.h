@@ -38,9 +38,23 @@ void    *mmallocDebug(CSOUND *, size_t, char*, int);
 void    *mcallocDebug(CSOUND *, size_t, char*, int);
 void    *mreallocDebug(CSOUND *, void *, size_t, char*, int);
 void    mfreeDebug(CSOUND *, void *, char*, int);
+/* subsystems memory is counted against, see csoundGetMemoryStats() */
+enum { CS_MEM_OTHER, CS_MEM_COMPILER, CS_MEM_INIT, CS_MEM_PERF,
+       CS_MEM_AUX, CS_MEM_STRING, CS_MEM_REGION, CS_MEM_NTAGS };
+void    *mmalloc_tag(CSOUND *, size_t, int);
+void    *mcalloc_tag(CSOUND *, size_t, int);
+int     memalloc_tag(int);
+void    memalloc_thread_exit(void);
+void    *csoundRegionAlloc(CSOUND *, void **, size_t);
+void    csoundRegionReset(CSOUND *, void **);
+void    csoundRegionFree(CSOUND *, void **);
+void    *csoundInstanceAlloc(CSOUND *, INSDS *, size_t);
 char    *cs_strdup(CSOUND*, char*);
 char    *cs_strndup(CSOUND*, char*, size_t);
 void    csoundAuxAlloc(CSOUND *, size_t, AUXCH *), auxchfree(CSOUND *, INSDS *);
+void    auxRESET(CSOUND *);
+void    auxForget(CSOUND *, void *, size_t);
+void    csoundAuxTouched(CSOUND *, AUXCH *, size_t);
 int     csoundAuxAllocAsync(CSOUND *, size_t , AUXCH *,
                             AUXASYNC *, aux_cb , void *);
 void    fdrecord(CSOUND *, FDCH *), fdclose(CSOUND *, FDCH *);
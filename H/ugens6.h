@@ -69,6 +69,7 @@ typedef struct DELAYR {
         MYFLT   *curp;
         uint32_t npts;
         AUXCH   auxch;
+        size_t  touched;        /* bytes of auxch written, until it wraps */
         struct DELAYR  *next_delayr; /* fifo for delayr pointers by Jens Groh */
 } DELAYR;
 
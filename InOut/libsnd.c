@@ -23,6 +23,7 @@
 
 #include "csoundCore.h"                 /*             SNDLIB.C         */
 #include "soundio.h"
+#include "aops_simd.h"
 #include <stdlib.h>
 #include <time.h>
 #include <inttypes.h>
@@ -55,126 +56,82 @@ static inline void alloc_globals(CSOUND *csound)
    spoutran to transfer nspout items to buffer
    audtran to actually write the data
 
-   spoutran is called with nchnls*ksamps items and this need to be
-   buffered until outbufsiz items have been accumulated.  It will call
-   audtran to flush when this happens.
+   spoutran is called once per k-cycle, with the instruments' output
+   in spraw as ksmps samples per channel.  It interleaves them into
+   spout and into the output buffer, which it flushes through audtran
+   every outbufsiz items, and meters each channel on the way.  The
+   work is done a channel at a time by the outchn kernel of aops_simd,
+   in one pass over spraw.
 */
 
-static void spoutsf(CSOUND *csound)
+static inline void spoutsf_(CSOUND *csound, MYFLT scale, int chkrange)
 {
-    uint32_t   chn = 0;
-    int     n;
-    int spoutrem = csound->nspout;
-    MYFLT   *sp = csound->spout;
-    MYFLT   absamp = FL(0.0);
-    uint32  nframes = csound->libsndStatics.nframes;
- nchk:
-    /* if nspout remaining > buf rem, prepare to send in parts */
-    if ((n = spoutrem) > (int) csound->libsndStatics.outbufrem) {
-      n = (int) csound->libsndStatics.outbufrem;
-    }
-    spoutrem -= n;
-    csound->libsndStatics.outbufrem -= n;
-    do {
-      absamp = *sp++;
-      if (csound->libsndStatics.osfopen) {
-        *csound->libsndStatics.outbufp++ = (absamp * csound->dbfs_to_float);
-      }
-      if (absamp < FL(0.0)) {
-        absamp = -absamp;
-      }
-      if (absamp > csound->maxamp[chn]) {   /*  maxamp this seg  */
-        csound->maxamp[chn] = absamp;
-        csound->maxpos[chn] = nframes;
-      }
-      if (absamp > csound->e0dbfs) {        /* out of range?     */
-        csound->rngcnt[chn]++;              /*  report it        */
-        csound->rngflg = 1;
+    const AOPS_KERNELS *k = aops_kernels();
+    uint32_t nchnls = csound->nchnls, nsmps = csound->ksmps;
+    uint32_t f = 0, nf, chn, pos;
+    uint32   nframes = STA(nframes);
+    int32_t  nover;
+
+    while (f < nsmps) {
+      /* if the frames remaining exceed the buffer, send them in parts */
+      nf = STA(outbufrem) / nchnls;
+      if (nf > nsmps - f)
+        nf = nsmps - f;
+      if (!csound->spoutactive) {       /* silent: nothing to meter */
+        memset(&csound->spout[f*nchnls], 0, nf*nchnls*sizeof(MYFLT));
+        if (STA(osfopen))
+          memset(STA(outbufp), 0, nf*nchnls*sizeof(MYFLT));
       }
-      if (csound->multichan) {
-        if (++chn >= csound->nchnls) {
-            chn = 0;
-            nframes++;
+      else for (chn = 0; chn < nchnls; chn++) {
+        nover = 0;
+        pos = k->outchn(&csound->spout[f*nchnls + chn],
+                        STA(osfopen) ? STA(outbufp) + chn : NULL, nchnls,
+                        &csound->spraw[chn*nsmps + f], scale, csound->e0dbfs,
+                        &csound->maxamp[chn], &nover, nf);
+        if (pos < nf)                   /*  maxamp this seg  */
+          csound->maxpos[chn] = nframes + pos;
+        if (chkrange && nover) {        /* out of range?     */
+          csound->rngcnt[chn] += nover; /*  report it        */
+          csound->rngflg = 1;
         }
-      } else {
-        nframes++;
       }
-    } while (--n);
-    if (!csound->libsndStatics.outbufrem) {
-      if (csound->libsndStatics.osfopen) {
-        csound->nrecs++;
-        csound->audtran(csound, csound->libsndStatics.outbuf,
-                        csound->libsndStatics.outbufsiz); /* Flush buffer */
-        csound->libsndStatics.outbufp = (MYFLT*) csound->libsndStatics.outbuf;
-      }
-      csound->libsndStatics.outbufrem = csound->oparms_.outbufsamps;
-      if (spoutrem) {
-        goto nchk;
+      f += nf;
+      nframes += nf;
+      if (STA(osfopen))
+        STA(outbufp) += nf*nchnls;
+      if (!(STA(outbufrem) -= nf*nchnls)) {
+        if (STA(osfopen)) {
+          csound->nrecs++;
+          csound->audtran(csound, STA(outbuf), STA(outbufsiz)); /* Flush */
+          STA(outbufp) = STA(outbuf);
+        }
+        STA(outbufrem) = csound->oparms_.outbufsamps;
       }
     }
-    csound->libsndStatics.nframes = nframes;
+    STA(nframes) = nframes;
+}
+
+static void spoutsf(CSOUND *csound)
+{
+    spoutsf_(csound, csound->dbfs_to_float, 1);
 }
 
 /* special version of spoutsf for "raw" floating point files */
 
 static void spoutsf_noscale(CSOUND *csound)
 {
-    uint32_t chn = 0;
-    int      n, spoutrem = csound->nspout;
-    MYFLT    *sp = csound->spout;
-    MYFLT    absamp = FL(0.0);
-    uint32   nframes = csound->libsndStatics.nframes;
-
- nchk:
-    /* if nspout remaining > buf rem, prepare to send in parts */
-    if ((n = spoutrem) > (int) csound->libsndStatics.outbufrem)
-      n = (int)csound->libsndStatics.outbufrem;
-    spoutrem -= n;
-    csound->libsndStatics.outbufrem -= n;
-    do {
-      absamp = *sp++;
-      if (csound->libsndStatics.osfopen)
-        *csound->libsndStatics.outbufp++ = absamp;
-      if (absamp < FL(0.0))
-        absamp = -absamp;
-      if (absamp > csound->maxamp[chn]) {   /*  maxamp this seg  */
-        csound->maxamp[chn] = absamp;
-        csound->maxpos[chn] = nframes;
-      }
-      if (++chn >= csound->nchnls)
-        chn = 0, nframes++;
-    } while (--n);
-
-    if (!csound->libsndStatics.outbufrem) {
-      if (csound->libsndStatics.osfopen) {
-        csound->nrecs++;
-        csound->audtran(csound, csound->libsndStatics.outbuf,
-                        csound->libsndStatics.outbufsiz); /* Flush buffer */
-        csound->libsndStatics.outbufp = (MYFLT*) csound->libsndStatics.outbuf;
-      }
-      csound->libsndStatics.outbufrem = csound->oparms_.outbufsamps;
-      if (spoutrem) goto nchk;
-    }
-    csound->libsndStatics.nframes = nframes;
+    spoutsf_(csound, FL(1.0), 0);
 }
 
+
 /* diskfile write option for audtran's */
 /*      assigned during sfopenout()    */
 
-static void writesf(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+static void heartbeat(CSOUND *csound)
 {
-    OPARMS  *O = csound->oparms;
     int     n;
 
-    if (UNLIKELY(STA(outfile) == NULL))
-      return;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader((void *)STA(outfile));
-    switch (O->heartbeat) {
+    switch (csound->oparms->heartbeat) {
       case 1:
         csound->MessageS(csound, CSOUNDMSG_REALTIME,
                                  "%c\010", "|/-\\"[csound->nrecs & 3]);
@@ -200,17 +157,12 @@ static void writesf(CSOUND *csound, const MYFLT *outbuf, int nbytes)
     }
 }
 
-static void writesf_dither_16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+/* triangular (signed formats) or rectangular (unsigned) dither noise */
+
+static void dither_16(CSOUND *csound, MYFLT *buf, int m)
 {
-    OPARMS  *O = csound->oparms;
-    int     n;
-    int m = nbytes / sizeof(MYFLT);
-    MYFLT *buf = (MYFLT*) outbuf;
-    int    dith;
+    int     n, dith = STA(dither);
 
-    if (UNLIKELY(STA(outfile) == NULL))
-      return;
-    dith = STA(dither);
     for (n=0; n<m; n++) {
       int   tmp = ((dith * 15625) + 1) & 0xFFFF;
       int   rnd = ((tmp * 15625) + 1) & 0xFFFF;
@@ -222,49 +174,12 @@ static void writesf_dither_16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
       buf[n] += result;
     }
     STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
-    switch (O->heartbeat) {
-      case 1:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME,
-                                 "%c\010", "|/-\\"[csound->nrecs & 3]);
-        break;
-      case 2:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, ".");
-        break;
-      case 3:
-        {
-          char    s[512];
-          CS_SPRINTF(s, "%ld(%.3f)%n", (long) csound->nrecs,
-                  csound->icurTime/csound->esr, &n);
-          if (n > 0) {
-            memset(&(s[n]), '\b', n);
-            s[n + n] = '\0';
-            csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s", s);
-          }
-        }
-        break;
-      case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "\a");
-        break;
-    }
 }
 
-static void writesf_dither_8(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+static void dither_8(CSOUND *csound, MYFLT *buf, int m)
 {
-    OPARMS  *O = csound->oparms;
-    int     n;
-    int m = nbytes / sizeof(MYFLT);
-    MYFLT *buf = (MYFLT*) outbuf;
-    int dith;
+    int     n, dith = STA(dither);
 
-    if (UNLIKELY(STA(outfile) == NULL))
-      return;
-    dith = STA(dither);
     for (n=0; n<m; n++) {
       int   tmp = ((dith * 15625) + 1) & 0xFFFF;
       int   rnd = ((tmp * 15625) + 1) & 0xFFFF;
@@ -276,49 +191,12 @@ static void writesf_dither_8(CSOUND *csound, const MYFLT *outbuf, int nbytes)
       buf[n] += result;
     }
     STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
-    switch (O->heartbeat) {
-      case 1:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME,
-                                 "%c\010", "|/-\\"[csound->nrecs & 3]);
-        break;
-      case 2:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, ".");
-        break;
-      case 3:
-        {
-          char    s[512];
-          CS_SPRINTF(s, "%ld(%.3f)%n", (long) csound->nrecs,
-                  csound->icurTime/csound->esr, &n);
-          if (n > 0) {
-            memset(&(s[n]), '\b', n);
-            s[n + n] = '\0';
-            csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s", s);
-          }
-        }
-        break;
-      case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "\a");
-        break;
-    }
 }
 
-static void writesf_dither_u16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+static void dither_u16(CSOUND *csound, MYFLT *buf, int m)
 {
-    OPARMS  *O = csound->oparms;
-    int     n;
-    int m = nbytes / sizeof(MYFLT);
-    MYFLT *buf = (MYFLT*) outbuf;
-    int dith;
+    int     n, dith = STA(dither);
 
-    if (UNLIKELY(STA(outfile) == NULL))
-      return;
-    dith = STA(dither);
     for (n=0; n<m; n++) {
       int   rnd = ((dith * 15625) + 1) & 0xFFFF;
       MYFLT result;
@@ -328,49 +206,12 @@ static void writesf_dither_u16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
       buf[n] += result;
     }
     STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
-    switch (O->heartbeat) {
-      case 1:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME,
-                                 "%c\010", "|/-\\"[csound->nrecs & 3]);
-        break;
-      case 2:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, ".");
-        break;
-      case 3:
-        {
-          char    s[512];
-          CS_SPRINTF(s, "%ld(%.3f)%n", (long) csound->nrecs,
-                  csound->icurTime/csound->esr, &n);
-          if (n > 0) {
-            memset(&(s[n]), '\b', n);
-            s[n + n] = '\0';
-            csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s",  s);
-          }
-        }
-        break;
-      case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s",  "\a");
-        break;
-    }
 }
 
-static void writesf_dither_u8(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+static void dither_u8(CSOUND *csound, MYFLT *buf, int m)
 {
-    OPARMS  *O = csound->oparms;
-    int     n;
-    int m = nbytes / sizeof(MYFLT);
-    MYFLT *buf = (MYFLT*) outbuf;
-    int dith;
+    int     n, dith = STA(dither);
 
-    if (UNLIKELY(STA(outfile) == NULL))
-      return;
-    dith = STA(dither);
     for (n=0; n<m; n++) {
       int   rnd = ((dith * 15625) + 1) & 0xFFFF;
       MYFLT result;
@@ -380,36 +221,145 @@ static void writesf_dither_u8(CSOUND *csound, const MYFLT *outbuf, int nbytes)
       buf[n] += result;
     }
     STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
+}
+
+/* dither, convert and write one buffer; returns the bytes written */
+
+static int writesf_block(CSOUND *csound, MYFLT *outbuf, int nbytes)
+{
+    int     n;
+
+    if (STA(ditherfn) != NULL)
+      STA(ditherfn)(csound, outbuf, nbytes / (int) sizeof(MYFLT));
+    n = (int) sf_write_MYFLT(STA(outfile), outbuf,
                              nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
+    if (UNLIKELY(csound->oparms->rewrt_hdr))
+      rewriteheader((void *)STA(outfile));
+    return n;
+}
+
+static void writesf(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+{
+    int     n;
+
+    if (UNLIKELY(STA(outfile) == NULL))
+      return;
+    n = writesf_block(csound, (MYFLT*) outbuf, nbytes);
     if (UNLIKELY(n < nbytes))
       sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
-    switch (O->heartbeat) {
-      case 1:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME,
-                                 "%c\010", "|/-\\"[csound->nrecs & 3]);
-        break;
-      case 2:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, ".");
-        break;
-      case 3:
-        {
-          char    s[512];
-          CS_SPRINTF(s, "%ld(%.3f)%n", (long) csound->nrecs,
-                  csound->icurTime/csound->esr, &n);
-          if (n > 0) {
-            memset(&(s[n]), '\b', n);
-            s[n + n] = '\0';
-            csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s", s);
-          }
+    heartbeat(csound);
+}
+
+/* With --disk-buffers=N the performance thread only copies each full
+   buffer into a ring of N and returns; a writer thread does the dither,
+   format conversion and sf_write.  Each index is advanced by one side
+   only, under wlock, which is held just to count and signal, never
+   across a copy or a write; wready and wfree are waited on with it,
+   so that no wake-up is lost.  A write error is latched by the writer
+   and reported from the performance thread on its next buffer. */
+
+static uintptr_t disk_writer(void *p)
+{
+    CSOUND  *csound = (CSOUND*) p;
+    int32_t get, slot, empty;
+
+    for (;;) {
+      csoundLockMutex(STA(wlock));
+      while ((empty = ((get = STA(wget)) == STA(wput))) && !STA(wstop))
+        csoundCondWait(STA(wready), STA(wlock));
+      csoundUnlockMutex(STA(wlock));
+      if (empty)                                /* stopped, and all written */
+        break;
+      slot = get % STA(wdepth);
+      if (!ATOMIC_GET(STA(werr))) {
+        int n = writesf_block(csound, STA(wbufs)[slot], STA(wsize)[slot]);
+        if (UNLIKELY(n < STA(wsize)[slot])) {
+          STA(wnret) = n;
+          STA(wnput) = STA(wsize)[slot];
+          ATOMIC_SET(STA(werr), 1);
         }
-        break;
-      case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "\a");
-        break;
+      }
+      csoundLockMutex(STA(wlock));
+      STA(wget) = get + 1;
+      csoundCondSignal(STA(wfree));
+      csoundUnlockMutex(STA(wlock));
     }
+    return 0;
+}
+
+static void writesf_async(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+{
+    int32_t put = STA(wput), used, slot;
+
+    csoundLockMutex(STA(wlock));
+    while ((used = put - STA(wget)) >= STA(wdepth))
+      csoundCondWait(STA(wfree), STA(wlock));   /* ring full: disk behind */
+    csoundUnlockMutex(STA(wlock));
+    if (used + 1 > STA(whigh))
+      STA(whigh) = used + 1;
+    slot = put % STA(wdepth);
+    memcpy(STA(wbufs)[slot], outbuf, nbytes);
+    STA(wsize)[slot] = nbytes;
+    csoundLockMutex(STA(wlock));
+    STA(wput) = put + 1;
+    csoundCondSignal(STA(wready));
+    csoundUnlockMutex(STA(wlock));
+    if (UNLIKELY(ATOMIC_GET(STA(werr))))
+      sndwrterr(csound, STA(wnret), STA(wnput));
+    heartbeat(csound);
+}
+
+static void disk_writer_locks_free(CSOUND *csound)
+{
+    csoundDestroyCondVar(STA(wready));
+    csoundDestroyCondVar(STA(wfree));
+    csoundDestroyMutex(STA(wlock));
+    STA(wready) = STA(wfree) = STA(wlock) = NULL;
+}
+
+static void disk_writer_start(CSOUND *csound)
+{
+    int     i, depth = csound->oparms->disk_buffers;
+
+    STA(wdepth) = depth;
+    STA(wbufs)  = (MYFLT**) csound->Malloc(csound, depth * sizeof(MYFLT*));
+    STA(wsize)  = (int*) csound->Malloc(csound, depth * sizeof(int));
+    for (i = 0; i < depth; i++)
+      STA(wbufs)[i] = (MYFLT*) csound->Malloc(csound, STA(outbufsiz));
+    STA(wput) = STA(wget) = 0;
+    STA(wstop) = STA(werr) = 0;
+    STA(whigh) = 0;
+    STA(wthread) = NULL;
+    STA(wlock)  = csoundCreateMutex(0);
+    STA(wready) = csoundCreateCondVar();
+    STA(wfree)  = csoundCreateCondVar();
+    if (STA(wlock) != NULL && STA(wready) != NULL && STA(wfree) != NULL)
+      STA(wthread) = csoundCreateThread(disk_writer, (void*) csound);
+    if (UNLIKELY(STA(wthread) == NULL)) {
+      csound->Warning(csound, Str("could not start disk writer thread, "
+                                  "writing synchronously"));
+      disk_writer_locks_free(csound);
+      return;
+    }
+    csound->audtran = writesf_async;
+}
+
+/* write out everything still queued and stop the writer */
+
+static void disk_writer_stop(CSOUND *csound)
+{
+    if (STA(wthread) == NULL)
+      return;
+    csoundLockMutex(STA(wlock));
+    STA(wstop) = 1;
+    csoundCondSignal(STA(wready));
+    csoundUnlockMutex(STA(wlock));
+    csoundJoinThread(STA(wthread));
+    STA(wthread) = NULL;
+    disk_writer_locks_free(csound);
+    csound->audtran = writesf;
+    csound->Message(csound, Str("disk writer: at most %d of %d buffers "
+                                "queued\n"), STA(whigh), STA(wdepth));
 }
 
 static int readsf(CSOUND *csound, MYFLT *inbuf, int inbufsize)
@@ -729,23 +679,7 @@ void sfopenout(CSOUND *csound)                  /* init for sound out       */
       }
       else if (strcmp(fName, "null") == 0) {
         STA(outfile) = NULL;
-        if (csound->dither_output && csound->oparms->outformat!=AE_FLOAT &&
-            csound->oparms->outformat!=AE_DOUBLE) {
-          if (csound->oparms->outformat==AE_SHORT)
-            if (csound->dither_output==1)
-              csound->audtran = writesf_dither_16;
-            else
-              csound->audtran = writesf_dither_u16;
-          else if (csound->oparms->outformat==AE_CHAR)
-            if (csound->dither_output==1)
-              csound->audtran = writesf_dither_8;
-            else
-              csound->audtran = writesf_dither_u8;
-          else
-            csound->audtran = writesf;
-        }
-        else
-          csound->audtran = writesf;
+        csound->audtran = writesf;
         goto outset;
       }
     }
@@ -827,14 +761,11 @@ void sfopenout(CSOUND *csound)                  /* init for sound out       */
     if (csound->dither_output && csound->oparms->outformat!=AE_FLOAT &&
         csound->oparms->outformat!=AE_DOUBLE) {
       if (csound->oparms->outformat==AE_SHORT)
-        csound->audtran = writesf_dither_16;
+        STA(ditherfn) = (csound->dither_output==1 ? dither_16 : dither_u16);
       else if (csound->oparms->outformat==AE_CHAR)
-        csound->audtran = writesf_dither_8;
-      else
-        csound->audtran = writesf;
+        STA(ditherfn) = (csound->dither_output==1 ? dither_8 : dither_u8);
     }
-    else
-      csound->audtran = writesf;
+    csound->audtran = writesf;
     /* Write any tags. */
     if ((s = csound->SF_id_title) != NULL && *s != '\0')
       sf_set_string(STA(outfile), SF_STR_TITLE, s);
@@ -866,6 +797,8 @@ void sfopenout(CSOUND *csound)                  /* init for sound out       */
     /* calc outbuf size & alloc bufspace */
     STA(outbufsiz) = O->outbufsamps * sizeof(MYFLT);
     STA(outbufp)   = STA(outbuf) = csound->Malloc(csound, STA(outbufsiz));
+    if (O->disk_buffers > 0 && STA(outfile) != NULL)
+      disk_writer_start(csound);
     if (STA(pipdevout) == 2)
       csound->Message(csound,
                       Str("writing %d sample blks of %lu-bit floats to %s\n"),
@@ -921,6 +854,7 @@ void sfcloseout(CSOUND *csound)
       csound->nrecs++;
       csound->audtran(csound, STA(outbuf), nb);
     }
+    disk_writer_stop(csound);
     if (STA(pipdevout) == 2 && (!STA(isfopen) || STA(pipdevin) != 2)) {
       /* close only if not open for input too */
       csound->rtclose_callback(csound);
@@ -22,16 +22,10 @@
 
 #include "csoundCore.h" /*                                      AOPS.C  */
 #include "aops.h"
+#include "aops_simd.h"
 #include <math.h>
 #include <time.h>
 
-#define POW2TABSIZI 4096
-#if ULONG_MAX == 18446744073709551615UL
-#  define POW2MAX   (24.0)
-#else
-#  define POW2MAX   (15.0)
-#endif
-
 #define EIPT3       (25.0/3.0)
 #define LOGTWO      (0.69314718055994530942)
 #define STEPS       (32768)
@@ -275,9 +269,9 @@ int32_t modkk(CSOUND *csound, AOP *p)
     return OK;
 }
 
-#define KA(OPNAME,OP)                                  \
+#define KA(OPNAME,OP,K)                                \
   int32_t OPNAME(CSOUND *csound, AOP *p) {             \
-    uint32_t n, nsmps = CS_KSMPS;                      \
+    uint32_t nsmps = CS_KSMPS;                         \
     IGN(csound);                                       \
     if (LIKELY(nsmps!=1)) {                            \
       MYFLT   *r, a, *b;                               \
@@ -291,8 +285,8 @@ int32_t modkk(CSOUND *csound, AOP *p)
         nsmps -= early;                                \
         memset(&r[nsmps], '\0', early*sizeof(MYFLT));  \
       }                                                \
-      for (n=offset; n<nsmps; n++)                     \
-        r[n] = a OP b[n];                              \
+      if (LIKELY(offset < nsmps))                      \
+        aops_kernels()->sv[K](&r[offset], a, &b[offset], nsmps-offset); \
       return OK;                                       \
     }                                                  \
     else {                                             \
@@ -302,10 +296,10 @@ int32_t modkk(CSOUND *csound, AOP *p)
   }
 
 
-KA(addka,+)
-KA(subka,-)
-KA(mulka,*)
-KA(divka,/)
+KA(addka,+,AOPS_ADD)
+KA(subka,-,AOPS_SUB)
+KA(mulka,*,AOPS_MUL)
+KA(divka,/,AOPS_DIV)
 
 int32_t modka(CSOUND *csound, AOP *p)
 {
@@ -328,9 +322,9 @@ int32_t modka(CSOUND *csound, AOP *p)
     return OK;
 }
 
-#define AK(OPNAME,OP)                           \
+#define AK(OPNAME,OP,K)                         \
   int32_t OPNAME(CSOUND *csound, AOP *p) {      \
-    uint32_t n, nsmps = CS_KSMPS;               \
+    uint32_t nsmps = CS_KSMPS;                  \
     IGN(csound);                                \
     if (LIKELY(nsmps != 1)) {                   \
       MYFLT   *r, *a, b;                        \
@@ -345,8 +339,8 @@ int32_t modka(CSOUND *csound, AOP *p)
         nsmps -= early;                         \
         memset(&r[nsmps], '\0', early*sizeof(MYFLT)); \
       }                                         \
-      for (n=offset; n<nsmps; n++)              \
-        r[n] = a[n] OP b;                       \
+      if (LIKELY(offset < nsmps))               \
+        aops_kernels()->vs[K](&r[offset], &a[offset], b, nsmps-offset); \
       return OK;                                \
     }                                           \
     else {                                      \
@@ -355,12 +349,12 @@ int32_t modka(CSOUND *csound, AOP *p)
     }                                           \
 }
 
-AK(addak,+)
-AK(subak,-)
-AK(mulak,*)
-//AK(divak,/)
+AK(addak,+,AOPS_ADD)
+AK(subak,-,AOPS_SUB)
+AK(mulak,*,AOPS_MUL)
+//AK(divak,/,AOPS_DIV)
 int32_t divak(CSOUND *csound, AOP *p) {
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t nsmps = CS_KSMPS;
     MYFLT b = *p->b;
     if (LIKELY(nsmps != 1)) {
       MYFLT   *r, *a;
@@ -377,8 +371,8 @@ int32_t divak(CSOUND *csound, AOP *p) {
         nsmps -= early;
         memset(&r[nsmps], '\0', early*sizeof(MYFLT));
       }
-      for (n=offset; n<nsmps; n++)
-        r[n] = a[n] / b;
+      if (LIKELY(offset < nsmps))
+        aops_kernels()->vs[AOPS_DIV](&r[offset], &a[offset], b, nsmps-offset);
       return OK;
     }
     else {
@@ -411,11 +405,11 @@ int32_t modak(CSOUND *csound, AOP *p)
     return OK;
 }
 
-#define AA(OPNAME,OP)                           \
+#define AA(OPNAME,OP,K)                         \
   int32_t OPNAME(CSOUND *csound, AOP *p) {      \
   MYFLT   *r, *a, *b;                           \
   IGN(csound);                                  \
-  uint32_t n, nsmps = CS_KSMPS;                 \
+  uint32_t nsmps = CS_KSMPS;                    \
   if (LIKELY(nsmps!=1)) {                       \
     uint32_t offset = p->h.insdshead->ksmps_offset;  \
     uint32_t early  = p->h.insdshead->ksmps_no_end;  \
@@ -427,8 +421,9 @@ int32_t modak(CSOUND *csound, AOP *p)
       nsmps -= early;                           \
       memset(&r[nsmps], '\0', early*sizeof(MYFLT)); \
     }                                           \
-    for (n=offset; n<nsmps; n++)                \
-      r[n] = a[n] OP b[n];                      \
+    if (LIKELY(offset < nsmps))                 \
+      aops_kernels()->vv[K](&r[offset], &a[offset], &b[offset], \
+                            nsmps-offset);      \
     return OK;                                  \
   }                                             \
     else {                                      \
@@ -437,52 +432,12 @@ int32_t modak(CSOUND *csound, AOP *p)
     }                                           \
   }
 
-/* VL
-   experimental code using SSE for operations
-   needs memory alignment - 16 bytes
-*/
-#ifdef USE_SSE
-#include "emmintrin.h"
-#define AA_VEC(OPNAME,OP)                   \
-int32_t OPNAME(CSOUND *csound, AOP *p){     \
-  MYFLT   *r, *a, *b;                       \
-  __m128d va, vb;                           \
-  uint32_t n, nsmps = CS_KSMPS, end;        \
-  if (LIKELY(nsmps!=1)) {                   \
-  uint32_t offset = p->h.insdshead->ksmps_offset; \
-  uint32_t early  = p->h.insdshead->ksmps_no_end; \
-  r = p->r; a = p->a; b = p->b;             \
-  if (UNLIKELY(offset)) memset(r, '\0', offset*sizeof(MYFLT)); \
-  if (UNLIKELY(early)) {                    \
-      nsmps -= early;                       \
-      memset(&r[nsmps], '\0', early*sizeof(MYFLT));  \
-  } \
-  end = nsmps; \
-  for (n=offset; n<end; n+=2) { \
-   va = _mm_loadu_pd(&a[n]); \
-   vb = _mm_loadu_pd(&b[n]); \
-   va = OP(va,vb);\
-   _mm_storeu_pd(&r[n],va); \
-  }     \
-  return OK; \
-  } \
-   else { \
-     *p->r = *p->a + *p->b;\
-      return OK; \
-   }             \
-} \
-
-AA_VEC(addaa,_mm_add_pd)
-AA_VEC(subaa,_mm_sub_pd)
-AA_VEC(mulaa,_mm_mul_pd)
-AA_VEC(divaa,_mm_div_pd)
-
-#else
-AA(addaa,+)
-AA(subaa,-)
-AA(mulaa,*)
-AA(divaa,/)
-#endif
+/* the loops run in the kernels of aops_simd.c, which use SSE2, AVX2 or
+   AVX-512 according to the CPU */
+AA(addaa,+,AOPS_ADD)
+AA(subaa,-,AOPS_SUB)
+AA(mulaa,*,AOPS_MUL)
+AA(divaa,/,AOPS_DIV)
 
 int32_t modaa(CSOUND *csound, AOP *p)
 {
@@ -505,6 +460,119 @@ int32_t modaa(CSOUND *csound, AOP *p)
     return OK;
 }
 
+/* Fused a-rate arithmetic.  csound_orc_optimize() collapses chains of
+   the ##add/##sub/##mul/##div a-rate opcodes above into one ##aexpr
+   call.  The first argument is the expression in postfix form, where
+   'a' and 'k' take the next argument as an audio or scalar leaf and
+   + - * / apply an operator; e.g. a1 = (a2*k1 + a3*k2)*0.5 arrives as
+   "ak*ak*+k*" a2 k1 a3 k2 0.5.  The samples are evaluated in chunks of
+   AEXPR_CHUNK so intermediate results stay in small stack registers,
+   with per-element operations in the same order as the unfused code. */
+
+int32_t aexpr_set(CSOUND *csound, AEXPR *p)
+{
+    const char *s = (const char *) p->prog->data;
+    int16_t stk[AEXPR_MAXARGS];
+    char    rate[AEXPR_MAXARGS];
+    int32_t sp = 0, nargs = 0, maxargs = p->INOCOUNT - 1;
+
+    p->ninsn = 0;
+    for ( ; s != NULL && *s != '\0'; s++) {
+      AEXPR_INSN *in;
+      switch (*s) {
+      case 'a':
+      case 'k':
+        if (UNLIKELY(nargs >= maxargs || sp >= AEXPR_MAXARGS))
+          goto err;
+        rate[sp] = *s;
+        stk[sp++] = (int16_t) nargs++;
+        break;
+      case '+':
+      case '-':
+      case '*':
+      case '/':
+        if (UNLIKELY(sp < 2 || (rate[sp-2] == 'k' && rate[sp-1] == 'k') ||
+                     sp - 2 >= AEXPR_MAXREG))
+          goto err;
+        in = &p->insn[p->ninsn++];
+        in->op = *s;
+        in->kind = (rate[sp-2] == 'k' ? AEXPR_SV :
+                    rate[sp-1] == 'k' ? AEXPR_VS : AEXPR_VV);
+        in->a = stk[sp-2];
+        in->b = stk[sp-1];
+        sp--;
+        in->dst = (int16_t) (-sp);     /* register sp-1 */
+        stk[sp-1] = in->dst;
+        rate[sp-1] = 'a';
+        break;
+      default:
+        goto err;
+      }
+    }
+    if (UNLIKELY(sp != 1 || p->ninsn == 0 || nargs != maxargs))
+      goto err;
+    return OK;
+ err:
+    return csound->InitError(csound, Str("invalid fused expression"));
+}
+
+#define AEXPR_LOOP(OP)                                        \
+    switch (in->kind) {                                       \
+    case AEXPR_VV:                                            \
+      for (k = 0; k < len; k++) d[k] = a[k] OP b[k];          \
+      break;                                                  \
+    case AEXPR_VS:                                            \
+      for (k = 0; k < len; k++) d[k] = a[k] OP sb;            \
+      break;                                                  \
+    default:                                                  \
+      for (k = 0; k < len; k++) d[k] = sa OP b[k];            \
+    }
+
+int32_t aexpr(CSOUND *csound, AEXPR *p)
+{
+    MYFLT   reg[AEXPR_MAXREG][AEXPR_CHUNK];
+    MYFLT   *r = p->r;
+    uint32_t offset = p->h.insdshead->ksmps_offset;
+    uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t n, k, len, nsmps = CS_KSMPS;
+    int32_t i, last = p->ninsn - 1;
+
+    if (LIKELY(nsmps != 1)) {
+      if (UNLIKELY(offset)) memset(r, '\0', offset*sizeof(MYFLT));
+      if (UNLIKELY(early)) {
+        nsmps -= early;
+        memset(&r[nsmps], '\0', early*sizeof(MYFLT));
+      }
+    }
+    else offset = 0;
+    for (i = 0; i <= last; i++) {       /* as divak */
+      if (UNLIKELY(p->insn[i].op == '/' && p->insn[i].kind == AEXPR_VS &&
+                   *p->args[p->insn[i].b] == FL(0.0)))
+        csound->Warning(csound, Str("Division by zero"));
+    }
+    for (n = offset; n < nsmps; n += len) {
+      len = nsmps - n;
+      if (len > AEXPR_CHUNK) len = AEXPR_CHUNK;
+      for (i = 0; i <= last; i++) {
+        const AEXPR_INSN *in = &p->insn[i];
+        MYFLT *d = (i == last ? &r[n] : reg[-in->dst-1]);
+        const MYFLT *a = NULL, *b = NULL;
+        MYFLT sa = FL(0.0), sb = FL(0.0);
+        if (in->kind == AEXPR_SV) sa = *p->args[in->a];
+        else a = (in->a < 0 ? reg[-in->a-1] : &p->args[in->a][n]);
+        if (in->kind == AEXPR_VS) sb = *p->args[in->b];
+        else b = (in->b < 0 ? reg[-in->b-1] : &p->args[in->b][n]);
+        switch (in->op) {
+        case '+': AEXPR_LOOP(+); break;
+        case '-': AEXPR_LOOP(-); break;
+        case '*': AEXPR_LOOP(*); break;
+        default:  AEXPR_LOOP(/);
+        }
+      }
+    }
+    return OK;
+}
+
 int32_t divzkk(CSOUND *csound, DIVZ *p)
 {
     IGN(csound);
@@ -875,7 +943,7 @@ int32_t aampdb(CSOUND *csound, EVAL *p)
 {
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps =CS_KSMPS;
+    uint32_t nsmps =CS_KSMPS;
     MYFLT   *r = p->r, *a = p->a;
     IGN(csound);
 
@@ -884,8 +952,28 @@ int32_t aampdb(CSOUND *csound, EVAL *p)
       nsmps -= early;
       memset(&r[nsmps], '\0', early*sizeof(MYFLT));
     }
-    for (n = offset; n < nsmps; n++)
-      r[n] = EXP(a[n] * LOG10D20);
+    if (LIKELY(offset < nsmps))
+      aops_kernels()->expk(&r[offset], &a[offset], (MYFLT) LOG10D20, FL(1.0),
+                           nsmps-offset);
+    return OK;
+}
+
+int32_t adbamp(CSOUND *csound, EVAL *p)
+{
+    uint32_t offset = p->h.insdshead->ksmps_offset;
+    uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t nsmps =CS_KSMPS;
+    MYFLT   *r = p->r, *a = p->a;
+    IGN(csound);
+
+    if (UNLIKELY(offset)) memset(r, '\0', offset*sizeof(MYFLT));
+    if (UNLIKELY(early)) {
+      nsmps -= early;
+      memset(&r[nsmps], '\0', early*sizeof(MYFLT));
+    }
+    if (LIKELY(offset < nsmps))
+      aops_kernels()->logk(&r[offset], &a[offset], (MYFLT) LOG10D20,
+                           nsmps-offset);
     return OK;
 }
 
@@ -905,7 +993,7 @@ int32_t aampdbfs(CSOUND *csound, EVAL *p)
 {
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps =CS_KSMPS;
+    uint32_t nsmps =CS_KSMPS;
     MYFLT   *r, *a;
 
     r = p->r;
@@ -915,8 +1003,9 @@ int32_t aampdbfs(CSOUND *csound, EVAL *p)
       nsmps -= early;
       memset(&r[nsmps], '\0', early*sizeof(MYFLT));
     }
-    for (n = offset; n < nsmps; n++)
-      r[n] = csound->e0dbfs * EXP(a[n] * LOG10D20);
+    if (LIKELY(offset < nsmps))
+      aops_kernels()->expk(&r[offset], &a[offset], (MYFLT) LOG10D20,
+                           csound->e0dbfs, nsmps-offset);
     return OK;
 }
 
@@ -1042,10 +1131,9 @@ int32_t cpsoct(CSOUND *csound, EVAL *p)
 int32_t acpsoct(CSOUND *csound, EVAL *p)
 {
     MYFLT   *r, *a;
-    int32_t    loct;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps =CS_KSMPS;
+    uint32_t nsmps =CS_KSMPS;
 
     a = p->a;
     r = p->r;
@@ -1054,10 +1142,9 @@ int32_t acpsoct(CSOUND *csound, EVAL *p)
       nsmps -= early;
       memset(&r[nsmps], '\0', early*sizeof(MYFLT));
     }
-    for (n = offset; n < nsmps; n++) {
-      loct = (int32_t)(a[n] * OCTRES);
-      r[n] = CPSOCTL(loct);
-    }
+    if (LIKELY(offset < nsmps))
+      aops_kernels()->cpsoct(&r[offset], &a[offset], csound->cpsocfrc,
+                             nsmps-offset);
     return OK;
 }
 
@@ -1264,14 +1351,15 @@ int32_t powoftwoa(CSOUND *csound, EVAL *p)
     MYFLT    *a=p->a, *r=p->r;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps =CS_KSMPS;
+    uint32_t nsmps =CS_KSMPS;
     if (UNLIKELY(offset)) memset(r, '\0', offset*sizeof(MYFLT));
     if (UNLIKELY(early)) {
       nsmps -= early;
       memset(&r[nsmps], '\0', early*sizeof(MYFLT));
     }
-    for (n = offset; n < nsmps; n++)
-      r[n] = csound->Pow2(csound,a[n]);
+    if (LIKELY(offset < nsmps))
+      aops_kernels()->pow2(&r[offset], &a[offset], csound->powerof2,
+                           nsmps-offset);
     return OK;
 }
 
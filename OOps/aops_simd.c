@@ -0,0 +1,473 @@
+/*
+  aops_simd.c:
+
+  Vector kernels for the arithmetic and conversion opcodes in aops.c,
+  with the instruction set picked at runtime
+
+  This file is part of Csound.
+
+  The Csound Library is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Csound is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+
+/*
+  The kernels are written once in aops_simd_tmpl.h against a small set
+  of vector macros, and instantiated here for SSE2, AVX2 and AVX-512F
+  on x86 (the last two with function target attributes, so the rest of
+  the library is still built for the baseline CPU). SSE2 only gets the
+  arithmetic kernels, as it has no gather. Everywhere else, and for the
+  conversions without a vector version, the plain C loops are used.
+*/
+
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include "csoundCore.h"
+#include "aops_simd.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+  (defined(__i386__) && defined(__SSE2__))
+#  define AOPS_X86 1
+#  include <emmintrin.h>
+#  if defined(__GNUC__) || defined(_MSC_VER)
+#    define AOPS_AVX 1
+#    include <immintrin.h>
+#  endif
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#endif
+
+#if defined(__GNUC__)
+#  define AOPS_TARGET_AVX2   __attribute__((target("avx2")))
+#  define AOPS_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#  define AOPS_TARGET_AVX2
+#  define AOPS_TARGET_AVX512
+#endif
+
+/* scalar kernels, also used for the tails of the vector ones */
+
+#define SCALAR_ARITH(NAME, OP)                                          \
+static void vv_##NAME##_scalar(MYFLT *r, const MYFLT *a, const MYFLT *b,\
+                               uint32_t n)                              \
+{                                                                       \
+    uint32_t i;                                                         \
+    for (i = 0; i < n; i++) r[i] = a[i] OP b[i];                        \
+}                                                                       \
+static void vs_##NAME##_scalar(MYFLT *r, const MYFLT *a, MYFLT b,       \
+                               uint32_t n)                              \
+{                                                                       \
+    uint32_t i;                                                         \
+    for (i = 0; i < n; i++) r[i] = a[i] OP b;                           \
+}                                                                       \
+static void sv_##NAME##_scalar(MYFLT *r, MYFLT a, const MYFLT *b,       \
+                               uint32_t n)                              \
+{                                                                       \
+    uint32_t i;                                                         \
+    for (i = 0; i < n; i++) r[i] = a OP b[i];                           \
+}
+
+SCALAR_ARITH(add, +)
+SCALAR_ARITH(sub, -)
+SCALAR_ARITH(mul, *)
+SCALAR_ARITH(div, /)
+
+/* as csoundPow2() */
+static void pow2_scalar(MYFLT *r, const MYFLT *a, const MYFLT *tab,
+                        uint32_t n)
+{
+    uint32_t i;
+    for (i = 0; i < n; i++) {
+      MYFLT x = a[i];
+      int32_t m;
+      if (x > POW2MAX) x = POW2MAX;
+      else if (x < -POW2MAX) x = -POW2MAX;
+      m = (int32_t)MYFLT2LRND(x * FL(POW2TABSIZI)) + POW2MAX*POW2TABSIZI;
+      r[i] = ((MYFLT) (1UL << (m >> 12)) * tab[m & (POW2TABSIZI-1)]);
+    }
+}
+
+/* as CPSOCTL() */
+static void cpsoct_scalar(MYFLT *r, const MYFLT *a, const MYFLT *tab,
+                          uint32_t n)
+{
+    uint32_t i;
+    for (i = 0; i < n; i++) {
+      int32_t loct = (int32_t)(a[i] * OCTRES);
+      r[i] = (MYFLT)(1<<(loct>>13)) * tab[loct & (OCTRES-1)];
+    }
+}
+
+static void expk_scalar(MYFLT *r, const MYFLT *a, MYFLT k, MYFLT s,
+                        uint32_t n)
+{
+    uint32_t i;
+    for (i = 0; i < n; i++) r[i] = s * EXP(a[i] * k);
+}
+
+static void logk_scalar(MYFLT *r, const MYFLT *a, MYFLT k, uint32_t n)
+{
+    uint32_t i;
+    for (i = 0; i < n; i++) r[i] = LOG(FABS(a[i])) / k;
+}
+
+/* as spoutsf() in libsnd.c did per sample */
+static uint32_t outchn_scalar(MYFLT *sp, MYFLT *out, uint32_t stride,
+                              const MYFLT *a, MYFLT s, MYFLT lim,
+                              MYFLT *peak, int32_t *nover, uint32_t n)
+{
+    uint32_t i, pos = n;
+    int32_t c = 0;
+    MYFLT   pk = *peak;
+    for (i = 0; i < n; i++) {
+      MYFLT x = a[i], ax = x < FL(0.0) ? -x : x;
+      sp[i*stride] = x;
+      if (out != NULL) out[i*stride] = x * s;
+      if (ax > pk) {
+        pk = ax;
+        pos = i;
+      }
+      if (ax > lim) c++;
+    }
+    *peak = pk;
+    *nover += c;
+    return pos;
+}
+
+static const AOPS_KERNELS kernels_scalar = {
+    { vv_add_scalar, vv_sub_scalar, vv_mul_scalar, vv_div_scalar },
+    { vs_add_scalar, vs_sub_scalar, vs_mul_scalar, vs_div_scalar },
+    { sv_add_scalar, sv_sub_scalar, sv_mul_scalar, sv_div_scalar },
+    pow2_scalar, cpsoct_scalar, expk_scalar, logk_scalar, outchn_scalar,
+    "scalar"
+};
+
+/* lanes set in a compare mask */
+static inline uint32_t mask_count(uint32_t m)
+{
+    uint32_t c = 0;
+    for ( ; m; m &= m - 1) c++;
+    return c;
+}
+
+#ifdef AOPS_X86
+
+/* SSE2 */
+
+#define ISA      sse2
+#define ISA_NAME "sse2"
+#define TGT
+#ifdef USE_DOUBLE
+#  define VT          __m128d
+#  define VLOAD(p)    _mm_loadu_pd(p)
+#  define VSTORE(p,v) _mm_storeu_pd(p, v)
+#  define VSET1(x)    _mm_set1_pd(x)
+#  define VADD        _mm_add_pd
+#  define VSUB        _mm_sub_pd
+#  define VMUL        _mm_mul_pd
+#  define VDIV        _mm_div_pd
+#  define VMAX        _mm_max_pd
+#  define VABS(x)     _mm_andnot_pd(_mm_set1_pd(-0.0), x)
+#  define VCNTGT(x,l) mask_count(_mm_movemask_pd(_mm_cmpgt_pd(x, l)))
+#else
+#  define VT          __m128
+#  define VLOAD(p)    _mm_loadu_ps(p)
+#  define VSTORE(p,v) _mm_storeu_ps(p, v)
+#  define VSET1(x)    _mm_set1_ps(x)
+#  define VADD        _mm_add_ps
+#  define VSUB        _mm_sub_ps
+#  define VMUL        _mm_mul_ps
+#  define VDIV        _mm_div_ps
+#  define VMAX        _mm_max_ps
+#  define VABS(x)     _mm_andnot_ps(_mm_set1_ps(-0.0f), x)
+#  define VCNTGT(x,l) mask_count(_mm_movemask_ps(_mm_cmpgt_ps(x, l)))
+#endif
+#define W ((uint32_t) (16 / sizeof(MYFLT)))
+#include "aops_simd_tmpl.h"
+#undef ISA
+#undef ISA_NAME
+#undef TGT
+#undef VT
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VDIV
+#undef VMAX
+#undef VABS
+#undef VCNTGT
+#undef W
+
+#ifdef AOPS_AVX
+
+/* AVX2: the index vector VI holds one int32 per lane */
+
+#define ISA      avx2
+#define ISA_NAME "avx2"
+#define TGT      AOPS_TARGET_AVX2
+#ifdef USE_DOUBLE
+#  define VT          __m256d
+#  define VI          __m128i
+#  define VLOAD(p)    _mm256_loadu_pd(p)
+#  define VSTORE(p,v) _mm256_storeu_pd(p, v)
+#  define VSET1(x)    _mm256_set1_pd(x)
+#  define VADD        _mm256_add_pd
+#  define VSUB        _mm256_sub_pd
+#  define VMUL        _mm256_mul_pd
+#  define VDIV        _mm256_div_pd
+#  define VMIN        _mm256_min_pd
+#  define VMAX        _mm256_max_pd
+#  define VABS(x)     _mm256_andnot_pd(_mm256_set1_pd(-0.0), x)
+#  define VCNTGT(x,l) \
+  mask_count(_mm256_movemask_pd(_mm256_cmp_pd(x, l, _CMP_GT_OQ)))
+#  define VROUND(x)   _mm256_round_pd(x, _MM_FROUND_TO_NEAREST_INT | \
+                                      _MM_FROUND_NO_EXC)
+#  define VOUT(x,lo,hi)                                           \
+  _mm256_movemask_pd(_mm256_or_pd(_mm256_cmp_pd(x, lo, _CMP_NGE_UQ), \
+                                  _mm256_cmp_pd(x, hi, _CMP_NLE_UQ)))
+#  define VLTSEL(x,y,a,b) \
+  _mm256_blendv_pd(b, a, _mm256_cmp_pd(x, y, _CMP_LT_OQ))
+/* mantissa in [0.5, 1) and exponent of a positive normal number */
+#  define VFREXP(x,m,e) {                                         \
+    __m256i bits_ = _mm256_castpd_si256(x);                       \
+    e = _mm256_sub_pd(_mm256_castsi256_pd(                        \
+          _mm256_or_si256(_mm256_srli_epi64(bits_, 52),           \
+                  _mm256_set1_epi64x(0x4330000000000000LL))),     \
+          _mm256_set1_pd(4503599627370496.0 + 1022.0));           \
+    m = _mm256_castsi256_pd(_mm256_or_si256(                      \
+          _mm256_and_si256(bits_,                                 \
+                  _mm256_set1_epi64x(0x000fffffffffffffLL)),      \
+          _mm256_set1_epi64x(0x3fe0000000000000LL)));             \
+  }
+#  define VCVTRN(x)   _mm256_cvtpd_epi32(x)
+#  define VCVTTZ(x)   _mm256_cvttpd_epi32(x)
+#  define VGATHER(t,i) _mm256_i32gather_pd(t, i, 8)
+#  define VIADD(i,c)  _mm_add_epi32(i, _mm_set1_epi32(c))
+#  define VIAND(i,c)  _mm_and_si128(i, _mm_set1_epi32(c))
+#  define VISRA(i,c)  _mm_srai_epi32(i, c)
+#  define VEXP2I(i)                                               \
+  _mm256_castsi256_pd(_mm256_slli_epi64(                          \
+      _mm256_add_epi64(_mm256_cvtepi32_epi64(i),                  \
+                       _mm256_set1_epi64x(1023)), 52))
+#else
+#  define VT          __m256
+#  define VI          __m256i
+#  define VLOAD(p)    _mm256_loadu_ps(p)
+#  define VSTORE(p,v) _mm256_storeu_ps(p, v)
+#  define VSET1(x)    _mm256_set1_ps(x)
+#  define VADD        _mm256_add_ps
+#  define VSUB        _mm256_sub_ps
+#  define VMUL        _mm256_mul_ps
+#  define VDIV        _mm256_div_ps
+#  define VMIN        _mm256_min_ps
+#  define VMAX        _mm256_max_ps
+#  define VABS(x)     _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x)
+#  define VCNTGT(x,l) \
+  mask_count(_mm256_movemask_ps(_mm256_cmp_ps(x, l, _CMP_GT_OQ)))
+#  define VROUND(x)   _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | \
+                                      _MM_FROUND_NO_EXC)
+#  define VOUT(x,lo,hi)                                           \
+  _mm256_movemask_ps(_mm256_or_ps(_mm256_cmp_ps(x, lo, _CMP_NGE_UQ), \
+                                  _mm256_cmp_ps(x, hi, _CMP_NLE_UQ)))
+#  define VLTSEL(x,y,a,b) \
+  _mm256_blendv_ps(b, a, _mm256_cmp_ps(x, y, _CMP_LT_OQ))
+#  define VFREXP(x,m,e) {                                         \
+    __m256i bits_ = _mm256_castps_si256(x);                       \
+    e = _mm256_cvtepi32_ps(_mm256_sub_epi32(                      \
+          _mm256_srli_epi32(bits_, 23), _mm256_set1_epi32(126))); \
+    m = _mm256_castsi256_ps(_mm256_or_si256(                      \
+          _mm256_and_si256(bits_, _mm256_set1_epi32(0x007fffff)), \
+          _mm256_set1_epi32(0x3f000000)));                        \
+  }
+#  define VCVTRN(x)   _mm256_cvtps_epi32(x)
+#  define VCVTTZ(x)   _mm256_cvttps_epi32(x)
+#  define VGATHER(t,i) _mm256_i32gather_ps(t, i, 4)
+#  define VIADD(i,c)  _mm256_add_epi32(i, _mm256_set1_epi32(c))
+#  define VIAND(i,c)  _mm256_and_si256(i, _mm256_set1_epi32(c))
+#  define VISRA(i,c)  _mm256_srai_epi32(i, c)
+#  define VEXP2I(i)                                               \
+  _mm256_castsi256_ps(_mm256_slli_epi32(                          \
+      _mm256_add_epi32(i, _mm256_set1_epi32(127)), 23))
+#endif
+#define W ((uint32_t) (32 / sizeof(MYFLT)))
+#include "aops_simd_tmpl.h"
+#undef ISA
+#undef ISA_NAME
+#undef TGT
+#undef VT
+#undef VI
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VDIV
+#undef VMIN
+#undef VMAX
+#undef VABS
+#undef VCNTGT
+#undef VROUND
+#undef VOUT
+#undef VLTSEL
+#undef VFREXP
+#undef VCVTRN
+#undef VCVTTZ
+#undef VGATHER
+#undef VIADD
+#undef VIAND
+#undef VISRA
+#undef VEXP2I
+#undef W
+
+/* AVX-512F */
+
+#define ISA      avx512
+#define ISA_NAME "avx512"
+#define TGT      AOPS_TARGET_AVX512
+#ifdef USE_DOUBLE
+#  define VT          __m512d
+#  define VI          __m256i
+#  define VLOAD(p)    _mm512_loadu_pd(p)
+#  define VSTORE(p,v) _mm512_storeu_pd(p, v)
+#  define VSET1(x)    _mm512_set1_pd(x)
+#  define VADD        _mm512_add_pd
+#  define VSUB        _mm512_sub_pd
+#  define VMUL        _mm512_mul_pd
+#  define VDIV        _mm512_div_pd
+#  define VMIN        _mm512_min_pd
+#  define VMAX        _mm512_max_pd
+#  define VABS(x)     _mm512_abs_pd(x)
+#  define VCNTGT(x,l) mask_count(_mm512_cmp_pd_mask(x, l, _CMP_GT_OQ))
+#  define VROUND(x)   _mm512_roundscale_pd(x, _MM_FROUND_TO_NEAREST_INT | \
+                                           _MM_FROUND_NO_EXC)
+#  define VOUT(x,lo,hi)                                           \
+  (_mm512_cmp_pd_mask(x, lo, _CMP_NGE_UQ) |                       \
+   _mm512_cmp_pd_mask(x, hi, _CMP_NLE_UQ))
+#  define VLTSEL(x,y,a,b) \
+  _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, y, _CMP_LT_OQ), b, a)
+#  define VFREXP(x,m,e) {                                         \
+    e = _mm512_add_pd(_mm512_getexp_pd(x), _mm512_set1_pd(1.0));  \
+    m = _mm512_getmant_pd(x, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_zero); \
+  }
+#  define VCVTRN(x)   _mm512_cvtpd_epi32(x)
+#  define VCVTTZ(x)   _mm512_cvttpd_epi32(x)
+#  define VGATHER(t,i) _mm512_i32gather_pd(i, t, 8)
+#  define VIADD(i,c)  _mm256_add_epi32(i, _mm256_set1_epi32(c))
+#  define VIAND(i,c)  _mm256_and_si256(i, _mm256_set1_epi32(c))
+#  define VISRA(i,c)  _mm256_srai_epi32(i, c)
+#  define VEXP2I(i)                                               \
+  _mm512_castsi512_pd(_mm512_slli_epi64(                          \
+      _mm512_add_epi64(_mm512_cvtepi32_epi64(i),                  \
+                       _mm512_set1_epi64(1023)), 52))
+#else
+#  define VT          __m512
+#  define VI          __m512i
+#  define VLOAD(p)    _mm512_loadu_ps(p)
+#  define VSTORE(p,v) _mm512_storeu_ps(p, v)
+#  define VSET1(x)    _mm512_set1_ps(x)
+#  define VADD        _mm512_add_ps
+#  define VSUB        _mm512_sub_ps
+#  define VMUL        _mm512_mul_ps
+#  define VDIV        _mm512_div_ps
+#  define VMIN        _mm512_min_ps
+#  define VMAX        _mm512_max_ps
+#  define VABS(x)     _mm512_abs_ps(x)
+#  define VCNTGT(x,l) mask_count(_mm512_cmp_ps_mask(x, l, _CMP_GT_OQ))
+#  define VROUND(x)   _mm512_roundscale_ps(x, _MM_FROUND_TO_NEAREST_INT | \
+                                           _MM_FROUND_NO_EXC)
+#  define VOUT(x,lo,hi)                                           \
+  (_mm512_cmp_ps_mask(x, lo, _CMP_NGE_UQ) |                       \
+   _mm512_cmp_ps_mask(x, hi, _CMP_NLE_UQ))
+#  define VLTSEL(x,y,a,b) \
+  _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, y, _CMP_LT_OQ), b, a)
+#  define VFREXP(x,m,e) {                                         \
+    e = _mm512_add_ps(_mm512_getexp_ps(x), _mm512_set1_ps(1.0f)); \
+    m = _mm512_getmant_ps(x, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_zero); \
+  }
+#  define VCVTRN(x)   _mm512_cvtps_epi32(x)
+#  define VCVTTZ(x)   _mm512_cvttps_epi32(x)
+#  define VGATHER(t,i) _mm512_i32gather_ps(i, t, 4)
+#  define VIADD(i,c)  _mm512_add_epi32(i, _mm512_set1_epi32(c))
+#  define VIAND(i,c)  _mm512_and_si512(i, _mm512_set1_epi32(c))
+#  define VISRA(i,c)  _mm512_srai_epi32(i, c)
+#  define VEXP2I(i)                                               \
+  _mm512_castsi512_ps(_mm512_slli_epi32(                          \
+      _mm512_add_epi32(i, _mm512_set1_epi32(127)), 23))
+#endif
+#define W ((uint32_t) (64 / sizeof(MYFLT)))
+#include "aops_simd_tmpl.h"
+
+#endif  /* AOPS_AVX */
+#endif  /* AOPS_X86 */
+
+int32_t aops_cpu_has(int32_t feature)
+{
+#if defined(AOPS_AVX) && defined(_MSC_VER)
+    int32_t r[4], fma;
+    unsigned long long xcr0;
+    __cpuid(r, 0);
+    if (r[0] < 7) return 0;
+    __cpuid(r, 1);
+    /* OSXSAVE and AVX, and the OS saves the YMM (and ZMM) state */
+    if ((r[2] & (3 << 27)) != (3 << 27)) return 0;
+    fma = (r[2] & (1 << 12)) != 0;
+    xcr0 = _xgetbv(0);
+    if ((xcr0 & 6) != 6 ||
+        (feature == AOPS_CPU_AVX512F && (xcr0 & 0xe6) != 0xe6)) return 0;
+    if (feature == AOPS_CPU_FMA) return fma;
+    __cpuidex(r, 7, 0);
+    return (r[1] & (feature == AOPS_CPU_AVX512F ? (1 << 16) : (1 << 5))) != 0;
+#elif defined(AOPS_AVX)
+    __builtin_cpu_init();
+    switch (feature) {
+    case AOPS_CPU_AVX2:    return __builtin_cpu_supports("avx2");
+    case AOPS_CPU_AVX512F: return __builtin_cpu_supports("avx512f");
+    case AOPS_CPU_FMA:     return __builtin_cpu_supports("fma");
+    }
+    return 0;
+#else
+    (void) feature;
+    return 0;
+#endif
+}
+
+int32_t aops_kernel_sets(const AOPS_KERNELS **sets, int32_t max)
+{
+    int32_t n = 0;
+    if (n < max) sets[n++] = &kernels_scalar;
+#ifdef AOPS_X86
+    if (n < max) sets[n++] = &kernels_sse2;
+#  ifdef AOPS_AVX
+    if (n < max && aops_cpu_has(AOPS_CPU_AVX2)) sets[n++] = &kernels_avx2;
+    if (n < max && aops_cpu_has(AOPS_CPU_AVX512F))
+      sets[n++] = &kernels_avx512;
+#  endif
+#endif
+    return n;
+}
+
+const AOPS_KERNELS *aops_kernels(void)
+{
+    static const AOPS_KERNELS *volatile k = NULL;
+    if (UNLIKELY(k == NULL)) {
+      const AOPS_KERNELS *sets[4];
+      k = sets[aops_kernel_sets(sets, 4) - 1];
+    }
+    return k;
+}
@@ -0,0 +1,298 @@
+/*
+  aops_simd_tmpl.h:
+
+  Kernel bodies for aops_simd.c
+
+  This file is part of Csound.
+
+  The Csound Library is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Csound is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+
+/*
+  Included once per instruction set by aops_simd.c, with ISA (name
+  suffix), TGT (function attribute), VT (vector type), W (lanes) and
+  the V* operations on MYFLT vectors defined. The conversion kernels
+  are only built when the integer and gather operations (VI, VGATHER,
+  ...) are also given, and the output kernel when VCNTGT is. Tails
+  shorter than W are done in scalar code.
+*/
+
+#define TMPL_NAME2(a, b) a##_##b
+#define TMPL_NAME1(a, b) TMPL_NAME2(a, b)
+#define K(name)          TMPL_NAME1(name, ISA)
+
+#define TMPL_ARITH(NAME, VOP, OP)                                       \
+TGT static void K(vv_##NAME)(MYFLT *r, const MYFLT *a, const MYFLT *b,  \
+                             uint32_t n)                                \
+{                                                                       \
+    uint32_t i = 0;                                                     \
+    for ( ; i + W <= n; i += W)                                         \
+      VSTORE(&r[i], VOP(VLOAD(&a[i]), VLOAD(&b[i])));                   \
+    for ( ; i < n; i++) r[i] = a[i] OP b[i];                            \
+}                                                                       \
+TGT static void K(vs_##NAME)(MYFLT *r, const MYFLT *a, MYFLT b,         \
+                             uint32_t n)                                \
+{                                                                       \
+    const VT vb = VSET1(b);                                             \
+    uint32_t i = 0;                                                     \
+    for ( ; i + W <= n; i += W)                                         \
+      VSTORE(&r[i], VOP(VLOAD(&a[i]), vb));                             \
+    for ( ; i < n; i++) r[i] = a[i] OP b;                               \
+}                                                                       \
+TGT static void K(sv_##NAME)(MYFLT *r, MYFLT a, const MYFLT *b,         \
+                             uint32_t n)                                \
+{                                                                       \
+    const VT va = VSET1(a);                                             \
+    uint32_t i = 0;                                                     \
+    for ( ; i + W <= n; i += W)                                         \
+      VSTORE(&r[i], VOP(va, VLOAD(&b[i])));                             \
+    for ( ; i < n; i++) r[i] = a OP b[i];                               \
+}
+
+TMPL_ARITH(add, VADD, +)
+TMPL_ARITH(sub, VSUB, -)
+TMPL_ARITH(mul, VMUL, *)
+TMPL_ARITH(div, VDIV, /)
+
+#ifdef VGATHER
+
+#ifdef USE_LRINT
+/* MYFLT2LRND() rounds half to even like VCVTRN only with lrint() */
+TGT static void K(pow2)(MYFLT *r, const MYFLT *a, const MYFLT *tab,
+                        uint32_t n)
+{
+    const VT hi = VSET1(FL(POW2MAX)), lo = VSET1(-FL(POW2MAX));
+    const VT sc = VSET1(FL(POW2TABSIZI));
+    uint32_t i = 0;
+    for ( ; i + W <= n; i += W) {
+      VT x = VMIN(VMAX(VLOAD(&a[i]), lo), hi);
+      VI m = VIADD(VCVTRN(VMUL(x, sc)), (int32_t) (POW2MAX * POW2TABSIZI));
+      VSTORE(&r[i], VMUL(VEXP2I(VISRA(m, 12)),
+                         VGATHER(tab, VIAND(m, POW2TABSIZI - 1))));
+    }
+    pow2_scalar(&r[i], &a[i], tab, n - i);
+}
+#endif
+
+TGT static void K(cpsoct)(MYFLT *r, const MYFLT *a, const MYFLT *tab,
+                          uint32_t n)
+{
+    const VT sc = VSET1((MYFLT) OCTRES);
+    uint32_t i = 0;
+    for ( ; i + W <= n; i += W) {
+      VI m = VCVTTZ(VMUL(VLOAD(&a[i]), sc));
+      VSTORE(&r[i], VMUL(VEXP2I(VISRA(m, 13)),
+                         VGATHER(tab, VIAND(m, OCTRES - 1))));
+    }
+    cpsoct_scalar(&r[i], &a[i], tab, n - i);
+}
+
+/* exp and log as in the Cephes library; lanes outside the range where
+   the reduction is valid (including 0, denormals, inf and NaN) make the
+   whole vector go through libm */
+
+TGT static void K(expk)(MYFLT *r, const MYFLT *a, MYFLT k, MYFLT s,
+                        uint32_t n)
+{
+    const VT vk = VSET1(k), vs = VSET1(s), one = VSET1(FL(1.0));
+#ifdef USE_DOUBLE
+    const VT lo = VSET1(-708.0), hi = VSET1(708.0);
+#else
+    const VT lo = VSET1(-87.0f), hi = VSET1(88.0f);
+#endif
+    uint32_t i = 0, j;
+    for ( ; i + W <= n; i += W) {
+      VT x = VMUL(VLOAD(&a[i]), vk), e, z;
+      if (UNLIKELY(VOUT(x, lo, hi))) {
+        for (j = i; j < i + W; j++) r[j] = s * EXP(a[j] * k);
+        continue;
+      }
+      e = VROUND(VMUL(x, VSET1(FL(1.4426950408889634074))));
+#ifdef USE_DOUBLE
+      x = VSUB(x, VMUL(e, VSET1(6.93145751953125e-1)));
+      x = VSUB(x, VMUL(e, VSET1(1.42860682030941723212e-6)));
+      z = VMUL(x, x);
+      {
+        VT px, qx;
+        px = VADD(VMUL(VSET1(1.26177193074810590878e-4), z),
+                  VSET1(3.02994407707441961300e-2));
+        px = VMUL(x, VADD(VMUL(px, z), VSET1(9.99999999999999999910e-1)));
+        qx = VADD(VMUL(VSET1(3.00198505138664455042e-6), z),
+                  VSET1(2.52448340349684104192e-3));
+        qx = VADD(VMUL(qx, z), VSET1(2.27265548208155028766e-1));
+        qx = VADD(VMUL(qx, z), VSET1(2.00000000000000000009e0));
+        x = VDIV(px, VSUB(qx, px));
+        x = VADD(one, VADD(x, x));
+      }
+#else
+      x = VSUB(x, VMUL(e, VSET1(0.693359375f)));
+      x = VSUB(x, VMUL(e, VSET1(-2.12194440e-4f)));
+      z = VMUL(x, x);
+      {
+        VT p = VADD(VMUL(VSET1(1.9875691500e-4f), x), VSET1(1.3981999507e-3f));
+        p = VADD(VMUL(p, x), VSET1(8.3334519073e-3f));
+        p = VADD(VMUL(p, x), VSET1(4.1665795894e-2f));
+        p = VADD(VMUL(p, x), VSET1(1.6666665459e-1f));
+        p = VADD(VMUL(p, x), VSET1(5.0000001201e-1f));
+        x = VADD(VADD(VMUL(p, z), x), one);
+      }
+#endif
+      VSTORE(&r[i], VMUL(vs, VMUL(x, VEXP2I(VCVTRN(e)))));
+    }
+    for ( ; i < n; i++) r[i] = s * EXP(a[i] * k);
+}
+
+TGT static void K(logk)(MYFLT *r, const MYFLT *a, MYFLT k, uint32_t n)
+{
+    const VT vk = VSET1(k), one = VSET1(FL(1.0)), half = VSET1(FL(0.5));
+#ifdef USE_DOUBLE
+    const VT lo = VSET1(DBL_MIN), hi = VSET1(DBL_MAX);
+#else
+    const VT lo = VSET1(FLT_MIN), hi = VSET1(FLT_MAX);
+#endif
+    uint32_t i = 0, j;
+    for ( ; i + W <= n; i += W) {
+      VT x = VABS(VLOAD(&a[i])), e, y, z;
+      if (UNLIKELY(VOUT(x, lo, hi))) {
+        for (j = i; j < i + W; j++) r[j] = LOG(FABS(a[j])) / k;
+        continue;
+      }
+      VFREXP(x, x, e);
+      e = VLTSEL(x, VSET1(FL(0.70710678118654752440)), VSUB(e, one), e);
+      x = VSUB(VLTSEL(x, VSET1(FL(0.70710678118654752440)), VADD(x, x), x),
+               one);
+      z = VMUL(x, x);
+#ifdef USE_DOUBLE
+      {
+        VT p, q;
+        p = VADD(VMUL(VSET1(1.01875663804580931796e-4), x),
+                 VSET1(4.97494994976747001425e-1));
+        p = VADD(VMUL(p, x), VSET1(4.70579119878881725854e0));
+        p = VADD(VMUL(p, x), VSET1(1.44989225341610930846e1));
+        p = VADD(VMUL(p, x), VSET1(1.79368678507819816313e1));
+        p = VADD(VMUL(p, x), VSET1(7.70838733755885391666e0));
+        q = VADD(x, VSET1(1.12873587189167450590e1));
+        q = VADD(VMUL(q, x), VSET1(4.52279145837532221105e1));
+        q = VADD(VMUL(q, x), VSET1(8.29875266912776603211e1));
+        q = VADD(VMUL(q, x), VSET1(7.11544750618563894466e1));
+        q = VADD(VMUL(q, x), VSET1(2.31251620126765340583e1));
+        y = VMUL(x, VDIV(VMUL(z, p), q));
+      }
+#else
+      {
+        VT p = VSUB(VMUL(VSET1(7.0376836292e-2f), x), VSET1(1.1514610310e-1f));
+        p = VADD(VMUL(p, x), VSET1(1.1676998740e-1f));
+        p = VSUB(VMUL(p, x), VSET1(1.2420140846e-1f));
+        p = VADD(VMUL(p, x), VSET1(1.4249322787e-1f));
+        p = VSUB(VMUL(p, x), VSET1(1.6668057665e-1f));
+        p = VADD(VMUL(p, x), VSET1(2.0000714765e-1f));
+        p = VSUB(VMUL(p, x), VSET1(2.4999993993e-1f));
+        p = VADD(VMUL(p, x), VSET1(3.3333331174e-1f));
+        y = VMUL(VMUL(p, x), z);
+      }
+#endif
+      y = VSUB(y, VMUL(e, VSET1(FL(2.121944400546905827679e-4))));
+      y = VSUB(y, VMUL(half, z));
+      x = VADD(VADD(x, y), VMUL(e, VSET1(FL(0.693359375))));
+      VSTORE(&r[i], VDIV(x, vk));
+    }
+    for ( ; i < n; i++) r[i] = LOG(FABS(a[i])) / k;
+}
+
+#endif  /* VGATHER */
+
+#ifdef VCNTGT
+/* the peak of the vector part is found with VMAX (which keeps its
+   second operand for NaN, as the scalar compare does), then located by
+   a scalar search only if it is a new one */
+TGT static uint32_t K(outchn)(MYFLT *sp, MYFLT *out, uint32_t stride,
+                              const MYFLT *a, MYFLT s, MYFLT lim,
+                              MYFLT *peak, int32_t *nover, uint32_t n)
+{
+    const VT vs = VSET1(s), vl = VSET1(lim);
+    VT vm = VSET1(FL(0.0));
+    MYFLT m[W], pk = *peak;
+    uint32_t i = 0, j, pos = n, c = 0;
+    for ( ; i + W <= n; i += W) {
+      VT x = VLOAD(&a[i]), ax = VABS(x);
+      vm = VMAX(ax, vm);
+      c += VCNTGT(ax, vl);
+      if (stride == 1) {
+        VSTORE(&sp[i], x);
+        if (out != NULL) VSTORE(&out[i], VMUL(x, vs));
+      }
+      else {
+        for (j = i; j < i + W; j++) sp[j*stride] = a[j];
+        if (out != NULL) {
+          VSTORE(m, VMUL(x, vs));
+          for (j = 0; j < W; j++) out[(i+j)*stride] = m[j];
+        }
+      }
+    }
+    if (i > 0) {
+      MYFLT hm = FL(0.0);
+      VSTORE(m, vm);
+      for (j = 0; j < W; j++) if (m[j] > hm) hm = m[j];
+      if (hm > pk) {
+        for (pos = 0; FABS(a[pos]) != hm; pos++) ;
+        pk = hm;
+      }
+    }
+    /* the tail is done here rather than by outchn_scalar(), which,
+       being built without TGT, would run legacy SSE code with the
+       upper vector halves dirty and pay the transition on every call */
+    for ( ; i < n; i++) {
+      MYFLT x = a[i], ax = x < FL(0.0) ? -x : x;
+      sp[i*stride] = x;
+      if (out != NULL) out[i*stride] = x * s;
+      if (ax > pk) {
+        pk = ax;
+        pos = i;
+      }
+      if (ax > lim) c++;
+    }
+    *peak = pk;
+    *nover += c;
+    return pos;
+}
+#endif
+
+static const AOPS_KERNELS K(kernels) = {
+    { K(vv_add), K(vv_sub), K(vv_mul), K(vv_div) },
+    { K(vs_add), K(vs_sub), K(vs_mul), K(vs_div) },
+    { K(sv_add), K(sv_sub), K(sv_mul), K(sv_div) },
+#ifdef VGATHER
+#  ifdef USE_LRINT
+    K(pow2),
+#  else
+    pow2_scalar,
+#  endif
+    K(cpsoct), K(expk), K(logk),
+#else
+    pow2_scalar, cpsoct_scalar, expk_scalar, logk_scalar,
+#endif
+#ifdef VCNTGT
+    K(outchn),
+#else
+    outchn_scalar,
+#endif
+    ISA_NAME
+};
+
+#undef TMPL_ARITH
+#undef K
+#undef TMPL_NAME1
+#undef TMPL_NAME2
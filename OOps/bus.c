@@ -333,15 +333,22 @@ static int32_t delete_channel_db(CSOUND *csound, void *p)
 
     cs_hash_table_mfree_complete(csound, csound->chn_db);
     csound->chn_db = NULL;
+    csound->chn_audio = NULL;
     return 0;
 }
 
+/* hosts look channels up on their own threads while the performance
+   thread may create new ones, which can grow the table, so every use
+   of chn_db is under chn_db_lock */
 static inline CHNENTRY *find_channel(CSOUND *csound, const char *name)
 {
+    CHNENTRY *pp = NULL;
     if (csound->chn_db != NULL && name[0]) {
-      return (CHNENTRY*) cs_hash_table_get(csound, csound->chn_db, (char*) name);
+      csoundSpinLock(&csound->chn_db_lock);
+      pp = (CHNENTRY*) cs_hash_table_get(csound, csound->chn_db, (char*) name);
+      csoundSpinUnLock(&csound->chn_db_lock);
     }
-    return NULL;
+    return pp;
 }
 
 void set_channel_data_ptr(CSOUND *csound,
@@ -396,24 +403,33 @@ static CS_NOINLINE int32_t create_new_channel(CSOUND *csound, const char *name,
     if (UNLIKELY(!(type & 48)))
       return CSOUND_ERROR;
 
+    csoundSpinLock(&csound->chn_db_lock);
     /* create new empty database if not allocated */
     if (csound->chn_db == NULL) {
-      csound->chn_db = cs_hash_table_create(csound);
       if (UNLIKELY(csound->RegisterResetCallback(csound, NULL,
-                                                 delete_channel_db) != 0))
-          return CSOUND_MEMORY;
-      if (UNLIKELY(csound->chn_db == NULL))
+                                                 delete_channel_db) != 0)) {
+        csoundSpinUnLock(&csound->chn_db_lock);
         return CSOUND_MEMORY;
+      }
+      csound->chn_db = cs_hash_table_create(csound);
+    }
+    /* another thread may have created it since the lookup */
+    if (cs_hash_table_get(csound, csound->chn_db, (char*)name) != NULL) {
+      csoundSpinUnLock(&csound->chn_db_lock);
+      return CSOUND_SUCCESS;
     }
     /* allocate new entry */
     pp = alloc_channel(csound, name, type);
-    if (UNLIKELY(pp == NULL))
+    if (UNLIKELY(pp == NULL)) {
+      csoundSpinUnLock(&csound->chn_db_lock);
       return CSOUND_MEMORY;
+    }
     pp->hints.behav = 0;
     pp->type = type;
     strcpy(&(pp->name[0]), name);
 
     cs_hash_table_put(csound, csound->chn_db, (char*)name, pp);
+    csoundSpinUnLock(&csound->chn_db_lock);
 
     return CSOUND_SUCCESS;
 }
@@ -473,6 +489,184 @@ PUBLIC int32_t *csoundGetChannelLock(CSOUND *csound,
     else return NULL;
 }
 
+/* channel handles: resolve a name once, then access the entry directly */
+
+static int32_t chn_audio_attach(CSOUND *csound, CHNENTRY *pp)
+{
+    CHNAUDIO *a;
+    MYFLT    *buf;
+    int32_t  i;
+
+    csoundSpinLock(&pp->lock);
+    if (pp->audio != NULL) {
+      csoundSpinUnLock(&pp->lock);
+      return CSOUND_SUCCESS;
+    }
+    a = (CHNAUDIO*) csound->Calloc(csound, sizeof(CHNAUDIO));
+    buf = (MYFLT*) csound->Calloc(csound, 6*csound->ksmps*sizeof(MYFLT));
+    if (UNLIKELY(a == NULL || buf == NULL)) {
+      csoundSpinUnLock(&pp->lock);
+      return CSOUND_MEMORY;
+    }
+    for (i = 0; i < 3; i++) {
+      a->in[i] = buf + i*csound->ksmps;
+      a->out[i] = buf + (i+3)*csound->ksmps;
+    }
+    a->in_host = a->out_host = 0;
+    a->in_mid = a->out_mid = 1;
+    a->in_perf = a->out_perf = 2;
+    pp->audio = a;
+    /* publish on the list walked by the performance thread */
+#if defined(MSVC)
+    do {
+      pp->audio_nxt = csound->chn_audio;
+    } while (InterlockedCompareExchangePointer((PVOID volatile*)
+                                               &csound->chn_audio,
+                                               pp, pp->audio_nxt)
+             != pp->audio_nxt);
+#elif defined(HAVE_ATOMIC_BUILTIN)
+    do {
+      pp->audio_nxt = csound->chn_audio;
+    } while (!__sync_bool_compare_and_swap(&csound->chn_audio,
+                                           pp->audio_nxt, pp));
+#else
+    pp->audio_nxt = csound->chn_audio;
+    csound->chn_audio = pp;
+#endif
+    csoundSpinUnLock(&pp->lock);
+    return CSOUND_SUCCESS;
+}
+
+PUBLIC CHANNEL_HANDLE csoundGetChannelHandle(CSOUND *csound,
+                                             const char *name, int32_t type)
+{
+    CHNENTRY *pp;
+    MYFLT    *p;
+
+    if (UNLIKELY(name == NULL || name[0] == '\0'))
+      return NULL;
+    if (csoundGetChannelPtr(csound, &p, name, type) != CSOUND_SUCCESS)
+      return NULL;
+    pp = find_channel(csound, name);
+    if ((type & CSOUND_CHANNEL_TYPE_MASK) == CSOUND_AUDIO_CHANNEL &&
+        chn_audio_attach(csound, pp) != CSOUND_SUCCESS)
+      return NULL;
+    return pp;
+}
+
+PUBLIC MYFLT csoundGetControlChannelH(CSOUND *csound, CHANNEL_HANDLE h)
+{
+    union {
+      MYFLT d;
+      MYFLT_INT_TYPE i;
+    } x;
+    IGN(csound);
+    if (UNLIKELY(h == NULL ||
+                 (h->type & CSOUND_CHANNEL_TYPE_MASK) != CSOUND_CONTROL_CHANNEL))
+      return FL(0.0);
+#if defined(MSVC)
+    x.i = InterlockedExchangeAdd64((MYFLT_INT_TYPE *) h->data, 0);
+#elif defined(HAVE_ATOMIC_BUILTIN)
+    x.i = __atomic_load_n((MYFLT_INT_TYPE *) h->data, __ATOMIC_SEQ_CST);
+#else
+    csoundSpinLock(&h->lock);
+    x.d = *h->data;
+    csoundSpinUnLock(&h->lock);
+#endif
+    return x.d;
+}
+
+PUBLIC void csoundSetControlChannelH(CSOUND *csound, CHANNEL_HANDLE h,
+                                     MYFLT val)
+{
+    union {
+      MYFLT d;
+      MYFLT_INT_TYPE i;
+    } x;
+    IGN(csound);
+    if (UNLIKELY(h == NULL ||
+                 (h->type & CSOUND_CHANNEL_TYPE_MASK) != CSOUND_CONTROL_CHANNEL))
+      return;
+    x.d = val;
+#if defined(MSVC)
+    InterlockedExchange64((MYFLT_INT_TYPE *) h->data, x.i);
+#elif defined(HAVE_ATOMIC_BUILTIN)
+    __atomic_store_n((MYFLT_INT_TYPE *) h->data, x.i, __ATOMIC_SEQ_CST);
+#else
+    csoundSpinLock(&h->lock);
+    *h->data = x.d;
+    csoundSpinUnLock(&h->lock);
+#endif
+}
+
+PUBLIC void csoundGetControlChannels(CSOUND *csound, const CHANNEL_HANDLE *h,
+                                     MYFLT *vals, int32_t n)
+{
+    int32_t i;
+    for (i = 0; i < n; i++)
+      if (h[i] != NULL) vals[i] = csoundGetControlChannelH(csound, h[i]);
+}
+
+PUBLIC void csoundSetControlChannels(CSOUND *csound, const CHANNEL_HANDLE *h,
+                                     const MYFLT *vals, int32_t n)
+{
+    int32_t i;
+    for (i = 0; i < n; i++)
+      if (h[i] != NULL) csoundSetControlChannelH(csound, h[i], vals[i]);
+}
+
+PUBLIC void csoundGetAudioChannelH(CSOUND *csound, CHANNEL_HANDLE h,
+                                   MYFLT *samples)
+{
+    CHNAUDIO *a;
+    if (UNLIKELY(h == NULL || (a = h->audio) == NULL))
+      return;
+    /* take the newest buffer the performance thread has handed over */
+    if (ATOMIC_LOAD_ACQ(a->out_mid) & CHNAUDIO_DIRTY)
+      a->out_host = ATOMIC_XCHG(a->out_mid, a->out_host) & 3;
+    memcpy(samples, a->out[a->out_host], csound->ksmps*sizeof(MYFLT));
+}
+
+PUBLIC void csoundSetAudioChannelH(CSOUND *csound, CHANNEL_HANDLE h,
+                                   const MYFLT *samples)
+{
+    CHNAUDIO *a;
+    if (UNLIKELY(h == NULL || (a = h->audio) == NULL))
+      return;
+    memcpy(a->in[a->in_host], samples, csound->ksmps*sizeof(MYFLT));
+    a->in_host = ATOMIC_XCHG(a->in_mid, a->in_host | CHNAUDIO_DIRTY) & 3;
+}
+
+/* called by the performance thread at the start of each k-cycle */
+void chn_audio_pull(CSOUND *csound)
+{
+    CHNENTRY *pp;
+    for (pp = csound->chn_audio; pp != NULL; pp = pp->audio_nxt) {
+      CHNAUDIO *a = pp->audio;
+      if (ATOMIC_LOAD_ACQ(a->in_mid) & CHNAUDIO_DIRTY) {
+        a->in_perf = ATOMIC_XCHG(a->in_mid, a->in_perf) & 3;
+        csoundSpinLock(&pp->lock);
+        memcpy(pp->data, a->in[a->in_perf], csound->ksmps*sizeof(MYFLT));
+        csoundSpinUnLock(&pp->lock);
+      }
+    }
+}
+
+/* called by the performance thread at the end of each k-cycle */
+void chn_audio_push(CSOUND *csound)
+{
+    CHNENTRY *pp;
+    for (pp = csound->chn_audio; pp != NULL; pp = pp->audio_nxt) {
+      CHNAUDIO *a = pp->audio;
+      if (!(pp->type & CSOUND_OUTPUT_CHANNEL))
+        continue;
+      csoundSpinLock(&pp->lock);
+      memcpy(a->out[a->out_perf], pp->data, csound->ksmps*sizeof(MYFLT));
+      csoundSpinUnLock(&pp->lock);
+      a->out_perf = ATOMIC_XCHG(a->out_mid, a->out_perf | CHNAUDIO_DIRTY) & 3;
+    }
+}
+
 static int32_t cmp_func(const void *p1, const void *p2)
 {
     return strcmp(((controlChannelInfo_t*) p1)->name,
@@ -489,7 +683,9 @@ PUBLIC int32_t csoundListChannels(CSOUND *csound, controlChannelInfo_t **lst)
     if (csound->chn_db == NULL)
       return 0;
 
+    csoundSpinLock(&csound->chn_db_lock);
     channels = cs_hash_table_values(csound, csound->chn_db);
+    csoundSpinUnLock(&csound->chn_db_lock);
     n = cs_cons_length(channels);
 
     if (!n)
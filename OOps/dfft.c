@@ -0,0 +1,766 @@
+/*
+  dfft.c:
+
+  Double precision real FFT with runtime-selected SIMD kernels
+
+  This file is part of Csound.
+
+  The Csound Library is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Csound is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+
+/*
+  A real FFT of N points is computed as a complex FFT of n = N/2 points
+  on the even/odd samples, followed by the usual split step. The complex
+  FFT is a Stockham autosort transform (radix 4, with a final radix 2
+  stage when log2(n) is odd) on split real/imaginary arrays, so every
+  stage after the first runs over contiguous blocks of at least four
+  points; those stages have SSE2 and AVX2 versions picked at runtime.
+  The first forward stage reads the interleaved input directly, and the
+  split step works in place on the caller's buffer.
+
+  There is one setup per size and direction for each Csound instance,
+  shared by every caller. Its scratch buffers are kept in a list; each
+  transform takes one for its duration, so that transforms of the same
+  size can run on several threads, and a new one is only made when all
+  are in use.
+*/
+
+#include <math.h>
+#include <string.h>
+#include "csoundCore.h"
+#include "dfft.h"
+#include "aops_simd.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+  (defined(__i386__) && defined(__SSE2__))
+#  define DFFT_X86 1
+#  include <emmintrin.h>
+#  if defined(__GNUC__) || defined(_MSC_VER)
+#    define DFFT_AVX2 1
+#    include <immintrin.h>
+#  endif
+#endif
+
+#if defined(__GNUC__)
+#  define DFFT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#  define DFFT_TARGET_AVX2
+#endif
+
+#define DFFT_ALIGN 64
+
+/*
+  Twiddle layout: the first stage (stride 1) keeps W^p, W^2p, W^3p as six
+  arrays of n/4 values (w1r, w1i, w2r, w2i, w3r, w3i) so that it can be
+  vectorised over p; later stages store the six values per group together,
+  as they are broadcast across the inner loop. The split step uses
+  cos(2 pi k/N) and sin(2 pi k/N) for k < n as two arrays.
+*/
+
+typedef struct {
+    /* first radix 4 stage, xs = 2 for interleaved, 1 for split input */
+    void (*first)(const double *xr, const double *xi, int32_t xs,
+                  double *yr, double *yi, int32_t n, const double *w,
+                  int32_t inv);
+    void (*radix4)(const double *xr, const double *xi,
+                   double *yr, double *yi, int32_t L, int32_t s,
+                   const double *w, int32_t inv);
+    void (*radix2)(const double *xr, const double *xi,
+                   double *yr, double *yi, int32_t s);
+    /* complex spectrum of the even/odd sequence -> packed real spectrum */
+    void (*split_fwd)(const double *zr, const double *zi, double *sig,
+                      int32_t n, const double *c, const double *s);
+    /* packed real spectrum -> scaled complex spectrum */
+    void (*split_inv)(const double *sig, double *zr, double *zi,
+                      int32_t n, const double *c, const double *s, double f);
+    void (*interleave)(const double *zr, const double *zi, double *sig,
+                       int32_t n);
+    const char *name;
+} DFFT_KERNELS;
+
+typedef struct DFFT_WORK_ {
+    struct DFFT_WORK_ *nxt;
+    double   *buf;          /* two split complex buffers of n points */
+} DFFT_WORK;
+
+struct DFFT_SETUP_ {
+    CSOUND   *csound;
+    int32_t  N, n;          /* real and complex sizes */
+    int32_t  d;             /* FFT_FWD or FFT_INV */
+    double   *tw;           /* radix 4 twiddles (at most 2n) */
+    double   *rtw;          /* split step cos and sin tables (2n) */
+    const DFFT_KERNELS *k;
+    spin_lock_t lock;       /* for work */
+    DFFT_WORK *work;        /* scratch not in use */
+    DFFT_SETUP *nxt;        /* next setup of the instance */
+};
+
+/* scalar kernels */
+
+static void first_scalar(const double *xr, const double *xi, int32_t xs,
+                         double *yr, double *yi, int32_t n, const double *w,
+                         int32_t inv)
+{
+    int32_t m = n >> 2, p;
+    /* the inverse butterfly is the forward one with b and d exchanged */
+    int32_t ob = (inv ? 3*m : m)*xs, oc = 2*m*xs, od = (inv ? m : 3*m)*xs;
+    const double *w1r = w, *w1i = w + m, *w2r = w + 2*m, *w2i = w + 3*m;
+    const double *w3r = w + 4*m, *w3i = w + 5*m;
+    for (p = 0; p < m; p++, xr += xs, xi += xs, yr += 4, yi += 4) {
+      double apcr = xr[0] + xr[oc], apci = xi[0] + xi[oc];
+      double amcr = xr[0] - xr[oc], amci = xi[0] - xi[oc];
+      double bpdr = xr[ob] + xr[od], bpdi = xi[ob] + xi[od];
+      double bmdr = xr[ob] - xr[od], bmdi = xi[ob] - xi[od];
+      double t1r = amcr + bmdi, t1i = amci - bmdr;
+      double t2r = apcr - bpdr, t2i = apci - bpdi;
+      double t3r = amcr - bmdi, t3i = amci + bmdr;
+      yr[0] = apcr + bpdr;
+      yi[0] = apci + bpdi;
+      yr[1] = t1r*w1r[p] - t1i*w1i[p];
+      yi[1] = t1r*w1i[p] + t1i*w1r[p];
+      yr[2] = t2r*w2r[p] - t2i*w2i[p];
+      yi[2] = t2r*w2i[p] + t2i*w2r[p];
+      yr[3] = t3r*w3r[p] - t3i*w3i[p];
+      yi[3] = t3r*w3i[p] + t3i*w3r[p];
+    }
+}
+
+static void radix4_scalar(const double *xr, const double *xi,
+                          double *yr, double *yi, int32_t L, int32_t s,
+                          const double *w, int32_t inv)
+{
+    int32_t m = L >> 2, p, q;
+    int32_t ob = inv ? 3*m : m, od = inv ? m : 3*m;
+    for (p = 0; p < m; p++, w += 6) {
+      const double *ar = xr + s*p, *ai = xi + s*p;
+      const double *br = xr + s*(p+ob), *bi = xi + s*(p+ob);
+      const double *cr = xr + s*(p+2*m), *ci = xi + s*(p+2*m);
+      const double *dr = xr + s*(p+od), *di = xi + s*(p+od);
+      double *y0r = yr + s*4*p, *y0i = yi + s*4*p;
+      for (q = 0; q < s; q++) {
+        double apcr = ar[q] + cr[q], apci = ai[q] + ci[q];
+        double amcr = ar[q] - cr[q], amci = ai[q] - ci[q];
+        double bpdr = br[q] + dr[q], bpdi = bi[q] + di[q];
+        double bmdr = br[q] - dr[q], bmdi = bi[q] - di[q];
+        double t1r = amcr + bmdi, t1i = amci - bmdr;
+        double t2r = apcr - bpdr, t2i = apci - bpdi;
+        double t3r = amcr - bmdi, t3i = amci + bmdr;
+        y0r[q] = apcr + bpdr;
+        y0i[q] = apci + bpdi;
+        y0r[s+q] = t1r*w[0] - t1i*w[1];
+        y0i[s+q] = t1r*w[1] + t1i*w[0];
+        y0r[2*s+q] = t2r*w[2] - t2i*w[3];
+        y0i[2*s+q] = t2r*w[3] + t2i*w[2];
+        y0r[3*s+q] = t3r*w[4] - t3i*w[5];
+        y0i[3*s+q] = t3r*w[5] + t3i*w[4];
+      }
+    }
+}
+
+static void radix2_scalar(const double *xr, const double *xi,
+                          double *yr, double *yi, int32_t s)
+{
+    int32_t q;
+    for (q = 0; q < s; q++) {
+      double ar = xr[q], ai = xi[q], br = xr[q+s], bi = xi[q+s];
+      yr[q] = ar + br;
+      yi[q] = ai + bi;
+      yr[q+s] = ar - br;
+      yi[q+s] = ai - bi;
+    }
+}
+
+/* X[k] = E[k] + W^k O[k], with E and O from Z[k] and conj(Z[n-k]),
+   for k0 <= k < n */
+static void split_fwd_from(const double *zr, const double *zi, double *sig,
+                           int32_t n, const double *c, const double *s,
+                           int32_t k)
+{
+    for ( ; k < n; k++) {
+      double er = 0.5*(zr[k] + zr[n-k]), ei = 0.5*(zi[k] - zi[n-k]);
+      double o_r = 0.5*(zi[k] + zi[n-k]), o_i = 0.5*(zr[n-k] - zr[k]);
+      sig[2*k] = er + o_r*c[k] + o_i*s[k];
+      sig[2*k+1] = ei + o_i*c[k] - o_r*s[k];
+    }
+}
+
+static void split_inv_from(const double *sig, double *zr, double *zi,
+                           int32_t n, const double *c, const double *s,
+                           double f, int32_t k)
+{
+    for ( ; k < n; k++) {
+      const double *xk = sig + 2*k, *xc = sig + 2*(n-k);
+      double er = f*(xk[0] + xc[0]), ei = f*(xk[1] - xc[1]);
+      double dr = f*(xk[0] - xc[0]), di = f*(xk[1] + xc[1]);
+      double o_r = dr*c[k] - di*s[k], o_i = dr*s[k] + di*c[k];
+      zr[k] = er - o_i;
+      zi[k] = ei + o_r;
+    }
+}
+
+static void split_fwd_scalar(const double *zr, const double *zi, double *sig,
+                             int32_t n, const double *c, const double *s)
+{
+    split_fwd_from(zr, zi, sig, n, c, s, 1);
+}
+
+static void split_inv_scalar(const double *sig, double *zr, double *zi,
+                             int32_t n, const double *c, const double *s,
+                             double f)
+{
+    split_inv_from(sig, zr, zi, n, c, s, f, 1);
+}
+
+static void interleave_scalar(const double *zr, const double *zi,
+                              double *sig, int32_t n)
+{
+    int32_t k;
+    for (k = 0; k < n; k++) {
+      sig[2*k] = zr[k];
+      sig[2*k+1] = zi[k];
+    }
+}
+
+static const DFFT_KERNELS kernels_scalar = {
+    first_scalar, radix4_scalar, radix2_scalar,
+    split_fwd_scalar, split_inv_scalar, interleave_scalar, "scalar"
+};
+
+/* the radix 4 butterfly on vectors of any width */
+#define BUTTERFLY4(V, ADD, SUB, MUL)                                    \
+    V apcr = ADD(a_r, c_r), apci = ADD(a_i, c_i);                       \
+    V amcr = SUB(a_r, c_r), amci = SUB(a_i, c_i);                       \
+    V bpdr = ADD(b_r, d_r), bpdi = ADD(b_i, d_i);                       \
+    V bmdr = SUB(b_r, d_r), bmdi = SUB(b_i, d_i);                       \
+    V t1r = ADD(amcr, bmdi), t1i = SUB(amci, bmdr);                     \
+    V t2r = SUB(apcr, bpdr), t2i = SUB(apci, bpdi);                     \
+    V t3r = SUB(amcr, bmdi), t3i = ADD(amci, bmdr);                     \
+    V y0r = ADD(apcr, bpdr), y0i = ADD(apci, bpdi);                     \
+    V y1r = SUB(MUL(t1r, w1r), MUL(t1i, w1i));                          \
+    V y1i = ADD(MUL(t1r, w1i), MUL(t1i, w1r));                          \
+    V y2r = SUB(MUL(t2r, w2r), MUL(t2i, w2i));                          \
+    V y2i = ADD(MUL(t2r, w2i), MUL(t2i, w2r));                          \
+    V y3r = SUB(MUL(t3r, w3r), MUL(t3i, w3i));                          \
+    V y3i = ADD(MUL(t3r, w3i), MUL(t3i, w3r))
+
+#ifdef DFFT_X86
+
+static void first_sse2(const double *xr, const double *xi, int32_t xs,
+                       double *yr, double *yi, int32_t n, const double *w,
+                       int32_t inv)
+{
+    int32_t m = n >> 2, p;
+    int32_t ob = inv ? 3*m : m, od = inv ? m : 3*m;
+    for (p = 0; p < m; p += 2) {
+      __m128d a_r, a_i, b_r, b_i, c_r, c_i, d_r, d_i;
+      __m128d w1r = _mm_loadu_pd(w + p), w1i = _mm_loadu_pd(w + m + p);
+      __m128d w2r = _mm_loadu_pd(w + 2*m + p), w2i = _mm_loadu_pd(w + 3*m + p);
+      __m128d w3r = _mm_loadu_pd(w + 4*m + p), w3i = _mm_loadu_pd(w + 5*m + p);
+      if (xs == 2) {          /* xr is interleaved re/im */
+#define LOAD_CPLX(r, i, ofs) {                                          \
+          __m128d v0 = _mm_loadu_pd(xr + 2*(ofs));                      \
+          __m128d v1 = _mm_loadu_pd(xr + 2*(ofs) + 2);                  \
+          r = _mm_unpacklo_pd(v0, v1); i = _mm_unpackhi_pd(v0, v1); }
+        LOAD_CPLX(a_r, a_i, p);
+        LOAD_CPLX(b_r, b_i, p + ob);
+        LOAD_CPLX(c_r, c_i, p + 2*m);
+        LOAD_CPLX(d_r, d_i, p + od);
+#undef LOAD_CPLX
+      }
+      else {
+        a_r = _mm_loadu_pd(xr + p); a_i = _mm_loadu_pd(xi + p);
+        b_r = _mm_loadu_pd(xr + p + ob); b_i = _mm_loadu_pd(xi + p + ob);
+        c_r = _mm_loadu_pd(xr + p + 2*m); c_i = _mm_loadu_pd(xi + p + 2*m);
+        d_r = _mm_loadu_pd(xr + p + od); d_i = _mm_loadu_pd(xi + p + od);
+      }
+      {
+        BUTTERFLY4(__m128d, _mm_add_pd, _mm_sub_pd, _mm_mul_pd);
+        /* outputs 4p..4p+3 and 4p+4..4p+7 */
+        _mm_storeu_pd(yr + 4*p, _mm_unpacklo_pd(y0r, y1r));
+        _mm_storeu_pd(yr + 4*p + 2, _mm_unpacklo_pd(y2r, y3r));
+        _mm_storeu_pd(yr + 4*p + 4, _mm_unpackhi_pd(y0r, y1r));
+        _mm_storeu_pd(yr + 4*p + 6, _mm_unpackhi_pd(y2r, y3r));
+        _mm_storeu_pd(yi + 4*p, _mm_unpacklo_pd(y0i, y1i));
+        _mm_storeu_pd(yi + 4*p + 2, _mm_unpacklo_pd(y2i, y3i));
+        _mm_storeu_pd(yi + 4*p + 4, _mm_unpackhi_pd(y0i, y1i));
+        _mm_storeu_pd(yi + 4*p + 6, _mm_unpackhi_pd(y2i, y3i));
+      }
+    }
+}
+
+static void radix4_sse2(const double *xr, const double *xi,
+                        double *yr, double *yi, int32_t L, int32_t s,
+                        const double *w, int32_t inv)
+{
+    int32_t m = L >> 2, p, q;
+    int32_t ob = inv ? 3*m : m, od = inv ? m : 3*m;
+    for (p = 0; p < m; p++, w += 6) {
+      __m128d w1r = _mm_set1_pd(w[0]), w1i = _mm_set1_pd(w[1]);
+      __m128d w2r = _mm_set1_pd(w[2]), w2i = _mm_set1_pd(w[3]);
+      __m128d w3r = _mm_set1_pd(w[4]), w3i = _mm_set1_pd(w[5]);
+      const double *ar = xr + s*p, *ai = xi + s*p;
+      const double *br = xr + s*(p+ob), *bi = xi + s*(p+ob);
+      const double *cr = xr + s*(p+2*m), *ci = xi + s*(p+2*m);
+      const double *dr = xr + s*(p+od), *di = xi + s*(p+od);
+      double *zr = yr + s*4*p, *zi = yi + s*4*p;
+      for (q = 0; q < s; q += 2) {
+        __m128d a_r = _mm_loadu_pd(ar+q), a_i = _mm_loadu_pd(ai+q);
+        __m128d b_r = _mm_loadu_pd(br+q), b_i = _mm_loadu_pd(bi+q);
+        __m128d c_r = _mm_loadu_pd(cr+q), c_i = _mm_loadu_pd(ci+q);
+        __m128d d_r = _mm_loadu_pd(dr+q), d_i = _mm_loadu_pd(di+q);
+        BUTTERFLY4(__m128d, _mm_add_pd, _mm_sub_pd, _mm_mul_pd);
+        _mm_storeu_pd(zr+q, y0r);
+        _mm_storeu_pd(zi+q, y0i);
+        _mm_storeu_pd(zr+s+q, y1r);
+        _mm_storeu_pd(zi+s+q, y1i);
+        _mm_storeu_pd(zr+2*s+q, y2r);
+        _mm_storeu_pd(zi+2*s+q, y2i);
+        _mm_storeu_pd(zr+3*s+q, y3r);
+        _mm_storeu_pd(zi+3*s+q, y3i);
+      }
+    }
+}
+
+static void radix2_sse2(const double *xr, const double *xi,
+                        double *yr, double *yi, int32_t s)
+{
+    int32_t q;
+    for (q = 0; q < s; q += 2) {
+      __m128d ar = _mm_loadu_pd(xr+q), ai = _mm_loadu_pd(xi+q);
+      __m128d br = _mm_loadu_pd(xr+q+s), bi = _mm_loadu_pd(xi+q+s);
+      _mm_storeu_pd(yr+q, _mm_add_pd(ar, br));
+      _mm_storeu_pd(yi+q, _mm_add_pd(ai, bi));
+      _mm_storeu_pd(yr+q+s, _mm_sub_pd(ar, br));
+      _mm_storeu_pd(yi+q+s, _mm_sub_pd(ai, bi));
+    }
+}
+
+#define REV_PD(v) _mm_shuffle_pd(v, v, 1)
+
+static void split_fwd_sse2(const double *zr, const double *zi, double *sig,
+                           int32_t n, const double *c, const double *s)
+{
+    const __m128d h = _mm_set1_pd(0.5);
+    int32_t k;
+    for (k = 1; k <= n - 2; k += 2) {
+      __m128d ar = _mm_loadu_pd(zr + k), ai = _mm_loadu_pd(zi + k);
+      __m128d br = _mm_loadu_pd(zr + n - k - 1);
+      __m128d bi = _mm_loadu_pd(zi + n - k - 1);
+      __m128d ck = _mm_loadu_pd(c + k), sk = _mm_loadu_pd(s + k);
+      __m128d er, ei, o_r, o_i, xr, xi;
+      br = REV_PD(br); bi = REV_PD(bi);
+      er = _mm_mul_pd(h, _mm_add_pd(ar, br));
+      ei = _mm_mul_pd(h, _mm_sub_pd(ai, bi));
+      o_r = _mm_mul_pd(h, _mm_add_pd(ai, bi));
+      o_i = _mm_mul_pd(h, _mm_sub_pd(br, ar));
+      xr = _mm_add_pd(er, _mm_add_pd(_mm_mul_pd(o_r, ck), _mm_mul_pd(o_i, sk)));
+      xi = _mm_add_pd(ei, _mm_sub_pd(_mm_mul_pd(o_i, ck), _mm_mul_pd(o_r, sk)));
+      _mm_storeu_pd(sig + 2*k, _mm_unpacklo_pd(xr, xi));
+      _mm_storeu_pd(sig + 2*k + 2, _mm_unpackhi_pd(xr, xi));
+    }
+    split_fwd_from(zr, zi, sig, n, c, s, k);
+}
+
+static void split_inv_sse2(const double *sig, double *zr, double *zi,
+                           int32_t n, const double *c, const double *s,
+                           double f)
+{
+    const __m128d vf = _mm_set1_pd(f);
+    int32_t k;
+    for (k = 1; k <= n - 2; k += 2) {
+      __m128d v0 = _mm_loadu_pd(sig + 2*k), v1 = _mm_loadu_pd(sig + 2*k + 2);
+      __m128d u0 = _mm_loadu_pd(sig + 2*(n-k-1));
+      __m128d u1 = _mm_loadu_pd(sig + 2*(n-k-1) + 2);
+      __m128d xr = _mm_unpacklo_pd(v0, v1), xi = _mm_unpackhi_pd(v0, v1);
+      /* reversed: index n-k first */
+      __m128d yr = _mm_unpacklo_pd(u1, u0), yi = _mm_unpackhi_pd(u1, u0);
+      __m128d ck = _mm_loadu_pd(c + k), sk = _mm_loadu_pd(s + k);
+      __m128d er = _mm_mul_pd(vf, _mm_add_pd(xr, yr));
+      __m128d ei = _mm_mul_pd(vf, _mm_sub_pd(xi, yi));
+      __m128d dr = _mm_mul_pd(vf, _mm_sub_pd(xr, yr));
+      __m128d di = _mm_mul_pd(vf, _mm_add_pd(xi, yi));
+      __m128d o_r = _mm_sub_pd(_mm_mul_pd(dr, ck), _mm_mul_pd(di, sk));
+      __m128d o_i = _mm_add_pd(_mm_mul_pd(dr, sk), _mm_mul_pd(di, ck));
+      _mm_storeu_pd(zr + k, _mm_sub_pd(er, o_i));
+      _mm_storeu_pd(zi + k, _mm_add_pd(ei, o_r));
+    }
+    split_inv_from(sig, zr, zi, n, c, s, f, k);
+}
+
+static void interleave_sse2(const double *zr, const double *zi, double *sig,
+                            int32_t n)
+{
+    int32_t k;
+    for (k = 0; k < n; k += 2) {
+      __m128d r = _mm_loadu_pd(zr + k), i = _mm_loadu_pd(zi + k);
+      _mm_storeu_pd(sig + 2*k, _mm_unpacklo_pd(r, i));
+      _mm_storeu_pd(sig + 2*k + 2, _mm_unpackhi_pd(r, i));
+    }
+}
+
+static const DFFT_KERNELS kernels_sse2 = {
+    first_sse2, radix4_sse2, radix2_sse2,
+    split_fwd_sse2, split_inv_sse2, interleave_sse2, "sse2"
+};
+#endif
+
+#ifdef DFFT_AVX2
+
+/* (a0 a1 a2 a3) in lanes of lo/hi unpacks -> natural and reversed order */
+#define ORDER_PD4(v)  _mm256_permute4x64_pd(v, 0xD8)
+#define RORDER_PD4(v) _mm256_permute4x64_pd(v, 0x27)
+#define REV_PD4(v)    _mm256_permute4x64_pd(v, 0x1B)
+
+DFFT_TARGET_AVX2
+static void first_avx2(const double *xr, const double *xi, int32_t xs,
+                       double *yr, double *yi, int32_t n, const double *w,
+                       int32_t inv)
+{
+    int32_t m = n >> 2, p;
+    int32_t ob = inv ? 3*m : m, od = inv ? m : 3*m;
+    for (p = 0; p < m; p += 4) {
+      __m256d a_r, a_i, b_r, b_i, c_r, c_i, d_r, d_i;
+      __m256d w1r = _mm256_loadu_pd(w + p), w1i = _mm256_loadu_pd(w + m + p);
+      __m256d w2r = _mm256_loadu_pd(w + 2*m + p);
+      __m256d w2i = _mm256_loadu_pd(w + 3*m + p);
+      __m256d w3r = _mm256_loadu_pd(w + 4*m + p);
+      __m256d w3i = _mm256_loadu_pd(w + 5*m + p);
+      if (xs == 2) {          /* xr is interleaved re/im */
+#define LOAD_CPLX(r, i, ofs) {                                          \
+          __m256d v0 = _mm256_loadu_pd(xr + 2*(ofs));                   \
+          __m256d v1 = _mm256_loadu_pd(xr + 2*(ofs) + 4);               \
+          r = ORDER_PD4(_mm256_unpacklo_pd(v0, v1));                    \
+          i = ORDER_PD4(_mm256_unpackhi_pd(v0, v1)); }
+        LOAD_CPLX(a_r, a_i, p);
+        LOAD_CPLX(b_r, b_i, p + ob);
+        LOAD_CPLX(c_r, c_i, p + 2*m);
+        LOAD_CPLX(d_r, d_i, p + od);
+#undef LOAD_CPLX
+      }
+      else {
+        a_r = _mm256_loadu_pd(xr + p); a_i = _mm256_loadu_pd(xi + p);
+        b_r = _mm256_loadu_pd(xr + p + ob); b_i = _mm256_loadu_pd(xi + p + ob);
+        c_r = _mm256_loadu_pd(xr + p + 2*m);
+        c_i = _mm256_loadu_pd(xi + p + 2*m);
+        d_r = _mm256_loadu_pd(xr + p + od); d_i = _mm256_loadu_pd(xi + p + od);
+      }
+      {
+        BUTTERFLY4(__m256d, _mm256_add_pd, _mm256_sub_pd, _mm256_mul_pd);
+        /* 4x4 transpose: outputs 4p..4p+15 */
+#define STORE_T(y, v0, v1, v2, v3) {                                    \
+          __m256d t0 = _mm256_unpacklo_pd(v0, v1);                      \
+          __m256d t1 = _mm256_unpackhi_pd(v0, v1);                      \
+          __m256d t2 = _mm256_unpacklo_pd(v2, v3);                      \
+          __m256d t3 = _mm256_unpackhi_pd(v2, v3);                      \
+          _mm256_storeu_pd(y, _mm256_permute2f128_pd(t0, t2, 0x20));    \
+          _mm256_storeu_pd(y + 4, _mm256_permute2f128_pd(t1, t3, 0x20)); \
+          _mm256_storeu_pd(y + 8, _mm256_permute2f128_pd(t0, t2, 0x31)); \
+          _mm256_storeu_pd(y + 12, _mm256_permute2f128_pd(t1, t3, 0x31)); }
+        STORE_T(yr + 4*p, y0r, y1r, y2r, y3r);
+        STORE_T(yi + 4*p, y0i, y1i, y2i, y3i);
+#undef STORE_T
+      }
+    }
+}
+
+DFFT_TARGET_AVX2
+static void radix4_avx2(const double *xr, const double *xi,
+                        double *yr, double *yi, int32_t L, int32_t s,
+                        const double *w, int32_t inv)
+{
+    int32_t m = L >> 2, p, q;
+    int32_t ob = inv ? 3*m : m, od = inv ? m : 3*m;
+    for (p = 0; p < m; p++, w += 6) {
+      __m256d w1r = _mm256_set1_pd(w[0]), w1i = _mm256_set1_pd(w[1]);
+      __m256d w2r = _mm256_set1_pd(w[2]), w2i = _mm256_set1_pd(w[3]);
+      __m256d w3r = _mm256_set1_pd(w[4]), w3i = _mm256_set1_pd(w[5]);
+      const double *ar = xr + s*p, *ai = xi + s*p;
+      const double *br = xr + s*(p+ob), *bi = xi + s*(p+ob);
+      const double *cr = xr + s*(p+2*m), *ci = xi + s*(p+2*m);
+      const double *dr = xr + s*(p+od), *di = xi + s*(p+od);
+      double *zr = yr + s*4*p, *zi = yi + s*4*p;
+      for (q = 0; q < s; q += 4) {
+        __m256d a_r = _mm256_loadu_pd(ar+q), a_i = _mm256_loadu_pd(ai+q);
+        __m256d b_r = _mm256_loadu_pd(br+q), b_i = _mm256_loadu_pd(bi+q);
+        __m256d c_r = _mm256_loadu_pd(cr+q), c_i = _mm256_loadu_pd(ci+q);
+        __m256d d_r = _mm256_loadu_pd(dr+q), d_i = _mm256_loadu_pd(di+q);
+        BUTTERFLY4(__m256d, _mm256_add_pd, _mm256_sub_pd, _mm256_mul_pd);
+        _mm256_storeu_pd(zr+q, y0r);
+        _mm256_storeu_pd(zi+q, y0i);
+        _mm256_storeu_pd(zr+s+q, y1r);
+        _mm256_storeu_pd(zi+s+q, y1i);
+        _mm256_storeu_pd(zr+2*s+q, y2r);
+        _mm256_storeu_pd(zi+2*s+q, y2i);
+        _mm256_storeu_pd(zr+3*s+q, y3r);
+        _mm256_storeu_pd(zi+3*s+q, y3i);
+      }
+    }
+}
+
+DFFT_TARGET_AVX2
+static void radix2_avx2(const double *xr, const double *xi,
+                        double *yr, double *yi, int32_t s)
+{
+    int32_t q;
+    for (q = 0; q < s; q += 4) {
+      __m256d ar = _mm256_loadu_pd(xr+q), ai = _mm256_loadu_pd(xi+q);
+      __m256d br = _mm256_loadu_pd(xr+q+s), bi = _mm256_loadu_pd(xi+q+s);
+      _mm256_storeu_pd(yr+q, _mm256_add_pd(ar, br));
+      _mm256_storeu_pd(yi+q, _mm256_add_pd(ai, bi));
+      _mm256_storeu_pd(yr+q+s, _mm256_sub_pd(ar, br));
+      _mm256_storeu_pd(yi+q+s, _mm256_sub_pd(ai, bi));
+    }
+}
+
+DFFT_TARGET_AVX2
+static void split_fwd_avx2(const double *zr, const double *zi, double *sig,
+                           int32_t n, const double *c, const double *s)
+{
+    const __m256d h = _mm256_set1_pd(0.5);
+    int32_t k;
+    for (k = 1; k <= n - 4; k += 4) {
+      __m256d ar = _mm256_loadu_pd(zr + k), ai = _mm256_loadu_pd(zi + k);
+      __m256d br = REV_PD4(_mm256_loadu_pd(zr + n - k - 3));
+      __m256d bi = REV_PD4(_mm256_loadu_pd(zi + n - k - 3));
+      __m256d ck = _mm256_loadu_pd(c + k), sk = _mm256_loadu_pd(s + k);
+      __m256d er = _mm256_mul_pd(h, _mm256_add_pd(ar, br));
+      __m256d ei = _mm256_mul_pd(h, _mm256_sub_pd(ai, bi));
+      __m256d o_r = _mm256_mul_pd(h, _mm256_add_pd(ai, bi));
+      __m256d o_i = _mm256_mul_pd(h, _mm256_sub_pd(br, ar));
+      __m256d xr = _mm256_add_pd(er, _mm256_add_pd(_mm256_mul_pd(o_r, ck),
+                                                   _mm256_mul_pd(o_i, sk)));
+      __m256d xi = _mm256_add_pd(ei, _mm256_sub_pd(_mm256_mul_pd(o_i, ck),
+                                                   _mm256_mul_pd(o_r, sk)));
+      __m256d lo = _mm256_unpacklo_pd(xr, xi), hi = _mm256_unpackhi_pd(xr, xi);
+      _mm256_storeu_pd(sig + 2*k, _mm256_permute2f128_pd(lo, hi, 0x20));
+      _mm256_storeu_pd(sig + 2*k + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+    }
+    split_fwd_from(zr, zi, sig, n, c, s, k);
+}
+
+DFFT_TARGET_AVX2
+static void split_inv_avx2(const double *sig, double *zr, double *zi,
+                           int32_t n, const double *c, const double *s,
+                           double f)
+{
+    const __m256d vf = _mm256_set1_pd(f);
+    int32_t k;
+    for (k = 1; k <= n - 4; k += 4) {
+      __m256d v0 = _mm256_loadu_pd(sig + 2*k);
+      __m256d v1 = _mm256_loadu_pd(sig + 2*k + 4);
+      __m256d u0 = _mm256_loadu_pd(sig + 2*(n-k-3));
+      __m256d u1 = _mm256_loadu_pd(sig + 2*(n-k-3) + 4);
+      __m256d xr = ORDER_PD4(_mm256_unpacklo_pd(v0, v1));
+      __m256d xi = ORDER_PD4(_mm256_unpackhi_pd(v0, v1));
+      __m256d yr = RORDER_PD4(_mm256_unpacklo_pd(u0, u1));
+      __m256d yi = RORDER_PD4(_mm256_unpackhi_pd(u0, u1));
+      __m256d ck = _mm256_loadu_pd(c + k), sk = _mm256_loadu_pd(s + k);
+      __m256d er = _mm256_mul_pd(vf, _mm256_add_pd(xr, yr));
+      __m256d ei = _mm256_mul_pd(vf, _mm256_sub_pd(xi, yi));
+      __m256d dr = _mm256_mul_pd(vf, _mm256_sub_pd(xr, yr));
+      __m256d di = _mm256_mul_pd(vf, _mm256_add_pd(xi, yi));
+      __m256d o_r = _mm256_sub_pd(_mm256_mul_pd(dr, ck), _mm256_mul_pd(di, sk));
+      __m256d o_i = _mm256_add_pd(_mm256_mul_pd(dr, sk), _mm256_mul_pd(di, ck));
+      _mm256_storeu_pd(zr + k, _mm256_sub_pd(er, o_i));
+      _mm256_storeu_pd(zi + k, _mm256_add_pd(ei, o_r));
+    }
+    split_inv_from(sig, zr, zi, n, c, s, f, k);
+}
+
+DFFT_TARGET_AVX2
+static void interleave_avx2(const double *zr, const double *zi, double *sig,
+                            int32_t n)
+{
+    int32_t k;
+    for (k = 0; k < n; k += 4) {
+      __m256d r = _mm256_loadu_pd(zr + k), i = _mm256_loadu_pd(zi + k);
+      __m256d lo = _mm256_unpacklo_pd(r, i), hi = _mm256_unpackhi_pd(r, i);
+      _mm256_storeu_pd(sig + 2*k, _mm256_permute2f128_pd(lo, hi, 0x20));
+      _mm256_storeu_pd(sig + 2*k + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+    }
+}
+
+static const DFFT_KERNELS kernels_avx2 = {
+    first_avx2, radix4_avx2, radix2_avx2,
+    split_fwd_avx2, split_inv_avx2, interleave_avx2, "avx2"
+};
+
+#endif
+
+static const DFFT_KERNELS *select_kernels(void)
+{
+    static const DFFT_KERNELS *volatile k = NULL;
+    if (k == NULL) {
+#ifdef DFFT_AVX2
+      if (aops_cpu_has(AOPS_CPU_AVX2)) k = &kernels_avx2;
+      else
+#endif
+#ifdef DFFT_X86
+        k = &kernels_sse2;
+#else
+        k = &kernels_scalar;
+#endif
+    }
+    return k;
+}
+
+const char *dfft_simd_name(void)
+{
+    return select_kernels()->name;
+}
+
+static void *align_alloc(CSOUND *csound, size_t nb_bytes)
+{
+    void *p, *p0 = csound->Malloc(csound, nb_bytes + DFFT_ALIGN);
+    if (p0 == NULL) return NULL;
+    p = (void *) (((size_t) p0 + DFFT_ALIGN) & (~((size_t) (DFFT_ALIGN-1))));
+    *((void **) p - 1) = p0;
+    return p;
+}
+
+static DFFT_WORK *dfft_new_work(DFFT_SETUP *setup)
+{
+    CSOUND    *csound = setup->csound;
+    DFFT_WORK *w = (DFFT_WORK *) csound->Malloc(csound, sizeof(DFFT_WORK));
+    w->buf = (double *) align_alloc(csound, sizeof(double) * 4 * setup->n);
+    w->nxt = NULL;
+    return w;
+}
+
+DFFT_SETUP *dfft_new_setup(CSOUND *csound, int32_t N, int32_t d)
+{
+    DFFT_SETUP *setup, **list;
+    int32_t    n = N >> 1, m = n >> 2, L, k, p;
+    double     sgn = (d == FFT_FWD ? -1.0 : 1.0);
+    double     *w;
+
+    if (N < DFFT_MIN_SIZE || (N & (N - 1)))
+      return NULL;
+    list = (DFFT_SETUP **) csound->QueryGlobalVariable(csound, "dfft.setups");
+    if (list == NULL) {
+      if (csound->CreateGlobalVariable(csound, "dfft.setups",
+                                       sizeof(DFFT_SETUP *)) != 0)
+        return NULL;
+      list = (DFFT_SETUP **) csound->QueryGlobalVariable(csound,
+                                                         "dfft.setups");
+    }
+    for (setup = *list; setup != NULL; setup = setup->nxt)
+      if (setup->N == N && setup->d == d)
+        return setup;
+
+    setup = (DFFT_SETUP *) csound->Calloc(csound, sizeof(DFFT_SETUP));
+    setup->csound = csound;
+    setup->N = N;
+    setup->n = n;
+    setup->d = d;
+    setup->tw = (double *) align_alloc(csound, sizeof(double) * 4 * n);
+    if (setup->tw == NULL) {
+      csound->Free(csound, setup);
+      return NULL;
+    }
+    setup->rtw = setup->tw + 2*n;
+
+    /* W^p, W^2p, W^3p, W = exp(-+2 pi i/L): first stage as six arrays */
+    w = setup->tw;
+    for (k = 1; k <= 3; k++)
+      for (p = 0; p < m; p++) {
+        double a = TWOPI * (double) (k*p) / (double) n;
+        w[(2*k-2)*m + p] = cos(a);
+        w[(2*k-1)*m + p] = sgn * sin(a);
+      }
+    w += 6*m;
+    /* later stages: six values per group */
+    for (L = n >> 2; L >= 4; L >>= 2) {
+      for (p = 0; p < (L >> 2); p++) {
+        for (k = 1; k <= 3; k++) {
+          double a = TWOPI * (double) (k*p) / (double) L;
+          *w++ = cos(a);
+          *w++ = sgn * sin(a);
+        }
+      }
+    }
+    for (k = 0; k < n; k++) {
+      double a = TWOPI * (double) k / (double) N;
+      setup->rtw[k] = cos(a);
+      setup->rtw[n + k] = sin(a);
+    }
+    setup->k = select_kernels();
+    csoundSpinLockInit(&setup->lock);
+    setup->work = dfft_new_work(setup);
+    setup->nxt = *list;
+    *list = setup;
+    return setup;
+}
+
+/* stages after the first: returns the buffer holding the result */
+static double *cfft_stages(DFFT_SETUP *setup, double *src, double *dst)
+{
+    const DFFT_KERNELS *kern = setup->k;
+    int32_t n = setup->n, L = n >> 2, s = 4;
+    int32_t inv = (setup->d != FFT_FWD);
+    const double *w = setup->tw + 6*(n >> 2);
+    double *t;
+    for ( ; L >= 4; L >>= 2, s <<= 2) {
+      kern->radix4(src, src + n, dst, dst + n, L, s, w, inv);
+      w += 6*(L >> 2);
+      t = src; src = dst; dst = t;
+    }
+    if (L == 2) {
+      kern->radix2(src, src + n, dst, dst + n, s);
+      src = dst;
+    }
+    return src;
+}
+
+void dfft_execute(DFFT_SETUP *setup, double *sig)
+{
+    const DFFT_KERNELS *kern = setup->k;
+    int32_t n = setup->n;
+    const double *c = setup->rtw, *s = setup->rtw + n;
+    DFFT_WORK *work;
+    double *a, *b, *z;
+
+    csoundSpinLock(&setup->lock);
+    if ((work = setup->work) != NULL)
+      setup->work = work->nxt;
+    csoundSpinUnLock(&setup->lock);
+    if (UNLIKELY(work == NULL))     /* in use on another thread */
+      work = dfft_new_work(setup);
+    a = work->buf;
+    b = work->buf + 2*n;
+
+    if (setup->d == FFT_FWD) {
+      /* even samples as real, odd as imaginary part */
+      kern->first(sig, sig + 1, 2, a, a + n, n, setup->tw, 0);
+      z = cfft_stages(setup, a, b);
+      sig[0] = z[0] + z[n];
+      sig[1] = z[0] - z[n];
+      kern->split_fwd(z, z + n, sig, n, c, s);
+    }
+    else {
+      const double f = 1.0 / (double) setup->N;
+      a[0] = f*(sig[0] + sig[1]);
+      a[n] = f*(sig[0] - sig[1]);
+      kern->split_inv(sig, a, a + n, n, c, s, f);
+      kern->first(a, a + n, 1, b, b + n, n, setup->tw, 1);
+      z = cfft_stages(setup, b, a);
+      kern->interleave(z, z + n, sig, n);
+    }
+    csoundSpinLock(&setup->lock);
+    work->nxt = setup->work;
+    setup->work = work;
+    csoundSpinUnLock(&setup->lock);
+}
@@ -34,6 +34,7 @@
 #include "csound.h"
 #include "fftlib.h"
 #include "pffft.h"
+#include "dfft.h"
 
 
 
@@ -3450,6 +3451,17 @@ void *csoundRealFFT2Setup(CSOUND *csound,
                          int32_t d){
   CSOUND_FFT_SETUP *setup;
   int32_t lib = csound->oparms->fft_lib;
+#ifdef USE_DOUBLE
+  /* without --fftlib, power-of-two sizes go to the native double
+     precision transform */
+  int32_t dfft_ok = isPowTwo(FFTsize) && FFTsize >= DFFT_MIN_SIZE;
+  if(lib < 0)
+    lib = dfft_ok ? DFFT_LIB : FFT_LIB;
+  else if(lib == DFFT_LIB && !dfft_ok)
+    lib = FFT_LIB;
+#else
+  if(lib < 0 || lib == DFFT_LIB) lib = FFT_LIB;
+#endif
   if(lib == PFFT_LIB && FFTsize <= 16){
     csound->Warning(csound,
       "FFTsize %d \n"
@@ -3486,6 +3498,17 @@ void *csoundRealFFT2Setup(CSOUND *csound,
                 PFFFT_BACKWARD);
     setup->lib = lib;
     break;
+#ifdef USE_DOUBLE
+  case DFFT_LIB:
+    /* shared by size and direction, freed with the instance */
+    setup->setup = (void *) dfft_new_setup(csound, FFTsize, d);
+    if (setup->setup != NULL) {
+      setup->d = d;
+      setup->lib = lib;
+      return (void *) setup;
+    }
+    /* fall through */
+#endif
   default:
     setup->lib = 0;
     setup->d = d;
@@ -3511,6 +3534,11 @@ void csoundRealFFT2(CSOUND *csound,
   case PFFT_LIB:
     pffft_execute(setup,sig);
     break;
+#ifdef USE_DOUBLE
+  case DFFT_LIB:
+    dfft_execute((DFFT_SETUP *) setup->setup, sig);
+    break;
+#endif
   default:
     (setup->d == FFT_FWD ?
       csoundRealFFT(csound,
@@ -3528,7 +3556,7 @@ void *csoundDCTSetup(CSOUND *csound,
  setup = (CSOUND_FFT_SETUP *)
    csoundRealFFT2Setup(csound,
                        FFTsize*4,d);
- if(setup->lib == 0){
+ if(setup->lib == 0 || setup->lib == DFFT_LIB){
   setup->buffer = (MYFLT *)
     csound->Calloc(csound, sizeof(MYFLT)*setup->N);
  }
@@ -3656,7 +3684,7 @@ void DCT_execute(CSOUND *csound,
     buffer[i] = FL(0.0);
     buffer[i+1] = sig[j];
   }
-  csoundRealFFT(csound,buffer,N);
+  csoundRealFFT2(csound,setup,buffer);
   for(i=j=0; i < N/2; i+=2, j++){
     sig[j] = buffer[i];
   }
@@ -3672,7 +3700,7 @@ void DCT_execute(CSOUND *csound,
     buffer[i] = -sig[j];
     buffer[i+1] = FL(0.0);
   }
-  csoundInverseRealFFT(csound,buffer,N);
+  csoundRealFFT2(csound,setup,buffer);
   for(i=j=0; i < N/2; i+=2, j++){
     sig[j] = buffer[i+1];
   }
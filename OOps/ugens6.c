@@ -307,15 +307,12 @@ int32_t delrset(CSOUND *csound, DELAYR *p)
     if (UNLIKELY((npts=(uint32_t)MYFLT2LRND(*p->idlt*csound->esr)) < CS_KSMPS)) {
       return csound->InitError(csound, Str("illegal delay time"));
     }
-    if ((auxp = (MYFLT*)p->auxch.auxp) == NULL ||       /* new space if reqd */
-        npts != p->npts) {
-      csound->AuxAlloc(csound, (int32_t)npts*sizeof(MYFLT), &p->auxch);
-      auxp = (MYFLT*)p->auxch.auxp;
-      p->npts = npts;
-    }
-    else if (*p->istor == FL(0.0)) {            /* else if requested */
-      memset(auxp, 0, npts*sizeof(MYFLT));
-    }
+    /* new space, or the old one cleared as far as it was written */
+    csound->AuxAlloc(csound, (int32_t)npts*sizeof(MYFLT), &p->auxch);
+    auxp = (MYFLT*)p->auxch.auxp;
+    p->npts = npts;
+    p->touched = 0;
+    csound->AuxTouched(csound, &p->auxch, 0);
     p->curp = auxp;
     return OK;
 }
@@ -453,6 +450,13 @@ int32_t delayw(CSOUND *csound, DELAYW *p)
         curp = (MYFLT *) q->auxch.auxp;
     }
     q->curp = curp;                                     /* now sav new curp */
+    if (UNLIKELY(q->touched < q->auxch.size) && nsmps > offset) {
+      /* writing starts at the beginning: tell the pool how far it got */
+      q->touched += (nsmps - offset) * sizeof(MYFLT);
+      if (q->touched > q->auxch.size)
+        q->touched = q->auxch.size;
+      csound->AuxTouched(csound, &q->auxch, q->touched);
+    }
     return OK;
  err1:
     return csound->PerfError(csound, p->h.insdshead,
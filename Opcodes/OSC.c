@@ -60,20 +60,44 @@ typedef struct {
 } OSCSEND;
 
 
-typedef struct osc_pat {
-    struct osc_pat *next;
-    union {
-      MYFLT number;
-      STRINGDAT string;
-      void     *blob;
-    } args[ARG_CNT-1];
-} OSC_PAT;
+/* one argument of a queued message */
+typedef union {
+    MYFLT     number;
+    STRINGDAT string;
+    void     *blob;
+} OSC_ARG;
+
+/* Messages waiting to be read by one OSClisten opcode. The ring has
+   OSC_QUEUE_LEN preallocated slots of nargs arguments each; it is only
+   written by the liblo server thread of the port and only read by the
+   opcode at k-time, so neither side needs a lock. */
+#define OSC_QUEUE_LEN (64)
+
+typedef struct {
+    OSC_ARG *msgs;
+    int32_t nargs;
+    volatile uint32_t head;     /* next slot to read */
+    volatile uint32_t tail;     /* next slot to write */
+    volatile int32_t dropped;   /* messages lost to a full ring */
+} OSC_QUEUE;
+
+/* the part of OSClisten shared by the scalar and array versions */
+typedef struct osc_listener {
+    char    *saved_path;
+    char    saved_types[ARG_CNT];    /* copy of type list */
+    uint32_t hash;                   /* of path and types */
+    OSC_QUEUE queue;
+    struct osc_listener *nxt;        /* next listener in the same bucket */
+} OSC_LISTENER;
 
 typedef struct {
     lo_server_thread thread;
     CSOUND  *csound;
     void    *mutex_;
-    void    *oplst;             /* list of opcodes listening on this port */
+    OSC_LISTENER **index;       /* listeners on this port, hashed on
+                                   path and types */
+    int32_t nbuckets;           /* size of index, a power of 2 */
+    int32_t nlisteners;
 } OSC_PORT;
 
 /* structure for global variables */
@@ -107,11 +131,7 @@ typedef struct {
     STRINGDAT   *type;
     MYFLT   *args[ARG_CNT];
     OSC_PORT  *port;
-    char    *saved_path;
-    char    saved_types[ARG_CNT];    /* copy of type list */
-    OSC_PAT *patterns;          /* FIFO list of pending messages */
-    OSC_PAT *freePatterns;      /* free message stack */
-    void    *nxt;               /* pointer to next opcode on the same port */
+    OSC_LISTENER l;
 } OSCLISTEN;
 
 typedef struct {
@@ -122,11 +142,7 @@ typedef struct {
     STRINGDAT *dest; 
     STRINGDAT *type;
     OSC_PORT  *port;
-    char      *saved_path;
-    char      saved_types[ARG_CNT];    /* copy of type list */
-    OSC_PAT   *patterns;          /* FIFO list of pending messages */
-    OSC_PAT   *freePatterns;      /* free message stack */
-    void      *nxt;               /* pointer to next opcode on the same port */
+    OSC_LISTENER l;
 } OSCLISTENA;
 
 static int32_t oscsend_deinit(CSOUND *csound, OSCSEND *p)
@@ -392,6 +408,7 @@ static int32_t OSC_reset(CSOUND *csound, OSC_GLOBALS *p)
         lo_server_thread_stop(p->ports[i].thread);
         lo_server_thread_free(p->ports[i].thread);
         csound->DestroyMutex(p->ports[i].mutex_);
+        csound->Free(csound, p->ports[i].index);
       }
     csound->DestroyGlobalVariable(csound, "_OSC_globals");
     return OK;
@@ -449,123 +466,245 @@ static CS_NOINLINE OSC_GLOBALS *alloc_globals(CSOUND *csound)
 
  /* ------------------------------------------------------------------------ */
 
-static CS_NOINLINE OSC_PAT *alloc_pattern(OSCLISTEN *pp)
+#define OSC_STRING_SIZE (64)    /* preallocated per string argument */
+
+static uint32_t osc_hash(const char *path, const char *types)
 {
-    CSOUND  *csound;
-    OSC_PAT *p;
-    size_t  nbytes;
+    uint32_t h = 2166136261U;   /* FNV-1a */
+    while (*path != '\0')
+      h = (h ^ (uint8_t) *path++) * 16777619U;
+    h = (h ^ (uint8_t) ',') * 16777619U;
+    while (*types != '\0')
+      h = (h ^ (uint8_t) *types++) * 16777619U;
+    return h;
+}
 
-    csound = pp->h.insdshead->csound;
-    /* number of bytes to allocate */
-    nbytes = sizeof(OSC_PAT);
-    /* allocate and initialise structure */
-    p = (OSC_PAT*) csound->Calloc(csound, nbytes);
+static inline int32_t osc_match(OSC_LISTENER *o, uint32_t h,
+                                const char *path, const char *types)
+{
+    return (o->hash == h && strcmp(o->saved_path, path) == 0 &&
+            strcmp(o->saved_types, types) == 0);
+}
 
-    return p;
+static void osc_queue_init(CSOUND *csound, OSC_LISTENER *o)
+{
+    OSC_QUEUE *q = &o->queue;
+    int32_t   i, j;
+
+    q->nargs = (int32_t) strlen(o->saved_types);
+    if (q->nargs < 1) q->nargs = 1;
+    q->msgs = (OSC_ARG*) csound->Calloc(csound, sizeof(OSC_ARG) *
+                                        OSC_QUEUE_LEN * q->nargs);
+    q->head = q->tail = 0;
+    q->dropped = 0;
+    for (i = 0; o->saved_types[i] != '\0'; i++)
+      if (o->saved_types[i] == 's')
+        for (j = 0; j < OSC_QUEUE_LEN; j++) {
+          STRINGDAT *str = &q->msgs[j * q->nargs + i].string;
+          str->data = (char*) csound->Calloc(csound, OSC_STRING_SIZE);
+          str->size = OSC_STRING_SIZE;
+        }
 }
 
-static inline OSC_PAT *get_pattern(OSCLISTEN *pp)
+static void osc_queue_free(CSOUND *csound, OSC_LISTENER *o)
 {
-    OSC_PAT *p;
+    OSC_QUEUE *q = &o->queue;
+    uint32_t  n;
+    int32_t   i;
+
+    if (q->msgs == NULL) return;
+    for (i = 0; o->saved_types[i] != '\0'; i++) {
+      if (o->saved_types[i] == 's') {
+        for (n = 0; n < OSC_QUEUE_LEN; n++)
+          csound->Free(csound, q->msgs[n * q->nargs + i].string.data);
+      }
+      else if (o->saved_types[i] == 'b') {  /* blobs not yet read */
+        for (n = q->head; n != q->tail; n++)
+          csound->Free(csound,
+                       q->msgs[(n & (OSC_QUEUE_LEN-1)) * q->nargs + i].blob);
+      }
+    }
+    csound->Free(csound, q->msgs);
+    q->msgs = NULL;
+}
 
-    if (pp->freePatterns != NULL) {
-      p = pp->freePatterns;
-      pp->freePatterns = p->next;
-      return p;
+/* called by the server thread only */
+static void osc_queue_push(CSOUND *csound, OSC_LISTENER *o,
+                           const char *types, lo_arg **argv)
+{
+    OSC_QUEUE *q = &o->queue;
+    uint32_t  tail = q->tail;
+    OSC_ARG   *m;
+    int32_t   i;
+
+    if (UNLIKELY(tail - ATOMIC_LOAD_ACQ(q->head) >= OSC_QUEUE_LEN)) {
+      ATOMIC_INCR(q->dropped);
+      return;
     }
-    return alloc_pattern(pp);
+    m = &q->msgs[(tail & (OSC_QUEUE_LEN-1)) * q->nargs];
+    /* copy argument list */
+    for (i = 0; o->saved_types[i] != '\0'; i++) {
+      switch (types[i]) {
+      default:              /* Should not happen */
+      case 'i':
+        m[i].number = (MYFLT) argv[i]->i; break;
+      case 'h':
+        m[i].number = (MYFLT) argv[i]->i64; break;
+      case 'c':
+        m[i].number= (MYFLT) argv[i]->c; break;
+      case 'f':
+        m[i].number = (MYFLT) argv[i]->f; break;
+      case 'd':
+        m[i].number= (MYFLT) argv[i]->d; break;
+      case 's':
+        {
+          char  *src = (char*) &(argv[i]->s), *dst = m[i].string.data;
+          if (m[i].string.size <= (int32_t) strlen(src)) {
+            if (dst != NULL) csound->Free(csound, dst);
+            dst = csound->Strdup(csound, src);
+            m[i].string.data = dst;
+            m[i].string.size = strlen(dst)+1;
+          }
+          else strcpy(dst, src);
+          break;
+        }
+      case 'b':
+        {
+          int32_t len =
+            lo_blobsize((lo_blob*)argv[i]);
+          m[i].blob =
+            csound->Malloc(csound,len);
+          memcpy(m[i].blob, argv[i], len);
+#ifdef OSC_DEBUG
+          {
+            lo_blob *bb = (lo_blob*)m[i].blob;
+            int32_t size = lo_blob_datasize(bb);
+            MYFLT *data = lo_blob_dataptr(bb);
+            int32_t   *idata = (int32_t*)data;
+            printf("size=%d data=%.8x %.8x ...\n",size, idata[0], idata[1]);
+          }
+#endif
+        }
+      }
+    }
+    ATOMIC_STORE_REL(q->tail, tail + 1);
+}
+
+/* called at k-time: returns the oldest message, or NULL if there is none;
+   osc_queue_pop() releases it once the arguments are copied */
+static inline OSC_ARG *osc_queue_peek(CSOUND *csound, OSC_LISTENER *o)
+{
+    OSC_QUEUE *q = &o->queue;
+    uint32_t  head = q->head;
+
+    if (UNLIKELY(q->dropped != 0)) {
+      int32_t n = q->dropped;
+      ATOMIC_SUB(q->dropped, n);
+      csound->Warning(csound,
+                      Str("OSClisten: %d messages for %s dropped, queue full\n"),
+                      n, o->saved_path);
+    }
+    if (head == ATOMIC_LOAD_ACQ(q->tail))
+      return NULL;
+    return &q->msgs[(head & (OSC_QUEUE_LEN-1)) * q->nargs];
+}
+
+static inline void osc_queue_pop(OSC_LISTENER *o)
+{
+    ATOMIC_STORE_REL(o->queue.head, o->queue.head + 1);
 }
 
 static int32_t OSC_handler(const char *path, const char *types,
                        lo_arg **argv, int32_t argc, void *data, void *p)
 {
-     IGN(argc);  IGN(data);
+    IGN(argc);  IGN(data);
     OSC_PORT  *pp = (OSC_PORT*) p;
-    OSCLISTEN *o;
     CSOUND    *csound = (CSOUND *) pp->csound;
-    int32_t       retval = 1;
+    uint32_t  h = osc_hash(path, types);
+    OSC_LISTENER *o;
+    int32_t   retval = 1;
 
+    /* the mutex only guards the index against listeners being added or
+       removed at i-time; the opcodes read their queues without it */
     pp->csound->LockMutex(pp->mutex_);
-    o = (OSCLISTEN*) pp->oplst;
-    //printf("opst=%p\n", o);
-    while (o != NULL) {
-      //printf("Looking at %s/%s against %s/%s\n",
-      //       o->saved_path, path,o->saved_types, types);
-      if (strcmp(o->saved_path, path) == 0 &&
-          strcmp(o->saved_types, types) == 0) {
-        /* Message is for this guy */
-        int32_t     i;
-        OSC_PAT *m;
-        //printf("handler found message\n");
-        m = get_pattern(o);
-        if (m != NULL) {
-          /* queue message for being read by OSClisten opcode */
-          m->next = NULL;
-          if (o->patterns == NULL)
-            o->patterns = m;
-          else {
-            OSC_PAT *mm;
-            for (mm = o->patterns; mm->next != NULL; mm = mm->next)
-              ;
-            mm->next = m;
-          }
-          /* copy argument list */
-          for (i = 0; o->saved_types[i] != '\0'; i++) {
-            switch (types[i]) {
-            default:              /* Should not happen */
-            case 'i':
-              m->args[i].number = (MYFLT) argv[i]->i; break;
-            case 'h':
-              m->args[i].number = (MYFLT) argv[i]->i64; break;
-            case 'c':
-               m->args[i].number= (MYFLT) argv[i]->c; break;
-            case 'f':
-               m->args[i].number = (MYFLT) argv[i]->f; break;
-            case 'd':
-               m->args[i].number= (MYFLT) argv[i]->d; break;
-            case 's':
-              { // ***NO CHECK THAT m->args[i] IS A STRING
-                char  *src = (char*) &(argv[i]->s), *dst = m->args[i].string.data;
-                if (m->args[i].string.size <= (int32_t) strlen(src)) {
-                  if (dst != NULL) csound->Free(csound, dst);
-                  dst = csound->Strdup(csound, src);
-                  // who sets m->args[i].string.size ??
-                  m->args[i].string.data = dst;
-                  m->args[i].string.size = strlen(dst)+1;
-                }
-                else strcpy(dst, src);
-                break;
-              }
-            case 'b':
-              {
-                int32_t len =
-                  lo_blobsize((lo_blob*)argv[i]);
-                m->args[i].blob =
-                  csound->Malloc(csound,len);
-                memcpy(m->args[i].blob, argv[i], len);
-#ifdef OSC_DEBUG
-                {
-                  lo_blob *bb = (lo_blob*)m->args[i].blob;
-                  int32_t size = lo_blob_datasize(bb);
-                  MYFLT *data = lo_blob_dataptr(bb);
-                  int32_t   *idata = (int32_t*)data;
-                  printf("size=%d data=%.8x %.8x ...\n",size, idata[0], idata[1]);
-                }
-#endif
-              }
-            }
-          }
+    if (pp->index != NULL) {
+      for (o = pp->index[h & (pp->nbuckets-1)]; o != NULL; o = o->nxt)
+        if (osc_match(o, h, path, types)) {
+          /* Message is for this guy */
+          osc_queue_push(csound, o, types, argv);
           retval = 0;
         }
-        break;
-      }
-      o = (OSCLISTEN*) o->nxt;
     }
-
     pp->csound->UnlockMutex(pp->mutex_);
     return retval;
 }
 
+/* Adds a listener to the index of its port, and the liblo method for
+   its path and types unless another listener already has one */
+static void osc_listener_add(CSOUND *csound, OSC_PORT *pp, OSC_LISTENER *l)
+{
+    OSC_LISTENER *o;
+    int32_t      i, found = 0;
+
+    l->hash = osc_hash(l->saved_path, l->saved_types);
+    osc_queue_init(csound, l);
+    csound->LockMutex(pp->mutex_);
+    if (pp->nlisteners >= pp->nbuckets) {
+      int32_t      n = pp->nbuckets ? 2 * pp->nbuckets : 64;
+      OSC_LISTENER **index =
+        (OSC_LISTENER**) csound->Calloc(csound, n * sizeof(OSC_LISTENER*));
+      for (i = 0; i < pp->nbuckets; i++)
+        while ((o = pp->index[i]) != NULL) {
+          pp->index[i] = o->nxt;
+          o->nxt = index[o->hash & (n-1)];
+          index[o->hash & (n-1)] = o;
+        }
+      csound->Free(csound, pp->index);
+      pp->index = index;
+      pp->nbuckets = n;
+    }
+    for (o = pp->index[l->hash & (pp->nbuckets-1)]; o != NULL; o = o->nxt)
+      if (osc_match(o, l->hash, l->saved_path, l->saved_types))
+        found = 1;
+    l->nxt = pp->index[l->hash & (pp->nbuckets-1)];
+    pp->index[l->hash & (pp->nbuckets-1)] = l;
+    pp->nlisteners++;
+    csound->UnlockMutex(pp->mutex_);
+    if (!found)
+      (void) lo_server_thread_add_method(pp->thread,
+                                         l->saved_path, l->saved_types,
+                                         OSC_handler, pp);
+}
+
+static int32_t osc_listener_remove(CSOUND *csound, OSC_PORT *pp,
+                                   OSC_LISTENER *l)
+{
+    OSC_LISTENER **o;
+    int32_t      found = 0;
+
+    if (pp->mutex_==NULL) return NOTOK;
+    csound->LockMutex(pp->mutex_);
+    for (o = &pp->index[l->hash & (pp->nbuckets-1)]; *o != NULL; ) {
+      if (*o == l) {
+        *o = l->nxt;
+        pp->nlisteners--;
+      }
+      else {
+        if (osc_match(*o, l->hash, l->saved_path, l->saved_types))
+          found = 1;
+        o = &(*o)->nxt;
+      }
+    }
+    csound->UnlockMutex(pp->mutex_);
+    if (!found)
+      lo_server_thread_del_method(pp->thread, l->saved_path, l->saved_types);
+    osc_queue_free(csound, l);
+    csound->Free(csound, l->saved_path);
+    l->saved_path = NULL;
+    l->nxt = NULL;
+    return OK;
+}
+
 static void OSC_error(int32_t num, const char *msg, const char *path)
 {
     fprintf(stderr, "OSC server error %d in path %s: %s\n", num, path, msg);
@@ -584,6 +723,9 @@ static int32_t OSC_deinit(CSOUND *csound, OSCINIT *p)
     lo_server_thread_stop(ports[n].thread);
     lo_server_thread_free(ports[n].thread);
     ports[n].thread =  NULL;
+    csound->Free(csound, ports[n].index);
+    ports[n].index = NULL;
+    ports[n].nbuckets = 0;
     csound->Message(csound, "%s", Str("OSC deinitiatised\n"));
     return OK;
 }
@@ -602,7 +744,9 @@ static int32_t osc_listener_init(CSOUND *csound, OSCINIT *p)
                                         sizeof(OSC_PORT) * (n + 1));
     ports[n].csound = csound;
     ports[n].mutex_ = csound->Create_Mutex(0);
-    ports[n].oplst = NULL;
+    ports[n].index = NULL;
+    ports[n].nbuckets = 0;
+    ports[n].nlisteners = 0;
     snprintf(buff, 32, "%d", (int32_t) *(p->port));
     ports[n].thread = lo_server_thread_new(buff, OSC_error);
     if (UNLIKELY(ports[n].thread==NULL))
@@ -637,7 +781,9 @@ static int32_t osc_listener_initMulti(CSOUND *csound, OSCINITM *p)
                                         sizeof(OSC_PORT) * (n + 1));
     ports[n].csound = csound;
     ports[n].mutex_ = csound->Create_Mutex(0);
-    ports[n].oplst = NULL;
+    ports[n].index = NULL;
+    ports[n].nbuckets = 0;
+    ports[n].nlisteners = 0;
     snprintf(buff, 32, "%d", (int32_t) *(p->port));
     ports[n].thread = lo_server_thread_new_multicast(p->group->data,
                                                      buff, OSC_error);
@@ -664,38 +810,7 @@ static int32_t osc_listener_initMulti(CSOUND *csound, OSCINITM *p)
 
 static int32_t OSC_listdeinit(CSOUND *csound, OSCLISTEN *p)
 {
-    OSC_PAT *m;
-
-    if (p->port->mutex_==NULL) return NOTOK;
-    csound->LockMutex(p->port->mutex_);
-    if (p->port->oplst == (void*) p)
-      p->port->oplst = p->nxt;
-    else {
-      OSCLISTEN *o = (OSCLISTEN*) p->port->oplst;
-      for ( ; o->nxt != (void*) p; o = (OSCLISTEN*) o->nxt)
-        ;
-      o->nxt = p->nxt;
-    }
-    csound->UnlockMutex(p->port->mutex_);
-    lo_server_thread_del_method(p->port->thread, p->saved_path, p->saved_types);
-    csound->Free(csound, p->saved_path);
-    p->saved_path = NULL;
-    p->nxt = NULL;
-    m = p->patterns;
-    p->patterns = NULL;
-    while (m != NULL) {
-      OSC_PAT *mm = m->next;
-      csound->Free(csound, m);
-      m = mm;
-    }
-    m = p->freePatterns;
-    p->freePatterns = NULL;
-    while (m != NULL) {
-      OSC_PAT *mm = m->next;
-      csound->Free(csound, m);
-      m = mm;
-    }
-    return OK;
+    return osc_listener_remove(csound, p->port, &p->l);
 }
 
 static int32_t OSC_list_init(CSOUND *csound, OSCLISTEN *p)
@@ -712,9 +827,9 @@ static int32_t OSC_list_init(CSOUND *csound, OSCLISTEN *p)
     if (UNLIKELY(n < 0 || n >= pp->nPorts))
       return csound->InitError(csound, "%s", Str("invalid handle"));
     p->port = &(pp->ports[n]);
-    p->saved_path = (char*) csound->Malloc(csound,
-                                           strlen((char*) p->dest->data) + 1);
-    strcpy(p->saved_path, (char*) p->dest->data);
+    p->l.saved_path = (char*) csound->Malloc(csound,
+                                             strlen((char*) p->dest->data) + 1);
+    strcpy(p->l.saved_path, (char*) p->dest->data);
     /* check for a valid argument list */
     n = csound->GetInputArgCnt(p) - 3;
     if (UNLIKELY(n < 1 || n > ARG_CNT-4))
@@ -723,19 +838,19 @@ static int32_t OSC_list_init(CSOUND *csound, OSCLISTEN *p)
       return csound->InitError(csound,
                                "%s", Str("argument list inconsistent with "
                                    "format string"));
-    strcpy(p->saved_types, (char*) p->type->data);
+    strcpy(p->l.saved_types, (char*) p->type->data);
     for (i = 0; i < n; i++) {
       const char *s;
       s = csound->GetInputArgName(p, i + 3);
       if (s[0] == 'g')
         s++;
-      switch (p->saved_types[i]) {
+      switch (p->l.saved_types[i]) {
       case 'G':
       case 'A':
       case 'D':
       case 'a':
       case 'S':
-        p->saved_types[i] = 'b';
+        p->l.saved_types[i] = 'b';
         break;
       case 'c':
       case 'd':
@@ -755,13 +870,7 @@ static int32_t OSC_list_init(CSOUND *csound, OSCLISTEN *p)
         return csound->InitError(csound, "%s", Str("invalid type"));
       }
     }
-    csound->LockMutex(p->port->mutex_);
-    p->nxt = p->port->oplst;
-    p->port->oplst = (void*) p;
-    csound->UnlockMutex(p->port->mutex_);
-    (void) lo_server_thread_add_method(p->port->thread,
-                                       p->saved_path, p->saved_types,
-                                       OSC_handler, p->port);
+    osc_listener_add(csound, p->port, &p->l);
     csound->RegisterDeinitCallback(csound, p,
                                    (int32_t (*)(CSOUND *, void *)) OSC_listdeinit);
     return OK;
@@ -769,26 +878,17 @@ static int32_t OSC_list_init(CSOUND *csound, OSCLISTEN *p)
 
 static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
 {
-    OSC_PAT *m;
+    OSC_ARG *m;
 
-    /* quick check for empty queue */
-    if (p->patterns == NULL) {
-      *p->kans = 0;
-      return OK;
-    }
-    csound->LockMutex(p->port->mutex_);
-    m = p->patterns;
-    /* check again for thread safety */
+    m = osc_queue_peek(csound, &p->l);
     if (m != NULL) {
       int32_t i;
-      /* unlink from queue */
-      p->patterns = m->next;
       /* copy arguments */
       //printf("copying args\n");
-      for (i = 0; p->saved_types[i] != '\0'; i++) {
-        //printf("%d: type %c\n", i, p->saved_types[i]);
-        if (p->saved_types[i] == 's') {
-          char *src = m->args[i].string.data;
+      for (i = 0; p->l.saved_types[i] != '\0'; i++) {
+        //printf("%d: type %c\n", i, p->l.saved_types[i]);
+        if (p->l.saved_types[i] == 's') {
+          char *src = m[i].string.data;
           char *dst = ((STRINGDAT*) p->args[i])->data;
           if (src != NULL) {
             if (((STRINGDAT*) p->args[i])->size <= (int32_t) strlen(src)){
@@ -801,12 +901,12 @@ static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
             strcpy(dst, src);
           }
         }
-        else if (p->saved_types[i]=='b') {
+        else if (p->l.saved_types[i]=='b') {
           char c = p->type->data[i];
-          int32_t len =  lo_blob_datasize(m->args[i].blob);
-          //printf("blob found %p type %c\n", m->args[i].blob, c);
-          //printf("length = %d\n", lo_blob_datasize(m->args[i].blob));
-          int32_t *idata = lo_blob_dataptr(m->args[i].blob);
+          int32_t len =  lo_blob_datasize(m[i].blob);
+          //printf("blob found %p type %c\n", m[i].blob, c);
+          //printf("length = %d\n", lo_blob_datasize(m[i].blob));
+          int32_t *idata = lo_blob_dataptr(m[i].blob);
           if (c == 'D') {
             int32_t j;
             MYFLT *data = (MYFLT *) idata;
@@ -866,12 +966,17 @@ static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
             MYFLT *data = (MYFLT *) idata;
             int32_t fno = MYFLT2LRND(*p->args[i]);
             FUNC *ftp;
-            if (UNLIKELY(fno <= 0))
+            if (UNLIKELY(fno <= 0)) {
+              csound->Free(csound, m[i].blob);
+              osc_queue_pop(&p->l);
               return csound->PerfError(csound, p->h.insdshead,
                                        Str("Invalid ftable no. %d"), fno);
+            }
 
             ftp = csound->FTnp2Find(csound, p->args[i]);
             if (UNLIKELY(ftp==NULL)) {
+              csound->Free(csound, m[i].blob);
+              osc_queue_pop(&p->l);
               return csound->PerfError(csound, p->h.insdshead,
                                        "%s", Str("OSC internal error"));
             }
@@ -914,148 +1019,30 @@ static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
           }
           else if (c == 'S') {
           }
-          else return csound->PerfError(csound,  p->h.insdshead, "Oh dear");
-          csound->Free(csound, m->args[i].blob);
+          else {
+            csound->Free(csound, m[i].blob);
+            osc_queue_pop(&p->l);
+            return csound->PerfError(csound,  p->h.insdshead, "Oh dear");
+          }
+          csound->Free(csound, m[i].blob);
         }
         else
-          *(p->args[i]) = m->args[i].number;
+          *(p->args[i]) = m[i].number;
       }
-      /* push to stack of free message structures */
-      m->next = p->freePatterns;
-      p->freePatterns = m;
+      /* hand the slot back to the server thread */
+      osc_queue_pop(&p->l);
       *p->kans = 1;
     }
     else
       *p->kans = 0;
-    csound->UnlockMutex(p->port->mutex_);
     return OK;
 }
 
 /* ******** ARRAY VERSION **** EXPERIMENTAL *** */
-#if 0
-//**** This fn only uses p to get csound pointer so any opcoe structwill do! ****
-static CS_NOINLINE OSC_PAT *alloc_apattern(OSCLISTENA *pp)
-{
-    CSOUND  *csound;
-    OSC_PAT *p;
-    size_t  nbytes;
-
-    csound = pp->h.insdshead->csound;
-    /* number of bytes to allocate */
-    nbytes = sizeof(OSC_PAT);
-    /* allocate and initialise structure */
-    p = (OSC_PAT*) csound->Calloc(csound, nbytes);
-
-    return p;
-}
-#endif
-
-static inline OSC_PAT *get_apattern(OSCLISTENA *pp)
-{
-    OSC_PAT *p;
-
-    if (pp->freePatterns != NULL) {
-      p = pp->freePatterns;
-      pp->freePatterns = p->next;
-      return p;
-    }
-    return alloc_pattern((OSCLISTEN*)pp);
-}
-
-static int32_t OSC_ahandler(const char *path, const char *types,
-                       lo_arg **argv, int32_t argc, void *data, void *p)
-{
-    IGN(argc);  IGN(data);
-    OSC_PORT  *pp = (OSC_PORT*) p;
-    OSCLISTENA *o;
-    //CSOUND    *csound = (CSOUND *) pp->csound;
-    int32_t   retval = 1;
-    //printf("***in ahandler\n");
-    pp->csound->LockMutex(pp->mutex_);
-    o = (OSCLISTENA*) pp->oplst;
-    //printf("opst=%p\n", o);
-    while (o != NULL) {
-      //printf("Looking at %s/%s against %s/%s\n",
-      //       o->saved_path, path,o->saved_types, types);
-      if (strcmp(o->saved_path, path) == 0 &&
-          strcmp(o->saved_types, types) == 0) {
-        /* Message is for this guy */
-        int32_t     i;
-        OSC_PAT *m;
-        //printf("handler found message\n");
-        m = get_apattern(o);
-        if (m != NULL) {
-          /* queue message for being read by OSClisten opcode */
-          m->next = NULL;
-          if (o->patterns == NULL)
-            o->patterns = m;
-          else {
-            OSC_PAT *mm;
-            for (mm = o->patterns; mm->next != NULL; mm = mm->next)
-              ;
-            mm->next = m;
-          }
-          /* copy argument list */
-          for (i = 0; o->saved_types[i] != '\0'; i++) {
-            switch (types[i]) {
-            default:              /* Should not happen */
-            case 'i':
-              m->args[i].number = (MYFLT) argv[i]->i; break;
-            case 'h':
-              m->args[i].number = (MYFLT) argv[i]->i64; break;
-            case 'c':
-              m->args[i].number= (MYFLT) argv[i]->c; break;
-            case 'f':
-              m->args[i].number = (MYFLT) argv[i]->f; break;
-            case 'd':
-              m->args[i].number= (MYFLT) argv[i]->d; break;
-            }
-          }
-          retval = 0;
-        }
-        break;
-      }
-      o = (OSCLISTENA*) o->nxt;
-    }
-
-    pp->csound->UnlockMutex(pp->mutex_);
-    return retval;
-}
 
 static int32_t OSC_listadeinit(CSOUND *csound, OSCLISTENA *p)
 {
-    OSC_PAT *m;
-
-    if (p->port->mutex_==NULL) return NOTOK;
-    csound->LockMutex(p->port->mutex_);
-    if (p->port->oplst == (void*) p)
-      p->port->oplst = p->nxt;
-    else {
-      OSCLISTEN *o = (OSCLISTEN*) p->port->oplst;
-      for ( ; o->nxt != (void*) p; o = (OSCLISTEN*) o->nxt)
-        ;
-      o->nxt = p->nxt;
-    }
-    csound->UnlockMutex(p->port->mutex_);
-    lo_server_thread_del_method(p->port->thread, p->saved_path, p->saved_types);
-    csound->Free(csound, p->saved_path);
-    p->saved_path = NULL;
-    p->nxt = NULL;
-    m = p->patterns;
-    p->patterns = NULL;
-    while (m != NULL) {
-      OSC_PAT *mm = m->next;
-      csound->Free(csound, m);
-      m = mm;
-    }
-    m = p->freePatterns;
-    p->freePatterns = NULL;
-    while (m != NULL) {
-      OSC_PAT *mm = m->next;
-      csound->Free(csound, m);
-      m = mm;
-    }
-    return OK;
+    return osc_listener_remove(csound, p->port, &p->l);
 }
 
 static inline void tabensure(CSOUND *csound, ARRAYDAT *p, int32_t size)
@@ -1091,9 +1078,9 @@ static int32_t OSC_alist_init(CSOUND *csound, OSCLISTENA *p)
     if (UNLIKELY(n < 0 || n >= pp->nPorts))
       return csound->InitError(csound, "%s", Str("invalid handle"));
     p->port = &(pp->ports[n]);
-    p->saved_path = (char*) csound->Malloc(csound,
-                                           strlen((char*) p->dest->data) + 1);
-    strcpy(p->saved_path, (char*) p->dest->data);
+    p->l.saved_path = (char*) csound->Malloc(csound,
+                                             strlen((char*) p->dest->data) + 1);
+    strcpy(p->l.saved_path, (char*) p->dest->data);
     /* check for a valid argument list */
     tabensure(csound, p->args, n=strlen((char*) p->type->data));
     /* // ****** could use equivalent of tabensure here but it is static ***** */
@@ -1102,9 +1089,9 @@ static int32_t OSC_alist_init(CSOUND *csound, OSCLISTENA *p)
     /*         return csound->InitError(csound, */
     /*                            "%s", Str("argument array nconsistent with " */
     /*                                "format string")); */
-    strcpy(p->saved_types, (char*) p->type->data);
+    strcpy(p->l.saved_types, (char*) p->type->data);
     for (i = 0; i < n; i++) {
-      switch (p->saved_types[i]) {
+      switch (p->l.saved_types[i]) {
       case 'c':
       case 'd':
       case 'f':
@@ -1115,13 +1102,7 @@ static int32_t OSC_alist_init(CSOUND *csound, OSCLISTENA *p)
         return csound->InitError(csound, "%s", Str("invalid type"));
       }
     }
-    csound->LockMutex(p->port->mutex_);
-    p->nxt = p->port->oplst;
-    p->port->oplst = (void*) p;
-    csound->UnlockMutex(p->port->mutex_);
-    (void) lo_server_thread_add_method(p->port->thread,
-                                       p->saved_path, p->saved_types,
-                                       OSC_ahandler, p->port);
+    osc_listener_add(csound, p->port, &p->l);
     csound->RegisterDeinitCallback(csound, p,
                                    (int32_t (*)(CSOUND *, void *)) OSC_listadeinit);
     return OK;
@@ -1129,33 +1110,20 @@ static int32_t OSC_alist_init(CSOUND *csound, OSCLISTENA *p)
 
 static int32_t OSC_alist(CSOUND *csound, OSCLISTENA *p)
 {
-    OSC_PAT *m;
-    /* quick check for empty queue */
-    if (p->patterns == NULL) {
-      *p->kans = 0;
-      return OK;
-    }
-    csound->LockMutex(p->port->mutex_);
-    m = p->patterns;
-    /* check again for thread safety */
+    OSC_ARG *m;
+
+    m = osc_queue_peek(csound, &p->l);
     if (m != NULL) {
       int32_t i;
-      /* unlink from queue */
-      p->patterns = m->next;
       /* copy arguments */
-      //printf("copying args\n");
-      for (i = 0; p->saved_types[i] != '\0'; i++) {
-        //printf("%d: type %c\n", i, p->saved_types[i]);
-        ((MYFLT*)p->args->data)[i] = m->args[i].number;
+      for (i = 0; p->l.saved_types[i] != '\0'; i++) {
+        ((MYFLT*)p->args->data)[i] = m[i].number;
       }
-      /* push to stack of free message structures */
-      m->next = p->freePatterns;
-      p->freePatterns = m;
+      osc_queue_pop(&p->l);
       *p->kans = 1;
     }
     else
       *p->kans = 0;
-    csound->UnlockMutex(p->port->mutex_);
     return OK;
 }
 
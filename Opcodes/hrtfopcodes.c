@@ -141,6 +141,204 @@ static int32_t swap4bytes(CSOUND* csound, MEMFIL* mfp)
 static int32_t (*swap4bytes)(CSOUND*, MEMFIL*) = NULL;
 #endif
 
+/* Data sets are held once per engine and shared read-only by all
+   instances: the measurements of each direction in the files as MYFLT,
+   their phases as unit phasors (for phase truncation) and, once an
+   hrtfmove in minimum phase mode needs them, the padded spectra of the
+   minimum phase impulse of every direction. The files only hold the
+   directions from 0 to 180 degrees, the others are their mirror image
+   with the ears swapped. */
+
+#define HRTF_NDIRS  (368)
+
+typedef struct hrtfdata_ {
+    struct hrtfdata_ *nxt;
+    MEMFIL  *fpl, *fpr;
+    int32_t irlength, irlengthpad;
+    /* first direction of each elevation */
+    int32_t dirbase[14];
+    /* [direction][ear][irlength] */
+    MYFLT   *data, *phasor;
+    /* [direction][ear][irlengthpad] */
+    MYFLT   *minphase;
+} HRTFDATA;
+
+/* direction in the files of angleindex at elevindex; sets *swap for
+   the mirrored half */
+static inline int32_t hrtf_dir(const HRTFDATA *h, int32_t elevindex,
+                               int32_t angleindex, int32_t *swap)
+{
+    *swap = (angleindex > elevationarray[elevindex] / 2);
+    if (*swap)
+      angleindex = elevationarray[elevindex] - angleindex;
+    return h->dirbase[elevindex] + angleindex;
+}
+
+/* the len values of one of the tables above for ear (0 left, 1 right) */
+static inline const MYFLT *hrtf_ear(const HRTFDATA *h, const MYFLT *tab,
+                                    int32_t len, int32_t elevindex,
+                                    int32_t angleindex, int32_t ear)
+{
+    int32_t swap, dir = hrtf_dir(h, elevindex, angleindex, &swap);
+    return tab + ((size_t) dir * 2 + (ear ^ swap)) * len;
+}
+
+static int32_t hrtf_data(CSOUND *csound, HRTFDATA **hp, STRINGDAT *ifilel,
+                         STRINGDAT *ifiler, int32_t irlength)
+{
+    HRTFDATA **list, *h;
+    MEMFIL  *fpl, *fpr;
+    char    filel[MAXNAME], filer[MAXNAME];
+    int32_t i, n, ear;
+
+    /* copy in string name */
+    strNcpy(filel, (char*) ifilel->data, MAXNAME-1);
+    strNcpy(filer, (char*) ifiler->data, MAXNAME-1);
+
+    /* reading files, with byte swap */
+    fpl = csound->ldmemfile2withCB(csound, filel, CSFTYPE_FLOATS_BINARY,
+                                   swap4bytes);
+    if (UNLIKELY(fpl == NULL))
+      return
+        csound->InitError(csound,
+                          Str("\n\n\nCannot load left data file, exiting\n\n"));
+
+    fpr = csound->ldmemfile2withCB(csound, filer, CSFTYPE_FLOATS_BINARY,
+                                   swap4bytes);
+    if (UNLIKELY(fpr == NULL))
+      return
+        csound->InitError(csound,
+                          Str("\n\n\nCannot load right data file, exiting\n\n"));
+
+    list = (HRTFDATA **) csound->QueryGlobalVariable(csound, "hrtfopcodes.data");
+    if (list == NULL) {
+      if (UNLIKELY(csound->CreateGlobalVariable(csound, "hrtfopcodes.data",
+                                                sizeof(HRTFDATA *)) != 0))
+        return csound->InitError(csound, Str("could not allocate globals"));
+      list = (HRTFDATA **) csound->QueryGlobalVariable(csound,
+                                                       "hrtfopcodes.data");
+    }
+    for (h = *list; h != NULL; h = h->nxt)
+      if (h->fpl == fpl && h->fpr == fpr && h->irlength == irlength) {
+        *hp = h;
+        return OK;
+      }
+
+    n = HRTF_NDIRS * irlength * (int32_t) sizeof(float);
+    if (UNLIKELY(fpl->length < n || fpr->length < n))
+      return csound->InitError(csound, Str("HRTF data file too short"));
+
+    h = (HRTFDATA *) csound->Calloc(csound, sizeof(HRTFDATA));
+    h->fpl = fpl;
+    h->fpr = fpr;
+    h->irlength = irlength;
+    h->irlengthpad = 2 * irlength;
+    for (i = 1; i < 14; i++)
+      h->dirbase[i] = h->dirbase[i - 1] + elevationarray[i - 1] / 2 + 1;
+    h->data = (MYFLT *) csound->Malloc(csound, HRTF_NDIRS * 2 * irlength *
+                                               sizeof(MYFLT));
+    h->phasor = (MYFLT *) csound->Malloc(csound, HRTF_NDIRS * 2 * irlength *
+                                                 sizeof(MYFLT));
+    for (n = 0; n < HRTF_NDIRS; n++)
+      for (ear = 0; ear < 2; ear++) {
+        const float *fp = (const float *) (ear ? fpr : fpl)->beginp +
+                          (size_t) n * irlength;
+        MYFLT *d = h->data + ((size_t) n * 2 + ear) * irlength;
+        MYFLT *ph = h->phasor + ((size_t) n * 2 + ear) * irlength;
+        for (i = 0; i < irlength; i++)
+          d[i] = fp[i];
+        /* 0 Hz and Nyq are real: a negative value is a phase of pi */
+        ph[0] = (d[0] < FL(0.0) ? -FL(1.0) : FL(1.0));
+        ph[1] = (d[1] < FL(0.0) ? -FL(1.0) : FL(1.0));
+        for (i = 2; i < irlength; i += 2) {
+          ph[i] = COS(d[i + 1]);
+          ph[i + 1] = SIN(d[i + 1]);
+        }
+      }
+    h->nxt = *list;
+    *list = h;
+    *hp = h;
+    return OK;
+}
+
+/* minimum phase spectra for all directions: the real cepstrum method
+   of hrtfmove, applied to the measured magnitudes */
+static void hrtf_minphase(CSOUND *csound, HRTFDATA *h)
+{
+    int32_t irlength = h->irlength, irlengthpad = h->irlengthpad;
+    int32_t i, n;
+    MYFLT   *mag, *logmag, *xhatwin, *expxhatwin, *win;
+
+    if (h->minphase != NULL)
+      return;
+    h->minphase = (MYFLT *) csound->Malloc(csound, HRTF_NDIRS * 2 *
+                                                   irlengthpad * sizeof(MYFLT));
+    logmag = (MYFLT *) csound->Malloc(csound, 4 * irlength * sizeof(MYFLT));
+    xhatwin = logmag + irlength;
+    expxhatwin = xhatwin + irlength;
+    win = expxhatwin + irlength;
+
+    /* min phase win defined for irlength point impulse! */
+    win[0] = FL(1.0);
+    for(i = 1; i < (irlength / 2); i++)
+      win[i] = FL(2.0);
+    win[(irlength / 2)] = FL(1.0);
+    for(i = ((irlength / 2) + 1); i < irlength; i++)
+      win[i] = FL(0.0);
+
+    for (n = 0; n < HRTF_NDIRS * 2; n++) {
+      MYFLT *hrtfpad = h->minphase + (size_t) n * irlengthpad;
+      MYFLT magn;
+      mag = h->data + (size_t) n * irlength;
+
+      /* 0 Hz and Nyq...absoulute values for mag, do not allow log(0.0) */
+      magn = FABS(mag[0]);
+      logmag[0] = LOG((magn == FL(0.0) ? FL(0.00000001) : magn));
+      magn = FABS(mag[1]);
+      logmag[1] = LOG(magn == FL(0.0) ? FL(0.00000001) : magn);
+      /* log magnitudes, 0 phases for ifft */
+      for(i = 2; i < irlength; i += 2)
+        {
+          logmag[i] = LOG(mag[i] == FL(0.0) ? FL(0.00000001) : mag[i]);
+          logmag[i + 1] = FL(0.0);
+        }
+
+      /* ifft!...see Oppehneim and Schafer for min phase
+         process...based on real cepstrum method */
+      csound->InverseRealFFT(csound, logmag, irlength);
+
+      /* window, note no need to scale on csound iffts... */
+      for(i = 0; i < irlength; i++)
+        xhatwin[i] = logmag[i] * win[i];
+
+      /* fft */
+      csound->RealFFT(csound, xhatwin, irlength);
+
+      /* exponential of result */
+      /* 0 hz and nyq purely real... */
+      expxhatwin[0] = EXP(xhatwin[0]);
+      expxhatwin[1] = EXP(xhatwin[1]);
+
+      /* exponential of real, cos/sin of imag */
+      for(i = 2; i < irlength; i += 2)
+        {
+          expxhatwin[i] = EXP(xhatwin[i]) * COS(xhatwin[i + 1]);
+          expxhatwin[i+1] = EXP(xhatwin[i]) * SIN(xhatwin[i + 1]);
+        }
+
+      /* ifft for output buffers */
+      csound->InverseRealFFT(csound, expxhatwin, irlength);
+
+      /* zero pad impulse, back to freq domain */
+      for(i= 0; i < irlength; i++)
+        hrtfpad[i] = expxhatwin[i];
+      for(i = irlength; i < irlengthpad; i++)
+        hrtfpad[i] = FL(0.0);
+      csound->RealFFT(csound, hrtfpad, irlengthpad);
+    }
+    csound->Free(csound, logmag);
+}
+
 /* Csound hrtf magnitude interpolation, phase truncation object */
 
 /* aleft,aright hrtfmove asrc, kaz, kel, ifilel->data, ifiler [, imode = 0,
@@ -160,7 +358,7 @@ typedef struct
         /* check if relative source has changed! */
         MYFLT anglev, elevv;
 
-        float *fpbeginl,*fpbeginr;
+        HRTFDATA *hrtf;
 
         /* see definitions in INIT */
         int32_t irlength, irlengthpad, overlapsize;
@@ -202,15 +400,9 @@ typedef struct
         /* old overlap data for longer crossfades */
         AUXCH overlapoldl, overlapoldr;
 
-        /* interpolation buffers */
-        AUXCH lowl1, lowr1, lowl2, lowr2, highl1, highr1, highl2, highr2;
-        /* current phase buffers */
-        AUXCH currentphasel, currentphaser;
+        /* current phase: unit phasors in the shared data */
+        const MYFLT *currentphasel, *currentphaser;
 
-        /* min phase buffers */
-        AUXCH logmagl,logmagr,xhatwinl,xhatwinr,expxhatwinl,expxhatwinr;
-        /* min phase window: a static buffer */
-        AUXCH win;
         MYFLT delayfloat;
 
         /* delay */
@@ -221,17 +413,10 @@ hrtfmove;
 
 static int32_t hrtfmove_init(CSOUND *csound, hrtfmove *p)
 {
-    /* left and right data files: spectral mag, phase format. */
-    MEMFIL *fpl = NULL,*fpr = NULL;
-    int32_t i;
-    char filel[MAXNAME],filer[MAXNAME];
-
     int32_t mode = (int32_t)*p->omode;
     int32_t fade = (int32_t)*p->ofade;
     MYFLT sr = *p->osr;
 
-    MYFLT *win;
-
     /* time domain impulse length, padded, overlap add */
     int32_t irlength=0, irlengthpad=0, overlapsize=0;
 
@@ -276,24 +461,12 @@ static int32_t hrtfmove_init(CSOUND *csound, hrtfmove *p)
         overlapsize = (irlength - 1);
       }
 
-    /* copy in string name */
-    strNcpy(filel, (char*) p->ifilel->data, MAXNAME-1); //filel[MAXNAME-1]='\0';
-    strNcpy(filer, (char*) p->ifiler->data, MAXNAME-1); //filel[MAXNAME-1]='\0';
-
-    /* reading files, with byte swap */
-    fpl = csound->ldmemfile2withCB(csound, filel, CSFTYPE_FLOATS_BINARY,
-                                   swap4bytes);
-    if (UNLIKELY(fpl == NULL))
-      return
-        csound->InitError(csound,
-                          Str("\n\n\nCannot load left data file, exiting\n\n"));
-
-    fpr = csound->ldmemfile2withCB(csound, filer, CSFTYPE_FLOATS_BINARY,
-                                   swap4bytes);
-    if (UNLIKELY(fpr == NULL))
-      return
-        csound->InitError(csound,
-                          Str("\n\n\nCannot load right data file, exiting\n\n"));
+    /* shared data set, with the minimum phase spectra if needed */
+    if (UNLIKELY(hrtf_data(csound, &p->hrtf, p->ifilel, p->ifiler,
+                           irlength) != OK))
+      return NOTOK;
+    if (p->minphase)
+      hrtf_minphase(csound, p->hrtf);
 
     p->irlength = irlength;
     p->irlengthpad = irlengthpad;
@@ -302,10 +475,6 @@ static int32_t hrtfmove_init(CSOUND *csound, hrtfmove *p)
     /* the amount of buffers to fade over. */
     p->fadebuffer = (int32_t)fade*irlength;
 
-    /* file handles */
-    p->fpbeginl = (float *) fpl->beginp;
-    p->fpbeginr = (float *) fpr->beginp;
-
     /* common buffers (used by both min phase and phasetrunc) */
     if (!p->insig.auxp || p->insig.size < irlength * sizeof(MYFLT))
       csound->AuxAlloc(csound, irlength*sizeof(MYFLT), &p->insig);
@@ -345,38 +514,7 @@ static int32_t hrtfmove_init(CSOUND *csound, hrtfmove *p)
     memset(p->overlapl.auxp, 0, overlapsize * sizeof(MYFLT));
     memset(p->overlapr.auxp, 0, overlapsize * sizeof(MYFLT));
 
-    /* interpolation values */
-    if (!p->lowl1.auxp || p->lowl1.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->lowl1);
-    if (!p->lowr1.auxp || p->lowr1.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->lowr1);
-    if (!p->lowl2.auxp || p->lowl2.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->lowl2);
-    if (!p->lowr2.auxp || p->lowr2.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->lowr2);
-    if (!p->highl1.auxp || p->highl1.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->highl1);
-    if (!p->highr1.auxp || p->highr1.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->highr1);
-    if (!p->highl2.auxp || p->highl2.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->highl2);
-    if (!p->highr2.auxp || p->highr2.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->highr2);
-    if (!p->currentphasel.auxp || p->currentphasel.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength*sizeof(MYFLT), &p->currentphasel);
-    if (!p->currentphaser.auxp || p->currentphaser.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength*sizeof(MYFLT), &p->currentphaser);
-
-    memset(p->lowl1.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->lowr1.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->lowl2.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->lowr2.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->highl1.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->highl2.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->highr1.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->highr2.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->currentphasel.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->currentphaser.auxp, 0, irlength * sizeof(MYFLT));
+    p->currentphasel = p->currentphaser = NULL;
 
     /* phase truncation buffers and variables */
     if (!p->oldhrtflpad.auxp || p->oldhrtflpad.size < irlengthpad * sizeof(MYFLT))
@@ -416,27 +554,6 @@ static int32_t hrtfmove_init(CSOUND *csound, hrtfmove *p)
     p->oldelevindex = -1;
     p->oldangleindex = -1;
 
-    /* buffer declaration for min phase calculations */
-    if (!p->logmagl.auxp || p->logmagl.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength*sizeof(MYFLT), &p->logmagl);
-    if (!p->logmagr.auxp || p->logmagr.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength*sizeof(MYFLT), &p->logmagr);
-    if (!p->xhatwinl.auxp || p->xhatwinl.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength*sizeof(MYFLT), &p->xhatwinl);
-    if (!p->xhatwinr.auxp || p->xhatwinr.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength*sizeof(MYFLT), &p->xhatwinr);
-    if (!p->expxhatwinl.auxp || p->expxhatwinl.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength*sizeof(MYFLT), &p->expxhatwinl);
-    if (!p->expxhatwinr.auxp || p->expxhatwinr.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength*sizeof(MYFLT), &p->expxhatwinr);
-
-    memset(p->logmagl.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->logmagr.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->xhatwinl.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->xhatwinr.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->expxhatwinl.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->expxhatwinr.auxp, 0, irlength * sizeof(MYFLT));
-
     /* delay buffers */
     if (!p->delmeml.auxp ||
         p->delmeml.size < (int32_t)(sr * maxdeltime) * sizeof(MYFLT))
@@ -450,19 +567,6 @@ static int32_t hrtfmove_init(CSOUND *csound, hrtfmove *p)
     memset(p->delmeml.auxp, 0, (int32_t)(sr * maxdeltime) * sizeof(MYFLT));
     memset(p->delmemr.auxp, 0, (int32_t)(sr * maxdeltime) * sizeof(MYFLT));
 
-    if (!p->win.auxp || p->win.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength*sizeof(MYFLT), &p->win);
-
-    win = (MYFLT *)p->win.auxp;
-
-    /* min phase win defined for irlength point impulse! */
-    win[0] = FL(1.0);
-    for(i = 1; i < (irlength / 2); i++)
-      win[i] = FL(2.0);
-    win[(irlength / 2)] = FL(1.0);
-    for(i = ((irlength / 2) + 1); i < irlength; i++)
-      win[i] = FL(0.0);
-
     p->mdtl = (int32_t)(FL(0.00095) * sr);
     p->mdtr = (int32_t)(FL(0.00095) * sr);
     p->delayfloat = FL(0.0);
@@ -508,11 +612,10 @@ static int32_t hrtfmove_process(CSOUND *csound, hrtfmove *p)
 
     int32_t counter = p->counter;
 
-    /* pointers into HRTF files: floating point data (even in 64 bit csound) */
-    float *fpindexl;
-    float *fpindexr;
+    /* shared data set */
+    const HRTFDATA *hrtf = p->hrtf;
 
-    int32_t i,elevindex, angleindex, skip = 0;
+    int32_t i,elevindex, angleindex;
 
     int32_t minphase = p->minphase;
     int32_t phasetrunc = p->phasetrunc;
@@ -528,23 +631,18 @@ static int32_t hrtfmove_process(CSOUND *csound, hrtfmove *p)
     MYFLT angleindexlowstore;
     MYFLT angleindexhighstore;
 
-    /* interpolation values */
-    MYFLT *lowl1 = (MYFLT *)p->lowl1.auxp;
-    MYFLT *lowr1 = (MYFLT *)p->lowr1.auxp;
-    MYFLT *lowl2 = (MYFLT *)p->lowl2.auxp;
-    MYFLT *lowr2 = (MYFLT *)p->lowr2.auxp;
-    MYFLT *highl1 = (MYFLT *)p->highl1.auxp;
-    MYFLT *highr1 = (MYFLT *)p->highr1.auxp;
-    MYFLT *highl2 = (MYFLT *)p->highl2.auxp;
-    MYFLT *highr2 = (MYFLT *)p->highr2.auxp;
-    MYFLT *currentphasel = (MYFLT *)p->currentphasel.auxp;
-    MYFLT *currentphaser = (MYFLT *)p->currentphaser.auxp;
+    /* interpolation values: measurements or minimum phase spectra of
+       the 4 nearest directions, in the shared data */
+    const MYFLT *lowl1, *lowr1, *lowl2, *lowr2;
+    const MYFLT *highl1, *highr1, *highl2, *highr2;
+    const MYFLT *currentphasel, *currentphaser;
+    int32_t swap;
 
     /* local interpolation values */
     MYFLT elevindexhighper, angleindex2per, angleindex4per;
     int32_t elevindexlow, elevindexhigh, angleindex1, angleindex2,
       angleindex3, angleindex4;
-    MYFLT magl,magr,phasel,phaser, magllow, magrlow, maglhigh, magrhigh;
+    MYFLT magl,magr, magllow, magrlow, maglhigh, magrhigh;
 
     /* phase truncation buffers and variables */
     MYFLT *oldhrtflpad = (MYFLT *)p->oldhrtflpad.auxp;
@@ -569,17 +667,6 @@ static int32_t hrtfmove_process(CSOUND *csound, hrtfmove *p)
     int32_t fade = p->fade;
     int32_t fadebuffer = p->fadebuffer;
 
-    /* minimum phase buffers */
-    MYFLT *logmagl = (MYFLT *)p->logmagl.auxp;
-    MYFLT *logmagr = (MYFLT *)p->logmagr.auxp;
-    MYFLT *xhatwinl = (MYFLT *)p->xhatwinl.auxp;
-    MYFLT *xhatwinr = (MYFLT *)p->xhatwinr.auxp;
-    MYFLT *expxhatwinl = (MYFLT *)p->expxhatwinl.auxp;
-    MYFLT *expxhatwinr = (MYFLT *)p->expxhatwinr.auxp;
-
-    /* min phase window */
-    MYFLT *win = (MYFLT *)p->win.auxp;
-
     /* min phase delay variables */
     MYFLT *delmeml = (MYFLT *)p->delmeml.auxp;
     MYFLT *delmemr = (MYFLT *)p->delmemr.auxp;
@@ -595,10 +682,6 @@ static int32_t hrtfmove_process(CSOUND *csound, hrtfmove *p)
     uint32_t j, nsmps = CS_KSMPS;
     MYFLT outvdl, outvdr, vdtl, vdtr, fracl, fracr, rpl, rpr;
 
-    /* start indices at correct value (start of file)/ zero indices. */
-    fpindexl = (float *) p->fpbeginl;
-    fpindexr = (float *) p->fpbeginr;
-
     if (UNLIKELY(offset)) {
       memset(outsigl, '\0', offset*sizeof(MYFLT));
       memset(outsigr, '\0', offset*sizeof(MYFLT));
@@ -719,319 +802,149 @@ static int32_t hrtfmove_process(CSOUND *csound, hrtfmove *p)
 
                         /* store point for current phase as trajectory comes
                            closer to a new index */
-                        skip = 0;
-                        /* store current phase */
-                        if(angleindex > elevationarray[elevindex] / 2)
-                          {
-                            for(i = 0; i < elevindex; i++)
-                              skip +=((int32_t)(elevationarray[i] / 2)+1)*irlength;
-                            for (i = 0;
-                                 i < (elevationarray[elevindex] - angleindex);
-                                 i++)
-                              skip += irlength;
-                            for(i = 0; i < irlength; i++)
-                              {
-                                currentphasel[i] = fpindexr[skip + i];
-                                currentphaser[i] = fpindexl[skip + i];
-                              }
-                          }
-                        else
-                          {
-                            for(i = 0; i < elevindex; i++)
-                              skip +=((int32_t)(elevationarray[i] / 2)+1)*irlength;
-                            for (i = 0; i < angleindex; i++)
-                              skip += irlength;
-                            for(i = 0; i < irlength; i++)
-                              {
-                                currentphasel[i] = fpindexl[skip+i];
-                                currentphaser[i] = fpindexr[skip+i];
-                              }
-                          }
+                        p->currentphasel = hrtf_ear(hrtf, hrtf->phasor, irlength,
+                                                    elevindex, angleindex, 0);
+                        p->currentphaser = hrtf_ear(hrtf, hrtf->phasor, irlength,
+                                                    elevindex, angleindex, 1);
                       }
                   }
                 /* for next check */
                 p->oldelevindex = elevindex;
                 p->oldangleindex = angleindex;
 
-                /* read 4 nearest HRTFs */
-                skip = 0;
-                /* switch l and r */
-                if(angleindex1 > elevationarray[elevindexlow] / 2)
-                  {
-                    for(i = 0; i < elevindexlow; i++)
-                      skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0;
-                         i < (elevationarray[elevindexlow] - angleindex1);
-                         i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        lowl1[i] = fpindexr[skip+i];
-                        lowr1[i] = fpindexl[skip+i];
-                      }
-                  }
-                else
-                  {
-                    for(i = 0; i < elevindexlow; i++)
-                      skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0; i < angleindex1; i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        lowl1[i] = fpindexl[skip+i];
-                        lowr1[i] = fpindexr[skip+i];
-                      }
-                  }
-
-                skip = 0;
-                if(angleindex2 > elevationarray[elevindexlow] / 2)
-                  {
-                    for(i = 0; i < elevindexlow; i++)
-                      skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0;
-                         i < (elevationarray[elevindexlow] - angleindex2);
-                         i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        lowl2[i] = fpindexr[skip+i];
-                        lowr2[i] = fpindexl[skip+i];
-                      }
-                  }
-                else
-                  {
-                    for(i = 0; i < elevindexlow; i++)
-                      skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0; i < angleindex2; i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        lowl2[i] = fpindexl[skip+i];
-                        lowr2[i] = fpindexr[skip+i];
-                      }
-                  }
-
-                skip = 0;
-                if(angleindex3 > elevationarray[elevindexhigh] / 2)
-                  {
-                    for(i = 0; i < elevindexhigh; i++)
-                      skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0;
-                         i < (elevationarray[elevindexhigh] - angleindex3);
-                         i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        highl1[i] = fpindexr[skip+i];
-                        highr1[i] = fpindexl[skip+i];
-                      }
-                  }
-                else
+                if(minphase)
                   {
-                    for(i = 0; i < elevindexhigh; i++)
-                      skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0; i < angleindex3; i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        highl1[i] = fpindexl[skip+i];
-                        highr1[i] = fpindexr[skip+i];
-                      }
-                  }
+                    /* the minimum phase spectra of the 4 nearest
+                       directions are interpolated directly: as linear
+                       interpolation of the minimum phase impulses */
+                    lowl1 = hrtf_ear(hrtf, hrtf->minphase, irlengthpad,
+                                     elevindexlow, angleindex1, 0);
+                    lowr1 = hrtf_ear(hrtf, hrtf->minphase, irlengthpad,
+                                     elevindexlow, angleindex1, 1);
+                    lowl2 = hrtf_ear(hrtf, hrtf->minphase, irlengthpad,
+                                     elevindexlow, angleindex2, 0);
+                    lowr2 = hrtf_ear(hrtf, hrtf->minphase, irlengthpad,
+                                     elevindexlow, angleindex2, 1);
+                    highl1 = hrtf_ear(hrtf, hrtf->minphase, irlengthpad,
+                                      elevindexhigh, angleindex3, 0);
+                    highr1 = hrtf_ear(hrtf, hrtf->minphase, irlengthpad,
+                                      elevindexhigh, angleindex3, 1);
+                    highl2 = hrtf_ear(hrtf, hrtf->minphase, irlengthpad,
+                                      elevindexhigh, angleindex4, 0);
+                    highr2 = hrtf_ear(hrtf, hrtf->minphase, irlengthpad,
+                                      elevindexhigh, angleindex4, 1);
 
-                skip = 0;
-                if(angleindex4 > elevationarray[elevindexhigh] / 2)
-                  {
-                    for(i = 0; i < elevindexhigh; i++)
-                      skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0;
-                         i < (elevationarray[elevindexhigh] - angleindex4);
-                         i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        highl2[i] = fpindexr[skip+i];
-                        highr2[i] = fpindexl[skip+i];
-                      }
-                  }
-                else
-                  {
-                    for(i = 0; i < elevindexhigh; i++)
-                      skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0; i < angleindex4; i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
+                    for(i = 0; i < irlengthpad; i++)
                       {
-                        highl2[i] = fpindexl[skip+i];
-                        highr2[i] = fpindexr[skip+i];
+                        magllow = lowl1[i] + (lowl2[i] - lowl1[i]) * angleindex2per;
+                        maglhigh = highl1[i] + (highl2[i] - highl1[i]) *
+                          angleindex4per;
+                        hrtflpad[i] = magllow + (maglhigh - magllow) *
+                          elevindexhighper;
+
+                        magrlow = lowr1[i] + (lowr2[i] - lowr1[i]) * angleindex2per;
+                        magrhigh = highr1[i] + (highr2[i] - highr1[i]) *
+                          angleindex4per;
+                        hrtfrpad[i] = magrlow + (magrhigh - magrlow) *
+                          elevindexhighper;
                       }
-                  }
-
-                /* interpolation */
-                /* 0 Hz and Nyq...absoulute values for mag */
-                magllow = FABS(lowl1[0]) + (FABS(lowl2[0]) - FABS(lowl1[0])) *
-                  angleindex2per;
-                maglhigh = FABS(highl1[0]) + (FABS(highl2[0]) - FABS(highl1[0]))
-                  * angleindex4per;
-                magl = magllow + (maglhigh - magllow) * elevindexhighper;
-                if(minphase)
-                  {
-                    logmagl[0] = LOG((magl == FL(0.0) ? FL(0.00000001) : magl));
-                  }
-                /* this is where real values of 0hz and nyq needed:
-                   if neg real, 180 degree phase */
-                /* if data was complex, mag interp would use fabs()
-                   inherently, phase would be 0/pi */
-                /* if pi, real is negative! */
-                else
-                  {
-                    if(currentphasel[0] < FL(0.0))
-                      hrtflfloat[0] = -magl;
-                    else
-                      hrtflfloat[0] = magl;
-                  }
 
-                magllow = FABS(lowl1[1]) + (FABS(lowl2[1]) - FABS(lowl1[1])) *
-                  angleindex2per;
-                maglhigh = FABS(highl1[1]) + (FABS(highl2[1]) - FABS(highl1[1])) *
-                  angleindex4per;
-                magl = magllow + (maglhigh-magllow) * elevindexhighper;
-                if(minphase)
-                  {
-                    logmagl[1] = LOG(magl == FL(0.0) ? FL(0.00000001) : magl);
-                  }
-                else
-
-                  {
-                    if(currentphasel[1] < FL(0.0))
-                      hrtflfloat[1] = -magl;
-                    else
-                      hrtflfloat[1] = magl;
-                  }
-
-                magrlow = FABS(lowr1[0]) + (FABS(lowr2[0]) - FABS(lowr1[0])) *
-                  angleindex2per;
-                magrhigh = FABS(highr1[0]) + (FABS(highr2[0]) - FABS(highr1[0])) *
-                  angleindex4per;
-                magr = magrlow + (magrhigh - magrlow) * elevindexhighper;
-                if(minphase)
-                  {
-                    logmagr[0] = LOG(magr == FL(0.0) ? FL(0.00000001) : magr);
-                  }
-                else
-                  {
-                    if(currentphaser[0] < FL(0.0))
-                      hrtfrfloat[0] = -magr;
-                    else
-                      hrtfrfloat[0] = magr;
-                  }
+                    /* delay interp, 4 nearest points */
+                    delaylow1 = minphasedels[hrtf_dir(hrtf, elevindexlow,
+                                                      angleindex1, &swap)];
+                    delaylow2 = minphasedels[hrtf_dir(hrtf, elevindexlow,
+                                                      angleindex2, &swap)];
+                    delayhigh1 = minphasedels[hrtf_dir(hrtf, elevindexhigh,
+                                                       angleindex3, &swap)];
+                    delayhigh2 = minphasedels[hrtf_dir(hrtf, elevindexhigh,
+                                                       angleindex4, &swap)];
+                    delaylow = delaylow1 + ((delaylow2 - delaylow1) *
+                                            angleindex2per);
+                    delayhigh = delayhigh1 + ((delayhigh2 - delayhigh1) *
+                                              angleindex4per);
+                    delayfloat = delaylow + ((delayhigh - delaylow) *
+                                             elevindexhighper);
 
-                magrlow = FABS(lowr1[1]) + (FABS(lowr2[1]) - FABS(lowr1[1]))  *
-                  angleindex2per;
-                magrhigh = FABS(highr1[1]) + (FABS(highr2[1]) - FABS(highr1[1])) *
-                  angleindex4per;
-                magr = magrlow + (magrhigh - magrlow) * elevindexhighper;
-                if(minphase)
-                  {
-                    logmagr[1] = LOG(magr == FL(0.0) ? FL(0.00000001) : magr);
+                    p->delayfloat = delayfloat;
                   }
                 else
                   {
-                    if(currentphaser[1] < FL(0.0))
-                      hrtfrfloat[1] = -magr;
-                    else
-                      hrtfrfloat[1] = magr;
-                  }
-
-                /* remaining values */
-                for(i = 2; i < irlength; i += 2)
-                  {
-                    /* interpolate high and low mags */
-                    magllow = lowl1[i] + (lowl2[i] - lowl1[i]) * angleindex2per;
-                    maglhigh = highl1[i] + (highl2[i] - highl1[i]) * angleindex4per;
-
-                    magrlow = lowr1[i] + (lowr2[i] - lowr1[i]) * angleindex2per;
-                    magrhigh = highr1[i] + (highr2[i] - highr1[i]) * angleindex4per;
-
-                    /* interpolate high and low results */
+                    /* 4 nearest HRTFs */
+                    lowl1 = hrtf_ear(hrtf, hrtf->data, irlength,
+                                     elevindexlow, angleindex1, 0);
+                    lowr1 = hrtf_ear(hrtf, hrtf->data, irlength,
+                                     elevindexlow, angleindex1, 1);
+                    lowl2 = hrtf_ear(hrtf, hrtf->data, irlength,
+                                     elevindexlow, angleindex2, 0);
+                    lowr2 = hrtf_ear(hrtf, hrtf->data, irlength,
+                                     elevindexlow, angleindex2, 1);
+                    highl1 = hrtf_ear(hrtf, hrtf->data, irlength,
+                                      elevindexhigh, angleindex3, 0);
+                    highr1 = hrtf_ear(hrtf, hrtf->data, irlength,
+                                      elevindexhigh, angleindex3, 1);
+                    highl2 = hrtf_ear(hrtf, hrtf->data, irlength,
+                                      elevindexhigh, angleindex4, 0);
+                    highr2 = hrtf_ear(hrtf, hrtf->data, irlength,
+                                      elevindexhigh, angleindex4, 1);
+                    currentphasel = p->currentphasel;
+                    currentphaser = p->currentphaser;
+
+                    /* interpolation */
+                    /* 0 Hz and Nyq...absoulute values for mag */
+                    /* this is where real values of 0hz and nyq needed:
+                       if neg real, 180 degree phase */
+                    magllow = FABS(lowl1[0]) + (FABS(lowl2[0]) - FABS(lowl1[0])) *
+                      angleindex2per;
+                    maglhigh = FABS(highl1[0]) + (FABS(highl2[0]) -
+                                                  FABS(highl1[0])) * angleindex4per;
                     magl = magllow + (maglhigh - magllow) * elevindexhighper;
+                    hrtflfloat[0] = magl * currentphasel[0];
+
+                    magllow = FABS(lowl1[1]) + (FABS(lowl2[1]) - FABS(lowl1[1])) *
+                      angleindex2per;
+                    maglhigh = FABS(highl1[1]) + (FABS(highl2[1]) -
+                                                  FABS(highl1[1])) * angleindex4per;
+                    magl = magllow + (maglhigh-magllow) * elevindexhighper;
+                    hrtflfloat[1] = magl * currentphasel[1];
+
+                    magrlow = FABS(lowr1[0]) + (FABS(lowr2[0]) - FABS(lowr1[0])) *
+                      angleindex2per;
+                    magrhigh = FABS(highr1[0]) + (FABS(highr2[0]) -
+                                                  FABS(highr1[0])) * angleindex4per;
                     magr = magrlow + (magrhigh - magrlow) * elevindexhighper;
+                    hrtfrfloat[0] = magr * currentphaser[0];
 
-                    if(phasetrunc)
-                      {
-                        /* use current phase, back to rectangular */
-                        phasel = currentphasel[i + 1];
-                        phaser = currentphaser[i + 1];
-
-                        /* polar to rectangular */
-                        hrtflfloat[i] = magl * COS(phasel);
-                        hrtflfloat[i+1] = magl * SIN(phasel);
-
-                        hrtfrfloat[i] = magr * COS(phaser);
-                        hrtfrfloat[i+1] = magr * SIN(phaser);
-                      }
+                    magrlow = FABS(lowr1[1]) + (FABS(lowr2[1]) - FABS(lowr1[1])) *
+                      angleindex2per;
+                    magrhigh = FABS(highr1[1]) + (FABS(highr2[1]) -
+                                                  FABS(highr1[1])) * angleindex4per;
+                    magr = magrlow + (magrhigh - magrlow) * elevindexhighper;
+                    hrtfrfloat[1] = magr * currentphaser[1];
 
-                    if(minphase)
+                    /* remaining values */
+                    for(i = 2; i < irlength; i += 2)
                       {
-                        /* store log magnitudes, 0 phases for ifft, do not
-                           allow log(0.0) */
-                        logmagl[i] = LOG(magl == FL(0.0) ? FL(0.00000001) : magl);
-                        logmagr[i] = LOG(magr == FL(0.0) ? FL(0.00000001) : magr);
+                        /* interpolate high and low mags */
+                        magllow = lowl1[i] + (lowl2[i] - lowl1[i]) * angleindex2per;
+                        maglhigh = highl1[i] + (highl2[i] - highl1[i]) *
+                          angleindex4per;
 
-                        logmagl[i + 1] = FL(0.0);
-                        logmagr[i + 1] = FL(0.0);
-                      }
-                  }
+                        magrlow = lowr1[i] + (lowr2[i] - lowr1[i]) * angleindex2per;
+                        magrhigh = highr1[i] + (highr2[i] - highr1[i]) *
+                          angleindex4per;
 
-                if(minphase)
-                  {
-                    /* ifft!...see Oppehneim and Schafer for min phase
-                       process...based on real cepstrum method */
-                    csound->InverseRealFFT(csound, logmagl, irlength);
-                    csound->InverseRealFFT(csound, logmagr, irlength);
+                        /* interpolate high and low results */
+                        magl = magllow + (maglhigh - magllow) * elevindexhighper;
+                        magr = magrlow + (magrhigh - magrlow) * elevindexhighper;
 
-                    /* window, note no need to scale on csound iffts... */
-                    for(i = 0; i < irlength; i++)
-                      {
-                        xhatwinl[i] = logmagl[i] * win[i];
-                        xhatwinr[i] = logmagr[i] * win[i];
-                      }
-
-                    /* fft */
-                    csound->RealFFT(csound, xhatwinl, irlength);
-                    csound->RealFFT(csound, xhatwinr, irlength);
-
-                    /* exponential of result */
-                    /* 0 hz and nyq purely real... */
-                    expxhatwinl[0] = EXP(xhatwinl[0]);
-                    expxhatwinl[1] = EXP(xhatwinl[1]);
-                    expxhatwinr[0] = EXP(xhatwinr[0]);
-                    expxhatwinr[1] = EXP(xhatwinr[1]);
+                        /* use current phase, back to rectangular */
+                        hrtflfloat[i] = magl * currentphasel[i];
+                        hrtflfloat[i+1] = magl * currentphasel[i + 1];
 
-                    /* exponential of real, cos/sin of imag */
-                    for(i = 2; i < irlength; i += 2)
-                      {
-                        expxhatwinl[i] = EXP(xhatwinl[i]) * COS(xhatwinl[i + 1]);
-                        expxhatwinl[i+1] = EXP(xhatwinl[i]) * SIN(xhatwinl[i + 1]);
-                        expxhatwinr[i] = EXP(xhatwinr[i]) * COS(xhatwinr[i + 1]);
-                        expxhatwinr[i+1] = EXP(xhatwinr[i]) * SIN(xhatwinr[i + 1]);
+                        hrtfrfloat[i] = magr * currentphaser[i];
+                        hrtfrfloat[i+1] = magr * currentphaser[i + 1];
                       }
 
-                    /* ifft for output buffers */
-                    csound->InverseRealFFT(csound, expxhatwinl, irlength);
-                    csound->InverseRealFFT(csound, expxhatwinr, irlength);
-
-                    /* output */
-                    for(i= 0; i < irlength; i++)
-                      {
-                        hrtflpad[i] = expxhatwinl[i];
-                        hrtfrpad[i] = expxhatwinr[i];
-                      }
-                  }
-
-                /* use current phase and interped mag directly */
-                if(phasetrunc)
-                  {
                     /* ifft */
                     csound->InverseRealFFT(csound, hrtflfloat, irlength);
                     csound->InverseRealFFT(csound, hrtfrfloat, irlength);
@@ -1042,115 +955,17 @@ static int32_t hrtfmove_process(CSOUND *csound, hrtfmove *p)
                         hrtflpad[i] = hrtflfloat[i];
                         hrtfrpad[i] = hrtfrfloat[i];
                       }
-                  }
-
-                /* zero pad impulse */
-                for(i = irlength; i < irlengthpad; i++)
-                  {
-                    hrtflpad[i] = FL(0.0);
-                    hrtfrpad[i] = FL(0.0);
-                  }
-
-                /* back to freq domain */
-                csound->RealFFT(csound, hrtflpad, irlengthpad);
-                csound->RealFFT(csound, hrtfrpad, irlengthpad);
-
-                if(minphase)
-                  {
-                    /* read delay data: 4 nearest points, as above */
-                    /* point 1 */
-                    skip = 0;
-                    if(angleindex1 > elevationarray[elevindexlow] / 2)
-                      {
-                        for (i = 0; i < elevindexlow; i++)
-                          skip += ((int32_t)(elevationarray[i] / 2) + 1);
-                        for(i = 0;
-                            i < (elevationarray[elevindexlow] - angleindex1);
-                            i++)
-                          skip++;
-                        delaylow1 = minphasedels[skip];
-                      }
-                    else
-                      {
-                        for (i = 0; i < elevindexlow; i++)
-                          skip += ((int32_t)(elevationarray[i] / 2) + 1);
-                        for(i = 0; i < angleindex1; i++)
-                          skip++;
-                        delaylow1 = minphasedels[skip];
-                      }
-
-                    /* point 2 */
-                    skip = 0;
-                    if(angleindex2 > elevationarray[elevindexlow] / 2)
-                      {
-                        for (i = 0; i < elevindexlow; i++)
-                          skip += ((int32_t)(elevationarray[i] / 2) + 1);
-                        for(i = 0;
-                            i < (elevationarray[elevindexlow] - angleindex2);
-                            i++)
-                          skip++;
-                        delaylow2 = minphasedels[skip];
-                      }
-                    else
-                      {
-                        for (i = 0; i < elevindexlow; i++)
-                          skip += ((int32_t)(elevationarray[i] / 2) + 1);
-                        for (i = 0; i < angleindex2; i++)
-                          skip++;
-                        delaylow2 = minphasedels[skip];
-                      }
-
-                    /* point 3 */
-                    skip = 0;
-                    if(angleindex3 > elevationarray[elevindexhigh] / 2)
-                      {
-                        for (i = 0; i < elevindexhigh; i++)
-                          skip += ((int32_t)(elevationarray[i] / 2) + 1);
-                        for(i = 0;
-                            i < (elevationarray[elevindexhigh] - angleindex3);
-                            i++)
-                          skip++;
-                        delayhigh1  =minphasedels[skip];
-                      }
-                    else
-                      {
-                        for (i = 0; i < elevindexhigh; i++)
-                          skip += ((int32_t)(elevationarray[i] / 2) + 1);
-                        for (i = 0; i < angleindex3; i++)
-                          skip++;
-                        delayhigh1 = minphasedels[skip];
-                      }
 
-                    /* point 4 */
-                    skip = 0;
-                    if(angleindex4 > elevationarray[elevindexhigh] / 2)
-                      {
-                        for (i = 0; i < elevindexhigh; i++)
-                          skip += ((int32_t)(elevationarray[i] / 2) + 1);
-                        for(i = 0;
-                            i < (elevationarray[elevindexhigh] - angleindex4);
-                            i++)
-                          skip++;
-                        delayhigh2 = minphasedels[skip];
-                      }
-                    else
+                    /* zero pad impulse */
+                    for(i = irlength; i < irlengthpad; i++)
                       {
-                        for (i = 0; i < elevindexhigh; i++)
-                          skip += ((int32_t)(elevationarray[i] / 2) + 1);
-                        for (i = 0; i < angleindex4; i++)
-                          skip++;
-                        delayhigh2 = minphasedels[skip];
+                        hrtflpad[i] = FL(0.0);
+                        hrtfrpad[i] = FL(0.0);
                       }
 
-                    /* delay interp */
-                    delaylow = delaylow1 + ((delaylow2 - delaylow1) *
-                                            angleindex2per);
-                    delayhigh = delayhigh1 + ((delayhigh2 - delayhigh1) *
-                                              angleindex4per);
-                    delayfloat = delaylow + ((delayhigh - delaylow) *
-                                             elevindexhighper);
-
-                    p->delayfloat = delayfloat;
+                    /* back to freq domain */
+                    csound->RealFFT(csound, hrtflpad, irlengthpad);
+                    csound->RealFFT(csound, hrtfrpad, irlengthpad);
                   }
                 /* end of angle/elev change process */
                 p->elevv = elev;
@@ -1376,9 +1191,6 @@ typedef struct
         /* overlap data */
         AUXCH overlapl, overlapr;
 
-        /* interpolation buffers */
-        AUXCH lowl1, lowr1, lowl2, lowr2, highl1, highr1, highl2, highr2;
-
         /* buffers for impulse shift */
         AUXCH leftshiftbuffer, rightshiftbuffer;
 }
@@ -1386,19 +1198,12 @@ hrtfstat;
 
 static int32_t hrtfstat_init(CSOUND *csound, hrtfstat *p)
 {
-    /* left and right data files: spectral mag, phase format. */
-    MEMFIL *fpl = NULL, *fpr = NULL;
-    char filel[MAXNAME], filer[MAXNAME];
+    /* shared data set */
+    HRTFDATA *hrtf;
 
     /* interpolation values */
-    MYFLT *lowl1;
-    MYFLT *lowr1;
-    MYFLT *lowl2;
-    MYFLT *lowr2;
-    MYFLT *highl1;
-    MYFLT *highr1;
-    MYFLT *highl2;
-    MYFLT *highr2;
+    const MYFLT *lowl1, *lowr1, *lowl2, *lowr2;
+    const MYFLT *highl1, *highr1, *highl2, *highr2;
 
     MYFLT *hrtflfloat;
     MYFLT *hrtfrfloat;
@@ -1411,14 +1216,10 @@ static int32_t hrtfstat_init(CSOUND *csound, hrtfstat *p)
     MYFLT r = *p->oradius;
     MYFLT sr = *p->osr;
 
-        /* pointers into HRTF files */
-    float *fpindexl=NULL;
-    float *fpindexr=NULL;
-
     /* time domain impulse length, padded, overlap add */
     int32_t irlength=0, irlengthpad=0, overlapsize=0;
 
-    int32_t i, skip = 0;
+    int32_t i;
 
     /* local interpolation values */
     MYFLT elevindexhighper, angleindex2per, angleindex4per;
@@ -1463,24 +1264,10 @@ static int32_t hrtfstat_init(CSOUND *csound, hrtfstat *p)
         overlapsize = (irlength - 1);
       }
 
-    /* copy in string name... */
-    strNcpy(filel, (char*) p->ifilel->data, MAXNAME-1); //filel[MAXNAME-1]='\0';
-    strNcpy(filer, (char*) p->ifiler->data, MAXNAME-1); //filel[MAXNAME-1]='\0';
-
-    /* reading files, with byte swap */
-    fpl = csound->ldmemfile2withCB(csound, filel, CSFTYPE_FLOATS_BINARY,
-                                   swap4bytes);
-    if (UNLIKELY(fpl == NULL))
-      return
-        csound->InitError(csound,
-                          Str("\n\n\nCannot load left data file, exiting\n\n"));
-
-    fpr = csound->ldmemfile2withCB(csound, filer, CSFTYPE_FLOATS_BINARY,
-                                   swap4bytes);
-    if (UNLIKELY(fpr == NULL))
-      return
-        csound->InitError(csound,
-                          Str("\n\n\nCannot load right data file, exiting\n\n"));
+    /* shared data set */
+    if (UNLIKELY(hrtf_data(csound, &hrtf, p->ifilel, p->ifiler,
+                           irlength) != OK))
+      return NOTOK;
 
     p->irlength = irlength;
     p->irlengthpad = irlengthpad;
@@ -1488,11 +1275,6 @@ static int32_t hrtfstat_init(CSOUND *csound, hrtfstat *p)
 
     p->sroverN = sr/irlength;
 
-    /* start indices at correct value (start of file)/ zero indices.
-       (do not need to store here, as only accessing in INIT) */
-    fpindexl = (float *) fpl->beginp;
-    fpindexr = (float *) fpr->beginp;
-
     /* buffers */
     if (!p->insig.auxp || p->insig.size < irlength * sizeof(MYFLT))
       csound->AuxAlloc(csound, irlength*sizeof(MYFLT), &p->insig);
@@ -1532,34 +1314,6 @@ static int32_t hrtfstat_init(CSOUND *csound, hrtfstat *p)
     memset(p->overlapl.auxp, 0, overlapsize * sizeof(MYFLT));
     memset(p->overlapr.auxp, 0, overlapsize * sizeof(MYFLT));
 
-    /* interpolation values */
-    if (!p->lowl1.auxp || p->lowl1.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->lowl1);
-    if (!p->lowr1.auxp || p->lowr1.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->lowr1);
-    if (!p->lowl2.auxp || p->lowl2.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->lowl2);
-    if (!p->lowr2.auxp || p->lowr2.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->lowr2);
-    if (!p->highl1.auxp || p->highl1.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->highl1);
-    if (!p->highr1.auxp || p->highr1.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->highr1);
-    if (!p->highl2.auxp || p->highl2.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->highl2);
-    if (!p->highr2.auxp || p->highr2.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->highr2);
-
-    /* best to zero, for future changes (filled in init) */
-    memset(p->lowl1.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->lowr1.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->lowl2.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->lowr2.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->highl1.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->highl2.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->highr1.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->highr2.auxp, 0, irlength * sizeof(MYFLT));
-
     /* shift buffers */
     if (!p->leftshiftbuffer.auxp ||
         p->leftshiftbuffer.size < irlength * sizeof(MYFLT))
@@ -1571,15 +1325,6 @@ static int32_t hrtfstat_init(CSOUND *csound, hrtfstat *p)
     memset(p->leftshiftbuffer.auxp, 0, irlength * sizeof(MYFLT));
     memset(p->rightshiftbuffer.auxp, 0, irlength * sizeof(MYFLT));
 
-    lowl1 = (MYFLT *)p->lowl1.auxp;
-    lowr1 = (MYFLT *)p->lowr1.auxp;
-    lowl2 = (MYFLT *)p->lowl2.auxp;
-    lowr2 = (MYFLT *)p->lowr2.auxp;
-    highl1 = (MYFLT *)p->highl1.auxp;
-    highr1 = (MYFLT *)p->highr1.auxp;
-    highl2 = (MYFLT *)p->highl2.auxp;
-    highr2 = (MYFLT *)p->highr2.auxp;
-
     leftshiftbuffer = (MYFLT *)p->leftshiftbuffer.auxp;
     rightshiftbuffer = (MYFLT *)p->rightshiftbuffer.auxp;
 
@@ -1634,111 +1379,23 @@ static int32_t hrtfstat_init(CSOUND *csound, hrtfstat *p)
     angleindex2per = angleindexlowstore - angleindex1;
     angleindex4per = angleindexhighstore - angleindex3;
 
-    /* read 4 nearest HRTFs */
-    skip = 0;
-    /* switch l and r */
-    if(angleindex1 > elevationarray[elevindexlow] / 2)
-      {
-        for(i = 0; i < elevindexlow; i++)
-          skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-        for (i = 0; i < (elevationarray[elevindexlow] - angleindex1); i++)
-          skip += irlength;
-        for(i = 0; i < irlength; i++)
-          {
-            lowl1[i] = fpindexr[skip + i];
-            lowr1[i] = fpindexl[skip + i];
-          }
-      }
-    else
-      {
-        for(i = 0; i < elevindexlow; i++)
-          skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-        for (i = 0; i < angleindex1; i++)
-          skip += irlength;
-        for(i = 0; i < irlength; i++)
-          {
-            lowl1[i] = fpindexl[skip + i];
-            lowr1[i] = fpindexr[skip + i];
-          }
-      }
-
-    skip = 0;
-    if(angleindex2 > elevationarray[elevindexlow] / 2)
-      {
-        for(i = 0; i < elevindexlow; i++)
-          skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-        for (i = 0; i < (elevationarray[elevindexlow] - angleindex2); i++)
-          skip += irlength;
-        for(i = 0; i < irlength; i++)
-          {
-            lowl2[i] = fpindexr[skip + i];
-            lowr2[i] = fpindexl[skip + i];
-          }
-      }
-    else
-      {
-        for(i = 0; i < elevindexlow; i++)
-          skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-        for (i = 0; i < angleindex2; i++)
-          skip += irlength;
-        for(i = 0; i < irlength; i++)
-          {
-            lowl2[i] = fpindexl[skip + i];
-            lowr2[i] = fpindexr[skip + i];
-          }
-      }
-
-    skip = 0;
-    if(angleindex3 > elevationarray[elevindexhigh] / 2)
-      {
-        for(i = 0; i < elevindexhigh; i++)
-          skip += ((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-        for (i = 0; i < (elevationarray[elevindexhigh] - angleindex3); i++)
-          skip += irlength;
-        for(i = 0; i < irlength; i++)
-          {
-            highl1[i] = fpindexr[skip + i];
-            highr1[i] = fpindexl[skip + i];
-          }
-      }
-    else
-      {
-        for(i = 0; i < elevindexhigh; i++)
-          skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-        for (i = 0; i < angleindex3; i++)
-          skip += irlength;
-        for(i = 0; i < irlength; i++)
-          {
-            highl1[i] = fpindexl[skip + i];
-            highr1[i] = fpindexr[skip + i];
-          }
-      }
-
-    skip = 0;
-    if(angleindex4 > elevationarray[elevindexhigh] / 2)
-      {
-        for(i = 0; i < elevindexhigh; i++)
-          skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-        for (i = 0; i < (elevationarray[elevindexhigh] - angleindex4); i++)
-          skip += irlength;
-        for(i = 0; i < irlength; i++)
-          {
-            highl2[i] = fpindexr[skip + i];
-            highr2[i] = fpindexl[skip + i];
-          }
-      }
-    else
-      {
-        for(i = 0; i < elevindexhigh; i++)
-          skip +=((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-        for (i = 0; i < angleindex4; i++)
-          skip += irlength;
-        for(i = 0; i < irlength; i++)
-          {
-            highl2[i] = fpindexl[skip + i];
-            highr2[i] = fpindexr[skip + i];
-          }
-      }
+    /* 4 nearest HRTFs */
+    lowl1 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexlow,
+                     angleindex1, 0);
+    lowr1 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexlow,
+                     angleindex1, 1);
+    lowl2 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexlow,
+                     angleindex2, 0);
+    lowr2 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexlow,
+                     angleindex2, 1);
+    highl1 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexhigh,
+                      angleindex3, 0);
+    highr1 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexhigh,
+                      angleindex3, 1);
+    highl2 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexhigh,
+                      angleindex4, 0);
+    highr2 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexhigh,
+                      angleindex4, 1);
 
     /* woodworth process */
     /* ITD formula, check which ear is relevant to calculate angle from */
@@ -2019,7 +1676,7 @@ MYFLT *ooverlap, *oradius, *osr;
 
         int32_t hopsize;
 
-        float *fpbeginl,*fpbeginr;
+        HRTFDATA *hrtf;
 
         /* to keep track of process */
         int32_t counter, t;
@@ -2036,9 +1693,6 @@ MYFLT *ooverlap, *oradius, *osr;
         /* spectral data */
         AUXCH outspecl, outspecr;
 
-        /* interpolation buffers */
-        AUXCH lowl1,lowr1,lowl2,lowr2,highl1,highr1,highl2,highr2;
-
         /* stft window */
         AUXCH win;
         /* used for skipping into next stft array on way in and out */
@@ -2049,11 +1703,6 @@ hrtfmove2;
 
 static int32_t hrtfmove2_init(CSOUND *csound, hrtfmove2 *p)
 {
-    /* left and right data files: spectral mag, phase format. */
-    MEMFIL *fpl = NULL, *fpr = NULL;
-
-    char filel[MAXNAME], filer[MAXNAME];
-
     /* time domain impulse length */
     int32_t irlength=0;
 
@@ -2085,32 +1734,14 @@ static int32_t hrtfmove2_init(CSOUND *csound, hrtfmove2 *p)
     else if(sr == 96000)
       irlength = 256;
 
-    /* copy in string name... */
-    strNcpy(filel, (char*) p->ifilel->data, MAXNAME-1); //filel[MAXNAME-1] = '\0';
-    strNcpy(filer, (char*) p->ifiler->data, MAXNAME-1); //filer[MAXNAME-1] = '\0';
-
-    /* reading files, with byte swap */
-    fpl = csound->ldmemfile2withCB(csound, filel, CSFTYPE_FLOATS_BINARY,
-                                   swap4bytes);
-    if (UNLIKELY(fpl == NULL))
-     return
-        csound->InitError(csound,
-                          Str("\n\n\nCannot load left data file, exiting\n\n"));
-
-    fpr = csound->ldmemfile2withCB(csound, filer, CSFTYPE_FLOATS_BINARY,
-                                   swap4bytes);
-    if (UNLIKELY(fpr == NULL))
-      return
-        csound->InitError(csound,
-                          Str("\n\n\nCannot load right data file, exiting\n\n"));
+    /* shared data set */
+    if (UNLIKELY(hrtf_data(csound, &p->hrtf, p->ifilel, p->ifiler,
+                           irlength) != OK))
+      return NOTOK;
 
     p->irlength = irlength;
     p->sroverN = sr / irlength;
 
-    /* file handles */
-    p->fpbeginl = (float *) fpl->beginp;
-    p->fpbeginr = (float *) fpr->beginp;
-
     if(overlap != 2 && overlap != 4 && overlap != 8 && overlap != 16)
       overlap = 4;
     p->overlap = overlap;
@@ -2149,33 +1780,6 @@ static int32_t hrtfmove2_init(CSOUND *csound, hrtfmove2 *p)
     memset(p->outspecl.auxp, 0, irlength * sizeof(MYFLT));
     memset(p->outspecr.auxp, 0, irlength * sizeof(MYFLT));
 
-    /* interpolation values */
-    if (!p->lowl1.auxp || p->lowl1.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->lowl1);
-    if (!p->lowr1.auxp || p->lowr1.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->lowr1);
-    if (!p->lowl2.auxp || p->lowl2.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->lowl2);
-    if (!p->lowr2.auxp || p->lowr2.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->lowr2);
-    if (!p->highl1.auxp || p->highl1.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->highl1);
-    if (!p->highr1.auxp || p->highr1.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->highr1);
-    if (!p->highl2.auxp || p->highl2.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->highl2);
-    if (!p->highr2.auxp || p->highr2.size < irlength * sizeof(MYFLT))
-      csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->highr2);
-
-    memset(p->lowl1.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->lowr1.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->lowl2.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->lowr2.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->highl1.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->highl2.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->highr1.auxp, 0, irlength * sizeof(MYFLT));
-    memset(p->highr2.auxp, 0, irlength * sizeof(MYFLT));
-
     if (!p->win.auxp || p->win.size < irlength * sizeof(MYFLT))
       csound->AuxAlloc(csound, irlength * sizeof(MYFLT), &p->win);
     if (!p->overlapskipin.auxp || p->overlapskipin.size < overlap * sizeof(int32_t))
@@ -2254,24 +1858,17 @@ static int32_t hrtfmove2_process(CSOUND *csound, hrtfmove2 *p)
     int32_t counter = p ->counter;
     int32_t t = p ->t;
 
-        /* pointers into HRTF files */
-    float *fpindexl;
-    float *fpindexr;
+    /* shared data set */
+    const HRTFDATA *hrtf = p->hrtf;
 
-    int32_t i, skip = 0;
+    int32_t i;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t j, nsmps = CS_KSMPS;
 
-    /* interpolation values */
-    MYFLT *lowl1 = (MYFLT *)p->lowl1.auxp;
-    MYFLT *lowr1 = (MYFLT *)p->lowr1.auxp;
-    MYFLT *lowl2 = (MYFLT *)p->lowl2.auxp;
-    MYFLT *lowr2 = (MYFLT *)p->lowr2.auxp;
-    MYFLT *highl1 = (MYFLT *)p->highl1.auxp;
-    MYFLT *highr1 = (MYFLT *)p->highr1.auxp;
-    MYFLT *highl2 = (MYFLT *)p->highl2.auxp;
-    MYFLT *highr2 = (MYFLT *)p->highr2.auxp;
+    /* interpolation values, in the shared data */
+    const MYFLT *lowl1, *lowr1, *lowl2, *lowr2;
+    const MYFLT *highl1, *highr1, *highl2, *highr2;
 
     /* local interpolation values */
     MYFLT elevindexhighper, angleindex2per, angleindex4per;
@@ -2290,10 +1887,6 @@ static int32_t hrtfmove2_process(CSOUND *csound, hrtfmove2 *p)
     MYFLT angleindexhighstore;
 
 
-    /* start indices at correct value (start of file)/ zero indices. */
-    fpindexl = (float *) p->fpbeginl;
-    fpindexr = (float *) p->fpbeginr;
-
     if (UNLIKELY(offset)) {
       memset(outsigl, '\0', offset*sizeof(MYFLT));
       memset(outsigr, '\0', offset*sizeof(MYFLT));
@@ -2366,119 +1959,23 @@ static int32_t hrtfmove2_process(CSOUND *csound, hrtfmove2 *p)
                 angleindex2per = angleindexlowstore - angleindex1;
                 angleindex4per = angleindexhighstore - angleindex3;
 
-                /* read 4 nearest HRTFs */
-                skip = 0;
-                /* switch l and r */
-                if(angleindex1 > elevationarray[elevindexlow] / 2)
-                  {
-                    for(i = 0; i < elevindexlow; i++)
-                      skip += ((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0;
-                         i < (elevationarray[elevindexlow] - angleindex1);
-                         i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        lowl1[i] = fpindexr[skip + i];
-                        lowr1[i] = fpindexl[skip + i];
-                      }
-                  }
-                else
-                  {
-                    for(i = 0; i < elevindexlow; i++)
-                      skip += ((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0; i < angleindex1; i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        lowl1[i] = fpindexl[skip + i];
-                        lowr1[i] = fpindexr[skip + i];
-                      }
-                  }
-
-                skip = 0;
-                if(angleindex2 > elevationarray[elevindexlow] / 2)
-                  {
-                    for(i = 0; i < elevindexlow; i++)
-                      skip += ((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0;
-                         i < (elevationarray[elevindexlow] - angleindex2);
-                         i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        lowl2[i] = fpindexr[skip + i];
-                        lowr2[i] = fpindexl[skip + i];
-                      }
-                  }
-                else
-                  {
-                    for(i = 0; i < elevindexlow; i++)
-                      skip += ((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0; i < angleindex2; i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        lowl2[i] = fpindexl[skip + i];
-                        lowr2[i] = fpindexr[skip + i];
-                      }
-                  }
-
-                skip = 0;
-                if(angleindex3 > elevationarray[elevindexhigh] / 2)
-                  {
-                    for(i = 0; i < elevindexhigh; i++)
-                      skip += ((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0;
-                         i < (elevationarray[elevindexhigh] - angleindex3);
-                         i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        highl1[i] = fpindexr[skip + i];
-                        highr1[i] = fpindexl[skip + i];
-                      }
-                  }
-                else
-                  {
-                    for(i = 0; i < elevindexhigh; i++)
-                      skip += ((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0; i < angleindex3; i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        highl1[i] = fpindexl[skip + i];
-                        highr1[i] = fpindexr[skip + i];
-                      }
-                  }
-
-                skip = 0;
-                if(angleindex4 > elevationarray[elevindexhigh] / 2)
-                  {
-                    for(i = 0; i < elevindexhigh; i++)
-                      skip += ((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0;
-                         i < (elevationarray[elevindexhigh] - angleindex4);
-                         i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        highl2[i] = fpindexr[skip + i];
-                        highr2[i] = fpindexl[skip + i];
-                      }
-                  }
-                else
-                  {
-                    for(i = 0; i < elevindexhigh; i++)
-                      skip += ((int32_t)(elevationarray[i] / 2) + 1) * irlength;
-                    for (i = 0; i < angleindex4; i++)
-                      skip += irlength;
-                    for(i = 0; i < irlength; i++)
-                      {
-                        highl2[i] = fpindexl[skip + i];
-                        highr2[i] = fpindexr[skip + i];
-                      }
-                  }
+                /* 4 nearest HRTFs */
+                lowl1 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexlow,
+                                 angleindex1, 0);
+                lowr1 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexlow,
+                                 angleindex1, 1);
+                lowl2 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexlow,
+                                 angleindex2, 0);
+                lowr2 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexlow,
+                                 angleindex2, 1);
+                highl1 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexhigh,
+                                  angleindex3, 0);
+                highr1 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexhigh,
+                                  angleindex3, 1);
+                highl2 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexhigh,
+                                  angleindex4, 0);
+                highr2 = hrtf_ear(hrtf, hrtf->data, irlength, elevindexhigh,
+                                  angleindex4, 1);
 
                 /* woodworth process */
                 /* ITD formula, check which ear is relevant to calculate
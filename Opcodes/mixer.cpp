@@ -21,7 +21,9 @@
     02110-1301 USA
 */
 #include "OpcodeBase.hpp"
+#include <atomic>
 #include <map>
+#include <memory>
 #include <vector>
 
 using namespace csound;
@@ -33,41 +35,162 @@ using namespace csound;
 //#define ENABLE_MIXER_KDEBUG
 
 /**
- * The mixer busses are laid out:
- * busses[csound][bus][channel][frame].
- * std::map<CSOUND *, std::map<size_t, std::vector< std::vector<MYFLT> > > >
- * *busses = 0;
+ * The mixer state of one Csound instance, stored in the global pointer
+ * "mixer". Everything is looked up and allocated at i-time; at k-time
+ * the opcodes only follow the pointers they cached in init.
  *
- * The mixer send matrix is laid out:
- * matrix[csound][send][bus].
- * std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT> > > *matrix = 0;
+ * Busses and gain tiles are kept in maps keyed by number, so a large
+ * buss or send number costs no more than a small one. Each MixerSend
+ * opcode owns one slot on its buss channel and writes only there, so
+ * senders running on different threads with -j never touch the same
+ * memory. The first MixerReceive of a buss in a k-period sums the
+ * slots of each channel, always in the order the senders were
+ * initialised, so the mix does not depend on the number of threads or
+ * on how instances were scheduled.
  */
+struct MixerSlot {
+  uint64_t kcycle; // k-period in which frames was last written
+  std::vector<MYFLT> frames;
+};
 
-/**
- * Creates the buss if it does not already exist.
- */
-static void createBuss(CSOUND *csound, size_t buss) {
-#ifdef ENABLE_MIXER_IDEBUG
-  csound->Message(csound, "createBuss: csound %p buss %d...\n", csound, buss);
-#endif
-  std::map<CSOUND *, std::map<size_t, std::vector<std::vector<MYFLT>>>>
-      *busses = 0;
-  csound::QueryGlobalPointer(csound, "busses", busses);
-  if ((*busses)[csound].find(buss) == (*busses)[csound].end()) {
-    size_t channels = csound->GetNchnls(csound);
-    size_t frames = csound->GetKsmps(csound);
-    (*busses)[csound][buss].resize(channels);
+struct MixerBuss {
+  // Senders of each channel, in order of initialisation.
+  std::vector<std::vector<MixerSlot *>> senders;
+  // The mix of each channel, valid for k-period mixed.
+  std::vector<std::vector<MYFLT>> mix;
+  uint64_t mixed;
+};
+
+class Mixer {
+public:
+  Mixer() : channels(0), frames(0) {}
+  ~Mixer() {
+    for (BussMap::iterator it = busses.begin(); it != busses.end(); ++it) {
+      for (size_t channel = 0; channel < channels; channel++) {
+        for (size_t j = 0; j < it->second->senders[channel].size(); j++) {
+          delete it->second->senders[channel][j];
+        }
+      }
+    }
+  }
+  /**
+   * Takes nchnls and ksmps from the orchestra before the first buss is
+   * created; the plugin is loaded before they are known.
+   */
+  void prepare(CSOUND *csound) {
+    if (busses.empty()) {
+      channels = csound->GetNchnls(csound);
+      frames = csound->GetKsmps(csound);
+    }
+  }
+  /**
+   * Returns the buss, creating it if it does not already exist.
+   */
+  MixerBuss *buss(size_t index) {
+    std::unique_ptr<MixerBuss> &buss = busses[index];
+    if (!buss) {
+      buss.reset(new MixerBuss);
+      buss->senders.resize(channels);
+      buss->mix.assign(channels, std::vector<MYFLT>(frames));
+      buss->mixed = 0;
+    }
+    return buss.get();
+  }
+  /**
+   * Returns the gain from send to buss. The gains are kept in fixed
+   * tiles, so the address does not change when more are added.
+   */
+  std::atomic<MYFLT> *gain(size_t send, size_t buss) {
+    std::unique_ptr<GainTile> &tile =
+        tiles[std::make_pair(send / TILE, buss / TILE)];
+    if (!tile) {
+      tile.reset(new GainTile);
+    }
+    return &tile->gains[send % TILE][buss % TILE];
+  }
+  MixerSlot *addSender(MixerBuss *buss, size_t channel) {
+    MixerSlot *slot = new MixerSlot;
+    slot->kcycle = 0;
+    slot->frames.resize(frames);
+    buss->senders[channel].push_back(slot);
+    return slot;
+  }
+  void removeSender(MixerBuss *buss, size_t channel, MixerSlot *slot) {
+    std::vector<MixerSlot *> &senders = buss->senders[channel];
+    for (size_t i = 0; i < senders.size(); i++) {
+      if (senders[i] == slot) {
+        senders.erase(senders.begin() + i);
+        break;
+      }
+    }
+    delete slot;
+  }
+  /**
+   * Sums the slots written in this k-period into the buss. Called by
+   * MixerReceive. MixerReceive and MixerClear are flagged _CW, and
+   * MixerSend _CR, which puts "##chn" in the write or read set of their
+   * instruments; the DAG then never runs an instrument that writes it
+   * alongside one that reads or writes it, so a receiver runs alone,
+   * after the senders in lower numbered instruments.
+   */
+  void reduce(MixerBuss *buss, uint64_t kcycle) {
     for (size_t channel = 0; channel < channels; channel++) {
-      (*busses)[csound][buss][channel].resize(frames);
+      MYFLT *mix = &buss->mix[channel].front();
+      const std::vector<MixerSlot *> &senders = buss->senders[channel];
+      std::fill(mix, mix + frames, MYFLT(0));
+      for (size_t i = 0; i < senders.size(); i++) {
+        if (senders[i]->kcycle == kcycle) {
+          const MYFLT *in = &senders[i]->frames.front();
+          for (size_t frame = 0; frame < frames; frame++) {
+            mix[frame] += in[frame];
+          }
+        }
+      }
     }
-#ifdef ENABLE_MIXER_IDEBUG
-    csound->Message(csound, "createBuss: created buss.\n");
-#endif
-  } else {
-#ifdef ENABLE_MIXER_IDEBUG
-    csound->Message(csound, "createBuss: buss already exists.\n");
-#endif
+    buss->mixed = kcycle;
   }
+  void clear(uint64_t kcycle) {
+    for (BussMap::iterator it = busses.begin(); it != busses.end(); ++it) {
+      for (size_t channel = 0; channel < channels; channel++) {
+        std::fill(it->second->mix[channel].begin(),
+                  it->second->mix[channel].end(), MYFLT(0));
+      }
+      it->second->mixed = kcycle;
+    }
+  }
+  size_t channels;
+  size_t frames;
+
+private:
+  enum { TILE = 16 };
+  struct GainTile {
+    std::atomic<MYFLT> gains[TILE][TILE];
+    GainTile() {
+      for (size_t i = 0; i < TILE; i++) {
+        for (size_t j = 0; j < TILE; j++) {
+          gains[i][j].store(MYFLT(0), std::memory_order_relaxed);
+        }
+      }
+    }
+  };
+  typedef std::map<size_t, std::unique_ptr<MixerBuss>> BussMap;
+  BussMap busses;
+  // Keyed by (send / TILE, buss / TILE).
+  std::map<std::pair<size_t, size_t>, std::unique_ptr<GainTile>> tiles;
+};
+
+static Mixer *getMixer(CSOUND *csound) {
+  Mixer *mixer = 0;
+  csound::QueryGlobalPointer(csound, "mixer", mixer);
+  mixer->prepare(csound);
+  return mixer;
+}
+
+/**
+ * The current k-period, counted from 1 so that 0 means never.
+ */
+static inline uint64_t mixerKcycle(CSOUND *csound) {
+  return csound->GetKcounter(csound) + 1;
 }
 
 /**
@@ -84,28 +207,31 @@ struct MixerSetLevel : public OpcodeBase<MixerSetLevel> {
   // State.
   size_t send;
   size_t buss;
-  std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT>>> *matrix;
+  std::atomic<MYFLT> *gain;
   int init(CSOUND *csound) {
 #ifdef ENABLE_MIXER_IDEBUG
     warn(csound, "MixerSetLevel::init...\n");
 #endif
-    csound::QueryGlobalPointer(csound, "matrix", matrix);
+    Mixer *mixer = getMixer(csound);
     send = static_cast<size_t>(*isend);
     buss = static_cast<size_t>(*ibuss);
-    createBuss(csound, buss);
-    (*matrix)[csound][send][buss] = *kgain;
+    mixer->buss(buss);
+    gain = mixer->gain(send, buss);
+    gain->store(*kgain, std::memory_order_relaxed);
 #ifdef ENABLE_MIXER_IDEBUG
     warn(csound, "MixerSetLevel::init: csound %p send %d buss %d gain %f\n",
-         csound, send, buss, (*matrix)[csound][send][buss]);
+         csound, send, buss, gain->load(std::memory_order_relaxed));
 #endif
     return OK;
   }
   int kontrol(CSOUND *csound) {
-    (*matrix)[csound][send][buss] = *kgain;
+    gain->store(*kgain, std::memory_order_relaxed);
 #ifdef ENABLE_MIXER_KDEBUG
     warn(csound, "MixerSetLevel::kontrol: csound %p send %d buss "
                  "%d gain %f\n",
-         csound, send, buss, (*matrix)[csound][send][buss]);
+         csound, send, buss, gain->load(std::memory_order_relaxed));
+#else
+    IGN(csound);
 #endif
     return OK;
   }
@@ -125,23 +251,26 @@ struct MixerGetLevel : public OpcodeBase<MixerGetLevel> {
   // State.
   size_t send;
   size_t buss;
-  std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT>>> *matrix;
+  std::atomic<MYFLT> *gain;
   int init(CSOUND *csound) {
 #ifdef ENABLE_MIXER_IDEBUG
     warn(csound, "MixerGetLevel::init...\n");
 #endif
-    csound::QueryGlobalPointer(csound, "matrix", matrix);
+    Mixer *mixer = getMixer(csound);
     send = static_cast<size_t>(*isend);
     buss = static_cast<size_t>(*ibuss);
-    createBuss(csound, buss);
+    mixer->buss(buss);
+    gain = mixer->gain(send, buss);
     return OK;
   }
   int noteoff(CSOUND *) { return OK; }
   int kontrol(CSOUND *csound) {
 #ifdef ENABLE_MIXER_KDEBUG
     warn(csound, "MixerGetLevel::kontrol...\n");
+#else
+    IGN(csound);
 #endif
-    *kgain = (*matrix)[csound][send][buss];
+    *kgain = gain->load(std::memory_order_relaxed);
     return OK;
   }
 };
@@ -151,7 +280,7 @@ struct MixerGetLevel : public OpcodeBase<MixerGetLevel> {
  * Routes a signal from a send to a channel of a mixer bus.
  * The gain of the send is controlled by the previously set mixer level.
  */
-struct MixerSend : public OpcodeBase<MixerSend> {
+struct MixerSend : public OpcodeNoteoffBase<MixerSend> {
   // No outputs.
   // Inputs.
   MYFLT *ainput;
@@ -163,21 +292,33 @@ struct MixerSend : public OpcodeBase<MixerSend> {
   size_t buss;
   size_t channel;
   size_t frames;
-  MYFLT *busspointer;
-  std::map<CSOUND *, std::map<size_t, std::vector<std::vector<MYFLT>>>> *busses;
-  std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT>>> *matrix;
+  Mixer *mixer;
+  MixerBuss *busspointer;
+  MixerSlot *slot;
+  std::atomic<MYFLT> *gain;
   int init(CSOUND *csound) {
 #ifdef ENABLE_MIXER_IDEBUG
     warn(csound, "MixerSend::init...\n");
 #endif
-    csound::QueryGlobalPointer(csound, "busses", busses);
-    csound::QueryGlobalPointer(csound, "matrix", matrix);
+    if (slot && (csound->GetReinitFlag(csound) || csound->GetTieFlag(csound))) {
+      mixer->removeSender(busspointer, channel, slot);
+    }
+    slot = 0;
+    mixer = getMixer(csound);
     send = static_cast<size_t>(*isend);
     buss = static_cast<size_t>(*ibuss);
-    createBuss(csound, buss);
     channel = static_cast<size_t>(*ichannel);
+    if (channel >= mixer->channels) {
+      return csound->InitError(csound, Str("MixerSend: channel %d out of range"),
+                               (int)channel);
+    }
     frames = opds.insdshead->ksmps;
-    busspointer = &(*busses)[csound][buss][channel].front();
+    if (frames > mixer->frames) {
+      frames = mixer->frames;
+    }
+    busspointer = mixer->buss(buss);
+    gain = mixer->gain(send, buss);
+    slot = mixer->addSender(busspointer, channel);
 #ifdef ENABLE_MIXER_IDEBUG
     warn(csound, "MixerSend::init: instance %p send %d buss "
                  "%d channel %d frames %d busspointer %p\n",
@@ -185,19 +326,37 @@ struct MixerSend : public OpcodeBase<MixerSend> {
 #endif
     return OK;
   }
-  int noteoff(CSOUND *) { return OK; }
+  int noteoff(CSOUND *) {
+    if (slot) {
+      mixer->removeSender(busspointer, channel, slot);
+      slot = 0;
+    }
+    return OK;
+  }
   int audio(CSOUND *csound) {
 #ifdef ENABLE_MIXER_KDEBUG
     warn(csound, "MixerSend::audio...\n");
 #endif
-    MYFLT gain = (*matrix)[csound][send][buss];
-    for (size_t i = 0; i < frames; i++) {
-      busspointer[i] += (ainput[i] * gain);
+    uint64_t kcycle = mixerKcycle(csound);
+    MYFLT g = gain->load(std::memory_order_relaxed);
+    MYFLT *out = &slot->frames.front();
+    if (slot->kcycle != kcycle) {
+      // First send of this k-period (the instrument may have a local
+      // ksmps, and perform more than once).
+      for (size_t i = 0; i < frames; i++) {
+        out[i] = ainput[i] * g;
+      }
+      std::fill(out + frames, out + mixer->frames, MYFLT(0));
+      slot->kcycle = kcycle;
+    } else {
+      for (size_t i = 0; i < frames; i++) {
+        out[i] += ainput[i] * g;
+      }
     }
 #ifdef ENABLE_MIXER_KDEBUG
     warn(csound, "MixerSend::audio: instance %d send %d buss "
                  "%d gain %f busspointer %p\n",
-         csound, send, buss, gain, busspointer);
+         csound, send, buss, g, busspointer);
 #endif
     return OK;
   }
@@ -220,18 +379,25 @@ struct MixerReceive : public OpcodeBase<MixerReceive> {
   size_t buss;
   size_t channel;
   size_t frames;
-  MYFLT *busspointer;
-  std::map<CSOUND *, std::map<size_t, std::vector<std::vector<MYFLT>>>> *busses;
+  Mixer *mixer;
+  MixerBuss *busspointer;
   int init(CSOUND *csound) {
-    csound::QueryGlobalPointer(csound, "busses", busses);
+    mixer = getMixer(csound);
     buss = static_cast<size_t>(*ibuss);
     channel = static_cast<size_t>(*ichannel);
+    if (channel >= mixer->channels) {
+      return csound->InitError(csound,
+                               Str("MixerReceive: channel %d out of range"),
+                               (int)channel);
+    }
     frames = opds.insdshead->ksmps;
-    createBuss(csound, buss);
+    if (frames > mixer->frames) {
+      frames = mixer->frames;
+    }
 #ifdef ENABLE_MIXER_IDEBUG
     warn(csound, "MixerReceive::init...\n");
 #endif
-    busspointer = &(*busses)[csound][buss][channel].front();
+    busspointer = mixer->buss(buss);
 #ifdef ENABLE_MIXER_IDEBUG
     warn(csound, "MixerReceive::init csound %p buss %d channel "
                  "%d frames %d busspointer %p\n",
@@ -243,15 +409,18 @@ struct MixerReceive : public OpcodeBase<MixerReceive> {
   int audio(CSOUND *csound) {
 #ifdef ENABLE_MIXER_KDEBUG
     warn(csound, "MixerReceive::audio...\n");
-#else
-    IGN(csound);
 #endif
+    uint64_t kcycle = mixerKcycle(csound);
+    if (busspointer->mixed != kcycle) {
+      mixer->reduce(busspointer, kcycle);
+    }
+    const MYFLT *in = &busspointer->mix[channel].front();
     for (size_t i = 0; i < frames; i++) {
-      aoutput[i] = busspointer[i];
+      aoutput[i] = in[i];
     }
 #ifdef ENABLE_MIXER_KDEBUG
     warn(csound, "MixerReceive::audio aoutput %p busspointer %p\n", aoutput,
-         buss);
+         busspointer);
 #endif
     return OK;
   }
@@ -263,36 +432,28 @@ struct MixerReceive : public OpcodeBase<MixerReceive> {
  * Clears all busses. Must be invoked after last MixerReceive.
  * You should probably use a highest-numbered instrument
  * with an indefinite duration that invokes only this opcode.
+ * Sends are only ever mixed into the k-period they were made in, so
+ * this is no longer needed to stop the busses accumulating, but a
+ * MixerReceive after it in the same k-period still gets silence.
  */
 struct MixerClear : public OpcodeBase<MixerClear> {
   // No output.
   // No input.
   // State.
-  std::map<CSOUND *, std::map<size_t, std::vector<std::vector<MYFLT>>>> *busses;
+  Mixer *mixer;
   int init(CSOUND *csound) {
-    csound::QueryGlobalPointer(csound, "busses", busses);
+    mixer = getMixer(csound);
     return OK;
   }
   int audio(CSOUND *csound) {
 #ifdef ENABLE_MIXER_KDEBUG
-    warn(csound, "MixerClear::audio...\n")
+    warn(csound, "MixerClear::audio...\n");
 #endif
-        for (std::map<size_t, std::vector<std::vector<MYFLT>>>::iterator busi =
-                 (*busses)[csound].begin();
-             busi != (*busses)[csound].end(); ++busi) {
-      for (std::vector<std::vector<MYFLT>>::iterator channeli =
-               busi->second.begin();
-           channeli != busi->second.end(); ++channeli) {
-        for (std::vector<MYFLT>::iterator framei = (*channeli).begin();
-             framei != (*channeli).end(); ++framei) {
-          *framei = 0;
-        }
-      }
-    }
+    mixer->clear(mixerKcycle(csound));
 #ifdef ENABLE_MIXER_KDEBUG
-    warn(csound, "MixerClear::audio\n")
+    warn(csound, "MixerClear::audio\n");
 #endif
-        return OK;
+    return OK;
   }
 };
 
@@ -311,19 +472,13 @@ static OENTRY localops[] = {
      (SUBR)&MixerSend::init_, (SUBR)&MixerSend::audio_},
     {(char *)"MixerReceive", sizeof(MixerReceive), _CW, 3, (char *)"a",
      (char *)"ii", (SUBR)&MixerReceive::init_, (SUBR)&MixerReceive::audio_},
-    {(char *)"MixerClear", sizeof(MixerClear), 0, 3, (char *)"", (char *)"",
+    {(char *)"MixerClear", sizeof(MixerClear), _CW, 3, (char *)"", (char *)"",
      (SUBR)&MixerClear::init_, (SUBR)&MixerClear::audio_},
     {NULL, 0, 0, 0, NULL, NULL, (SUBR)NULL, (SUBR)NULL, (SUBR)NULL}};
 
 PUBLIC int csoundModuleCreate_mixer(CSOUND *csound) {
-  std::map<CSOUND *, std::map<size_t, std::vector<std::vector<MYFLT>>>>
-      *busses = 0;
-  busses =
-      new std::map<CSOUND *, std::map<size_t, std::vector<std::vector<MYFLT>>>>;
-  csound::CreateGlobalPointer(csound, "busses", busses);
-  std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT>>> *matrix = 0;
-  matrix = new std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT>>>;
-  csound::CreateGlobalPointer(csound, "matrix", matrix);
+  Mixer *mixer = new Mixer;
+  csound::CreateGlobalPointer(csound, "mixer", mixer);
   return OK;
 }
 
@@ -342,48 +497,13 @@ PUBLIC int csoundModuleInit_mixer(CSOUND *csound) {
   return err;
 }
 
-/*
- * The mixer busses are laid out:
- * busses[csound][bus][channel][frame].
- * std::map<CSOUND *, std::map<size_t,
- *          std::vector< std::vector<MYFLT> > > > *busses = 0;
- * The mixer send matrix is laid out:
- * matrix[csound][send][bus].
- * std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT> > > *matrix = 0;
- */
 PUBLIC int csoundModuleDestroy_mixer(CSOUND *csound) {
-  std::map<CSOUND *, std::map<size_t, std::vector<std::vector<MYFLT>>>>
-      *busses = 0;
-  csound::QueryGlobalPointer(csound, "busses", busses);
-  if (busses) {
-    for (std::map<size_t, std::vector<std::vector<MYFLT>>>::iterator busi =
-             (*busses)[csound].begin();
-         busi != (*busses)[csound].end(); ++busi) {
-      for (std::vector<std::vector<MYFLT>>::iterator channeli =
-               busi->second.begin();
-           channeli != busi->second.end(); ++channeli) {
-        channeli->resize(0);
-      }
-      busi->second.clear();
-    }
-    busses->clear();
-    csound->DestroyGlobalVariable(csound, "busses");
-    delete busses;
-    busses = nullptr;
-  }
-  std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT>>> *matrix = 0;
-  csound::QueryGlobalPointer(csound, "matrix", matrix);
-  if (matrix) {
-    // std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT> > >
-    for (std::map<size_t, std::map<size_t, MYFLT>>::iterator matrixi =
-             (*matrix)[csound].begin();
-         matrixi != (*matrix)[csound].end(); ++matrixi) {
-      matrixi->second.clear();
-    }
-    matrix->clear();
-    csound->DestroyGlobalVariable(csound, "matrix");
-    delete matrix;
-    matrix = nullptr;
+  Mixer *mixer = 0;
+  csound::QueryGlobalPointer(csound, "mixer", mixer);
+  if (mixer) {
+    csound->DestroyGlobalVariable(csound, "mixer");
+    delete mixer;
+    mixer = nullptr;
   }
   return OK;
 }
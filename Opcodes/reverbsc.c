@@ -35,8 +35,23 @@
 */
 
 #include "stdopcod.h"
+#include "aops_simd.h"
 #include <math.h>
 
+#if defined(__x86_64__) || defined(_M_X64) || \
+  (defined(__i386__) && defined(__SSE2__))
+#  if defined(__GNUC__) || defined(_MSC_VER)
+#    define SC_REVERB_AVX2 1
+#    include <immintrin.h>
+#  endif
+#endif
+
+#if defined(__GNUC__)
+#  define SC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#  define SC_TARGET_AVX2
+#endif
+
 #define DEFAULT_SRATE   44100.0
 #define MIN_SRATE       5000.0
 #define MAX_SRATE       1000000.0
@@ -64,28 +79,34 @@ static const double reverbParams[8][4] = {
 static const double outputGain  = 0.35;
 static const double jpScale     = 0.25;
 
-typedef struct {
-    int32_t         writePos;
-    int32_t         bufferSize;
-    int32_t         readPos;
-    int32_t         readPosFrac;
-    int32_t         readPosFrac_inc;
-    int32_t         dummy;
-    int32_t         seedVal;
-    int32_t         randLine_cnt;
-    double      filterState;
-    MYFLT       buf[1];
-} delayLine;
+/* The 8 delay lines, one array element per line, so that the vector
+   code can load a field of all of them at once. The samples of line n
+   are at bufStart[n] in auxData. */
 
 typedef struct {
+    int32_t     writePos[8];
+    int32_t     bufferSize[8];
+    int32_t     readPos[8];
+    int32_t     readPosFrac[8];
+    int32_t     readPosFrac_inc[8];
+    int32_t     seedVal[8];
+    int32_t     randLine_cnt[8];
+    int32_t     bufStart[8];
+    double      filterState[8];
+} delayLines;
+
+typedef struct SC_REVERB_ {
     OPDS        h;
     MYFLT       *aoutL, *aoutR, *ainL, *ainR, *kFeedBack, *kLPFreq;
-    MYFLT       *iSampleRate, *iPitchMod, *iSkipInit;
+    MYFLT       *iSampleRate, *iPitchMod, *iSkipInit, *iFast;
     double      sampleRate;
     double      dampFact;
     MYFLT       prv_LPFreq;
-    int32_t         initDone;
-    delayLine   *delayLines[8];
+    int32_t     initDone;
+    int32_t     fast;
+    void        (*lines)(struct SC_REVERB_ *, uint32_t, uint32_t,
+                         double, double);
+    delayLines  dl;
     AUXCH       auxData;
 } SC_REVERB;
 
@@ -98,74 +119,340 @@ static int32_t delay_line_max_samples(SC_REVERB *p, int32_t n)
     return (int32_t) (maxDel * p->sampleRate + 16.5);
 }
 
-static int32_t delay_line_bytes_alloc(SC_REVERB *p, int32_t n)
+/* lines start on a 16 byte boundary */
+static int32_t delay_line_samples_alloc(SC_REVERB *p, int32_t n)
 {
-    int32_t nBytes;
+    int32_t align = 16 / (int32_t) sizeof(MYFLT);
 
-    nBytes = (int32_t) sizeof(delayLine) - (int32_t) sizeof(MYFLT);
-    nBytes += (delay_line_max_samples(p, n) * (int32_t) sizeof(MYFLT));
-    nBytes = (nBytes + 15) & (~15);
-    return nBytes;
+    return (delay_line_max_samples(p, n) + align - 1) & ~(align - 1);
 }
 
-static void next_random_lineseg(SC_REVERB *p, delayLine *lp, int32_t n)
+static void next_random_lineseg(SC_REVERB *p, int32_t n)
 {
+    delayLines *dl = &(p->dl);
     double  prvDel, nxtDel, phs_incVal;
 
     /* update random seed */
-    if (lp->seedVal < 0)
-      lp->seedVal += 0x10000;
-    lp->seedVal = (lp->seedVal * 15625 + 1) & 0xFFFF;
-    if (lp->seedVal >= 0x8000)
-      lp->seedVal -= 0x10000;
+    if (dl->seedVal[n] < 0)
+      dl->seedVal[n] += 0x10000;
+    dl->seedVal[n] = (dl->seedVal[n] * 15625 + 1) & 0xFFFF;
+    if (dl->seedVal[n] >= 0x8000)
+      dl->seedVal[n] -= 0x10000;
     /* length of next segment in samples */
-    lp->randLine_cnt = (int32_t) ((p->sampleRate / reverbParams[n][2]) + 0.5);
-    prvDel = (double) lp->writePos;
-    prvDel -= ((double) lp->readPos
-               + ((double) lp->readPosFrac / (double) DELAYPOS_SCALE));
+    dl->randLine_cnt[n] =
+      (int32_t) ((p->sampleRate / reverbParams[n][2]) + 0.5);
+    prvDel = (double) dl->writePos[n];
+    prvDel -= ((double) dl->readPos[n]
+               + ((double) dl->readPosFrac[n] / (double) DELAYPOS_SCALE));
     while (prvDel < 0.0)
-      prvDel += (double) lp->bufferSize;
+      prvDel += (double) dl->bufferSize[n];
     prvDel = prvDel / p->sampleRate;    /* previous delay time in seconds */
-    nxtDel = (double) lp->seedVal * reverbParams[n][1] / 32768.0;
+    nxtDel = (double) dl->seedVal[n] * reverbParams[n][1] / 32768.0;
     /* next delay time in seconds */
     nxtDel = reverbParams[n][0] + (nxtDel * (double) *(p->iPitchMod));
     /* calculate phase increment per sample */
-    phs_incVal = (prvDel - nxtDel) / (double) lp->randLine_cnt;
+    phs_incVal = (prvDel - nxtDel) / (double) dl->randLine_cnt[n];
     phs_incVal = phs_incVal * p->sampleRate + 1.0;
-    lp->readPosFrac_inc = (int32_t) (phs_incVal * DELAYPOS_SCALE + 0.5);
+    dl->readPosFrac_inc[n] = (int32_t) (phs_incVal * DELAYPOS_SCALE + 0.5);
 }
 
-static void init_delay_line(SC_REVERB *p, delayLine *lp, int32_t n)
+static void init_delay_line(SC_REVERB *p, int32_t n, int32_t bufStart)
 {
+    delayLines *dl = &(p->dl);
     double  readPos;
-    /* int32_t     i; */
 
     /* calculate length of delay line */
-    lp->bufferSize = delay_line_max_samples(p, n);
-    lp->dummy = 0;
-    lp->writePos = 0;
+    dl->bufferSize[n] = delay_line_max_samples(p, n);
+    dl->bufStart[n] = bufStart;
+    dl->writePos[n] = 0;
     /* set random seed */
-    lp->seedVal = (int32_t) (reverbParams[n][3] + 0.5);
+    dl->seedVal[n] = (int32_t) (reverbParams[n][3] + 0.5);
     /* set initial delay time */
-    readPos = (double) lp->seedVal * reverbParams[n][1] / 32768;
+    readPos = (double) dl->seedVal[n] * reverbParams[n][1] / 32768;
     readPos = reverbParams[n][0] + (readPos * (double) *(p->iPitchMod));
-    readPos = (double) lp->bufferSize - (readPos * p->sampleRate);
-    lp->readPos = (int32_t) readPos;
-    readPos = (readPos - (double) lp->readPos) * (double) DELAYPOS_SCALE;
-    lp->readPosFrac = (int32_t) (readPos + 0.5);
+    readPos = (double) dl->bufferSize[n] - (readPos * p->sampleRate);
+    dl->readPos[n] = (int32_t) readPos;
+    readPos = (readPos - (double) dl->readPos[n]) * (double) DELAYPOS_SCALE;
+    dl->readPosFrac[n] = (int32_t) (readPos + 0.5);
     /* initialise first random line segment */
-    next_random_lineseg(p, lp, n);
+    next_random_lineseg(p, n);
     /* clear delay line to zero */
-    lp->filterState = 0.0;
-    memset(lp->buf, 0, sizeof(MYFLT)*lp->bufferSize);
-    /* for (i = 0; i < lp->bufferSize; i++) */
-    /*   lp->buf[i] = FL(0.0); */
+    dl->filterState[n] = 0.0;
+    memset((MYFLT*) p->auxData.auxp + bufStart, 0,
+           sizeof(MYFLT) * dl->bufferSize[n]);
 }
 
+/* one line at a time, as the opcode always did */
+
+static void sc_reverb_lines(SC_REVERB *p, uint32_t offset, uint32_t nsmps,
+                            double feedBack, double dampFact)
+{
+    delayLines *dl = &(p->dl);
+    MYFLT     *buf;
+    double    ainL, ainR, aoutL, aoutR;
+    double    vm1, v0, v1, v2, am1, a0, a1, a2, frac;
+    int32_t   readPos;
+    int32_t   bufferSize; /* Local copy */
+    uint32_t  i, n;
+
+    for (i = offset; i < nsmps; i++) {
+      /* calculate "resultant junction pressure" and mix to input signals */
+      ainL = aoutL = aoutR = 0.0;
+      for (n = 0; n < 8; n++)
+        ainL += dl->filterState[n];
+      ainL *= jpScale;
+      ainR = ainL + (double) p->ainR[i];
+      ainL = ainL + (double) p->ainL[i];
+      /* loop through all delay lines */
+      for (n = 0; n < 8; n++) {
+        buf = (MYFLT*) p->auxData.auxp + dl->bufStart[n];
+        bufferSize = dl->bufferSize[n];
+        /* send input signal and feedback to delay line */
+        buf[dl->writePos[n]] = (MYFLT) ((n & 1 ? ainR : ainL)
+                                        - dl->filterState[n]);
+        if (UNLIKELY(++dl->writePos[n] >= bufferSize))
+          dl->writePos[n] -= bufferSize;
+        /* read from delay line with cubic interpolation */
+        if (dl->readPosFrac[n] >= DELAYPOS_SCALE) {
+          dl->readPos[n] += (dl->readPosFrac[n] >> DELAYPOS_SHIFT);
+          dl->readPosFrac[n] &= DELAYPOS_MASK;
+        }
+        if (UNLIKELY(dl->readPos[n] >= bufferSize))
+          dl->readPos[n] -= bufferSize;
+        readPos = dl->readPos[n];
+        frac = (double) dl->readPosFrac[n] * (1.0 / (double) DELAYPOS_SCALE);
+        /* calculate interpolation coefficients */
+        a2 = frac * frac; a2 -= 1.0; a2 *= (1.0 / 6.0);
+        a1 = frac; a1 += 1.0; a1 *= 0.5; am1 = a1 - 1.0;
+        a0 = 3.0 * a2; a1 -= a0; am1 -= a2; a0 -= frac;
+        /* read four samples for interpolation */
+        if (LIKELY(readPos > 0 && readPos < (bufferSize - 2))) {
+          vm1 = (double) (buf[readPos - 1]);
+          v0  = (double) (buf[readPos]);
+          v1  = (double) (buf[readPos + 1]);
+          v2  = (double) (buf[readPos + 2]);
+        }
+        else {
+          /* at buffer wrap-around, need to check index */
+          if (--readPos < 0) readPos += bufferSize;
+          vm1 = (double) buf[readPos];
+          if (++readPos >= bufferSize) readPos -= bufferSize;
+          v0 = (double) buf[readPos];
+          if (++readPos >= bufferSize) readPos -= bufferSize;
+          v1 = (double) buf[readPos];
+          if (++readPos >= bufferSize) readPos -= bufferSize;
+          v2 = (double) buf[readPos];
+        }
+        v0 = (am1 * vm1 + a0 * v0 + a1 * v1 + a2 * v2) * frac + v0;
+        /* update buffer read position */
+        dl->readPosFrac[n] += dl->readPosFrac_inc[n];
+        /* apply feedback gain and lowpass filter */
+        v0 *= feedBack;
+        v0 = (dl->filterState[n] - v0) * dampFact + v0;
+        dl->filterState[n] = v0;
+        /* mix to output */
+        if (n & 1)
+          aoutR += v0;
+        else
+          aoutL += v0;
+        /* start next random line segment if current one has reached endpoint */
+        if (--(dl->randLine_cnt[n]) <= 0)
+          next_random_lineseg(p, n);
+      }
+      p->aoutL[i] = (MYFLT) (aoutL * outputGain);
+      p->aoutR[i] = (MYFLT) (aoutR * outputGain);
+    }
+}
+
+#ifdef SC_REVERB_AVX2
+
+/* All 8 lines at once: positions and indices in one vector of 8 int32,
+   samples and filter states as two vectors of 4 doubles. Every lane
+   does the same double operations in the same order as above, so with
+   the sums over the lines also taken in line order the output is the
+   same to the bit. In fast mode those sums are done pairwise, and the
+   junction pressure is taken from the previous sample's output sums;
+   that only changes rounding (see sc_reverb_perf). */
+
+SC_TARGET_AVX2 static inline void sc_gather(const MYFLT *buf, __m256i idx,
+                                            __m256d *lo, __m256d *hi)
+{
+#ifdef USE_DOUBLE
+    *lo = _mm256_i32gather_pd(buf, _mm256_castsi256_si128(idx), 8);
+    *hi = _mm256_i32gather_pd(buf, _mm256_extracti128_si256(idx, 1), 8);
+#else
+    __m256 v = _mm256_i32gather_ps(buf, idx, 4);
+    *lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+    *hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+#endif
+}
+
+/* cubic interpolation and feedback filter for 4 lines */
+SC_TARGET_AVX2 static inline __m256d sc_interp(__m256d frac, __m256d vm1,
+                                               __m256d v0, __m256d v1,
+                                               __m256d v2, __m256d fs,
+                                               __m256d fb, __m256d damp)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d am1, a0, a1, a2;
+
+    a2 = _mm256_mul_pd(_mm256_sub_pd(_mm256_mul_pd(frac, frac), one),
+                       _mm256_set1_pd(1.0 / 6.0));
+    a1 = _mm256_mul_pd(_mm256_add_pd(frac, one), _mm256_set1_pd(0.5));
+    am1 = _mm256_sub_pd(a1, one);
+    a0 = _mm256_mul_pd(_mm256_set1_pd(3.0), a2);
+    a1 = _mm256_sub_pd(a1, a0);
+    am1 = _mm256_sub_pd(am1, a2);
+    a0 = _mm256_sub_pd(a0, frac);
+    vm1 = _mm256_add_pd(_mm256_mul_pd(am1, vm1), _mm256_mul_pd(a0, v0));
+    vm1 = _mm256_add_pd(vm1, _mm256_mul_pd(a1, v1));
+    vm1 = _mm256_add_pd(vm1, _mm256_mul_pd(a2, v2));
+    v0 = _mm256_add_pd(_mm256_mul_pd(vm1, frac), v0);
+    v0 = _mm256_mul_pd(v0, fb);
+    return _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(fs, v0), damp), v0);
+}
+
+/* x - (x > y ? n : 0) */
+#define SC_WRAP(x, y, n) \
+  _mm256_sub_epi32(x, _mm256_and_si256(_mm256_cmpgt_epi32(x, y), n))
+
+SC_TARGET_AVX2 static void sc_reverb_lines_avx2(SC_REVERB *p,
+                                                uint32_t offset,
+                                                uint32_t nsmps,
+                                                double feedBack,
+                                                double dampFact)
+{
+    delayLines *dl = &(p->dl);
+    MYFLT     *buf = (MYFLT*) p->auxData.auxp;
+    const int32_t fast = p->fast;
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i fracMask = _mm256_set1_epi32(DELAYPOS_MASK);
+    const __m256i start = _mm256_loadu_si256((__m256i*) dl->bufStart);
+    const __m256i size = _mm256_loadu_si256((__m256i*) dl->bufferSize);
+    const __m256i last = _mm256_sub_epi32(size, one);
+    const __m256d fb = _mm256_set1_pd(feedBack);
+    const __m256d damp = _mm256_set1_pd(dampFact);
+    const __m256d fracScale = _mm256_set1_pd(1.0 / (double) DELAYPOS_SCALE);
+    __m256i   writePos = _mm256_loadu_si256((__m256i*) dl->writePos);
+    __m256i   readPos = _mm256_loadu_si256((__m256i*) dl->readPos);
+    __m256i   readPosFrac = _mm256_loadu_si256((__m256i*) dl->readPosFrac);
+    __m256i   inc = _mm256_loadu_si256((__m256i*) dl->readPosFrac_inc);
+    __m256i   cnt = _mm256_loadu_si256((__m256i*) dl->randLine_cnt);
+    __m256i   m, im1, i1, i2;
+    __m256d   fsLo = _mm256_loadu_pd(&(dl->filterState[0]));
+    __m256d   fsHi = _mm256_loadu_pd(&(dl->filterState[4]));
+    __m256d   in, fLo, fHi, vm1Lo, vm1Hi, v0Lo, v0Hi, v1Lo, v1Hi, v2Lo, v2Hi;
+    double    jp = 0.0, aoutL, aoutR, fs[8];
+    int32_t   idx[8], n, lanes;
+    MYFLT     w[8];
+    uint32_t  i;
+
+    if (fast) {
+      __m256d s = _mm256_add_pd(fsLo, fsHi);
+      s = _mm256_add_pd(s, _mm256_permute2f128_pd(s, s, 1));
+      jp = _mm256_cvtsd_f64(_mm256_hadd_pd(s, s));
+    }
+    for (i = offset; i < nsmps; i++) {
+      /* "resultant junction pressure" */
+      if (!fast) {
+        _mm256_storeu_pd(&fs[0], fsLo);
+        _mm256_storeu_pd(&fs[4], fsHi);
+        jp = 0.0;
+        for (n = 0; n < 8; n++)
+          jp += fs[n];
+      }
+      jp *= jpScale;
+      /* input signal and feedback to the delay lines, odd lines right */
+      in = _mm256_blend_pd(_mm256_set1_pd(jp + (double) p->ainL[i]),
+                           _mm256_set1_pd(jp + (double) p->ainR[i]), 0xA);
+#ifdef USE_DOUBLE
+      _mm256_storeu_pd(&w[0], _mm256_sub_pd(in, fsLo));
+      _mm256_storeu_pd(&w[4], _mm256_sub_pd(in, fsHi));
+#else
+      _mm_storeu_ps(&w[0], _mm256_cvtpd_ps(_mm256_sub_pd(in, fsLo)));
+      _mm_storeu_ps(&w[4], _mm256_cvtpd_ps(_mm256_sub_pd(in, fsHi)));
+#endif
+      _mm256_storeu_si256((__m256i*) idx, _mm256_add_epi32(start, writePos));
+      for (n = 0; n < 8; n++)
+        buf[idx[n]] = w[n];
+      writePos = SC_WRAP(_mm256_add_epi32(writePos, one), last, size);
+      /* advance the read positions by the whole samples in the fractions */
+      m = _mm256_cmpgt_epi32(readPosFrac, fracMask);
+      readPos = _mm256_add_epi32(readPos, _mm256_and_si256(
+                    m, _mm256_srai_epi32(readPosFrac, DELAYPOS_SHIFT)));
+      readPosFrac = _mm256_blendv_epi8(
+                    readPosFrac, _mm256_and_si256(readPosFrac, fracMask), m);
+      readPos = SC_WRAP(readPos, last, size);
+      /* four taps for the interpolation, wrapped around the buffer ends */
+      im1 = _mm256_sub_epi32(readPos, one);
+      im1 = _mm256_add_epi32(im1, _mm256_and_si256(
+                _mm256_cmpgt_epi32(_mm256_setzero_si256(), im1), size));
+      i1 = SC_WRAP(_mm256_add_epi32(readPos, one), last, size);
+      i2 = SC_WRAP(_mm256_add_epi32(i1, one), last, size);
+      sc_gather(buf, _mm256_add_epi32(start, im1), &vm1Lo, &vm1Hi);
+      sc_gather(buf, _mm256_add_epi32(start, readPos), &v0Lo, &v0Hi);
+      sc_gather(buf, _mm256_add_epi32(start, i1), &v1Lo, &v1Hi);
+      sc_gather(buf, _mm256_add_epi32(start, i2), &v2Lo, &v2Hi);
+      fLo = _mm256_mul_pd(_mm256_cvtepi32_pd(
+                _mm256_castsi256_si128(readPosFrac)), fracScale);
+      fHi = _mm256_mul_pd(_mm256_cvtepi32_pd(
+                _mm256_extracti128_si256(readPosFrac, 1)), fracScale);
+      readPosFrac = _mm256_add_epi32(readPosFrac, inc);
+      fsLo = sc_interp(fLo, vm1Lo, v0Lo, v1Lo, v2Lo, fsLo, fb, damp);
+      fsHi = sc_interp(fHi, vm1Hi, v0Hi, v1Hi, v2Hi, fsHi, fb, damp);
+      /* mix to output, even lines left */
+      if (fast) {
+        __m256d s = _mm256_add_pd(fsLo, fsHi);
+        __m128d lr = _mm_add_pd(_mm256_castpd256_pd128(s),
+                                _mm256_extractf128_pd(s, 1));
+        aoutL = _mm_cvtsd_f64(lr);
+        aoutR = _mm_cvtsd_f64(_mm_unpackhi_pd(lr, lr));
+        jp = aoutL + aoutR;
+      }
+      else {
+        _mm256_storeu_pd(&fs[0], fsLo);
+        _mm256_storeu_pd(&fs[4], fsHi);
+        aoutL = aoutR = 0.0;
+        for (n = 0; n < 8; n += 2) {
+          aoutL += fs[n];
+          aoutR += fs[n + 1];
+        }
+      }
+      p->aoutL[i] = (MYFLT) (aoutL * outputGain);
+      p->aoutR[i] = (MYFLT) (aoutR * outputGain);
+      /* start next random line segment where the current one has ended */
+      cnt = _mm256_sub_epi32(cnt, one);
+      lanes = _mm256_movemask_ps(_mm256_castsi256_ps(
+                  _mm256_cmpgt_epi32(one, cnt)));
+      if (UNLIKELY(lanes)) {
+        _mm256_storeu_si256((__m256i*) dl->writePos, writePos);
+        _mm256_storeu_si256((__m256i*) dl->readPos, readPos);
+        _mm256_storeu_si256((__m256i*) dl->readPosFrac, readPosFrac);
+        _mm256_storeu_si256((__m256i*) dl->randLine_cnt, cnt);
+        for (n = 0; n < 8; n++)
+          if (lanes & (1 << n))
+            next_random_lineseg(p, n);
+        inc = _mm256_loadu_si256((__m256i*) dl->readPosFrac_inc);
+        cnt = _mm256_loadu_si256((__m256i*) dl->randLine_cnt);
+      }
+    }
+    _mm256_storeu_si256((__m256i*) dl->writePos, writePos);
+    _mm256_storeu_si256((__m256i*) dl->readPos, readPos);
+    _mm256_storeu_si256((__m256i*) dl->readPosFrac, readPosFrac);
+    _mm256_storeu_si256((__m256i*) dl->readPosFrac_inc, inc);
+    _mm256_storeu_si256((__m256i*) dl->randLine_cnt, cnt);
+    _mm256_storeu_pd(&(dl->filterState[0]), fsLo);
+    _mm256_storeu_pd(&(dl->filterState[4]), fsHi);
+}
+
+#undef SC_WRAP
+
+#endif  /* SC_REVERB_AVX2 */
+
 static int32_t sc_reverb_init(CSOUND *csound, SC_REVERB *p)
 {
     int32_t i;
-    int32_t nBytes;
+    int32_t nSamples;
 
     /* check for valid parameters */
     if (UNLIKELY(*(p->iSampleRate) <= FL(0.0)))
@@ -181,21 +468,27 @@ static int32_t sc_reverb_init(CSOUND *csound, SC_REVERB *p)
       return csound->InitError(csound,
                                Str("reverbsc: invalid pitch modulation factor"));
     }
+    /* the vector code is bit exact, fast mode only affects rounding */
+    p->fast = (*(p->iFast) != FL(0.0));
+    p->lines = sc_reverb_lines;
+#ifdef SC_REVERB_AVX2
+    if (aops_cpu_has(AOPS_CPU_AVX2))
+      p->lines = sc_reverb_lines_avx2;
+#endif
     /* calculate the number of bytes to allocate */
-    nBytes = 0;
+    nSamples = 0;
     for (i = 0; i < 8; i++)
-      nBytes += delay_line_bytes_alloc(p, i);
-    if (nBytes != (int32_t)p->auxData.size)
-      csound->AuxAlloc(csound, (size_t) nBytes, &(p->auxData));
+      nSamples += delay_line_samples_alloc(p, i);
+    if ((size_t) nSamples * sizeof(MYFLT) != p->auxData.size)
+      csound->AuxAlloc(csound, (size_t) nSamples * sizeof(MYFLT),
+                       &(p->auxData));
     else if (p->initDone && *(p->iSkipInit) != FL(0.0))
       return OK;    /* skip initialisation if requested */
     /* set up delay lines */
-    nBytes = 0;
+    nSamples = 0;
     for (i = 0; i < 8; i++) {
-      p->delayLines[i] = (delayLine*) ((unsigned char*) (p->auxData.auxp)
-                                       + (int32_t) nBytes);
-      init_delay_line(p, p->delayLines[i], i);
-      nBytes += delay_line_bytes_alloc(p, i);
+      init_delay_line(p, i, nSamples);
+      nSamples += delay_line_samples_alloc(p, i);
     }
     p->dampFact = 1.0;
     p->prv_LPFreq = FL(0.0);
@@ -204,16 +497,18 @@ static int32_t sc_reverb_init(CSOUND *csound, SC_REVERB *p)
     return OK;
 }
 
+/* In fast mode the output differs from the reference only in rounding.
+   With double samples that is less than 1e-12 of the input level for
+   any feedback below 1.  With float samples a delay line write or an
+   output sample can round to the neighbouring float, and the feedback
+   carries that on, so the difference is of the order of the float
+   precision of the signal divided by (1 - feedback). */
+
 static int32_t sc_reverb_perf(CSOUND *csound, SC_REVERB *p)
 {
-    double    ainL, ainR, aoutL, aoutR;
-    double    vm1, v0, v1, v2, am1, a0, a1, a2, frac;
-    delayLine *lp;
-    int32_t       readPos;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t i, n, nsmps = CS_KSMPS;
-    int32_t       bufferSize; /* Local copy */
+    uint32_t nsmps = CS_KSMPS;
     double    dampFact = p->dampFact;
 
     if (UNLIKELY(p->initDone <= 0)) goto err1;
@@ -233,73 +528,7 @@ static int32_t sc_reverb_perf(CSOUND *csound, SC_REVERB *p)
       memset(&p->aoutR[nsmps], '\0', early*sizeof(MYFLT));
     }
     /* update delay lines */
-    for (i = offset; i < nsmps; i++) {
-      /* calculate "resultant junction pressure" and mix to input signals */
-      ainL = aoutL = aoutR = 0.0;
-      for (n = 0; n < 8; n++)
-        ainL += p->delayLines[n]->filterState;
-      ainL *= jpScale;
-      ainR = ainL + (double) p->ainR[i];
-      ainL = ainL + (double) p->ainL[i];
-      /* loop through all delay lines */
-      for (n = 0; n < 8; n++) {
-        lp = p->delayLines[n];
-        bufferSize = lp->bufferSize;
-        /* send input signal and feedback to delay line */
-        lp->buf[lp->writePos] = (MYFLT) ((n & 1 ? ainR : ainL)
-                                         - lp->filterState);
-        if (UNLIKELY(++lp->writePos >= bufferSize))
-          lp->writePos -= bufferSize;
-        /* read from delay line with cubic interpolation */
-        if (lp->readPosFrac >= DELAYPOS_SCALE) {
-          lp->readPos += (lp->readPosFrac >> DELAYPOS_SHIFT);
-          lp->readPosFrac &= DELAYPOS_MASK;
-        }
-        if (UNLIKELY(lp->readPos >= bufferSize))
-          lp->readPos -= bufferSize;
-        readPos = lp->readPos;
-        frac = (double) lp->readPosFrac * (1.0 / (double) DELAYPOS_SCALE);
-        /* calculate interpolation coefficients */
-        a2 = frac * frac; a2 -= 1.0; a2 *= (1.0 / 6.0);
-        a1 = frac; a1 += 1.0; a1 *= 0.5; am1 = a1 - 1.0;
-        a0 = 3.0 * a2; a1 -= a0; am1 -= a2; a0 -= frac;
-        /* read four samples for interpolation */
-        if (LIKELY(readPos > 0 && readPos < (bufferSize - 2))) {
-          vm1 = (double) (lp->buf[readPos - 1]);
-          v0  = (double) (lp->buf[readPos]);
-          v1  = (double) (lp->buf[readPos + 1]);
-          v2  = (double) (lp->buf[readPos + 2]);
-        }
-        else {
-          /* at buffer wrap-around, need to check index */
-          if (--readPos < 0) readPos += bufferSize;
-          vm1 = (double) lp->buf[readPos];
-          if (++readPos >= bufferSize) readPos -= bufferSize;
-          v0 = (double) lp->buf[readPos];
-          if (++readPos >= bufferSize) readPos -= bufferSize;
-          v1 = (double) lp->buf[readPos];
-          if (++readPos >= bufferSize) readPos -= bufferSize;
-          v2 = (double) lp->buf[readPos];
-        }
-        v0 = (am1 * vm1 + a0 * v0 + a1 * v1 + a2 * v2) * frac + v0;
-        /* update buffer read position */
-        lp->readPosFrac += lp->readPosFrac_inc;
-        /* apply feedback gain and lowpass filter */
-        v0 *= (double) *(p->kFeedBack);
-        v0 = (lp->filterState - v0) * dampFact + v0;
-        lp->filterState = v0;
-        /* mix to output */
-        if (n & 1)
-          aoutR += v0;
-        else
-          aoutL += v0;
-        /* start next random line segment if current one has reached endpoint */
-        if (--(lp->randLine_cnt) <= 0)
-          next_random_lineseg(p, lp, n);
-      }
-      p->aoutL[i] = (MYFLT) (aoutL * outputGain);
-      p->aoutR[i] = (MYFLT) (aoutR * outputGain);
-    }
+    p->lines(p, offset, nsmps, (double) *(p->kFeedBack), dampFact);
 
     return OK;
  err1:
@@ -312,9 +541,8 @@ static int32_t sc_reverb_perf(CSOUND *csound, SC_REVERB *p)
 int32_t reverbsc_init_(CSOUND *csound)
 {
     return csound->AppendOpcode(csound, "reverbsc",
-                                (int32_t) sizeof(SC_REVERB), 0, 3, "aa", "aakkjpo",
+                                (int32_t) sizeof(SC_REVERB), 0, 3, "aa", "aakkjpoo",
                                 (int32_t (*)(CSOUND *, void *)) sc_reverb_init,
                                 (int32_t (*)(CSOUND *, void *)) sc_reverb_perf,
                                 NULL);
 }
-
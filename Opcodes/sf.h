@@ -125,6 +125,8 @@ struct _SFBANK {
         instrType *instr;
         SHORT *sampleData;
         CHUNKS chunk;
+        void *map;              /* shared mapping of the file, or NULL */
+        int32_t prefetch;       /* read ahead samples of assigned presets */
 } PACKED;
 typedef struct _SFBANK SFBANK;
 
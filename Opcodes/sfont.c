@@ -39,12 +39,19 @@
 #include <errno.h>
 #include "sfenum.h"
 #include "sfont.h"
+#if !defined(WIN32) && !defined(WORDS_BIGENDIAN)
+/* mapped files are parsed in place, so not where bytes need swapping */
+#define SF_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #define s2d(x)  *((DWORD *) (x))
 
 
 
 static int32_t chunk_read(CSOUND *, FILE *f, CHUNK *chunk);
+static DWORD dword(char *p);
 static void fill_SfPointers(CSOUND *);
 static int32_t  fill_SfStruct(CSOUND *);
 static void layerDefaults(layerType *layer);
@@ -67,6 +74,124 @@ typedef struct _sfontg {
   MYFLT pitches[128];
 } sfontg;
 
+#ifdef SF_MMAP
+/* Files loaded by sfload with imode != 0 are mapped rather than read:
+   only the header chunks are touched while loading, and the sample
+   data is paged in when it is played.  A mapping is shared by all
+   Csound instances of the process that load the same unchanged file. */
+
+typedef struct sfmap_s {
+    struct sfmap_s *nxt;
+    char    *path;
+    time_t  mtime;
+    off_t   size;
+    void    *addr;
+    int32_t refs;
+} SFMAP;
+
+static SFMAP *sfmaps = NULL;
+static spin_lock_t sfmaplock = SPINLOCK_INIT;
+
+static SFMAP *sf_map(FILE *fil, const char *path)
+{
+    struct stat st;
+    SFMAP   *m, *nm;
+    void    *addr;
+
+    if (fstat(fileno(fil), &st) != 0 || st.st_size < 8)
+      return NULL;
+    csoundSpinLock(&sfmaplock);
+    for (m = sfmaps; m != NULL; m = m->nxt)
+      if (m->mtime == st.st_mtime && m->size == st.st_size &&
+          strcmp(m->path, path) == 0) {
+        m->refs++;
+        csoundSpinUnLock(&sfmaplock);
+        return m;
+      }
+    csoundSpinUnLock(&sfmaplock);
+    /* private, so that nothing done to it can reach the file */
+    addr = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE, fileno(fil), 0);
+    if (addr == MAP_FAILED)
+      return NULL;
+    posix_madvise(addr, (size_t) st.st_size, POSIX_MADV_RANDOM);
+    nm = (SFMAP *) malloc(sizeof(SFMAP));
+    if (nm == NULL || (nm->path = strdup(path)) == NULL) {
+      free(nm);
+      munmap(addr, (size_t) st.st_size);
+      return NULL;
+    }
+    nm->mtime = st.st_mtime;
+    nm->size = st.st_size;
+    nm->addr = addr;
+    nm->refs = 1;
+    csoundSpinLock(&sfmaplock);
+    /* another instance may have mapped it meanwhile */
+    for (m = sfmaps; m != NULL; m = m->nxt)
+      if (m->mtime == nm->mtime && m->size == nm->size &&
+          strcmp(m->path, path) == 0)
+        break;
+    if (m != NULL)
+      m->refs++;
+    else {
+      nm->nxt = sfmaps;
+      sfmaps = nm;
+    }
+    csoundSpinUnLock(&sfmaplock);
+    if (m != NULL) {
+      munmap(addr, (size_t) nm->size);
+      free(nm->path);
+      free(nm);
+      return m;
+    }
+    return nm;
+}
+
+static void sf_unmap(void *p)
+{
+    SFMAP   *m = (SFMAP *) p, **mp;
+
+    csoundSpinLock(&sfmaplock);
+    if (--m->refs > 0) {
+      csoundSpinUnLock(&sfmaplock);
+      return;
+    }
+    for (mp = &sfmaps; *mp != m; mp = &(*mp)->nxt)
+      ;
+    *mp = m->nxt;
+    csoundSpinUnLock(&sfmaplock);
+    munmap(m->addr, (size_t) m->size);
+    free(m->path);
+    free(m);
+}
+
+/* ask the system to read ahead the samples of a preset */
+
+static void sf_prefetch(SFBANK *sf, presetType *prs)
+{
+    uintptr_t pg = (uintptr_t) sysconf(_SC_PAGESIZE);
+    int32_t   l, k;
+
+    if (sf->map == NULL || !sf->prefetch)
+      return;
+    for (l = 0; l < prs->layers_num; l++) {
+      layerType *lay = &prs->layer[l];
+      for (k = 0; k < lay->splits_num; k++) {
+        sfSample  *smp = lay->split[k].sample;
+        uintptr_t beg = (uintptr_t) (sf->sampleData + smp->dwStart);
+        uintptr_t end = (uintptr_t) (sf->sampleData + smp->dwEnd);
+        if (smp->dwEnd <= smp->dwStart)
+          continue;
+        beg &= ~(pg - 1);
+        posix_madvise((void *) beg, (size_t) (end - beg), POSIX_MADV_WILLNEED);
+      }
+    }
+}
+#else
+#define sf_unmap(p)
+#define sf_prefetch(sf, prs)
+#endif
+
 int32_t sfont_ModuleDestroy(CSOUND *csound)
 {
     int32_t j,k,l;
@@ -88,7 +213,10 @@ int32_t sfont_ModuleDestroy(CSOUND *csound)
         csound->Free(csound, sfArray[j].instr[l].split);
       }
       csound->Free(csound, sfArray[j].instr);
-      csound->Free(csound, sfArray[j].chunk.main_chunk.ckDATA);
+      if (sfArray[j].map != NULL)
+        sf_unmap(sfArray[j].map);
+      else
+        csound->Free(csound, sfArray[j].chunk.main_chunk.ckDATA);
     }
     csound->Free(csound, sfArray);
     globals->currSFndx = 0;
@@ -99,7 +227,7 @@ int32_t sfont_ModuleDestroy(CSOUND *csound)
     return 0;
 }
 
-static void SoundFontLoad(CSOUND *csound, char *fname)
+static void SoundFontLoad(CSOUND *csound, char *fname, int32_t mode)
 {
     FILE *fil;
     void *fd;
@@ -122,8 +250,28 @@ static void SoundFontLoad(CSOUND *csound, char *fname)
     /* } */
     strNcpy(soundFont->name, csound->GetFileName(fd), 256);
     //soundFont->name[255]='\0';
-    if (UNLIKELY(chunk_read(csound, fil, &soundFont->chunk.main_chunk)<0))
-      csound->Message(csound, Str("sfont: failed to read file\n"));
+    soundFont->map = NULL;
+    soundFont->prefetch = (mode > 1);
+#ifdef SF_MMAP
+    if (mode != 0 &&
+        (soundFont->map = sf_map(fil, csound->GetFileName(fd))) != NULL) {
+      SFMAP *m = (SFMAP *) soundFont->map;
+      CHUNK *main_chunk = &soundFont->chunk.main_chunk;
+      memcpy(main_chunk->ckID, m->addr, 4);
+      main_chunk->ckSize = dword((char *) m->addr + 4);
+      if (main_chunk->ckSize > (DWORD) (m->size - 8))
+        main_chunk->ckSize = (DWORD) (m->size - 8);
+      main_chunk->ckDATA = (BYTE *) m->addr + 8;
+    }
+    else
+#endif
+    {
+      if (UNLIKELY(mode != 0))
+        csound->Warning(csound, Str("sfload: cannot map \"%s\", reading it"),
+                        fname);
+      if (UNLIKELY(chunk_read(csound, fil, &soundFont->chunk.main_chunk)<0))
+        csound->Message(csound, Str("sfont: failed to read file\n"));
+    }
     csound->FileClose(csound, fd);
     globals->soundFont = soundFont;
     fill_SfPointers(csound);
@@ -164,7 +312,7 @@ static int32_t SfLoad_(CSOUND *csound, SFLOAD *p, int32_t istring)
     }
     /*    strcpy(fname, (char*) p->fname); */
     Gfname = fname;
-    SoundFontLoad(csound, fname);
+    SoundFontLoad(csound, fname, (int32_t) *p->imode);
     *p->ihandle = (float) globals->currSFndx;
     sf = &globals->sfArray[globals->currSFndx];
     qsort(sf->preset, sf->presets_num, sizeof(presetType),
@@ -248,6 +396,7 @@ static int32_t SfAssignAllPresets(CSOUND *csound, SFPASSIGN *p)
                                 j, prs->name, prs->prog, prs->bank);
       globals->presetp[pHandle] = &sf->preset[j];
       globals->sampleBase[pHandle] = sf->sampleData;
+      sf_prefetch(sf, prs);
       pHandle++;
     }
     if (enableMsgs)
@@ -292,6 +441,7 @@ static int32_t SfPreset(CSOUND *csound, SFPRESET *p)
         {
           globals->presetp[presetHandle] = &sf->preset[j];
           globals->sampleBase[presetHandle] = sf->sampleData;
+          sf_prefetch(sf, &sf->preset[j]);
           break;
         }
     }
@@ -2570,8 +2720,8 @@ static int32_t sflooper_process(CSOUND *csound, sflooper *p)
 #define S       sizeof
 
 static OENTRY localops[] = {
-  { "sfload",S(SFLOAD),     0, 1,    "i",    "S",      (SUBR)SfLoad_S, NULL, NULL },
-   { "sfload.i",S(SFLOAD),     0, 1,    "i",    "i",   (SUBR)SfLoad, NULL, NULL },
+  { "sfload",S(SFLOAD),     0, 1,    "i",    "So",     (SUBR)SfLoad_S, NULL, NULL },
+   { "sfload.i",S(SFLOAD),     0, 1,    "i",    "io",  (SUBR)SfLoad, NULL, NULL },
   { "sfpreset",S(SFPRESET), 0, 1,    "i",    "iiii",   (SUBR)SfPreset         },
   { "sfplay", S(SFPLAY), 0, 3, "aa", "iixxiooo",
     (SUBR)SfPlay_set, (SUBR)SfPlay     },
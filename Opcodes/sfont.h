@@ -27,7 +27,7 @@
 
 typedef struct {
         OPDS    h;
-        MYFLT   *ihandle, *fname;
+        MYFLT   *ihandle, *fname, *imode;
 } SFLOAD;
 
 typedef struct {
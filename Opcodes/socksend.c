@@ -556,11 +556,15 @@ static inline char *byteswap(char *p, int32_t N){
     return p;
 }
 
+/* grow the buffer, keeping its contents; aux spaces may come from the
+   engine's pools, which only AuxAlloc can resize */
 static inline int32_t aux_realloc(CSOUND *csound, size_t size, AUXCH *aux) {
-    char *p = aux->auxp;
-    aux->auxp = csound->ReAlloc(csound, p, size);
-    aux->size = size;
-    aux->endp = (char*)aux->auxp + size;
+    size_t n = aux->size < size ? aux->size : size;
+    char *tmp = csound->Malloc(csound, n);
+    memcpy(tmp, aux->auxp, n);
+    csound->AuxAlloc(csound, size, aux);
+    memcpy(aux->auxp, tmp, n);
+    csound->Free(csound, tmp);
     return size;
 }
 
@@ -298,12 +298,20 @@ static const char *longUsageList[] = {
   Str_noop("--port=N                listen to UDP port N for instruments/orchestra "
                                     "code (implies --daemon)"),
   Str_noop("--vbr-quality=Ft        set quality of variable bit-rate compression"),
+  Str_noop("--disk-buffers=N        write sound files from a separate thread "
+                                   "through N buffers"),
+  Str_noop("--aux-zero-async=N      clear freed delay lines etc. of N KiB or "
+                                   "more in a separate thread"),
+  Str_noop("--profile               time each opcode and instrument and "
+                                   "report at the end"),
   Str_noop("--devices[=in|out]      list available audio devices and exit"),
   Str_noop("--midi-devices[=in|out] list available MIDI devices and exit"),
   Str_noop("--get-system-sr         print system sr and exit"),
   Str_noop("--ksmps=N               override ksmps"),
   Str_noop("--fftlib=N              actual FFT lib to use (FFTLIB=0, "
-                                   "PFFFT = 1, vDSP =2)"),
+                                   "PFFFT = 1, vDSP =2, DFFT = 3;"),
+  Str_noop("                        default DFFT for powers of two in "
+                                   "double builds, else FFTLIB)"),
   Str_noop("--udp-echo              echo UDP commands on terminal"),
   Str_noop("--aft-zero              set aftertouch to zero, not 127 (default)"),
   " ",
@@ -1041,6 +1049,10 @@ static int decode_long(CSOUND *csound, char *s, int argc, char **argv)
       O->sampleAccurate = 1;
       return 1;
     }
+    else if (!(strcmp(s, "profile"))) {
+      O->profile = 1;
+      return 1;
+    }
     else if (!(strcmp(s, "realtime"))) {
       csound->Message(csound, Str("realtime mode enabled\n"));
       O->realtime = 1;
@@ -1120,6 +1132,18 @@ static int decode_long(CSOUND *csound, char *s, int argc, char **argv)
       O->fft_lib = atoi(s);
       return 1;
     }
+    else if (!(strncmp(s, "disk-buffers=",13))) {
+      s += 13;
+      O->disk_buffers = atoi(s);
+      if (O->disk_buffers < 0) O->disk_buffers = 0;
+      return 1;
+    }
+    else if (!(strncmp(s, "aux-zero-async=",15))) {
+      s += 15;
+      O->aux_zero_async = atoi(s);
+      if (O->aux_zero_async < 0) O->aux_zero_async = 0;
+      return 1;
+    }
     else if (!(strncmp(s, "vbr-quality=",12))) {
       s += 12;
       O->quality = atof(s);
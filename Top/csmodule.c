@@ -74,9 +74,12 @@
 #include <string.h>
 #include <errno.h>
 #include <setjmp.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "csoundCore.h"
 #include "csmodule.h"
+#include "find_opcode.h"
 
 #if defined(__MACH__)
 #include <TargetConditionals.h>
@@ -110,6 +113,10 @@ int             closedir(DIR*);
 #if defined(WIN32) && !defined(__CYGWIN__)
 #  include <io.h>
 #  include <direct.h>
+#  define GETPID()  GetCurrentProcessId()
+#else
+#  include <unistd.h>
+#  define GETPID()  getpid()
 #endif
 
 extern  int     allocgen(CSOUND *, char *, int (*)(FGDATA *, FUNC *));
@@ -388,6 +395,562 @@ static int csoundCheckOpcodeDeny(CSOUND * csound, const char *fname)
     return 0;
 }
 
+/* ------------------------------------------------------------------------ */
+
+/* Plugin manifest.  For each plugin directory a text file in the user's
+ * cache directory lists the libraries found there by name, modification
+ * time and size.  Libraries that only export a static opcode table
+ * (csound_opcode_init() and neither csoundModuleCreate() nor
+ * csound_fgen_init()) are listed together with their opcodes; on later
+ * runs stubs carrying the listed names and types are registered instead
+ * of opening the library, and the library is opened when the parser
+ * first looks up one of its opcodes (csoundLoadDeferredOpcode()).  All
+ * other libraries are opened at startup as before.  The environment
+ * variable CS_PLUGIN_CACHE selects the cache directory, or turns the
+ * manifest off when set to 0.
+ */
+
+static  const   char    *plugincache_envvar = "CS_PLUGIN_CACHE";
+
+typedef struct lazyStub_s {
+    OENTRY      e;                          /* entry in csound->opcodes      */
+    struct lazyModule_s *mod;               /* library providing the opcode  */
+    struct lazyStub_s   *nxt;
+    CONS_CELL   *cell, *tail;               /* set while the library loads   */
+} lazyStub_t;
+
+typedef struct lazyModule_s {
+    struct lazyModule_s *nxt;
+    lazyStub_t  *stubs;                     /* NULL once the library is open */
+    csoundModule_t *after;                  /* csmodule_db when deferred     */
+    int         listed;                     /* stubs are in csound->opcodes  */
+    char        path[1];
+} lazyModule_t;
+
+typedef struct manifestLib_s {
+    struct manifestLib_s *nxt;
+    char        *name;                      /* these point into the text     */
+    char        *ops;                       /*   read from the manifest file */
+    size_t      opslen;
+    long long   mtime, size;
+    int         lazy, used;
+} manifestLib_t;
+
+typedef struct manifest_s {
+    char        *path;                      /* NULL if there is no manifest  */
+    char        *text;
+    manifestLib_t *libs;
+    char        *out;                       /* manifest for this run         */
+    size_t      outlen, outsize;
+    int         dirty;
+} manifest_t;
+
+static int deferred_opcode(CSOUND *csound, void *p)
+{
+    return csound->InitError(csound, Str("%s: plugin library not loaded"),
+                             ((OPDS*) p)->optext->t.opcod);
+}
+
+static void manifest_header(char *buf, size_t n)
+{
+    snprintf(buf, n, "csound plugin manifest 1 %d %d.%d\n",
+             (int) sizeof(MYFLT), CS_APIVERSION, CS_APISUBVER);
+}
+
+static void make_dirs(char *path)
+{
+    char    *s;
+
+    for (s = path + 1; ; s++) {
+      if (*s == DIRSEP || *s == '\0') {
+        char  c = *s;
+        *s = '\0';
+#if defined(WIN32) && !defined(__CYGWIN__)
+        _mkdir(path);
+#else
+        mkdir(path, 0755);
+#endif
+        *s = c;
+        if (c == '\0')
+          break;
+      }
+    }
+}
+
+static char *manifest_path(CSOUND *csound, const char *dname)
+{
+    const char    *dir = getenv(plugincache_envvar), *s;
+    char          *path, *e;
+    unsigned int  h = 2166136261U;          /* FNV-1a of the directory name */
+    size_t        n;
+
+    if (dir != NULL && strcmp(dir, "0") == 0)
+      return NULL;
+    for (s = dname; *s != '\0'; s++)
+      h = (h ^ (unsigned char) *s) * 16777619U;
+    if (dir != NULL && dir[0] != '\0') {
+      n = strlen(dir) + 40;
+      path = (char*) csound->Malloc(csound, n);
+      snprintf(path, n, "%s", dir);
+    }
+    else if ((dir = getenv("XDG_CACHE_HOME")) != NULL && dir[0] != '\0') {
+      n = strlen(dir) + 48;
+      path = (char*) csound->Malloc(csound, n);
+      snprintf(path, n, "%s%ccsound", dir, DIRSEP);
+    }
+    else if ((dir = getenv("HOME")) != NULL && dir[0] != '\0') {
+      n = strlen(dir) + 56;
+      path = (char*) csound->Malloc(csound, n);
+      snprintf(path, n, "%s%c.cache%ccsound", dir, DIRSEP, DIRSEP);
+    }
+    else
+      return NULL;
+    make_dirs(path);
+    e = path + strlen(path);
+    snprintf(e, n - (size_t) (e - path), "%copcodes-%08x-%d.manifest",
+             DIRSEP, h, (int) sizeof(MYFLT) * 8);
+    return path;
+}
+
+static void manifest_read(CSOUND *csound, manifest_t *mf)
+{
+    FILE          *f;
+    long          n;
+    char          hdr[64], *s, *eol;
+    manifestLib_t *lib = NULL;
+
+    if ((f = fopen(mf->path, "rb")) == NULL)
+      return;
+    if (fseek(f, 0L, SEEK_END) != 0 || (n = ftell(f)) <= 0L ||
+        fseek(f, 0L, SEEK_SET) != 0) {
+      fclose(f);
+      return;
+    }
+    mf->text = (char*) csound->Malloc(csound, (size_t) n + 1);
+    n = (long) fread(mf->text, 1, (size_t) n, f);
+    fclose(f);
+    mf->text[n] = '\0';
+    manifest_header(hdr, sizeof(hdr));
+    if (strncmp(mf->text, hdr, strlen(hdr)) != 0)
+      return;                               /* other version: rebuild it    */
+    for (s = mf->text + strlen(hdr); *s != '\0'; s = eol + 1) {
+      if ((eol = strchr(s, '\n')) == NULL)
+        break;                              /* truncated, ignore last line  */
+      if ((s[0] == 'L' || s[0] == 'E') && s[1] == ' ') {
+        lib = (manifestLib_t*) csound->Calloc(csound, sizeof(manifestLib_t));
+        lib->lazy = (s[0] == 'L');
+        lib->mtime = strtoll(s + 2, &s, 10);
+        lib->size = strtoll(s, &s, 10);
+        lib->name = s + 1;
+        *eol = '\0';
+        lib->ops = eol + 1;
+        lib->nxt = mf->libs;
+        mf->libs = lib;
+      }
+      else if (s[0] == 'o' && lib != NULL)
+        lib->opslen = (size_t) (eol + 1 - lib->ops);
+      else
+        lib = NULL;
+    }
+}
+
+static void manifest_put(CSOUND *csound, manifest_t *mf,
+                         const char *s, size_t n)
+{
+    if (mf->outlen + n + 1 > mf->outsize) {
+      mf->outsize = (mf->outlen + n + 1) * 2;
+      mf->out = (char*) csound->ReAlloc(csound, mf->out, mf->outsize);
+    }
+    memcpy(mf->out + mf->outlen, s, n);
+    mf->outlen += n;
+}
+
+static void manifest_put_lib(CSOUND *csound, manifest_t *mf, int lazy,
+                             const struct stat *st, const char *fname)
+{
+    char    buf[1024];
+    int     n;
+
+    n = snprintf(buf, sizeof(buf), "%c %lld %lld %s\n", lazy ? 'L' : 'E',
+                 (long long) st->st_mtime, (long long) st->st_size, fname);
+    manifest_put(csound, mf, buf, (size_t) n);
+}
+
+/* list the opcodes of a library just opened; returns non-zero if the
+   library cannot be deferred */
+
+static int manifest_put_ops(CSOUND *csound, manifest_t *mf,
+                            csoundModule_t *m)
+{
+    OENTRY  *ep;
+    long    i, n;
+    char    buf[1024];
+
+    if (m->PreInitFunc != NULL || m->fn.o.opcode_init == NULL ||
+        m->fn.o.fgen_init != NULL)
+      return -1;
+    n = m->fn.o.opcode_init(csound, &ep) / (long) sizeof(OENTRY);
+    for (i = 0; i < n && ep[i].opname != NULL; i++) {
+      int len = snprintf(buf, sizeof(buf), "o %u %u %u %s %s%s %s%s\n",
+                         (unsigned) ep[i].dsblksiz, (unsigned) ep[i].flags,
+                         (unsigned) ep[i].thread, ep[i].opname,
+                         ep[i].outypes ? ":" : "-",
+                         ep[i].outypes ? ep[i].outypes : "",
+                         ep[i].intypes ? ":" : "-",
+                         ep[i].intypes ? ep[i].intypes : "");
+      if (len >= (int) sizeof(buf) || strchr(buf + 2, '\n') != buf + len - 1 ||
+          strchr(ep[i].opname, ' ') != NULL ||
+          (ep[i].outypes && strchr(ep[i].outypes, ' ') != NULL) ||
+          (ep[i].intypes && strchr(ep[i].intypes, ' ') != NULL))
+        return -1;
+      manifest_put(csound, mf, buf, (size_t) len);
+    }
+    return 0;
+}
+
+static void manifest_write(CSOUND *csound, manifest_t *mf)
+{
+    FILE    *f;
+    char    hdr[64], *tmp;
+    size_t  n = strlen(mf->path) + 48;
+
+    /* the instance is part of the name, as several may share a process */
+    tmp = (char*) csound->Malloc(csound, n);
+    snprintf(tmp, n, "%s.%d.%p", mf->path, (int) GETPID(), (void*) csound);
+    if ((f = fopen(tmp, "wb")) != NULL) {
+      manifest_header(hdr, sizeof(hdr));
+      fputs(hdr, f);
+      if (mf->outlen)
+        fwrite(mf->out, 1, mf->outlen, f);
+      if (fclose(f) == 0) {
+#if defined(WIN32)
+        remove(mf->path);
+#endif
+        if (rename(tmp, mf->path) == 0) {
+          if (UNLIKELY(csound->oparms->odebug))
+            csound->Message(csound, Str("Wrote plugin manifest %s\n"),
+                            mf->path);
+          csound->Free(csound, tmp);
+          return;
+        }
+      }
+      remove(tmp);
+    }
+    csound->Free(csound, tmp);
+}
+
+static void manifest_free(CSOUND *csound, manifest_t *mf)
+{
+    while (mf->libs != NULL) {
+      manifestLib_t *nxt = mf->libs->nxt;
+      csound->Free(csound, mf->libs);
+      mf->libs = nxt;
+    }
+    if (mf->text != NULL) csound->Free(csound, mf->text);
+    if (mf->out != NULL) csound->Free(csound, mf->out);
+    if (mf->path != NULL) csound->Free(csound, mf->path);
+    memset(mf, 0, sizeof(manifest_t));
+}
+
+/* build a stub from an "o" line of the manifest */
+
+static lazyStub_t *stub_parse(CSOUND *csound, const char *s, const char *end)
+{
+    char        buf[1024], *tok[7], *p;
+    int         i;
+    size_t      n = (size_t) (end - s);
+    lazyStub_t  *stub;
+
+    if (n >= sizeof(buf))
+      return NULL;
+    memcpy(buf, s, n);
+    buf[n] = '\0';
+    for (i = 0, p = buf; i < 7; i++) {
+      tok[i] = p;
+      if ((p = strchr(p, ' ')) == NULL)
+        break;
+      *p++ = '\0';
+    }
+    if (i != 6 || (tok[5][0] != ':' && tok[5][0] != '-') ||
+        (tok[6][0] != ':' && tok[6][0] != '-'))
+      return NULL;
+    n = strlen(tok[4]) + strlen(tok[5]) + strlen(tok[6]) + 3;
+    stub = (lazyStub_t*) csound->Calloc(csound, sizeof(lazyStub_t) + n);
+    p = (char*) (stub + 1);
+    stub->e.opname = strcpy(p, tok[4]);
+    p += strlen(p) + 1;
+    if (tok[5][0] == ':') {
+      stub->e.outypes = strcpy(p, tok[5] + 1);
+      p += strlen(p) + 1;
+    }
+    if (tok[6][0] == ':')
+      stub->e.intypes = strcpy(p, tok[6] + 1);
+    stub->e.dsblksiz = (uint16) strtoul(tok[1], NULL, 10);
+    stub->e.flags = (uint16) strtoul(tok[2], NULL, 10);
+    stub->e.thread = (uint8_t) strtoul(tok[3], NULL, 10);
+    stub->e.iopadr = stub->e.kopadr = stub->e.aopadr = deferred_opcode;
+    return stub;
+}
+
+/* make stubs for the opcodes of a library listed as deferrable; they are
+   put in the opcode lists by csoundInitModules() */
+
+static int defer_module(CSOUND *csound, const char *path, manifestLib_t *lib)
+{
+    lazyModule_t  *mod;
+    lazyStub_t    *stub, *stubs = NULL, **tail = &stubs;
+    const char    *s = lib->ops, *end = lib->ops + lib->opslen;
+
+    while (s < end) {
+      const char  *eol = strchr(s, '\n');
+      if ((stub = stub_parse(csound, s, eol)) == NULL) {
+        while (stubs != NULL) {
+          stub = stubs->nxt;
+          csound->Free(csound, stubs);
+          stubs = stub;
+        }
+        return -1;
+      }
+      *tail = stub;
+      tail = &(stub->nxt);
+      s = eol + 1;
+      csound->startup.nstub++;
+    }
+    mod = (lazyModule_t*) csound->Malloc(csound,
+                                         sizeof(lazyModule_t) + strlen(path));
+    strcpy(&(mod->path[0]), path);
+    mod->stubs = stubs;
+    mod->after = (csoundModule_t*) csound->csmodule_db;
+    mod->listed = 0;
+    mod->nxt = (lazyModule_t*) csound->lazymodule_db;
+    csound->lazymodule_db = (void*) mod;
+    for (stub = stubs; stub != NULL; stub = stub->nxt)
+      stub->mod = mod;
+    csound->startup.ndefer++;
+    return 0;
+}
+
+/* append the stubs of a deferred library to the opcode lists, as
+   csoundInitModule() appends the entries of a library it opened */
+
+static void list_stubs(CSOUND *csound, lazyModule_t *mod)
+{
+    lazyStub_t  *stub;
+
+    if (mod->listed)
+      return;
+    mod->listed = 1;
+    for (stub = mod->stubs; stub != NULL; stub = stub->nxt) {
+      char      *shortName = get_opcode_short_name(csound, stub->e.opname);
+      CONS_CELL *head = cs_hash_table_get(csound, csound->opcodes, shortName);
+      if (head != NULL)
+        cs_cons_append(head, cs_cons(csound, stub, NULL));
+      else
+        cs_hash_table_put(csound, csound->opcodes, shortName,
+                          cs_cons(csound, stub, NULL));
+      if (shortName != stub->e.opname)
+        csound->Free(csound, shortName);
+    }
+}
+
+static int load_timed(CSOUND *csound, const char *path)
+{
+    RTCLOCK clk;
+    int     err;
+
+    csoundInitTimerStruct(&clk);
+    err = csoundLoadExternal(csound, path);
+    csound->startup.open += csoundGetRealTime(&clk);
+    csound->startup.nopen++;
+    return err;
+}
+
+/* load a plugin library found in a plugin directory, or defer it if
+   the manifest allows */
+
+static int load_with_manifest(CSOUND *csound, manifest_t *mf,
+                              const char *path, const char *fname)
+{
+    struct stat   st;
+    manifestLib_t *lib;
+    void          *head;
+    size_t        mark;
+    int           err;
+
+    if (mf->path == NULL || stat(path, &st) != 0)
+      return load_timed(csound, path);
+    for (lib = mf->libs; lib != NULL; lib = lib->nxt)
+      if (!lib->used && lib->mtime == (long long) st.st_mtime &&
+          lib->size == (long long) st.st_size && strcmp(lib->name, fname) == 0)
+        break;
+    if (lib != NULL) {
+      lib->used = 1;
+      if (!lib->lazy) {
+        manifest_put_lib(csound, mf, 0, &st, fname);
+        return load_timed(csound, path);
+      }
+      if (defer_module(csound, path, lib) == 0) {
+        manifest_put_lib(csound, mf, 1, &st, fname);
+        manifest_put(csound, mf, lib->ops, lib->opslen);
+        return CSOUND_SUCCESS;
+      }
+    }
+    /* new or changed library: open it and record what it is */
+    mf->dirty = 1;
+    head = csound->csmodule_db;
+    err = load_timed(csound, path);
+    mark = mf->outlen;
+    if (err == CSOUND_SUCCESS && csound->csmodule_db != head) {
+      manifest_put_lib(csound, mf, 1, &st, fname);
+      if (manifest_put_ops(csound, mf,
+                           (csoundModule_t*) csound->csmodule_db) == 0)
+        return err;
+      mf->outlen = mark;
+    }
+    manifest_put_lib(csound, mf, 0, &st, fname);
+    return err;
+}
+
+/* s, or "" for a missing type string */
+#define TYPES(s)  ((s) != NULL ? (s) : "")
+
+/* open a deferred library and replace its stubs by the real entries */
+
+static void load_deferred(CSOUND *csound, lazyModule_t *mod)
+{
+    lazyStub_t  *stubs = mod->stubs, *stub;
+    RTCLOCK     clk;
+    int         err;
+
+    mod->stubs = NULL;
+    /* the library appends its entries to the opcode lists; note where
+       each stub and the end of its list are, so that the entries can be
+       put where the stubs were and overloads resolve as they would had
+       the library been opened at startup */
+    for (stub = stubs; stub != NULL; stub = stub->nxt) {
+      char      *shortName = get_opcode_short_name(csound, stub->e.opname);
+      CONS_CELL *c = cs_hash_table_get(csound, csound->opcodes, shortName);
+
+      stub->cell = stub->tail = NULL;
+      for ( ; c != NULL; c = c->next) {
+        if (c->value == (void*) stub)
+          stub->cell = c;
+        stub->tail = c;
+      }
+      if (shortName != stub->e.opname)
+        csound->Free(csound, shortName);
+    }
+    csoundInitTimerStruct(&clk);
+    err = csoundLoadAndInitModule(csound, mod->path);
+    csound->startup.deferred += csoundGetRealTime(&clk);
+    csound->startup.nlate++;
+    if (UNLIKELY(err != CSOUND_SUCCESS))
+      csound->Warning(csound, Str("could not load plugin library '%s'"),
+                      mod->path);
+    else if (UNLIKELY(csound->oparms->odebug))
+      csound->Message(csound, Str("Loaded deferred plugin library '%s'\n"),
+                      mod->path);
+    /* move each new entry into the cell of its stub; only cells after
+       the old ends of the lists are unlinked, so the ends stay valid */
+    for (stub = stubs; stub != NULL; stub = stub->nxt) {
+      CONS_CELL *c, *prv = stub->tail;
+
+      if (stub->cell == NULL)
+        continue;
+      for (c = prv->next; c != NULL; prv = c, c = c->next) {
+        OENTRY  *ep = (OENTRY*) c->value;
+        if (strcmp(ep->opname, stub->e.opname) == 0 &&
+            strcmp(TYPES(ep->outypes), TYPES(stub->e.outypes)) == 0 &&
+            strcmp(TYPES(ep->intypes), TYPES(stub->e.intypes)) == 0)
+          break;
+      }
+      if (c != NULL) {
+        stub->cell->value = c->value;
+        prv->next = c->next;
+        csound->Free(csound, c);
+        stub->cell = NULL;
+      }
+    }
+    /* drop the stubs the library did not provide */
+    while (stubs != NULL) {
+      lazyStub_t  *nxt = stubs->nxt;
+
+      if (stubs->cell != NULL) {
+        char      *shortName = get_opcode_short_name(csound,
+                                                     stubs->e.opname);
+        CONS_CELL *head = cs_hash_table_get(csound, csound->opcodes,
+                                            shortName);
+        CONS_CELL *c, *prv = NULL;
+
+        for (c = head; c != NULL && c->value != (void*) stubs; c = c->next)
+          prv = c;
+        if (c != NULL) {
+          if (prv != NULL)
+            prv->next = c->next;
+          else if (c->next != NULL) {       /* keep the head cell in place */
+            prv = c, c = c->next;
+            prv->value = c->value;
+            prv->next = c->next;
+          }
+          else
+            cs_hash_table_remove(csound, csound->opcodes, shortName);
+          csound->Free(csound, c);
+        }
+        if (shortName != stubs->e.opname)
+          csound->Free(csound, shortName);
+      }
+      csound->Free(csound, stubs);
+      stubs = nxt;
+    }
+}
+
+#undef TYPES
+
+/**
+ * Open the plugin libraries deferred by the plugin manifest that provide
+ * an opcode named 'shortName', so that the opcode list holds their real
+ * entries.  Called by the parser before looking up an opcode.
+ */
+void csoundLoadDeferredOpcode(CSOUND *csound, const char *shortName)
+{
+    CONS_CELL *c;
+
+    if (LIKELY(csound->lazymodule_db == NULL || csound->opcodes == NULL))
+      return;
+ again:
+    for (c = cs_hash_table_get(csound, csound->opcodes, (char*) shortName);
+         c != NULL; c = c->next) {
+      OENTRY  *ep = (OENTRY*) c->value;
+      if (ep->iopadr == deferred_opcode) {
+        load_deferred(csound, ((lazyStub_t*) ep)->mod);
+        goto again;
+      }
+    }
+}
+
+/**
+ * Print where the time between csoundReset() and csoundStart() went.
+ */
+void csoundPrintStartupTimes(CSOUND *csound)
+{
+    STARTUP_TIMES *t = &(csound->startup);
+
+    csound->Message(csound, Str("startup times (ms):\n"));
+    csound->Message(csound, Str("  plugin scan and manifest  %9.2f\n"),
+                    t->scan * 1000.0);
+    csound->Message(csound, Str("  plugin libraries opened   %9.2f  (%d)\n"),
+                    t->open * 1000.0, t->nopen);
+    csound->Message(csound, Str("  plugin initialisation     %9.2f\n"),
+                    t->init * 1000.0);
+    csound->Message(csound, Str("  deferred libraries opened %9.2f  "
+                                "(%d of %d, %d opcodes deferred)\n"),
+                    t->deferred * 1000.0, t->nlate, t->ndefer, t->nstub);
+    csound->Message(csound, Str("  orchestra compilation     %9.2f\n"),
+                    t->compile * 1000.0);
+    csound->Message(csound, Str("  total since reset         %9.2f\n"),
+                    csoundGetRealTime(&t->clock) * 1000.0);
+}
+
 /**
  * Load plugin libraries for Csound instance 'csound', and call
  * pre-initialisation functions.
@@ -405,6 +968,9 @@ int csoundLoadModules(CSOUND *csound)
     int             i, n, len, err = CSOUND_SUCCESS;
     char   *dname1, *end;
     int     read_directory = 1;
+    manifest_t  mf;
+    RTCLOCK     clk;
+    double      open0 = csound->startup.open;
     char sep =
 #ifdef WIN32
     ';';
@@ -414,6 +980,8 @@ int csoundLoadModules(CSOUND *csound)
 
     if (UNLIKELY(csound->csmodule_db != NULL))
       return CSOUND_ERROR;
+    csoundInitTimerStruct(&clk);
+    memset(&mf, 0, sizeof(manifest_t));
 
     /* open plugin directory */
     dname = csoundGetEnv(csound, (sizeof(MYFLT) == sizeof(float) ?
@@ -465,10 +1033,9 @@ int csoundLoadModules(CSOUND *csound)
 
     if(UNLIKELY(csound->oparms->odebug))
       csound->Message(csound, "Opening plugin directory: %s\n", dname1);
-    /* load database for deferred plugin loading */
-/*     n = csoundLoadOpcodeDB(csound, dname); */
-/*     if (n != 0) */
-/*       return n; */
+    /* load manifest for deferred plugin loading */
+    if ((mf.path = manifest_path(csound, dname1)) != NULL)
+      manifest_read(csound, &mf);
     /* scan all files in directory */
     while ((f = readdir(dir)) != NULL) {
       fname = &(f->d_name[0]);
@@ -505,19 +1072,29 @@ int csoundLoadModules(CSOUND *csound)
         csoundWarning(csound, Str("Library %s omitted\n"), fname);
         continue;
       }
-      snprintf(buf, 1024, "%s%c%s", dname, DIRSEP, fname);
+      snprintf(buf, 1024, "%s%c%s", dname1, DIRSEP, fname);
       if (UNLIKELY(csound->oparms->odebug)) {
         csoundMessage(csound, Str("Loading '%s'\n"), buf);
        }
-      n = csoundLoadExternal(csound, buf);
+      n = load_with_manifest(csound, &mf, buf, fname);
       if (UNLIKELY(UNLIKELY(n == CSOUND_ERROR)))
         continue;               /* ignore non-plugin files */
       if (UNLIKELY(n < err))
         err = n;                /* record serious errors */
     }
     closedir(dir);
+    if (mf.path != NULL) {
+      manifestLib_t *lib;
+      for (lib = mf.libs; lib != NULL && lib->used; lib = lib->nxt)
+        ;
+      if (mf.dirty || lib != NULL)          /* changed or removed libraries */
+        manifest_write(csound, &mf);
+      manifest_free(csound, &mf);
+    }
     csound->Free(csound, dname1);
     }
+    csound->startup.scan +=
+      csoundGetRealTime(&clk) - (csound->startup.open - open0);
     return (err == CSOUND_INITIALIZATION ? CSOUND_ERROR : err);
 #else
     return CSOUND_SUCCESS;
@@ -627,7 +1204,11 @@ static CS_NOINLINE int csoundInitModule(CSOUND *csound, csoundModule_t *m)
 int csoundInitModules(CSOUND *csound)
 {
     csoundModule_t  *m;
+    lazyModule_t    *lm;
     int             i, retval = CSOUND_SUCCESS;
+    RTCLOCK         clk;
+
+    csoundInitTimerStruct(&clk);
     /* For regular Csound, init_static_modules is not compiled or called.
      * For some builds of Csound, e.g. for PNaCl, init_static_modules is
      * compiled and called to initialize statically linked opcodes and other
@@ -636,12 +1217,19 @@ int csoundInitModules(CSOUND *csound)
 #if defined(INIT_STATIC_MODULES)
     retval = init_static_modules(csound);
 #endif
-    /* call init functions */
+    /* call init functions, newest library first; the stubs of deferred
+       libraries go in at the place their entries would have had */
+    lm = (lazyModule_t*) csound->lazymodule_db;
     for (m = (csoundModule_t*) csound->csmodule_db; m != NULL; m = m->nxt) {
+      for ( ; lm != NULL && lm->after == m; lm = lm->nxt)
+        list_stubs(csound, lm);
       i = csoundInitModule(csound, m);
       if (UNLIKELY(i != CSOUND_SUCCESS && i < retval))
         retval = i;
     }
+    for ( ; lm != NULL; lm = lm->nxt)
+      list_stubs(csound, lm);
+    csound->startup.init += csoundGetRealTime(&clk);
     /* return with error code */
     return retval;
 }
@@ -703,6 +1291,12 @@ int csoundDestroyModules(CSOUND *csound)
       csound->Free(csound, (void*) m);
 
     }
+    /* stubs still in the opcode list are freed with it */
+    while (csound->lazymodule_db != NULL) {
+      lazyModule_t  *lm = (lazyModule_t*) csound->lazymodule_db;
+      csound->lazymodule_db = (void*) lm->nxt;
+      csound->Free(csound, lm);
+    }
     sfont_ModuleDestroy(csound);
     /* return with error code */
     return retval;
@@ -67,6 +67,7 @@
 #include "csound_standard_types.h"
 
 #include "csdebug.h"
+#include "profile.h"
 #include <time.h>
 
 extern void allocate_message_queue(CSOUND *csound);
@@ -140,17 +141,14 @@ void print_csound_version(CSOUND* csound)
 }
 
 static void free_opcode_table(CSOUND* csound) {
-    int i;
-    CS_HASH_TABLE_ITEM* bucket;
-    CONS_CELL* head;
+    uint32_t i;
+    CS_HASH_TABLE_ITEM* item;
 
-    for (i = 0; i < HASH_SIZE; i++) {
-      bucket = csound->opcodes->buckets[i];
+    for (i = 0; i < csound->opcodes->size; i++) {
+      item = &csound->opcodes->items[i];
 
-      while (bucket != NULL) {
-        head = bucket->value;
-        cs_cons_free_complete(csound, head);
-        bucket = bucket->next;
+      if (item->key != NULL) {
+        cs_cons_free_complete(csound, item->value);
       }
     }
 
@@ -481,11 +479,13 @@ static const CSOUND cenviron_ = {
     csoundAuxAllocAsync,
     csoundGetHostData,
     strNcpy,
+    csoundInstanceAlloc,
+    csoundAuxTouched,
     {
       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-      NULL, NULL, NULL, NULL, NULL
+      NULL, NULL, NULL
     },
     /* ------- private data (not to be used by hosts or externals) ------- */
     /* callback function pointers */
@@ -595,7 +595,7 @@ static const CSOUND cenviron_ = {
     {0}, {0}, {0},  /*  maxpos, smaxpos, omaxpos */
     NULL, NULL,     /*  scorein, scoreout   */
     NULL,           /*  argoffspace         */
-    NULL,           /*  frstoff             */
+    NULL,           /*  turnoffs            */
     NULL,           /*  zkstart             */
     0L,             /*  zklast              */
     NULL,           /*  zastart             */
@@ -650,7 +650,7 @@ static const CSOUND cenviron_ = {
     NULL,
     NULL,
     NULL,
-    NULL,
+    {NULL, NULL, 0, 0.0, NULL},
     NULL,
     NULL,
     0,
@@ -684,6 +684,10 @@ static const CSOUND cenviron_ = {
    0,
    0,
    0,
+   0,
+   NULL,
+   NULL,
+   NULL,
     FL(0.0),
     NULL,
     NULL,
@@ -891,8 +895,11 @@ static const CSOUND cenviron_ = {
       0,            /*    no exit on compile error */
       0.4,          /*    vbr quality  */
       0,            /*    ksmps_override */
-      0,             /*    fft_lib */
-      0
+      -1,           /*    fft_lib: by size */
+      0,            /*    echo */
+      0,            /*    disk_buffers */
+      0,            /*    aux_zero_async */
+      0             /*    profile */
     },
 
     {0, 0, {0}}, /* REMOT_BUF */
@@ -948,10 +955,9 @@ static const CSOUND cenviron_ = {
     0,              /* tseglen */
     1,              /* inZero */
     NULL,           /* msg_queue */
-    0,              /* msg_queue_wget */
-    0,              /* msg_queue_wput */
-    0,              /* msg_queue_rstart */
-    0,              /* msg_queue_items */
+    0,              /* msg_queue_wpos */
+    0,              /* msg_queue_rpos */
+    NULL,           /* msg_slab */
     127,            /* aftouch */
     NULL,           /* directory for corfiles */
     NULL,           /* alloc_queue */
@@ -963,7 +969,22 @@ static const CSOUND cenviron_ = {
     NULL,             /* message_string */
     0,               /* message_string_queue_items */
     0,               /* message_string_queue_wp */
-    NULL              /* message_string_queue */
+    NULL,             /* message_string_queue */
+    NULL,             /* dag_sched */
+    NULL,             /* dag_prev_map */
+    NULL,             /* dag_prev_dep */
+    NULL,             /* dag_remap */
+    0,                /* dag_dep_bytes */
+    NULL,             /* dag_edge_cache */
+    0,                /* dag_edge_valid */
+    NULL,             /* chn_audio */
+    SPINLOCK_INIT,    /* chn_db_lock */
+    NULL,             /* actindex */
+    NULL,             /* memalloc_pool */
+    NULL,             /* auxpool */
+    NULL,             /* lazymodule_db */
+    NULL,             /* profile */
+    { { 0, 0 }, 0.0, 0.0, 0.0, 0.0, 0.0, 0, 0, 0, 0 }  /* startup */
     /*, NULL */           /* self-reference */
 };
 
@@ -1467,11 +1488,16 @@ inline void advanceINSDSPointer(INSDS ***start, int num)
 }
 
 int dag_get_task(CSOUND *csound, int index, int numThreads, int next_task);
-int dag_end_task(CSOUND *csound, int task);
+int dag_end_task(CSOUND *csound, int index, int task);
 void dag_build(CSOUND *csound, INSDS *chain);
 void dag_reinit(CSOUND *csound);
+void dag_sched_collect(CSOUND *csound);
+void chn_audio_pull(CSOUND *csound);
+void chn_audio_push(CSOUND *csound);
 
-inline static int nodePerf(CSOUND *csound, int index, int numThreads)
+/* prof (a constant) times the opcodes and instances, see profile.c */
+PROFILE_INLINE int nodePerf(CSOUND *csound, int index, int numThreads,
+                            const int prof)
 {
     INSDS *insds = NULL;
     OPDS  *opstart = NULL;
@@ -1482,13 +1508,12 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
 #define INVALID (-1)
 #define WAIT    (-2)
     int next_task = INVALID;
-    IGN(index);
 
     while (1) {
       int done;
+      /* blocks while other threads still hold work */
       which_task = dag_get_task(csound, index, numThreads, next_task);
       //printf("******** Select task %d\n", which_task);
-      if (which_task==WAIT) continue;
       if (which_task==INVALID) return played_count;
          /* VL: the validity of icurTime needs to be checked */
         time_end = (csound->ksmps+csound->icurTime)/csound->esr;
@@ -1505,6 +1530,8 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
         done = insds->init_done;
 #endif
         if (done) {
+          uint64_t t0 = prof ? profile_ticks() : 0;
+          int error;
           opstart = (OPDS*)task_map[which_task];
           if (insds->ksmps == csound->ksmps) {
             insds->spin = csound->spin;
@@ -1513,7 +1540,7 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
             while ((opstart = opstart->nxtp) != NULL) {
               /* In case of jumping need this repeat of opstart */
               opstart->insdshead->pds = opstart;
-              (*opstart->opadr)(csound, opstart); /* run each opcode */
+              PROFILE_PERF(csound, prof, opstart, error); /* run each opcode */
               opstart = opstart->insdshead->pds;
             }
           } else {
@@ -1545,41 +1572,24 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
               opstart = (OPDS*) insds;
               while ((opstart = opstart->nxtp) != NULL) {
                 opstart->insdshead->pds = opstart;
-                (*opstart->opadr)(csound, opstart); /* run each opcode */
+                PROFILE_PERF(csound, prof, opstart, error); /* run each opcode */
                 opstart = opstart->insdshead->pds;
               }
               insds->kcounter++;
             }
           }
+          (void) error;
+          if (prof) profile_instr(csound, insds, profile_ticks() - t0, 0);
           insds->ksmps_offset = 0; /* reset sample-accuracy offset */
           insds->ksmps_no_end = 0;  /* reset end of loop samples */
           played_count++;
         }
         //printf("******** finished task %d\n", which_task);
-        next_task = dag_end_task(csound, which_task);
+        next_task = dag_end_task(csound, index, which_task);
     }
     return played_count;
 }
 
-inline static void make_interleave(CSOUND *csound)
-{
-    uint32_t nsmps = csound->ksmps, i, j, k=0;
-    MYFLT *spout = csound->spout;
-
-    if (!csound->spoutactive) {
-      memset(spout, '\0', csound->nspout*sizeof(MYFLT));
-    }
-    else {
-      for (j=0; j<nsmps; j++) {
-        for (i=0; i<csound->nchnls; i++) {
-          // Will be copy t ad when complette
-          spout[k + i] = csound->spraw[i*nsmps+j];
-        }
-        k += csound->nchnls;
-      }
-    }
-}
-
 
 unsigned long kperfThread(void * cs)
 {
@@ -1623,13 +1633,17 @@ unsigned long kperfThread(void * cs)
       }
       /*csound_global_mutex_unlock();*/
 
-      nodePerf(csound, index, numThreads);
+      if (UNLIKELY(csound->profile != NULL))
+        nodePerf(csound, index, numThreads, 1);
+      else
+        nodePerf(csound, index, numThreads, 0);
 
       csound->WaitBarrier(csound->barrier2);
     }
 }
 
-int kperf_nodebug(CSOUND *csound)
+/* prof (a constant) times the opcodes and instances, see profile.c */
+PROFILE_INLINE int kperf_run(CSOUND *csound, const int prof)
 {
     INSDS *ip;
     /* update orchestra time */
@@ -1639,7 +1653,8 @@ int kperf_nodebug(CSOUND *csound)
 
    /* call message_dequeue to run API calls */
     message_dequeue(csound);
-
+    /* pick up audio written by the host through channel handles */
+    if (csound->chn_audio != NULL) chn_audio_pull(csound);
 
     /* if skipping time on request by 'a' score statement: */
     if (UNLIKELY(UNLIKELY(csound->advanceCnt))) {
@@ -1660,8 +1675,7 @@ int kperf_nodebug(CSOUND *csound)
     if (csound->oparms_.sfread)         /*   if audio_infile open  */
       csound->spinrecv(csound);         /*      fill the spin buf  */
     csound->spoutactive = 0;            /*   make spout inactive   */
-    /* clear spout */
-    memset(csound->spout, 0, csound->nspout*sizeof(MYFLT));
+    /* clear spraw; spoutran rewrites all of spout */
     memset(csound->spraw, 0, csound->nspout*sizeof(MYFLT));
     ip = csound->actanchor.nxtact;
 
@@ -1675,11 +1689,12 @@ int kperf_nodebug(CSOUND *csound)
         /* process this partition */
         csound->WaitBarrier(csound->barrier1);
 
-        (void) nodePerf(csound, 0, 1);
+        (void) nodePerf(csound, 0, 1, prof);
 
         /* wait until partition is complete */
         csound->WaitBarrier(csound->barrier2);
         csound->multiThreadedDag = NULL;
+        dag_sched_collect(csound);
       }
       else {
         int done;
@@ -1699,6 +1714,7 @@ int kperf_nodebug(CSOUND *csound)
           done = ATOMIC_GET(ip->init_done);
           if (done == 1) {/* if init-pass has been done */
             int error = 0;
+            uint64_t t0 = prof ? profile_ticks() : 0;
             OPDS  *opstart = (OPDS*) ip;
             ip->spin = csound->spin;
             ip->spout = csound->spraw;
@@ -1708,7 +1724,7 @@ int kperf_nodebug(CSOUND *csound)
                      (opstart = opstart->nxtp) != NULL &&
                      ip->actflg) {
                 opstart->insdshead->pds = opstart;
-                error = (*opstart->opadr)(csound, opstart); /* run each opcode */
+                PROFILE_PERF(csound, prof, opstart, error); /* run each opcode */
                 opstart = opstart->insdshead->pds;
               }
             } else {
@@ -1742,12 +1758,13 @@ int kperf_nodebug(CSOUND *csound)
                   while (error ==  0 && (opstart = opstart->nxtp) != NULL
                          && ip->actflg) {
                     opstart->insdshead->pds = opstart;
-                    error = (*opstart->opadr)(csound, opstart); /* run each opcode */
+                    PROFILE_PERF(csound, prof, opstart, error); /* run each opcode */
                     opstart = opstart->insdshead->pds;
                   }
                   ip->kcounter++;
                 }
             }
+            if (prof) profile_instr(csound, ip, profile_ticks() - t0, 0);
           }
           /*else csound->Message(csound, "time %f\n",
                                  csound->kcounter/csound->ekr);*/
@@ -1758,12 +1775,11 @@ int kperf_nodebug(CSOUND *csound)
       }
     }
 
-    if (!csound->spoutactive) { /* results now in spout? */
-      memset(csound->spout, 0, csound->nspout * sizeof(MYFLT));
-      memset(csound->spraw, 0, csound->nspout * sizeof(MYFLT));
-    }
-    make_interleave(csound);
-    csound->spoutran(csound); /* send to audio_out */
+    /* interleave spraw into spout (zeros if !spoutactive) and send to
+       audio_out */
+    csound->spoutran(csound);
+    /* hand this cycle's audio channels over to host readers */
+    if (csound->chn_audio != NULL) chn_audio_push(csound);
     //#ifdef ANDROID
     //struct timespec ts;
     //clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -1773,6 +1789,23 @@ int kperf_nodebug(CSOUND *csound)
     return 0;
 }
 
+/* what this thread allocates in a k-cycle is counted against
+   performance, and what the host allocates in between is not */
+int kperf_nodebug(CSOUND *csound)
+{
+    int tag = memalloc_tag(CS_MEM_PERF), ret = kperf_run(csound, 0);
+    memalloc_tag(tag);
+    return ret;
+}
+
+/* kperf with --profile */
+int kperf_profile(CSOUND *csound)
+{
+    int tag = memalloc_tag(CS_MEM_PERF), ret = kperf_run(csound, 1);
+    memalloc_tag(tag);
+    return ret;
+}
+
 static inline void opcode_perf_debug(CSOUND *csound,
                                      csdebug_data_t *data, INSDS *ip)
 {
@@ -1851,13 +1884,14 @@ static inline void process_debug_buffers(CSOUND *csound, csdebug_data_t *data)
     }
 }
 
-int kperf_debug(CSOUND *csound)
+static int kperf_debug_run(CSOUND *csound)
 {
     INSDS *ip;
     csdebug_data_t *data = (csdebug_data_t *) csound->csdebug_data;
 
     /* call message_dequeue to run API calls */
     message_dequeue(csound);
+    if (csound->chn_audio != NULL) chn_audio_pull(csound);
 
     if (!data || data->status != CSDEBUG_STATUS_STOPPED) {
       /* update orchestra time */
@@ -1891,8 +1925,7 @@ int kperf_debug(CSOUND *csound)
       if (csound->oparms_.sfread)         /*   if audio_infile open  */
         csound->spinrecv(csound);         /*      fill the spin buf  */
       csound->spoutactive = 0;            /*   make spout inactive   */
-      /* clear spout */
-      memset(csound->spout, 0, csound->nspout*sizeof(MYFLT));
+      /* clear spraw; spoutran rewrites all of spout */
       memset(csound->spraw, 0, csound->nspout*sizeof(MYFLT));
     }
 
@@ -1930,11 +1963,12 @@ int kperf_debug(CSOUND *csound)
         /* process this partition */
         csound->WaitBarrier(csound->barrier1);
 
-        (void) nodePerf(csound, 0, 1);
+        (void) nodePerf(csound, 0, 1, 0);
 
         /* wait until partition is complete */
         csound->WaitBarrier(csound->barrier2);
         csound->multiThreadedDag = NULL;
+        dag_sched_collect(csound);
       }
       else {
         int done;
@@ -2040,17 +2074,19 @@ int kperf_debug(CSOUND *csound)
 
     if (!data || data->status != CSDEBUG_STATUS_STOPPED)
     {
-    if (!csound->spoutactive) {             /*   results now in spout? */
-      memset(csound->spout, 0, csound->nspout * sizeof(MYFLT));
-      memset(csound->spraw, 0, csound->nspout * sizeof(MYFLT));
-    }
-    else
-      make_interleave(csound);
     csound->spoutran(csound);               /*      send to audio_out  */
+    if (csound->chn_audio != NULL) chn_audio_push(csound);
     }
     return 0;
 }
 
+int kperf_debug(CSOUND *csound)
+{
+    int tag = memalloc_tag(CS_MEM_PERF), ret = kperf_debug_run(csound);
+    memalloc_tag(tag);
+    return ret;
+}
+
 
 int csoundReadScoreInternal(CSOUND *csound, const char *str)
 {
@@ -3224,6 +3260,7 @@ static void reset(CSOUND *csound)
     /* delete temporary files created by this Csound instance */
     remove_tmpfiles(csound);
     rlsmemfiles(csound);
+    auxRESET(csound);
 
      while (csound->filedir[n])        /* Clear source directory */
        csound->Free(csound,csound->filedir[n++]);
@@ -3340,9 +3377,11 @@ PUBLIC void csoundReset(CSOUND *csound)
      csoundSpinLockInit(&csound->spinlock);
      csoundSpinLockInit(&csound->memlock);
      csoundSpinLockInit(&csound->spinlock1);
+     csoundSpinLockInit(&csound->chn_db_lock);
      if (UNLIKELY(O->odebug))
         csound->Message(csound,"init spinlocks\n");
     }
+    csoundInitTimerStruct(&csound->startup.clock);
 
     if (msgcallback_ != NULL) {
       csoundSetMessageCallback(csound, msgcallback_);
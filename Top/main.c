@@ -493,6 +493,8 @@ PUBLIC int csoundStart(CSOUND *csound) // DEBUG
       csoundUDPServerStart(csound,csound->oparms->daemon);
 
     allocate_message_queue(csound); /* if de-alloc by reset */
+    if (UNLIKELY(O->odebug))
+      csoundPrintStartupTimes(csound);
     return musmon(csound);
 }
 
@@ -177,14 +177,39 @@ typedef struct barrier {
 #endif
 #endif
 
+typedef struct {
+    uintptr_t   (*func)(void *);
+    void        *userdata;
+} threadParams;
+
+static void *threadRoutineWrapper(void *p)
+{
+    threadParams  params = *((threadParams*) p);
+    uintptr_t     retval;
+
+    free(p);
+    retval = params.func(params.userdata);
+    memalloc_thread_exit();
+    return (void*) retval;
+}
+
 PUBLIC void *csoundCreateThread(uintptr_t (*threadRoutine)(void *),
                                 void *userdata)
 {
     pthread_t *pthread = (pthread_t *) malloc(sizeof(pthread_t));
+    threadParams *p = (threadParams *) malloc(sizeof(threadParams));
+    if (pthread == NULL || p == NULL) {
+      free(p);
+      free(pthread);
+      return NULL;
+    }
+    p->func = threadRoutine;
+    p->userdata = userdata;
     if (!pthread_create(pthread, (pthread_attr_t*) NULL,
-                        (void *(*)(void *)) threadRoutine, userdata)) {
+                        threadRoutineWrapper, (void*) p)) {
       return (void*) pthread;
     }
+    free(p);
     free(pthread);
     return NULL;
 
@@ -556,6 +581,13 @@ PUBLIC void csoundCondSignal(void* condVar) {
         pthread_cond_signal(condVar);
 }
 
+PUBLIC void csoundDestroyCondVar(void* condVar) {
+  if (condVar != NULL) {
+    pthread_cond_destroy((pthread_cond_t*) condVar);
+    free(condVar);
+  }
+}
+
 /* ------------------------------------------------------------------------ */
 
 #elif defined(WIN32)
@@ -577,11 +609,14 @@ static unsigned int __stdcall threadRoutineWrapper(void *p)
 {
   uintptr_t (*threadRoutine)(void *);
   void      *userData;
+  uintptr_t retval;
 
   threadRoutine = ((threadParams*) p)->func;
   userData = ((threadParams*) p)->userdata;
   SetEvent(((threadParams*) p)->threadLock);
-  return (unsigned int) threadRoutine(userData);
+  retval = threadRoutine(userData);
+  memalloc_thread_exit();
+  return (unsigned int) retval;
 }
 
 PUBLIC void *csoundCreateThread(uintptr_t (*threadRoutine)(void *),
@@ -781,6 +816,10 @@ PUBLIC void csoundCondSignal(void* condVar) {
     WakeConditionVariable(cv);
 }
 
+PUBLIC void csoundDestroyCondVar(void* condVar) {
+    free(condVar);
+}
+
 // REMOVE FOLLOWING BARRIER DEFINITION WINDOWS SUPPORT LIMITED to WIN 8.1+
 typedef struct barrier {
     CRITICAL_SECTION* mut;
@@ -960,6 +999,9 @@ PUBLIC void csoundCondSignal(void* condVar) {
  // notImplementedWarning_("csoundCreateCondSignal");
 }
 
+PUBLIC void csoundDestroyCondVar(void* condVar) {
+}
+
 PUBLIC long csoundRunCommand(const char * const *argv, int noWait) {
   //notImplementedWarning_("csoundRunCommand");
     return 0;
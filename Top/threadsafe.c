@@ -53,27 +53,73 @@ void set_channel_data_ptr(CSOUND *csound, const char *name,
 enum {INPUT_MESSAGE=1, READ_SCORE, SCORE_EVENT, SCORE_EVENT_ABS,
       TABLE_COPY_OUT, TABLE_COPY_IN, TABLE_SET, MERGE_STATE, KILL_INSTANCE};
 
-/* MAX QUEUE SIZE */
+/* MAX QUEUE SIZE (must be a power of two) */
 #define API_MAX_QUEUE 1024
 /* ARG LIST ALIGNMENT */
 #define ARG_ALIGN 8
-
-/* Message queue structure */
+/* bytes of arguments stored inside each queue slot */
+#define API_INLINE_ARGS 128
+/* larger arguments spill into chunks of a preallocated slab */
+#define API_SLAB_CHUNKS 64
+#define API_SLAB_CHUNK  4096
+
+enum {SPILL_NONE=0, SPILL_SLAB, SPILL_HEAP};
+
+/* Message queue structure.
+   The queue is a bounded multi-producer, single-consumer ring in the
+   style of D. Vyukov: each slot carries a sequence number telling
+   producers and the consumer whose turn it is, so no locks are taken
+   and nothing is allocated for messages that fit in the slot. */
 typedef struct _message_queue {
-  int64_t message;  /* message id */
-  char *args;   /* args, arg pointers */
-  int64_t rtn;  /* return value */
+  volatile long seq;       /* ring sequence number */
+  int32_t message;         /* message id */
+  int32_t spill;           /* where args live, SPILL_* */
+  long    chunk;           /* slab chunk index for SPILL_SLAB */
+  char   *args;            /* args, arg pointers */
+  char    inline_args[API_INLINE_ARGS];
 } message_queue_t;
 
+/* Free slab chunks are kept in a second ring of indices.  Producers
+   take chunks and only the consumer returns them. */
+typedef struct {
+  volatile long seq;
+  long chunk;
+} slab_cell_t;
+
+typedef struct {
+  char *mem;
+  volatile long head, tail;
+  slab_cell_t cells[API_SLAB_CHUNKS];
+} message_slab_t;
 
-/* atomicGetAndIncrementWithModulus */
-static long atomicGet_Incr_Mod(volatile long* val, long mod) {
-  volatile long oldVal, newVal;
-  do {
-    oldVal = *val;
-    newVal = (oldVal + 1) % mod;
-  } while (ATOMIC_CMP_XCH(val, newVal, oldVal));
-  return oldVal;
+static long slab_get(message_slab_t *s)
+{
+  long pos = ATOMIC_LOAD_ACQ(s->head);
+  while (1) {
+    slab_cell_t *cell = &s->cells[pos & (API_SLAB_CHUNKS-1)];
+    long dif = ATOMIC_LOAD_ACQ(cell->seq) - (pos + 1);
+    if (dif == 0) {
+      long next = pos + 1;
+      if (!ATOMIC_CMP_XCH(&s->head, next, pos)) {
+        long chunk = cell->chunk;
+        ATOMIC_STORE_REL(cell->seq, pos + API_SLAB_CHUNKS);
+        return chunk;
+      }
+    }
+    else if (dif < 0) return -1;        /* no free chunk */
+    pos = ATOMIC_LOAD_ACQ(s->head);
+  }
+}
+
+/* only called by the consumer, and there can never be more chunks
+   in use than exist, so the cell is always ready */
+static void slab_put(message_slab_t *s, long chunk)
+{
+  long pos = s->tail;
+  slab_cell_t *cell = &s->cells[pos & (API_SLAB_CHUNKS-1)];
+  cell->chunk = chunk;
+  s->tail = pos + 1;
+  ATOMIC_STORE_REL(cell->seq, pos + 1);
 }
 
 /* called by csoundCreate() at the start
@@ -82,45 +128,89 @@ static long atomicGet_Incr_Mod(volatile long* val, long mod) {
 */
 void allocate_message_queue(CSOUND *csound) {
   if (csound->msg_queue == NULL) {
-    int i;
-    csound->msg_queue = (message_queue_t **)
-      csound->Calloc(csound, sizeof(message_queue_t*)*API_MAX_QUEUE);
-    for (i = 0; i < API_MAX_QUEUE; i++) {
-      csound->msg_queue[i] =
-        (message_queue_t*)
-        csound->Calloc(csound, sizeof(message_queue_t));
+    message_slab_t *slab;
+    long i;
+    csound->msg_queue = (message_queue_t *)
+      csound->Calloc(csound, sizeof(message_queue_t)*API_MAX_QUEUE);
+    for (i = 0; i < API_MAX_QUEUE; i++)
+      csound->msg_queue[i].seq = i;
+    csound->msg_queue_wpos = csound->msg_queue_rpos = 0;
+    slab = (message_slab_t *) csound->Calloc(csound, sizeof(message_slab_t));
+    slab->mem = (char *) csound->Calloc(csound,
+                                        API_SLAB_CHUNKS*API_SLAB_CHUNK);
+    for (i = 0; i < API_SLAB_CHUNKS; i++) {
+      slab->cells[i].chunk = i;
+      slab->cells[i].seq = i + 1;       /* all chunks start free */
+    }
+    slab->head = 0;
+    slab->tail = API_SLAB_CHUNKS;
+    csound->msg_slab = slab;
+  }
+}
+
+/* Claim a slot, returns NULL if the queue is full */
+static message_queue_t *message_claim(CSOUND *csound, long *ppos)
+{
+  long pos = ATOMIC_LOAD_ACQ(csound->msg_queue_wpos);
+  while (1) {
+    message_queue_t *msg = &csound->msg_queue[pos & (API_MAX_QUEUE-1)];
+    long dif = ATOMIC_LOAD_ACQ(msg->seq) - pos;
+    if (dif == 0) {
+      long next = pos + 1;
+      if (!ATOMIC_CMP_XCH(&csound->msg_queue_wpos, next, pos)) {
+        *ppos = pos;
+        return msg;
+      }
     }
+    else if (dif < 0) return NULL;
+    pos = ATOMIC_LOAD_ACQ(csound->msg_queue_wpos);
   }
 }
 
+/* Enqueue a message whose arguments are args followed by data (which
+   may be NULL); returns CSOUND_QUEUE_FULL when not blocking and there
+   is no room */
+static int message_enqueue_parts(CSOUND *csound, int32_t message,
+                                 const char *args, int argsiz,
+                                 const void *data, int datasiz, int block)
+{
+  message_queue_t *msg;
+  long pos;
+  int tries = 0, total = argsiz + datasiz;
+  if (UNLIKELY(csound->msg_queue == NULL)) return CSOUND_ERROR;
+  while ((msg = message_claim(csound, &pos)) == NULL) {
+    if (!block) return CSOUND_QUEUE_FULL;
+    /* the queue is drained once per k-cycle, so back off */
+    if (++tries > 64) csoundSleep(1);
+  }
+  msg->message = message;
+  msg->spill = SPILL_NONE;
+  if (total <= API_INLINE_ARGS)
+    msg->args = msg->inline_args;
+  else {
+    message_slab_t *slab = (message_slab_t *) csound->msg_slab;
+    long chunk = total <= API_SLAB_CHUNK ? slab_get(slab) : -1;
+    if (chunk >= 0) {
+      msg->spill = SPILL_SLAB;
+      msg->chunk = chunk;
+      msg->args = slab->mem + chunk*API_SLAB_CHUNK;
+    }
+    else {                      /* very large payloads only */
+      msg->spill = SPILL_HEAP;
+      msg->args = (char *) csound->Malloc(csound, total);
+    }
+  }
+  memcpy(msg->args, args, argsiz);
+  if (datasiz > 0) memcpy(msg->args + argsiz, data, datasiz);
+  ATOMIC_STORE_REL(msg->seq, pos + 1);  /* publish */
+  return CSOUND_SUCCESS;
+}
 
 /* enqueue should be called by the relevant API function */
-void *message_enqueue(CSOUND *csound, int32_t message, char *args,
-                      int argsiz) {
-  if(csound->msg_queue != NULL) {
-    int64_t *rtn;
-    volatile long items;
-
-    /* block if queue is full */
-    do {
-      items = ATOMIC_GET(csound->msg_queue_items);
-    } while(items >= API_MAX_QUEUE);
-
-    message_queue_t* msg =
-      csound->msg_queue[atomicGet_Incr_Mod(&csound->msg_queue_wget,
-                                           API_MAX_QUEUE)];
-    msg->message = message;
-    if(msg->args != NULL)
-      csound->Free(csound, msg->args);
-    msg->args = (char *)csound->Calloc(csound, argsiz);
-    memcpy(msg->args, args, argsiz);
-    rtn = &msg->rtn;
-    csound->msg_queue[atomicGet_Incr_Mod(&csound->msg_queue_wput,
-                                         API_MAX_QUEUE)] = msg;
-    ATOMIC_INCR(csound->msg_queue_items);
-    return (void *) rtn;
-  }
-  else return NULL;
+int message_enqueue(CSOUND *csound, int32_t message, char *args,
+                    int argsiz, int block)
+{
+  return message_enqueue_parts(csound, message, args, argsiz, NULL, 0, block);
 }
 
 /* dequeue should be called by kperf_*()
@@ -128,12 +218,13 @@ void *message_enqueue(CSOUND *csound, int32_t message, char *args,
 */
 void message_dequeue(CSOUND *csound) {
   if(csound->msg_queue != NULL) {
-    long rp = csound->msg_queue_rstart;
-    long items = csound->msg_queue_items;
-    long rend = rp + items;
+    long rp = csound->msg_queue_rpos;
+    long n;
 
-    while(rp < rend) {
-      message_queue_t* msg = csound->msg_queue[rp % API_MAX_QUEUE];
+    /* at most one ring's worth, so producers cannot keep us here */
+    for (n = 0; n < API_MAX_QUEUE; n++) {
+      message_queue_t* msg = &csound->msg_queue[rp & (API_MAX_QUEUE-1)];
+      if (ATOMIC_LOAD_ACQ(msg->seq) != rp + 1) break;  /* empty */
       switch(msg->message) {
       case INPUT_MESSAGE:
         {
@@ -154,10 +245,9 @@ void message_dequeue(CSOUND *csound) {
           const MYFLT *pfields;
           long numFields;
           type = msg->args[0];
-          memcpy(&pfields, msg->args + ARG_ALIGN,
-                 sizeof(MYFLT *));
-          memcpy(&numFields, msg->args + ARG_ALIGN*2,
+          memcpy(&numFields, msg->args + ARG_ALIGN,
                  sizeof(long));
+          pfields = (const MYFLT *) (msg->args + ARG_ALIGN*2);
 
           csoundScoreEventInternal(csound, type, pfields, numFields);
         }
@@ -169,12 +259,11 @@ void message_dequeue(CSOUND *csound) {
           long numFields;
           double ofs;
           type = msg->args[0];
-          memcpy(&pfields, msg->args + ARG_ALIGN,
-                 sizeof(MYFLT *));
-          memcpy(&numFields, msg->args + ARG_ALIGN*2,
+          memcpy(&numFields, msg->args + ARG_ALIGN,
                  sizeof(long));
-          memcpy(&ofs, msg->args + ARG_ALIGN*3,
+          memcpy(&ofs, msg->args + ARG_ALIGN*2,
                  sizeof(double));
+          pfields = (const MYFLT *) (msg->args + ARG_ALIGN*3);
 
           csoundScoreEventAbsoluteInternal(csound, type, pfields, numFields,
                                              ofs);
@@ -243,79 +332,95 @@ void message_dequeue(CSOUND *csound) {
         }
         break;
       }
+      if (msg->spill == SPILL_SLAB)
+        slab_put((message_slab_t *) csound->msg_slab, msg->chunk);
+      else if (msg->spill == SPILL_HEAP)
+        csound->Free(csound, msg->args);
       msg->message = 0;
+      /* hand the slot back to producers, one lap ahead */
+      ATOMIC_STORE_REL(msg->seq, rp + API_MAX_QUEUE);
       rp += 1;
     }
-    ATOMIC_SUB(csound->msg_queue_items, items);
-    csound->msg_queue_rstart = rp % API_MAX_QUEUE;
+    csound->msg_queue_rpos = rp;
   }
 }
 
 /* these are the message enqueueing functions for each relevant API function */
-static inline void csoundInputMessage_enqueue(CSOUND *csound,
-                                              const char *str){
-  message_enqueue(csound,INPUT_MESSAGE, (char *) str, strlen(str)+1);
+static inline int csoundInputMessage_enqueue(CSOUND *csound,
+                                             const char *str, int block){
+  return message_enqueue(csound,INPUT_MESSAGE, (char *) str, strlen(str)+1,
+                         block);
 }
 
-static inline int64_t *csoundReadScore_enqueue(CSOUND *csound, const char *str){
-  return message_enqueue(csound, READ_SCORE, (char *) str, strlen(str)+1);
+static inline int csoundReadScore_enqueue(CSOUND *csound, const char *str,
+                                          int block){
+  return message_enqueue(csound, READ_SCORE, (char *) str, strlen(str)+1,
+                         block);
 }
 
-static inline void csoundTableCopyOut_enqueue(CSOUND *csound, int table,
-                                              MYFLT *ptable){
+static inline int csoundTableCopyOut_enqueue(CSOUND *csound, int table,
+                                             MYFLT *ptable, int block){
   const int argsize = ARG_ALIGN*2;
   char args[ARG_ALIGN*2];
   memcpy(args, &table, sizeof(int));
   memcpy(args+ARG_ALIGN, &ptable, sizeof(MYFLT *));
-  message_enqueue(csound,TABLE_COPY_OUT, args, argsize);
+  return message_enqueue(csound,TABLE_COPY_OUT, args, argsize, block);
 }
 
-static inline void csoundTableCopyIn_enqueue(CSOUND *csound, int table,
-                                             MYFLT *ptable){
+static inline int csoundTableCopyIn_enqueue(CSOUND *csound, int table,
+                                            MYFLT *ptable, int block){
   const int argsize = ARG_ALIGN*2;
   char args[ARG_ALIGN*2];
   memcpy(args, &table, sizeof(int));
   memcpy(args+ARG_ALIGN, &ptable, sizeof(MYFLT *));
-  message_enqueue(csound,TABLE_COPY_IN, args, argsize);
+  return message_enqueue(csound,TABLE_COPY_IN, args, argsize, block);
 }
 
-static inline void csoundTableSet_enqueue(CSOUND *csound, int table, int index,
-                                          MYFLT value)
+static inline int csoundTableSet_enqueue(CSOUND *csound, int table, int index,
+                                         MYFLT value, int block)
 {
   const int argsize = ARG_ALIGN*3;
   char args[ARG_ALIGN*3];
   memcpy(args, &table, sizeof(int));
   memcpy(args+ARG_ALIGN, &index, sizeof(int));
   memcpy(args+2*ARG_ALIGN, &value, sizeof(MYFLT));
-  message_enqueue(csound,TABLE_SET, args, argsize);
+  return message_enqueue(csound,TABLE_SET, args, argsize, block);
 }
 
-
-static inline int64_t *csoundScoreEvent_enqueue(CSOUND *csound, char type,
-                                                const MYFLT *pfields,
-                                                long numFields)
+/* The pfields are copied into the message, as the caller's array
+   may be gone by the time the event is dequeued */
+static int score_event_enqueue(CSOUND *csound, int32_t message, char type,
+                               const MYFLT *pfields, long numFields,
+                               double time_ofs, int block)
 {
-  const int argsize = ARG_ALIGN*3;
   char args[ARG_ALIGN*3];
+  int hdr = (message == SCORE_EVENT_ABS) ? ARG_ALIGN*3 : ARG_ALIGN*2;
+  if (UNLIKELY(numFields < 0)) numFields = 0;
   args[0] = type;
-  memcpy(args+ARG_ALIGN, &pfields, sizeof(MYFLT *));
-  memcpy(args+2*ARG_ALIGN, &numFields, sizeof(long));
-  return message_enqueue(csound,SCORE_EVENT, args, argsize);
+  memcpy(args+ARG_ALIGN, &numFields, sizeof(long));
+  if (message == SCORE_EVENT_ABS)
+    memcpy(args+2*ARG_ALIGN, &time_ofs, sizeof(double));
+  return message_enqueue_parts(csound, message, args, hdr, pfields,
+                               (int) (numFields*sizeof(MYFLT)), block);
+}
+
+static inline int csoundScoreEvent_enqueue(CSOUND *csound, char type,
+                                           const MYFLT *pfields,
+                                           long numFields, int block)
+{
+  return score_event_enqueue(csound, SCORE_EVENT, type, pfields, numFields,
+                             0.0, block);
 }
 
 
-static inline int64_t *csoundScoreEventAbsolute_enqueue(CSOUND *csound, char type,
-                                                        const MYFLT *pfields,
-                                                        long numFields,
-                                                        double time_ofs)
+static inline int csoundScoreEventAbsolute_enqueue(CSOUND *csound, char type,
+                                                   const MYFLT *pfields,
+                                                   long numFields,
+                                                   double time_ofs,
+                                                   int block)
 {
-  const int argsize = ARG_ALIGN*4;
-  char args[ARG_ALIGN*4];
-  args[0] = type;
-  memcpy(args+ARG_ALIGN, &pfields, sizeof(MYFLT *));
-  memcpy(args+2*ARG_ALIGN, &numFields, sizeof(long));
-  memcpy(args+3*ARG_ALIGN, &time_ofs, sizeof(double));
-  return message_enqueue(csound,SCORE_EVENT_ABS, args, argsize);
+  return score_event_enqueue(csound, SCORE_EVENT_ABS, type, pfields,
+                             numFields, time_ofs, block);
 }
 
 /* this is to be called from
@@ -326,12 +431,12 @@ void killInstance_enqueue(CSOUND *csound, MYFLT instr, int insno,
                           int allow_release) {
   const int argsize = ARG_ALIGN*5;
   char args[ARG_ALIGN*5];
-  memcpy(args, &instr, sizeof(int));
+  memcpy(args, &instr, sizeof(MYFLT));
   memcpy(args+ARG_ALIGN, &insno, sizeof(int));
   memcpy(args+ARG_ALIGN*2, &ip, sizeof(INSDS *));
   memcpy(args+ARG_ALIGN*3, &mode, sizeof(int));
   memcpy(args+ARG_ALIGN*4, &allow_release, sizeof(int));
-  message_enqueue(csound,KILL_INSTANCE,args,argsize);
+  message_enqueue(csound,KILL_INSTANCE,args,argsize,1);
 }
 
 /* this is to be called from
@@ -343,7 +448,7 @@ void mergeState_enqueue(CSOUND *csound, ENGINE_STATE *e, TYPE_TABLE* t, OPDS *id
   memcpy(args, &e, sizeof(ENGINE_STATE *));
   memcpy(args+ARG_ALIGN, &t, sizeof(TYPE_TABLE *));
   memcpy(args+2*ARG_ALIGN, &ids, sizeof(OPDS *));
-  message_enqueue(csound,MERGE_STATE, args, argsize);
+  message_enqueue(csound,MERGE_STATE, args, argsize, 1);
 }
 
 /*  VL: These functions are slated to
@@ -445,30 +550,30 @@ MYFLT csoundEvalCode(CSOUND *csound, const char *str)
     To be removed once everything is made async
 */
 void csoundInputMessageAsync(CSOUND *csound, const char *message){
-  csoundInputMessage_enqueue(csound, message);
+  csoundInputMessage_enqueue(csound, message, 1);
 }
 
 void csoundReadScoreAsync(CSOUND *csound, const char *message){
-  csoundReadScore_enqueue(csound, message);
+  csoundReadScore_enqueue(csound, message, 1);
 }
 
 void csoundTableCopyOutAsync(CSOUND *csound, int table, MYFLT *ptable){
-  csoundTableCopyOut_enqueue(csound, table, ptable);
+  csoundTableCopyOut_enqueue(csound, table, ptable, 1);
 }
 
 void csoundTableCopyInAsync(CSOUND *csound, int table, MYFLT *ptable){
-  csoundTableCopyIn_enqueue(csound, table, ptable);
+  csoundTableCopyIn_enqueue(csound, table, ptable, 1);
 }
 
 void csoundTableSetAsync(CSOUND *csound, int table, int index, MYFLT value)
 {
-  csoundTableSet_enqueue(csound, table, index, value);
+  csoundTableSet_enqueue(csound, table, index, value, 1);
 }
 
 void csoundScoreEventAsync(CSOUND *csound, char type,
                            const MYFLT *pfields, long numFields)
 {
-  csoundScoreEvent_enqueue(csound, type, pfields, numFields);
+  csoundScoreEvent_enqueue(csound, type, pfields, numFields, 1);
 }
 
 void csoundScoreEventAbsoluteAsync(CSOUND *csound, char type,
@@ -476,7 +581,46 @@ void csoundScoreEventAbsoluteAsync(CSOUND *csound, char type,
                                    double time_ofs)
 {
 
-  csoundScoreEventAbsolute_enqueue(csound, type, pfields, numFields, time_ofs);
+  csoundScoreEventAbsolute_enqueue(csound, type, pfields, numFields, time_ofs,
+                                   1);
+}
+
+/** Non-blocking versions of the Async functions: these return
+    CSOUND_QUEUE_FULL instead of waiting for room in the queue
+*/
+int csoundTryInputMessage(CSOUND *csound, const char *message){
+  return csoundInputMessage_enqueue(csound, message, 0);
+}
+
+int csoundTryReadScore(CSOUND *csound, const char *message){
+  return csoundReadScore_enqueue(csound, message, 0);
+}
+
+int csoundTryTableCopyOut(CSOUND *csound, int table, MYFLT *ptable){
+  return csoundTableCopyOut_enqueue(csound, table, ptable, 0);
+}
+
+int csoundTryTableCopyIn(CSOUND *csound, int table, MYFLT *ptable){
+  return csoundTableCopyIn_enqueue(csound, table, ptable, 0);
+}
+
+int csoundTryTableSet(CSOUND *csound, int table, int index, MYFLT value)
+{
+  return csoundTableSet_enqueue(csound, table, index, value, 0);
+}
+
+int csoundTryScoreEvent(CSOUND *csound, char type,
+                        const MYFLT *pfields, long numFields)
+{
+  return csoundScoreEvent_enqueue(csound, type, pfields, numFields, 0);
+}
+
+int csoundTryScoreEventAbsolute(CSOUND *csound, char type,
+                                const MYFLT *pfields, long numFields,
+                                double time_ofs)
+{
+  return csoundScoreEventAbsolute_enqueue(csound, type, pfields, numFields,
+                                          time_ofs, 0);
 }
 
 int csoundCompileTreeAsync(CSOUND *csound, TREE *root) {
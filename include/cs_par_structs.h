@@ -67,4 +67,43 @@ typedef struct _watchList {
                      sizeof(struct _watchList *))) / sizeof(uint8_t)];
 } watchList;
 
+/* Work-stealing dispatch: each performance thread owns a deque of ready
+ * tasks.  The owner pushes and pops at the bottom, idle threads steal from
+ * the top.  A task becomes ready exactly once per k-cycle, so a deque never
+ * holds more than dag_task_max_size entries and never needs to wrap; the
+ * indices are simply reset at the start of each cycle.
+ */
+typedef struct _taskDeque {
+  volatile int top;                     /* written by thieves */
+  uint8_t padding1 [(CONCURRENTPADDING - sizeof(int)) / sizeof(uint8_t)];
+  volatile int bottom;                  /* written by the owner */
+  uint8_t padding2 [(CONCURRENTPADDING - sizeof(int)) / sizeof(uint8_t)];
+  taskID *tasks;
+  int spin;                             /* adaptive spin budget */
+  /* counters for the current k-cycle, only written by the owner */
+  unsigned long executed;
+  unsigned long stolen;
+  unsigned long idle;
+  uint8_t padding3 [(CONCURRENTPADDING -
+                     (sizeof(taskID *) + sizeof(int) +
+                      3 * sizeof(unsigned long))) / sizeof(uint8_t)];
+} taskDeque;
+
+typedef struct _dagScheduler {
+  taskDeque *deques;                    /* one per performance thread */
+  int num_deques;
+  int capacity;                         /* entries in each deque */
+  volatile int remaining;               /* tasks not yet DONE this cycle */
+  uint8_t padding1 [(CONCURRENTPADDING - 3 * sizeof(int) -
+                     sizeof(taskDeque *)) / sizeof(uint8_t)];
+  volatile int sleepers;                /* threads blocked for work */
+  volatile int wake_epoch;              /* futex word, bumped on wake */
+  uint8_t padding2 [(CONCURRENTPADDING - 2 * sizeof(int)) / sizeof(uint8_t)];
+  /* summed over all threads at the end of each k-cycle */
+  unsigned long executed, stolen, idle;
+  unsigned long total_executed, total_stolen, total_idle;
+  unsigned long max_stolen, max_idle;
+  unsigned long kcycles;
+} dagScheduler;
+
 #endif
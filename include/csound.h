@@ -337,7 +337,9 @@ extern "C" {
       /* Failed to allocate requested memory. */
       CSOUND_MEMORY = -4,
       /* Termination requested by SIGINT or SIGTERM. */
-      CSOUND_SIGNAL = -5
+      CSOUND_SIGNAL = -5,
+      /* The API message queue is full, try again later. */
+      CSOUND_QUEUE_FULL = -6
     } CSOUND_STATUS;
 
   /* Compilation or performance aborted, but not as a result of an error
@@ -509,7 +511,7 @@ extern "C" {
     MYFLT   e0dbfs_override;   /* overriding 0dbfs */
     int     daemon;  /* daemon mode */
     int     ksmps_override; /* ksmps override */
-    int     FFT_library;    /* fft_lib */
+    int     FFT_library;    /* fft_lib, -1 picks one by size */
   } CSOUND_PARAMS;
 
   /**
@@ -552,6 +554,28 @@ extern "C" {
     float   sampleRate;
   } csRtAudioParams;
 
+  /**
+   * Memory use of one subsystem, see csoundGetMemoryStats()
+   */
+  typedef struct {
+    const char  *name;
+    uint64_t    allocs;
+    uint64_t    frees;
+    int64_t     bytes;          /* in use */
+  } CSOUND_MEMSTAT;
+
+  /**
+   * Time spent in one opcode or instrument, see csoundGetProfile()
+   */
+  typedef struct {
+    const char  *name;          /* NULL for a numbered instrument */
+    int         instr;          /* instrument number, 0 for an opcode */
+    uint64_t    inits;          /* init calls */
+    uint64_t    perfs;          /* perf calls (k-cycles for instruments) */
+    double      init_time;      /* seconds */
+    double      perf_time;
+  } CSOUND_PROFILE;
+
   typedef struct RTCLOCK_S {
     int_least64_t   starttime_real;
     int_least64_t   starttime_CPU;
@@ -656,6 +680,12 @@ extern "C" {
     controlChannelHints_t    hints;
   } controlChannelInfo_t;
 
+  /**
+   * Opaque handle to a bus channel, returned by csoundGetChannelHandle().
+   * Handles stay valid until csoundReset() or csoundDestroy().
+   */
+  typedef struct channelEntry_s *CHANNEL_HANDLE;
+
   typedef void (*channelCallback_t)(CSOUND *csound,
                                     const char *channelName,
                                     void *channelValuePtr,
@@ -1020,6 +1050,25 @@ extern "C" {
    */
   PUBLIC int csoundGetSizeOfMYFLT(void);
 
+  /**
+   * Fills stats with the memory allocated by csound->Malloc() and friends
+   * for each subsystem (compiler, init pass, performance, ...), writing at
+   * most max entries, and returns the number written.
+   */
+  PUBLIC int csoundGetMemoryStats(CSOUND *, CSOUND_MEMSTAT *stats, int max);
+
+  /**
+   * Fills entries with the time spent in the init and perf routines of
+   * each opcode and in each instrument since performance started, most
+   * expensive first, writing at most max entries, and returns the number
+   * written. Opcode times include the opcodes they call, so the time of
+   * a user-defined opcode covers its body.
+   * Only available if the --profile option was given before csoundStart(),
+   * otherwise returns 0. The report is also printed at the end of
+   * performance.
+   */
+  PUBLIC int csoundGetProfile(CSOUND *, CSOUND_PROFILE *entries, int max);
+
   /**
    * Returns host data.
    */
@@ -1459,6 +1508,12 @@ extern "C" {
    */
   PUBLIC void csoundReadScoreAsync(CSOUND *csound, const char *str);
 
+  /**
+   *  Non-blocking version of csoundReadScoreAsync(). Returns
+   *  CSOUND_QUEUE_FULL if the message queue has no room.
+   */
+  PUBLIC int csoundTryReadScore(CSOUND *csound, const char *str);
+
   /**
    * Returns the current score time in seconds
    * since the beginning of performance.
@@ -1763,6 +1818,63 @@ extern "C" {
   PUBLIC void csoundSetAudioChannel(CSOUND *csound,
                                     const char *name, MYFLT *samples);
 
+  /**
+   * Resolves the channel called 'name' once, creating it as with
+   * csoundGetChannelPtr() if it does not exist, and returns a handle
+   * that can be used for fast access from the host without further
+   * name lookups. 'type' is the channel type and direction, as for
+   * csoundGetChannelPtr(). Returns NULL if the channel could not be
+   * created or exists with a different type.
+   * For audio channels, the handle enables a host-side copy of the channel
+   * that is exchanged with the performance thread once per k-cycle, so that
+   * csoundGetAudioChannelH() and csoundSetAudioChannelH() never lock out
+   * the performance thread. Each direction of an audio handle should be
+   * used by only one host thread at a time.
+   */
+  PUBLIC CHANNEL_HANDLE csoundGetChannelHandle(CSOUND *csound,
+                                               const char *name, int type);
+
+  /**
+   * retrieves the value of the control channel referred to by handle h
+   */
+  PUBLIC MYFLT csoundGetControlChannelH(CSOUND *csound, CHANNEL_HANDLE h);
+
+  /**
+   * sets the value of the control channel referred to by handle h
+   */
+  PUBLIC void csoundSetControlChannelH(CSOUND *csound,
+                                       CHANNEL_HANDLE h, MYFLT val);
+
+  /**
+   * reads the n control channels in h[] into vals[] in a single call.
+   * NULL handles are skipped.
+   */
+  PUBLIC void csoundGetControlChannels(CSOUND *csound, const CHANNEL_HANDLE *h,
+                                       MYFLT *vals, int n);
+
+  /**
+   * writes vals[] into the n control channels in h[] in a single call.
+   * NULL handles are skipped.
+   */
+  PUBLIC void csoundSetControlChannels(CSOUND *csound, const CHANNEL_HANDLE *h,
+                                       const MYFLT *vals, int n);
+
+  /**
+   * copies the last complete k-cycle of the audio channel referred to by
+   * handle h (obtained with CSOUND_OUTPUT_CHANNEL) into *samples, which
+   * should contain enough memory for ksmps MYFLTs
+   */
+  PUBLIC void csoundGetAudioChannelH(CSOUND *csound, CHANNEL_HANDLE h,
+                                     MYFLT *samples);
+
+  /**
+   * sets the audio channel referred to by handle h (obtained with
+   * CSOUND_INPUT_CHANNEL) with ksmps MYFLTs from *samples; the data is
+   * picked up at the start of the next k-cycle
+   */
+  PUBLIC void csoundSetAudioChannelH(CSOUND *csound, CHANNEL_HANDLE h,
+                                     const MYFLT *samples);
+
   /**
    * copies the string channel identified by *name into *string
    * which should contain enough memory for the string
@@ -1832,6 +1944,14 @@ extern "C" {
   PUBLIC void csoundScoreEventAsync(CSOUND *,
                               char type, const MYFLT *pFields, long numFields);
 
+  /**
+   *  Non-blocking version of csoundScoreEventAsync(). Returns
+   *  CSOUND_SUCCESS, or CSOUND_QUEUE_FULL if the message queue has no room,
+   *  in which case the event was not sent.
+   */
+  PUBLIC int csoundTryScoreEvent(CSOUND *,
+                              char type, const MYFLT *pFields, long numFields);
+
   /**
    * Like csoundScoreEvent(), this function inserts a score event, but
    * at absolute time with respect to the start of performance, or from an
@@ -1845,6 +1965,13 @@ extern "C" {
    */
   PUBLIC void csoundScoreEventAbsoluteAsync(CSOUND *,
                  char type, const MYFLT *pfields, long numFields, double time_ofs);
+
+  /**
+   *  Non-blocking version of csoundScoreEventAbsoluteAsync(). Returns
+   *  CSOUND_QUEUE_FULL if the message queue has no room.
+   */
+  PUBLIC int csoundTryScoreEventAbsolute(CSOUND *,
+                 char type, const MYFLT *pfields, long numFields, double time_ofs);
   /**
    * Input a NULL-terminated string (as if from a console),
    * used for line events.
@@ -1856,6 +1983,12 @@ extern "C" {
    */
   PUBLIC void csoundInputMessageAsync(CSOUND *, const char *message);
 
+  /**
+   * Non-blocking version of csoundInputMessageAsync(). Returns
+   * CSOUND_QUEUE_FULL if the message queue has no room.
+   */
+  PUBLIC int csoundTryInputMessage(CSOUND *, const char *message);
+
   /**
    * Kills off one or more running instances of an instrument identified
    * by instr (number) or instrName (name). If instrName is NULL, the
@@ -1869,6 +2002,15 @@ extern "C" {
   PUBLIC int csoundKillInstance(CSOUND *csound, MYFLT instr,
                                 char *instrName, int mode, int allow_release);
 
+  /**
+   * Allocates instances of every instrument and user-defined opcode of
+   * the compiled orchestra, so that each has at least count of them,
+   * in the same way as the prewarm opcode. Notes started later reuse
+   * these instead of allocating memory while performing.
+   * Returns CSOUND_ERROR if no orchestra has been compiled.
+   */
+  PUBLIC int csoundPrewarmInstances(CSOUND *csound, int count);
+
 
   /**
    * Register a function to be called once in every control period
@@ -1965,6 +2107,12 @@ extern "C" {
    */
   PUBLIC void csoundTableSet(CSOUND *, int table, int index, MYFLT value);
 
+  /**
+   * Queues a csoundTableSet() for the next k-cycle without blocking.
+   * Returns CSOUND_QUEUE_FULL if the message queue has no room.
+   */
+  PUBLIC int csoundTryTableSet(CSOUND *, int table, int index, MYFLT value);
+
 
   /**
    * Copy the contents of a function table into a supplied array *dest
@@ -1977,6 +2125,12 @@ extern "C" {
    * Asynchronous version of csoundTableCopyOut()
    */
   PUBLIC void csoundTableCopyOutAsync(CSOUND *csound, int table, MYFLT *dest);
+
+  /**
+   * Non-blocking version of csoundTableCopyOutAsync(). Returns
+   * CSOUND_QUEUE_FULL if the message queue has no room.
+   */
+  PUBLIC int csoundTryTableCopyOut(CSOUND *csound, int table, MYFLT *dest);
   /**
    * Copy the contents of an array *src into a given function table
    * The table number is assumed to be valid, and the table needs to
@@ -1989,6 +2143,12 @@ extern "C" {
    */
   PUBLIC void csoundTableCopyInAsync(CSOUND *csound, int table, MYFLT *src);
 
+  /**
+   * Non-blocking version of csoundTableCopyInAsync(). Returns
+   * CSOUND_QUEUE_FULL if the message queue has no room.
+   */
+  PUBLIC int csoundTryTableCopyIn(CSOUND *csound, int table, MYFLT *src);
+
   /**
    * Stores pointer to function table 'tableNum' in *tablePtr,
    * and returns the table length (not including the guard point).
@@ -2243,6 +2403,9 @@ extern "C" {
   /** Signals a conditional variable */
   PUBLIC void csoundCondSignal(void* condVar);
 
+  /** Destroys a conditional variable created by csoundCreateCondVar() */
+  PUBLIC void csoundDestroyCondVar(void* condVar);
+
   /**
    * Waits for at least the specified number of milliseconds,
    * yielding the CPU to other threads.
@@ -213,7 +213,7 @@ extern int ISSTRCOD(MYFLT);
 #define ASYNC_GLOBAL 1
 #define ASYNC_LOCAL  2
 
-enum {FFT_LIB=0, PFFT_LIB, VDSP_LIB};
+enum {FFT_LIB=0, PFFT_LIB, VDSP_LIB, DFFT_LIB};
 enum {FFT_FWD=0, FFT_INV};
 
 /* advance declaration for
@@ -262,6 +262,9 @@ typedef struct CORFIL {
     int     ksmps_override;
     int     fft_lib;
     int     echo;
+    int     disk_buffers;   /* depth of the disk writer ring, 0: none */
+    int     aux_zero_async; /* KiB of aux space cleared by a thread, 0: none */
+    int     profile;        /* time opcodes and instruments (profile.c) */
   } OPARMS;
 
   typedef struct arglst {
@@ -344,6 +347,10 @@ typedef struct CORFIL {
     int     instcnt;                /* Count number of instances ever */
     int     isNew;                  /* is this a new definition */
     int     nocheckpcnt;            /* Control checks on pcnt */
+    struct inst_tmpl *tmpl;         /* Image and slabs of the instances
+                                       (see instance() in insert.c) */
+    char    *udo_byref;             /* UDO inputs bound to the caller's
+                                       argument, 'A' array, 'S' string */
   } INSTRTXT;
 
   typedef struct namedInstr {
@@ -511,8 +518,8 @@ typedef struct CORFIL {
     struct insds * nxtact;
     /* Previous in list of active instruments */
     struct insds * prvact;
-    /* Next instrument to terminate */
-    struct insds * nxtoff;
+    /* Link in the queue of notes to turn off (csound->turnoffs) */
+    CS_WHEEL_NODE offnode;
     /* Chain of files used by opcodes in this instr */
     FDCH    *fdchp;
     /* Extra memory used by opcodes in this instr */
@@ -567,6 +574,14 @@ typedef struct CORFIL {
     int      init_done;
     int      tieflag;
     int      reinitflag;
+    /* Task index in the last DAG build, -1 if newly activated */
+    int      dag_task;
+    /* Notes active with the same p1 (insert.c), NULL if not active */
+    struct act_key *actkey;
+    /* Next indefinite note with the same p1, for ties */
+    struct insds *nxtheld;
+    /* memory freed when the instance is deactivated (memalloc.c) */
+    void    *region;
     MYFLT    retval;
     MYFLT   *lclbas;  /* base for variable memory pool */
     char    *strarg;       /* string argument */
@@ -822,8 +837,8 @@ typedef struct CORFIL {
   } MGLOBAL;
 
   typedef struct eventnode {
-    struct eventnode  *nxt;
-    uint32     start_kcnt;
+    struct eventnode  *nxt;         /* in the stack of free nodes */
+    CS_WHEEL_NODE     node;         /* in csound->OrcTrigEvts */
     EVTBLK            evt;
   } EVTNODE;
 
@@ -874,6 +889,7 @@ typedef struct CORFIL {
  * and nodebug kperf functions */
   int kperf_nodebug(CSOUND *csound);
   int kperf_debug(CSOUND *csound);
+  int kperf_profile(CSOUND *csound);
 
 #endif  /* __BUILDING_LIBCSOUND */
 
@@ -982,6 +998,18 @@ typedef struct _message_queue_t_ {
     char str[MAX_MESSAGE_STR];
 } message_string_queue_t;
 
+/* where the time between csoundReset() and csoundStart() went,
+   printed with -v (seconds) */
+typedef struct {
+    RTCLOCK clock;              /* started by csoundReset() */
+    double  scan;               /* plugin directories and manifest */
+    double  open;               /* plugin libraries opened at startup */
+    double  init;               /* csoundInitModules() */
+    double  deferred;           /* deferred libraries opened by the parser */
+    double  compile;            /* orchestra compilation, incl. deferred */
+    int     nopen, ndefer, nstub, nlate;
+} STARTUP_TIMES;
+
 
   /**
    * Contains all function pointers, data, and data pointers required
@@ -1371,11 +1399,14 @@ typedef struct _message_queue_t_ {
                          AUXASYNC *, aux_cb, void *);
     void *(*GetHostData)(CSOUND *);
     char *(*strNcpy)(char *dst, const char *src, size_t siz);
+    void *(*InstanceAlloc)(CSOUND *, INSDS *, size_t);
+    /* the first nbytes of an aux space are all that has been written */
+    void (*AuxTouched)(CSOUND *, AUXCH *auxchp, size_t nbytes);
        /**@}*/
     /** @name Placeholders
         To allow the API to grow while maintining backward binary compatibility. */
     /**@{ */
-    SUBR dummyfn_2[37];
+    SUBR dummyfn_2[35];
     /**@}*/
 #ifdef __BUILDING_LIBCSOUND
     /* ------- private data (not to be used by hosts or externals) ------- */
@@ -1484,7 +1515,7 @@ typedef struct _message_queue_t_ {
     FILE*         scorein;
     FILE*         scoreout;
     int           *argoffspace;
-    INSDS         *frstoff;
+    CS_WHEEL      *turnoffs;     /* notes with finite duration, by offtim */
     MYFLT         *zkstart;
     int64_t          zklast;
     MYFLT         *zastart;
@@ -1527,7 +1558,7 @@ typedef struct _message_queue_t_ {
     int32         rngcnt[MAXCHNLS];
     int16         rngflg, multichan;
     void          *evtFuncChain;
-    EVTNODE       *OrcTrigEvts;             /* List of events to be started */
+    CS_WHEEL      *OrcTrigEvts;             /* Events to be started */
     EVTNODE       *freeEvtNodes;
     int           csoundIsScorePending_;
     int64_t       advanceCnt;
@@ -1650,6 +1681,16 @@ typedef struct _message_queue_t_ {
       uint32        nframes               /* = 1UL */;
       FILE          *pin, *pout;
       int           dither;
+      void          (*ditherfn)(CSOUND *, MYFLT *, int);
+      void          *wthread;             /* disk writer (--disk-buffers) */
+      void          *wlock;               /* mutex for wput, wget, wstop  */
+      void          *wready, *wfree;      /* and conditions on them       */
+      MYFLT         **wbufs;              /* ring of wdepth outbufs       */
+      int           *wsize;               /* bytes queued in each         */
+      int           wdepth, whigh;        /* size, high-water mark        */
+      volatile int  wput, wget;           /* buffers queued / written     */
+      volatile int  wstop, werr;
+      int           wnret, wnput;         /* failed write, for sndwrterr  */
     } libsndStatics;
 
     int           warped;               /* rdscor.c */
@@ -1777,11 +1818,10 @@ typedef struct _message_queue_t_ {
     CS_HASH_TABLE* symbtab;
     int           tseglen;
     int           inZero;       /* flag compilation of instr0 */
-    struct _message_queue **msg_queue;
-    volatile long msg_queue_wget; /* Writer - Get index */
-    volatile long msg_queue_wput; /* Writer - Put Index */
-    volatile long msg_queue_rstart; /* Reader - start index */
-    volatile long msg_queue_items;
+    struct _message_queue *msg_queue;
+    volatile long msg_queue_wpos; /* Writer - next slot to claim */
+    long          msg_queue_rpos; /* Reader - next slot to read */
+    void          *msg_slab;      /* spill space for large messages */
     int      aftouch;
     void     *directory;
     ALLOC_DATA *alloc_queue;
@@ -1800,6 +1840,28 @@ typedef struct _message_queue_t_ {
     volatile unsigned long message_string_queue_items;
     unsigned long message_string_queue_wp;
     message_string_queue_t *message_string_queue;
+    dagScheduler  *dag_sched;   /* work-stealing dispatch state */
+    INSDS         **dag_prev_map;   /* task map of the previous DAG build */
+    char          **dag_prev_dep;
+    int           *dag_remap;
+    int           dag_dep_bytes;    /* size of one dependency bitset */
+    void          *dag_edge_cache;  /* dependency class by instr pair */
+    int           dag_edge_valid;
+    /* audio channels with host handles, exchanged once per k-cycle */
+    struct channelEntry_s *volatile chn_audio;
+    /* chn_db lookups against channels created on another thread */
+    spin_lock_t   chn_db_lock;
+    /* index over actanchor by instrument and p1 (insert.c) */
+    struct act_index *actindex;
+    /* size class pools and thread caches (memalloc.c) */
+    void          *memalloc_pool;
+    /* size class pools of aux spaces (auxfd.c) */
+    void          *auxpool;
+    /* plugin libraries deferred by the plugin manifest (csmodule.c) */
+    void          *lazymodule_db;
+    /* opcode and instrument timings with --profile (profile.c) */
+    void          *profile;
+    STARTUP_TIMES startup;
     /*struct CSOUND_ **self;*/
     /**@}*/
 #endif  /* __BUILDING_LIBCSOUND */
@@ -28,24 +28,54 @@
 extern "C" {
 #endif
 
-#define HASH_SIZE 4099
-
 typedef struct _cons {
     void* value; // should be car, but using value
     struct _cons* next; // should be cdr, but to follow csound
     // linked list conventions
 } CONS_CELL;
 
-typedef struct _cs_hash_bucket_item {
+/* slot of an open addressed hash table; empty when key is NULL */
+typedef struct _cs_hash_table_item {
+    uint32_t hash;
     char* key;
     void* value;
-    struct _cs_hash_bucket_item* next;
 } CS_HASH_TABLE_ITEM;
 
+/* linear probing over a power of two number of slots, doubled when
+   more than three quarters are in use */
 typedef struct _cs_hash_table {
-    CS_HASH_TABLE_ITEM* buckets[HASH_SIZE];
+    CS_HASH_TABLE_ITEM* items;
+    uint32_t size;
+    uint32_t count;
 } CS_HASH_TABLE;
 
+#define CS_WHEEL_BITS   8
+#define CS_WHEEL_SLOTS  (1 << CS_WHEEL_BITS)
+#define CS_WHEEL_LEVELS 4
+
+/* Link for an item queued on a CS_WHEEL, embedded in the item. tick is
+   the k-cycle the item is due at; items due at the same tick are
+   ordered by when, then by the order they were queued in. */
+typedef struct _cs_wheel_node {
+    struct _cs_wheel_node* next;    /* NULL when not queued */
+    struct _cs_wheel_node* prev;
+    uint64_t tick;
+    double when;
+    void* value;
+} CS_WHEEL_NODE;
+
+/* Hierarchical timing wheel. Level 0 has a slot per tick for the next
+   CS_WHEEL_SLOTS ticks, each level above covers CS_WHEEL_SLOTS times
+   the range of the one below, and slots are moved down a level as the
+   wheel turns. Items due at or before the current tick are all kept,
+   in order, in its level 0 slot. */
+typedef struct _cs_wheel {
+    CS_WHEEL_NODE slots[CS_WHEEL_LEVELS][CS_WHEEL_SLOTS];
+    CS_WHEEL_NODE overflow;         /* beyond the last level */
+    uint64_t now;
+    int count;
+} CS_WHEEL;
+
 /* FUNCTIONS FOR CONS CELL */
 
 /** Given a value and CONS_CELL, create a new CONS_CELL that holds the
@@ -125,6 +155,30 @@ PUBLIC void cs_hash_table_mfree_complete(CSOUND* csound, CS_HASH_TABLE* hashTabl
     ->value pointer. */
 PUBLIC void cs_hash_table_free_complete(CSOUND* csound, CS_HASH_TABLE* hashTable);
 
+/* FUNCTIONS FOR TIMING WHEEL */
+
+/** Create an empty CS_WHEEL at tick 0 */
+PUBLIC CS_WHEEL* cs_wheel_create(CSOUND* csound);
+
+/** Queues node, which must not be queued already, using its tick and
+ when fields. Ticks before the current one are due at once. */
+PUBLIC void cs_wheel_insert(CS_WHEEL* wheel, CS_WHEEL_NODE* node);
+
+/** Removes node from the wheel; does nothing if it is not queued. */
+PUBLIC void cs_wheel_remove(CS_WHEEL* wheel, CS_WHEEL_NODE* node);
+
+/** Turns the wheel forward to tick and returns the first item due by
+ then, or NULL if there is none. The item stays queued. An empty wheel
+ is simply set to tick, which may be earlier than its current one. */
+PUBLIC CS_WHEEL_NODE* cs_wheel_due(CS_WHEEL* wheel, uint64_t tick);
+
+/** Returns the first queued item whatever its tick, or NULL if the
+ wheel is empty. */
+PUBLIC CS_WHEEL_NODE* cs_wheel_first(CS_WHEEL* wheel);
+
+/** Frees the wheel, but not the queued items */
+PUBLIC void cs_wheel_free(CSOUND* csound, CS_WHEEL* wheel);
+
 #ifdef __cplusplus
 }
 #endif
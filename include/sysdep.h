@@ -482,20 +482,21 @@ char *strNcpy(char *dst, const char *src, size_t siz);
 #define ATOMIC_GET8(var) var
 #endif
 
+/* ATOMIC_DECR and ATOMIC_INCR yield the new value on every platform */
 #ifdef MSVC
-#define ATOMIC_DECR(var) InterlockedExchangeAdd(&var, -1)
+#define ATOMIC_DECR(var) (InterlockedExchangeAdd(&var, -1) - 1)
 #elif defined(HAVE_ATOMIC_BUILTIN)
 #define ATOMIC_DECR(var) __atomic_sub_fetch(&var, 1, __ATOMIC_SEQ_CST)
 #else
-#define ATOMIC_DECR(var) var -= 1
+#define ATOMIC_DECR(var) (var -= 1)
 #endif
 
 #ifdef MSVC
-#define ATOMIC_INCR(var) InterlockedExchangeAdd(&var, 1)
+#define ATOMIC_INCR(var) (InterlockedExchangeAdd(&var, 1) + 1)
 #elif defined(HAVE_ATOMIC_BUILTIN)
 #define ATOMIC_INCR(var) __atomic_add_fetch(&var, 1, __ATOMIC_SEQ_CST)
 #else
-#define ATOMIC_INCR(var) var += 1
+#define ATOMIC_INCR(var) (var += 1)
 #endif
 
 #ifdef MSVC
@@ -525,6 +526,49 @@ char *strNcpy(char *dst, const char *src, size_t siz);
 #define ATOMIC_CMP_XCH(val, newVal, oldVal) (*val = newVal) != oldVal
 #endif
 
+/* For lock-free queues: ATOMIC_LOAD_ACQ is a load that later accesses
+   do not move before, ATOMIC_STORE_REL a store that earlier accesses
+   do not move after, and ATOMIC_XCHG stores val and yields the old
+   value, on int or long variables; the _PTR forms are for pointers.
+   ATOMIC_ADD64 adds to a 64 bit counter, ATOMIC_FENCE is a full
+   barrier.  Without the builtins the older __sync ones are used. */
+#if defined(MSVC)
+#define ATOMIC_LOAD_ACQ(var) \
+  InterlockedCompareExchange((volatile LONG *) &(var), 0, 0)
+#define ATOMIC_STORE_REL(var, val) \
+  InterlockedExchange((volatile LONG *) &(var), (LONG) (val))
+#define ATOMIC_XCHG(var, val) \
+  InterlockedExchange((volatile LONG *) &(var), (LONG) (val))
+#define ATOMIC_LOAD_PTR_ACQ(var) \
+  InterlockedCompareExchangePointer((void *volatile *) &(var), NULL, NULL)
+#define ATOMIC_STORE_PTR_REL(var, val) \
+  InterlockedExchangePointer((void *volatile *) &(var), (void *) (val))
+#define ATOMIC_ADD64(var, val) \
+  InterlockedExchangeAdd64((volatile LONG64 *) &(var), (LONG64) (val))
+#define ATOMIC_FENCE() MemoryBarrier()
+#elif defined(HAVE_ATOMIC_BUILTIN)
+#define ATOMIC_LOAD_ACQ(var) __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE_REL(var, val) \
+  __atomic_store_n(&(var), (val), __ATOMIC_RELEASE)
+#define ATOMIC_XCHG(var, val) \
+  __atomic_exchange_n(&(var), (val), __ATOMIC_ACQ_REL)
+#define ATOMIC_LOAD_PTR_ACQ(var) ATOMIC_LOAD_ACQ(var)
+#define ATOMIC_STORE_PTR_REL(var, val) ATOMIC_STORE_REL(var, val)
+#define ATOMIC_ADD64(var, val) \
+  __atomic_fetch_add(&(var), (val), __ATOMIC_RELAXED)
+#define ATOMIC_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define ATOMIC_LOAD_ACQ(var) __sync_val_compare_and_swap(&(var), 0, 0)
+#define ATOMIC_STORE_REL(var, val) \
+  (__sync_synchronize(), (void) __sync_lock_test_and_set(&(var), (val)))
+#define ATOMIC_XCHG(var, val) \
+  (__sync_synchronize(), __sync_lock_test_and_set(&(var), (val)))
+#define ATOMIC_LOAD_PTR_ACQ(var) ATOMIC_LOAD_ACQ(var)
+#define ATOMIC_STORE_PTR_REL(var, val) ATOMIC_STORE_REL(var, val)
+#define ATOMIC_ADD64(var, val) __sync_fetch_and_add(&(var), (val))
+#define ATOMIC_FENCE() __sync_synchronize()
+#endif
+
 #if defined(WIN32)
 typedef int32_t spin_lock_t;
 #define SPINLOCK_INIT 0
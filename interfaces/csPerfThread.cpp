@@ -23,6 +23,9 @@
 
 #include <iostream>
 #include <exception>
+#include <atomic>
+#include <cstring>
+#include <stdint.h>
 
 #include "csound.hpp"
 #include "csPerfThread.hpp"
@@ -30,97 +33,149 @@
 
 // ----------------------------------------------------------------------------
 
-/**
- * Base class for event messages.
+/*
+ * Messages to the performance thread go through a bounded ring of fixed
+ * size slots, written by any number of threads and read only by the
+ * performance thread (D. Vyukov's bounded queue). The slot for position
+ * pos is free when its sequence number is pos, and holds a message when
+ * it is pos + 1. A message too large for one slot takes consecutive
+ * slots, claimed with a single compare-and-swap. Nothing is allocated
+ * per message, and the performance thread only takes a lock to sleep
+ * while paused with an empty queue, or to wake threads waiting in
+ * FlushMessageQueue() or for room in the queue.
  */
 
-class CsoundPerformanceThreadMessage {
- protected:
-    CsoundPerformanceThread *pt_;
-    void SetPaused(int state)
-    {
-      pt_->paused = state;
-    }
-    int GetPaused()
-    {
-      return pt_->paused;
-    }
-    recordData_t * getRecordData()
-    {
-      return &(pt_->recordData);
-    }
-    void lockRecord()
-    {
-        csoundLockMutex(pt_->recordLock);
-    }
-    void unlockRecord()
-    {
-        csoundUnlockMutex(pt_->recordLock);
-    }
+#define CSPT_QUEUE_SLOTS    1024        /* must be a power of two */
+#define CSPT_SLOT_DATA      104
+
+enum {
+    CSPT_MSG_PLAY,
+    CSPT_MSG_PAUSE,
+    CSPT_MSG_TOGGLE_PAUSE,
+    CSPT_MSG_STOP,
+    CSPT_MSG_STOP_RECORD,
+    CSPT_MSG_SCORE_EVENT,
+    CSPT_MSG_INPUT_MESSAGE,
+    CSPT_MSG_SCORE_OFFSET
+};
 
-    void QueueMessage(CsoundPerformanceThreadMessage *msg)
-    {
-      pt_->QueueMessage(msg);
-    }
+struct CsPerfThreadSlot {
+    std::atomic<uint64_t> seq;
+    uint16_t  type;
+    char      opcod;
+    char      absp2mode;
+    uint32_t  nslots;           // slots taken by the message, in the first
+    int32_t   count;            // p-fields, or characters with the '\0'
+    union {
+      MYFLT   p[CSPT_SLOT_DATA / sizeof(MYFLT)];
+      double  timeVal;
+      char    s[CSPT_SLOT_DATA];
+    } data;
+};
 
- public:
-    CsoundPerformanceThreadMessage *nxt;
-    virtual int run() = 0;
-    CsoundPerformanceThreadMessage(CsoundPerformanceThread *pt)
-    {
-      pt_ = pt;
-      nxt = (CsoundPerformanceThreadMessage*) 0;
-    }
-    virtual ~CsoundPerformanceThreadMessage() {}
+struct CsPerfThreadQueue {
+    CsPerfThreadSlot      *slots;
+    std::atomic<uint64_t> head;         // next position to claim
+    std::atomic<uint64_t> tail;         // next position to read
+    char                  *spill;       // multi-slot messages are copied here
+    std::atomic<int>      overflow;
+    std::atomic<long>     dropped;
+    // OverflowCoalesce: pending transport state (-1 if none, else one
+    // of CSPT_MSG_PLAY, _PAUSE or _TOGGLE_PAUSE) and score offset
+    std::atomic<int>      pendingPause;
+    std::atomic<int>      pendingSeek;
+    std::atomic<double>   seekTime;
+    // control path
+    std::atomic<int>      sleeping;     // performance thread waits for wakeCond
+    std::atomic<int>      waiters;      // threads waiting for drainCond
+    std::atomic<int>      finished;     // performance thread has returned
+    void                  *wakeLock, *wakeCond;
+    void                  *drainLock, *drainCond;
 };
 
-/**
- * Unpause performance
- */
+static inline uint32_t csptSlotsFor(size_t bytes)
+{
+    return bytes <= CSPT_SLOT_DATA ?
+      1 : (uint32_t) ((bytes + CSPT_SLOT_DATA - 1) / CSPT_SLOT_DATA);
+}
 
-class CsPerfThreadMsg_Play : public CsoundPerformanceThreadMessage {
- public:
-    CsPerfThreadMsg_Play(CsoundPerformanceThread *pt)
-    : CsoundPerformanceThreadMessage(pt) {}
-    int run()
-    {
-      SetPaused(0);
-      return 0;
+static inline bool csptHasMessage(CsPerfThreadQueue *q)
+{
+    uint64_t pos = q->tail.load(std::memory_order_relaxed);
+    return q->slots[pos & (CSPT_QUEUE_SLOTS - 1)].seq.load() == pos + 1 ||
+           q->pendingPause.load() >= 0 || q->pendingSeek.load();
+}
+
+/* Claims slots for a message and copies it in; false if it does not fit. */
+
+static bool csptTryPush(CsPerfThreadQueue *q, int type, char opcod,
+                        int absp2mode, int count,
+                        const void *data, size_t bytes)
+{
+    const uint64_t mask = CSPT_QUEUE_SLOTS - 1;
+    uint32_t  k = csptSlotsFor(bytes), i;
+    uint64_t  pos = q->head.load(std::memory_order_relaxed);
+    for (;;) {
+      // the performance thread frees slots in order, so if the last one
+      // needed is free, so are the ones before it
+      int64_t d0 = (int64_t) (q->slots[pos & mask].seq.load(
+                                std::memory_order_acquire) - pos);
+      int64_t d1 = (int64_t) (q->slots[(pos + k - 1) & mask].seq.load(
+                                std::memory_order_acquire) - (pos + k - 1));
+      if (d0 == 0 && d1 == 0) {
+        if (q->head.compare_exchange_weak(pos, pos + k,
+                                          std::memory_order_relaxed))
+          break;
+      }
+      else if (d0 < 0 || d1 < 0)
+        return false;
+      else
+        pos = q->head.load(std::memory_order_relaxed);
     }
-    ~CsPerfThreadMsg_Play() {}
-};
+    CsPerfThreadSlot *s = &q->slots[pos & mask];
+    s->type = (uint16_t) type;
+    s->opcod = opcod;
+    s->absp2mode = (char) absp2mode;
+    s->nslots = k;
+    s->count = count;
+    for (i = 0; i < k; i++) {
+      size_t n = bytes - (size_t) i * CSPT_SLOT_DATA;
+      if (n > CSPT_SLOT_DATA)
+        n = CSPT_SLOT_DATA;
+      std::memcpy(q->slots[(pos + i) & mask].data.s,
+                  (const char*) data + (size_t) i * CSPT_SLOT_DATA, n);
+      if (i > 0)
+        q->slots[(pos + i) & mask].seq.store(pos + i + 1,
+                                             std::memory_order_relaxed);
+    }
+    s->seq.store(pos + 1);              // publish
+    return true;
+}
 
-/**
- * Pause performance
- */
+/* Wakes the performance thread if it is paused with nothing to do. */
 
-class CsPerfThreadMsg_Pause : public CsoundPerformanceThreadMessage {
- public:
-    CsPerfThreadMsg_Pause(CsoundPerformanceThread *pt)
-    : CsoundPerformanceThreadMessage(pt) {}
-    int run()
-    {
-      SetPaused(1);
-      return 0;
+static void csptWake(CsPerfThreadQueue *q)
+{
+    if (q->sleeping.load()) {
+      csoundLockMutex(q->wakeLock);
+      csoundCondSignal(q->wakeCond);
+      csoundUnlockMutex(q->wakeLock);
     }
-    ~CsPerfThreadMsg_Pause() {}
-};
+}
 
-/**
- * Toggle pause mode
- */
+/* Wakes all threads waiting for drainCond. */
 
-class CsPerfThreadMsg_TogglePause : public CsoundPerformanceThreadMessage {
- public:
-    CsPerfThreadMsg_TogglePause(CsoundPerformanceThread *pt)
-    : CsoundPerformanceThreadMessage(pt) {}
-    int run()
-    {
-      SetPaused(GetPaused() ? 0 : 1);
-      return 0;
+static void csptNotifyDrained(CsPerfThreadQueue *q)
+{
+    if (q->waiters.load()) {
+      csoundLockMutex(q->drainLock);
+      for (int i = q->waiters.load(); i > 0; i--)
+        csoundCondSignal(q->drainCond);
+      csoundUnlockMutex(q->drainLock);
     }
-    ~CsPerfThreadMsg_TogglePause() {}
-};
+}
+
+// ----------------------------------------------------------------------------
 
 extern "C" {
   static uintptr_t recordThread_(void *recordData_)
@@ -151,242 +206,186 @@ extern "C" {
   }
 }
 
-class CsPerfThreadMsg_Record: public CsoundPerformanceThreadMessage {
-public:
-    CsPerfThreadMsg_Record(CsoundPerformanceThread *pt,
-                           std::string filename,
-                           int samplebits = 16,
-                           int numbufs = 4)
-    : CsoundPerformanceThreadMessage(pt)
-    {
-        this->filename = filename;
-        CsoundPerformanceThreadMessage::lockRecord();
-        recordData_t *recordData = CsoundPerformanceThreadMessage::getRecordData();
-        if (recordData->running) {
-            CsoundPerformanceThreadMessage::unlockRecord();
-            return;
-        }
-        CSOUND * csound = pt_->GetCsound();
-        if (!csound) {
-            return;
-        }
-        int bufsize = csoundGetOutputBufferSize(csound)
-                * csoundGetNchnls(csound) * numbufs;
-        recordData->cbuf = csoundCreateCircularBuffer(csound,
-                                                 bufsize,
-                                                 sizeof(MYFLT));
-
-        if (!recordData->cbuf) {
-          csoundMessage(csound, "Could create recording buffer.");
-          return;
-        }
-
-        SF_INFO sf_info;
-        sf_info.samplerate = csoundGetSr(csound);
-        sf_info.channels = csoundGetNchnls(csound);
-        switch (samplebits) {
-        case 32:
-            sf_info.format = SF_FORMAT_FLOAT;
-            break;
-        case 24:
-            sf_info.format = SF_FORMAT_PCM_24;
-            break;
-        case 16:
-        default:
-            sf_info.format = SF_FORMAT_PCM_16;
-            break;
-        }
-
-        sf_info.format |= SF_FORMAT_WAV;
-
-        recordData->sfile = (void *) sf_open(filename.c_str(),
-                                                 SFM_WRITE,
-                                                 &sf_info);
-        if (!recordData->sfile) {
-          csoundMessage(csound, "Could not open file for recording.");
-          csoundDestroyCircularBuffer(csound, recordData->cbuf);
-          return;
-        }
-        sf_command((SNDFILE *) recordData->sfile, SFC_SET_CLIPPING,
-                   NULL, SF_TRUE);
-
-        recordData->running = true;
-        recordData->thread = csoundCreateThread(recordThread_, (void*) recordData);
-
+/**
+ * Opens the file and starts the recording thread; done by the calling
+ * thread, as it may block on file system access.
+ */
 
-        CsoundPerformanceThreadMessage::unlockRecord();
-    }
-    int run()
-    {
-      return 0;
+void CsoundPerformanceThread::StartRecord(std::string filename,
+                                          int samplebits, int numbufs)
+{
+    csoundLockMutex(recordLock);
+    if (recordData.running) {
+        csoundUnlockMutex(recordLock);
+        return;
     }
-    ~CsPerfThreadMsg_Record() {
+    if (!csound) {
+        csoundUnlockMutex(recordLock);
+        return;
     }
-private:
-    std::string filename;
-
-};
-
-class CsPerfThreadMsg_StopRecord: public CsoundPerformanceThreadMessage {
-public:
-    CsPerfThreadMsg_StopRecord(CsoundPerformanceThread *pt)
-      : CsoundPerformanceThreadMessage(pt) {}
-    int run()
-    {
-
-      CsoundPerformanceThreadMessage::lockRecord();
-      recordData_t *recordData = CsoundPerformanceThreadMessage::getRecordData();
-      if (recordData->running) {
-          recordData->running = false;
-          csoundJoinThread(recordData->thread);
-          sf_close((SNDFILE *) recordData->sfile);
-      }
-
-      CsoundPerformanceThreadMessage::unlockRecord();
+    int bufsize = csoundGetOutputBufferSize(csound)
+            * csoundGetNchnls(csound) * numbufs;
+    recordData.cbuf = csoundCreateCircularBuffer(csound,
+                                                 bufsize,
+                                                 sizeof(MYFLT));
 
-      return 0;
+    if (!recordData.cbuf) {
+      csoundMessage(csound, "Could create recording buffer.");
+      csoundUnlockMutex(recordLock);
+      return;
     }
-    ~CsPerfThreadMsg_StopRecord(){}
-private:
-  //    bool start;
-};
 
+    SF_INFO sf_info;
+    sf_info.samplerate = csoundGetSr(csound);
+    sf_info.channels = csoundGetNchnls(csound);
+    switch (samplebits) {
+    case 32:
+        sf_info.format = SF_FORMAT_FLOAT;
+        break;
+    case 24:
+        sf_info.format = SF_FORMAT_PCM_24;
+        break;
+    case 16:
+    default:
+        sf_info.format = SF_FORMAT_PCM_16;
+        break;
+    }
+
+    sf_info.format |= SF_FORMAT_WAV;
+
+    recordData.sfile = (void *) sf_open(filename.c_str(),
+                                        SFM_WRITE,
+                                        &sf_info);
+    if (!recordData.sfile) {
+      csoundMessage(csound, "Could not open file for recording.");
+      csoundDestroyCircularBuffer(csound, recordData.cbuf);
+      csoundUnlockMutex(recordLock);
+      return;
+    }
+    sf_command((SNDFILE *) recordData.sfile, SFC_SET_CLIPPING,
+               NULL, SF_TRUE);
 
-/**
- * Stop performance (cannot be continued)
- */
+    recordData.running = true;
+    recordData.thread = csoundCreateThread(recordThread_, (void*) &recordData);
 
-class CsPerfThreadMsg_Stop : public CsoundPerformanceThreadMessage {
- public:
-    CsPerfThreadMsg_Stop(CsoundPerformanceThread *pt)
-    : CsoundPerformanceThreadMessage(pt)
-    {
-      CsoundPerformanceThreadMessage::QueueMessage(
-                                         new CsPerfThreadMsg_StopRecord(pt));
-    }
-    int run()
-    {
-      return 1;
-    }
-    ~CsPerfThreadMsg_Stop() {}
-};
+    csoundUnlockMutex(recordLock);
+}
 
 /**
- * Score event message
+ * Runs one message on the performance thread. Returns non-zero to stop
+ * performance.
  *
- * absp2mode: if non-zero, start times are measured from the beginning of
- *            performance, instead of the current time
- * opcod:     score opcode (e.g. 'i' for a note event)
- * pcnt:      number of p-fields
- * *p:        array of p-fields, p[0] is p1
+ * CSPT_MSG_SCORE_EVENT:
+ *   absp2mode: if non-zero, start times are measured from the beginning of
+ *              performance, instead of the current time
+ *   opcod:     score opcode (e.g. 'i' for a note event)
+ *   count:     number of p-fields
+ *   data:      array of p-fields, p[0] is p1
+ * CSPT_MSG_INPUT_MESSAGE: score event as a string, in data
+ * CSPT_MSG_SCORE_OFFSET:  seek to the score time (in seconds) in data
  */
 
-class CsPerfThreadMsg_ScoreEvent : public CsoundPerformanceThreadMessage {
- private:
-    char    opcod;
-    int     absp2mode;
-    int     pcnt;
-    MYFLT   *pp;
-    MYFLT   p[10];
- public:
-    CsPerfThreadMsg_ScoreEvent(CsoundPerformanceThread *pt,
-                               int absp2mode, char opcod,
-                               int pcnt, const MYFLT *p)
-    : CsoundPerformanceThreadMessage(pt)
-    {
-      this->opcod = opcod;
-      this->absp2mode = absp2mode;
-      this->pcnt = pcnt;
-      if (pcnt <= 10)
-        this->pp = &(this->p[0]);
-      else
-        this->pp = new MYFLT[(unsigned int) pcnt];
-      for (int i = 0; i < pcnt; i++)
-        this->pp[i] = p[i];
-    }
-    int run() {
-      CSOUND  *csound = pt_->GetCsound();
-      if (absp2mode && pcnt > 1) {
-        double  p2 = (double) pp[1] - csoundGetScoreTime(csound);
-        if (p2 < 0.0) {
-          if (pcnt > 2 && pp[2] >= (MYFLT) 0 &&
-              (opcod == 'a' || opcod == 'i')) {
-            pp[2] = (MYFLT) ((double) pp[2] + p2);
-            if (pp[2] <= (MYFLT) 0)
-              return 0;
+int CsoundPerformanceThread::RunMessage(int type, char opcod, int absp2mode,
+                                        int count, void *data)
+{
+    switch (type) {
+    case CSPT_MSG_PLAY:
+      paused = 0;
+      break;
+    case CSPT_MSG_PAUSE:
+      paused = 1;
+      break;
+    case CSPT_MSG_TOGGLE_PAUSE:
+      paused = (paused ? 0 : 1);
+      break;
+    case CSPT_MSG_STOP:
+      return 1;
+    case CSPT_MSG_STOP_RECORD:
+      csoundLockMutex(recordLock);
+      if (recordData.running) {
+          recordData.running = false;
+          csoundJoinThread(recordData.thread);
+          sf_close((SNDFILE *) recordData.sfile);
+      }
+      csoundUnlockMutex(recordLock);
+      break;
+    case CSPT_MSG_SCORE_EVENT:
+      {
+        MYFLT *pp = (MYFLT*) data;
+        if (absp2mode && count > 1) {
+          double  p2 = (double) pp[1] - csoundGetScoreTime(csound);
+          if (p2 < 0.0) {
+            if (count > 2 && pp[2] >= (MYFLT) 0 &&
+                (opcod == 'a' || opcod == 'i')) {
+              pp[2] = (MYFLT) ((double) pp[2] + p2);
+              if (pp[2] <= (MYFLT) 0)
+                return 0;
+            }
+            p2 = 0.0;
           }
-          p2 = 0.0;
+          pp[1] = (MYFLT) p2;
         }
-        pp[1] = (MYFLT) p2;
+        if (csoundScoreEvent(csound, opcod, pp, (long) count) != 0)
+          csoundMessageS(csound, CSOUNDMSG_WARNING,
+                         "WARNING: could not create score event\n");
       }
-      if (csoundScoreEvent(csound, opcod, pp, (long) pcnt) != 0)
-        csoundMessageS(csound, CSOUNDMSG_WARNING,
-                       "WARNING: could not create score event\n");
-      return 0;
-    }
-    ~CsPerfThreadMsg_ScoreEvent()
-    {
-      if (pcnt > 10)
-        delete[] pp;
-    }
-};
-
-/**
- * Score event message as a string
- */
-
-class CsPerfThreadMsg_InputMessage : public CsoundPerformanceThreadMessage {
- private:
-    int     len;
-    char    *sp;
-    char    s[128];
- public:
-    CsPerfThreadMsg_InputMessage(CsoundPerformanceThread *pt, const char *s)
-    : CsoundPerformanceThreadMessage(pt)
-    {
-      len = (int) strlen(s);
-      if (len < 128)
-        this->sp = &(this->s[0]);
-      else
-        this->sp = new char[(unsigned int) (len + 1)];
-      strcpy(this->sp, s);
-    }
-    int run()
-    {
-      csoundInputMessage(pt_->GetCsound(), sp);
-      return 0;
+      break;
+    case CSPT_MSG_INPUT_MESSAGE:
+      csoundInputMessage(csound, (const char*) data);
+      break;
+    case CSPT_MSG_SCORE_OFFSET:
+      csoundSetScoreOffsetSeconds(csound, (MYFLT) *((double*) data));
+      break;
     }
-    ~CsPerfThreadMsg_InputMessage()
-    {
-      if (len >= 128)
-        delete[] sp;
-    }
-};
+    return 0;
+}
 
 /**
- * Seek to the specified score time
+ * Runs all queued messages, then any coalesced transport state and
+ * score offset. Returns non-zero to stop performance.
  */
 
-class CsPerfThreadMsg_SetScoreOffsetSeconds
-      : public CsoundPerformanceThreadMessage {
-private:
-    double  timeVal;
-public:
-    CsPerfThreadMsg_SetScoreOffsetSeconds(CsoundPerformanceThread *pt,
-                                          double timeVal)
-    : CsoundPerformanceThreadMessage(pt)
-    {
-      this->timeVal = timeVal;
-    }
-    int run()
-    {
-      csoundSetScoreOffsetSeconds(pt_->GetCsound(), (MYFLT) timeVal);
-      return 0;
-    }
-    ~CsPerfThreadMsg_SetScoreOffsetSeconds() {}
-};
-
-// ----------------------------------------------------------------------------
+int CsoundPerformanceThread::ProcessMessages()
+{
+    const uint64_t mask = CSPT_QUEUE_SLOTS - 1;
+    CsPerfThreadQueue *q = queue;
+    uint64_t  pos = q->tail.load(std::memory_order_relaxed);
+    int       retval = 0, n = 0;
+
+    while (!retval) {
+      CsPerfThreadSlot *s = &q->slots[pos & mask];
+      if (s->seq.load(std::memory_order_acquire) != pos + 1)
+        break;
+      uint32_t k = s->nslots, i;
+      void *data = s->data.s;
+      if (k > 1) {                      // make the message contiguous
+        for (i = 0; i < k; i++)
+          std::memcpy(q->spill + (size_t) i * CSPT_SLOT_DATA,
+                      q->slots[(pos + i) & mask].data.s, CSPT_SLOT_DATA);
+        data = q->spill;
+      }
+      retval = RunMessage(s->type, s->opcod, s->absp2mode, s->count, data);
+      for (i = 0; i < k; i++)
+        q->slots[(pos + i) & mask].seq.store(pos + i + CSPT_QUEUE_SLOTS,
+                                             std::memory_order_release);
+      pos += k;
+      q->tail.store(pos);
+      n++;
+    }
+    if (!retval && q->pendingPause.load(std::memory_order_relaxed) >= 0) {
+      retval = RunMessage(q->pendingPause.exchange(-1), 0, 0, 0, NULL);
+      n++;
+    }
+    if (!retval && q->pendingSeek.load(std::memory_order_relaxed)) {
+      q->pendingSeek.store(0);
+      double timeVal = q->seekTime.load();
+      retval = RunMessage(CSPT_MSG_SCORE_OFFSET, 0, 0, 0, &timeVal);
+      n++;
+    }
+    if (n)
+      csptNotifyDrained(q);
+    return retval;
+}
 
 /**
  * Performs the score until end of score, error, or receiving a stop event.
@@ -395,39 +394,21 @@ public:
 
 int CsoundPerformanceThread::Perform()
 {
+    CsPerfThreadQueue *q = queue;
     int retval = 0;
     do {
-      while (firstMessage) {
-        csoundLockMutex(queueLock);
-        do {
-          CsoundPerformanceThreadMessage *msg;
-          // get oldest message
-          msg = (CsoundPerformanceThreadMessage*) firstMessage;
-          if (!msg)
-            break;
-          // unlink from FIFO
-          firstMessage = msg->nxt;
-          if (!msg->nxt)
-            lastMessage = (CsoundPerformanceThreadMessage*) 0;
-          // process and destroy message
-          retval = msg->run();
-          delete msg; // TODO: This should be moved out of the Perform function
-        } while (!retval);
-        if (paused)
-          csoundWaitThreadLock(pauseLock, (size_t) 0);
-        // mark queue as empty
-        csoundNotifyThreadLock(flushLock);
-        csoundUnlockMutex(queueLock);
-        // if error or end of score, return now
-        if (retval)
+      if ((retval = ProcessMessages()) != 0)
+        goto endOfPerf;
+      // if paused, wait until a new message is received
+      while (paused) {
+        csoundLockMutex(q->wakeLock);
+        q->sleeping.store(1);
+        if (!csptHasMessage(q))
+          csoundCondWait(q->wakeCond, q->wakeLock);
+        q->sleeping.store(0);
+        csoundUnlockMutex(q->wakeLock);
+        if ((retval = ProcessMessages()) != 0)
           goto endOfPerf;
-        // fprintf(stderr, "Error or end of score, returning now.");
-        // if paused, wait until a new message is received, then loop back
-        if (!paused)
-          break;
-        // VL: if this is paused, then it will double lock.
-        csoundWaitThreadLockNoTimeout(pauseLock);
-        csoundNotifyThreadLock(pauseLock);
       }
       if(processcallback != NULL)
            processcallback(cdata);
@@ -455,21 +436,25 @@ int CsoundPerformanceThread::Perform()
  endOfPerf:
     status = retval;
     csoundCleanup(csound);
-    // delete any pending messages
-    csoundLockMutex(queueLock);
+    // discard any pending messages, and release threads waiting for room
+    // or for the queue to be flushed
+    q->finished.store(1);
     {
-      CsoundPerformanceThreadMessage *msg;
-      msg = (CsoundPerformanceThreadMessage*) firstMessage;
-      firstMessage = (CsoundPerformanceThreadMessage*) 0;
-      lastMessage = (CsoundPerformanceThreadMessage*) 0;
-      while (msg) {
-        CsoundPerformanceThreadMessage *nxt = msg->nxt;
-        delete msg;
-        msg = nxt;
+      const uint64_t mask = CSPT_QUEUE_SLOTS - 1;
+      uint64_t pos = q->tail.load(std::memory_order_relaxed);
+      CsPerfThreadSlot *s;
+      while ((s = &q->slots[pos & mask])->seq.load() == pos + 1) {
+        uint32_t k = s->nslots;
+        for (uint32_t i = 0; i < k; i++)
+          q->slots[(pos + i) & mask].seq.store(pos + i + CSPT_QUEUE_SLOTS);
+        pos += k;
       }
+      q->tail.store(pos);
     }
-    csoundNotifyThreadLock(flushLock);
-    csoundUnlockMutex(queueLock);
+    csoundLockMutex(q->drainLock);
+    for (int i = q->waiters.load(); i > 0; i--)
+      csoundCondSignal(q->drainCond);
+    csoundUnlockMutex(q->drainLock);
     //running = 0;
     return retval;
 }
@@ -503,14 +488,69 @@ extern "C" {
   }
 }
 
+static void csptDestroyQueue(CsPerfThreadQueue *q)
+{
+    if (!q)
+      return;
+    if (q->wakeLock)
+      csoundDestroyMutex(q->wakeLock);
+    if (q->drainLock)
+      csoundDestroyMutex(q->drainLock);
+    csoundDestroyCondVar(q->wakeCond);
+    csoundDestroyCondVar(q->drainCond);
+    delete[] q->slots;
+    delete[] q->spill;
+    delete q;
+}
+
+static CsPerfThreadQueue *csptCreateQueue()
+{
+    CsPerfThreadQueue *q;
+    try {
+      q = new CsPerfThreadQueue;
+    }
+    catch (std::bad_alloc&) {
+      return (CsPerfThreadQueue*) 0;
+    }
+    q->slots = (CsPerfThreadSlot*) 0;
+    q->spill = (char*) 0;
+    q->wakeLock = q->drainLock = (void*) 0;
+    q->wakeCond = q->drainCond = (void*) 0;
+    try {
+      q->slots = new CsPerfThreadSlot[CSPT_QUEUE_SLOTS];
+      q->spill = new char[(size_t) CSPT_QUEUE_SLOTS * CSPT_SLOT_DATA];
+    }
+    catch (std::bad_alloc&) {
+      csptDestroyQueue(q);
+      return (CsPerfThreadQueue*) 0;
+    }
+    for (uint64_t i = 0; i < CSPT_QUEUE_SLOTS; i++)
+      q->slots[i].seq.store(i, std::memory_order_relaxed);
+    q->head.store(0);
+    q->tail.store(0);
+    q->overflow.store(CsoundPerformanceThread::OverflowBlock);
+    q->dropped.store(0);
+    q->pendingPause.store(-1);
+    q->pendingSeek.store(0);
+    q->seekTime.store(0.0);
+    q->sleeping.store(0);
+    q->waiters.store(0);
+    q->finished.store(0);
+    q->wakeLock = csoundCreateMutex(0);
+    q->drainLock = csoundCreateMutex(0);
+    q->wakeCond = csoundCreateCondVar();
+    q->drainCond = csoundCreateCondVar();
+    if (!q->wakeLock || !q->drainLock || !q->wakeCond || !q->drainCond) {
+      csptDestroyQueue(q);
+      return (CsPerfThreadQueue*) 0;
+    }
+    return q;
+}
+
 void CsoundPerformanceThread::csPerfThread_constructor(CSOUND *csound_)
 {
     csound = csound_;
-    firstMessage = (CsoundPerformanceThreadMessage*) 0;
-    lastMessage = (CsoundPerformanceThreadMessage*) 0;
-    queueLock = (void*) 0;
-    pauseLock = (void*) 0;
-    flushLock = (void*) 0;
+    queue = (CsPerfThreadQueue*) 0;
     recordLock = (void *) 0;
     perfThread = (void*) 0;
     paused = 1;
@@ -518,25 +558,12 @@ void CsoundPerformanceThread::csPerfThread_constructor(CSOUND *csound_)
     cdata = 0;
     processcallback = 0;
     running = 0;
-    queueLock = csoundCreateMutex(0);
-    if (!queueLock)
-      return;
-    pauseLock = csoundCreateThreadLock();
-    if (!pauseLock)
-      return;
-    flushLock = csoundCreateThreadLock();
-    if (!flushLock)
+    queue = csptCreateQueue();
+    if (!queue)
       return;
     recordLock = csoundCreateMutex(0);
     if (!recordLock)
       return;
-    try {
-      lastMessage = new CsPerfThreadMsg_Pause(this);
-    }
-    catch (std::bad_alloc&) {
-      return;
-    }
-    firstMessage = lastMessage;
     recordData.cbuf = NULL;
     recordData.sfile = NULL;
     recordData.thread = NULL;
@@ -584,15 +611,7 @@ CsoundPerformanceThread::~CsoundPerformanceThread()
     if (!status)
       this->Stop();     // FIXME: should handle memory errors here
     this->Join();
-    if (queueLock) {
-        csoundDestroyMutex(queueLock);
-    }
-    if (pauseLock) {
-        csoundDestroyMutex(pauseLock);
-    }
-    if (flushLock) {
-        csoundDestroyMutex(flushLock);
-    }
+    csptDestroyQueue(queue);
     if (recordLock) {
         csoundDestroyMutex(recordLock);
 
@@ -601,74 +620,147 @@ CsoundPerformanceThread::~CsoundPerformanceThread()
 
 // ----------------------------------------------------------------------------
 
-void CsoundPerformanceThread::QueueMessage(CsoundPerformanceThreadMessage *msg)
+/**
+ * Sends a message to the performance thread. count and data are the
+ * message's arguments (bytes long), copied into the queue.
+ */
+
+void CsoundPerformanceThread::QueueMessage(int type, char opcod,
+                                           int absp2mode, int count,
+                                           const void *data, size_t bytes)
 {
-    if (status) {
-      delete msg;
+    CsPerfThreadQueue *q = queue;
+    if (status || !q)
+      return;
+    if (csptSlotsFor(bytes) > CSPT_QUEUE_SLOTS) {
+      csoundMessageS(csound, CSOUNDMSG_WARNING,
+                     "WARNING: message too large for the performance "
+                     "thread queue\n");
+      q->dropped++;
       return;
     }
-    csoundLockMutex(queueLock);
-    // link message into FIFO
-    if (!lastMessage)
-      firstMessage = msg;
-    else
-      lastMessage->nxt = msg;
-    lastMessage = msg;
-    // mark queue as non-empty
-    csoundWaitThreadLock(flushLock, (size_t) 0);
-    // wake up from pause
-    csoundNotifyThreadLock(pauseLock);
-    csoundUnlockMutex(queueLock);
+    if (!csptTryPush(q, type, opcod, absp2mode, count, data, bytes)) {
+      int policy = q->overflow.load(std::memory_order_relaxed);
+      if (policy == OverflowDrop &&
+          (type == CSPT_MSG_SCORE_EVENT || type == CSPT_MSG_INPUT_MESSAGE)) {
+        q->dropped++;
+        return;
+      }
+      if (policy == OverflowCoalesce &&
+          (type == CSPT_MSG_PLAY || type == CSPT_MSG_PAUSE ||
+           type == CSPT_MSG_TOGGLE_PAUSE)) {
+        int state = q->pendingPause.load();
+        int next;
+        do {                            // a toggle applies to the pending state
+          if (type != CSPT_MSG_TOGGLE_PAUSE)
+            next = type;
+          else if (state < 0)
+            next = CSPT_MSG_TOGGLE_PAUSE;
+          else if (state == CSPT_MSG_TOGGLE_PAUSE)
+            next = -1;
+          else
+            next = (state == CSPT_MSG_PLAY ? CSPT_MSG_PAUSE : CSPT_MSG_PLAY);
+        } while (!q->pendingPause.compare_exchange_weak(state, next));
+        csptWake(q);
+        return;
+      }
+      if (policy == OverflowCoalesce && type == CSPT_MSG_SCORE_OFFSET) {
+        q->seekTime.store(*((const double*) data));
+        q->pendingSeek.store(1);
+        csptWake(q);
+        return;
+      }
+      // wait for room; the performance thread signals drainCond after
+      // moving the tail, if it sees a waiter
+      csoundLockMutex(q->drainLock);
+      q->waiters++;
+      for (;;) {
+        uint64_t seen = q->tail.load();
+        if (csptTryPush(q, type, opcod, absp2mode, count, data, bytes))
+          break;
+        if (q->finished.load()) {
+          q->waiters--;
+          csoundUnlockMutex(q->drainLock);
+          return;
+        }
+        if (q->tail.load() == seen)
+          csoundCondWait(q->drainCond, q->drainLock);
+      }
+      q->waiters--;
+      csoundUnlockMutex(q->drainLock);
+    }
+    csptWake(q);
 }
 
 void CsoundPerformanceThread::Play()
 {
-    QueueMessage(new CsPerfThreadMsg_Play(this));
+    QueueMessage(CSPT_MSG_PLAY, 0, 0, 0, NULL, 0);
 }
 
 void CsoundPerformanceThread::Pause()
 {
-    QueueMessage(new CsPerfThreadMsg_Pause(this));
+    QueueMessage(CSPT_MSG_PAUSE, 0, 0, 0, NULL, 0);
 }
 
 void CsoundPerformanceThread::TogglePause()
 {
-    QueueMessage(new CsPerfThreadMsg_TogglePause(this));
+    QueueMessage(CSPT_MSG_TOGGLE_PAUSE, 0, 0, 0, NULL, 0);
 }
 
 void CsoundPerformanceThread::Stop()
 {
-    QueueMessage(new CsPerfThreadMsg_Stop(this));
+    QueueMessage(CSPT_MSG_STOP_RECORD, 0, 0, 0, NULL, 0);
+    QueueMessage(CSPT_MSG_STOP, 0, 0, 0, NULL, 0);
 }
 
 void CsoundPerformanceThread::Record(std::string filename,
                                      int samplebits,
                                      int numbufs)
 {
-    QueueMessage(new CsPerfThreadMsg_Record(this, filename,
-                                            samplebits, numbufs));
+    if (!status)
+      StartRecord(filename, samplebits, numbufs);
 }
 
 void CsoundPerformanceThread::StopRecord()
 {
-    QueueMessage(new CsPerfThreadMsg_StopRecord(this));
+    QueueMessage(CSPT_MSG_STOP_RECORD, 0, 0, 0, NULL, 0);
 }
 
 void CsoundPerformanceThread::ScoreEvent(int absp2mode, char opcod,
                                          int pcnt, const MYFLT *p)
 {
-    QueueMessage(new CsPerfThreadMsg_ScoreEvent(this,
-                                                absp2mode, opcod, pcnt, p));
+    if (pcnt < 0)
+      pcnt = 0;
+    QueueMessage(CSPT_MSG_SCORE_EVENT, opcod, absp2mode, pcnt,
+                 p, (size_t) pcnt * sizeof(MYFLT));
 }
 
 void CsoundPerformanceThread::InputMessage(const char *s)
 {
-    QueueMessage(new CsPerfThreadMsg_InputMessage(this, s));
+    size_t len = strlen(s) + 1;
+    QueueMessage(CSPT_MSG_INPUT_MESSAGE, 0, 0, (int) len, s, len);
 }
 
 void CsoundPerformanceThread::SetScoreOffsetSeconds(double timeVal)
 {
-    QueueMessage(new CsPerfThreadMsg_SetScoreOffsetSeconds(this, timeVal));
+    QueueMessage(CSPT_MSG_SCORE_OFFSET, 0, 0, 0, &timeVal, sizeof(double));
+}
+
+void CsoundPerformanceThread::SetOverflowPolicy(OverflowPolicy policy)
+{
+    if (queue)
+      queue->overflow.store(policy);
+}
+
+CsoundPerformanceThread::OverflowPolicy
+CsoundPerformanceThread::GetOverflowPolicy()
+{
+    return queue ? (OverflowPolicy) queue->overflow.load() : OverflowBlock;
+}
+
+long CsoundPerformanceThread::GetDroppedMessages()
+{
+    return queue ? queue->dropped.load() : 0L;
 }
 
 int CsoundPerformanceThread::Join()
@@ -686,34 +778,6 @@ int CsoundPerformanceThread::Join()
         csoundJoinThread(recordData.thread);
     }
 
-    // delete any pending messages
-    {
-      CsoundPerformanceThreadMessage *msg;
-      msg = (CsoundPerformanceThreadMessage*) firstMessage;
-      firstMessage = (CsoundPerformanceThreadMessage*) 0;
-      lastMessage = (CsoundPerformanceThreadMessage*) 0;
-      while (msg) {
-        CsoundPerformanceThreadMessage *nxt = msg->nxt;
-        delete msg;
-        msg = nxt;
-      }
-    }
-    // delete all thread locks
-    if (queueLock) {
-      csoundDestroyMutex(queueLock);
-      queueLock = (void*) 0;
-    }
-    if (pauseLock) {
-      csoundNotifyThreadLock(pauseLock);
-      csoundDestroyThreadLock(pauseLock);
-      pauseLock = (void*) 0;
-    }
-    if (flushLock) {
-      csoundNotifyThreadLock(flushLock);
-      csoundDestroyThreadLock(flushLock);
-      flushLock = (void*) 0;
-    }
-
     running = 0;
     return retval;
 }
@@ -725,10 +789,18 @@ int CsoundPerformanceThread::Join()
 
 void CsoundPerformanceThread::FlushMessageQueue()
 {
-    if (firstMessage) {
-      csoundWaitThreadLockNoTimeout(flushLock);
-      csoundNotifyThreadLock(flushLock);
-    }
+    CsPerfThreadQueue *q = queue;
+    if (!q || status)
+      return;
+    uint64_t target = q->head.load();
+    csoundLockMutex(q->drainLock);
+    q->waiters++;
+    while (!q->finished.load() &&
+           ((int64_t) (q->tail.load() - target) < 0 ||
+            q->pendingPause.load() >= 0 || q->pendingSeek.load()))
+      csoundCondWait(q->drainCond, q->drainLock);
+    q->waiters--;
+    csoundUnlockMutex(q->drainLock);
 }
 
 
@@ -24,7 +24,7 @@
 #ifndef CSOUND_CSPERFTHREAD_HPP
 #define CSOUND_CSPERFTHREAD_HPP
 
-class CsoundPerformanceThreadMessage;
+struct CsPerfThreadQueue;
 class CsPerfThread_PerformScore;
 
 #ifdef SWIG
@@ -117,13 +117,30 @@ typedef struct {
 } recordData_t;
 
 class PUBLIC CsoundPerformanceThread {
+ public:
+    /**
+     * What a call that sends a message does when the message queue is
+     * full. Stop() and StopRecord() always wait for room.
+     *
+     * OverflowBlock:    wait until the performance thread has made room
+     *                   (the default).
+     * OverflowDrop:     discard score events and input messages that do
+     *                   not fit, and count them (see GetDroppedMessages());
+     *                   other messages wait.
+     * OverflowCoalesce: Play(), Pause(), TogglePause() and
+     *                   SetScoreOffsetSeconds() calls that do not fit are
+     *                   merged into one pending transport state and score
+     *                   offset, which the performance thread applies after
+     *                   the queued messages; other messages wait.
+     */
+    enum OverflowPolicy {
+      OverflowBlock,
+      OverflowDrop,
+      OverflowCoalesce
+    };
  private:
     CSOUND  *csound;
-    volatile CsoundPerformanceThreadMessage *firstMessage;
-    CsoundPerformanceThreadMessage *lastMessage;
-    void    *queueLock;         // this is actually a mutex
-    void    *pauseLock;
-    void    *flushLock;
+    CsPerfThreadQueue *queue;
     void    *recordLock;
     void    *perfThread;
     int     paused;
@@ -133,8 +150,12 @@ class PUBLIC CsoundPerformanceThread {
     int  running;
     void (*processcallback)(void *cdata);
     int  Perform();
+    int  ProcessMessages();
+    int  RunMessage(int type, char opcod, int absp2mode, int count, void *data);
     void csPerfThread_constructor(CSOUND *);
-    void QueueMessage(CsoundPerformanceThreadMessage *);
+    void QueueMessage(int type, char opcod, int absp2mode, int count,
+                      const void *data, size_t bytes);
+    void StartRecord(std::string filename, int samplebits, int numbufs);
  public:
 #ifdef SWIGPYTHON
   PyThreadState *_tstate;
@@ -226,12 +247,24 @@ class PUBLIC CsoundPerformanceThread {
      * are actually received by the performance thread.
      */
     void FlushMessageQueue();
+    /**
+     * Sets what happens to messages sent while the queue is full.
+     */
+    void SetOverflowPolicy(OverflowPolicy policy);
+    /**
+     * Returns the current overflow policy.
+     */
+    OverflowPolicy GetOverflowPolicy();
+    /**
+     * Returns the number of messages discarded because the queue was full
+     * (with OverflowDrop) or because they were too large for it.
+     */
+    long GetDroppedMessages();
     // --------
     CsoundPerformanceThread(Csound *);
     CsoundPerformanceThread(CSOUND *);
     ~CsoundPerformanceThread();
     // --------
-    friend class CsoundPerformanceThreadMessage;
     friend class CsPerfThread_PerformScore;
 };
 
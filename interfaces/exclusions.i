@@ -33,7 +33,7 @@
 %ignore Csound::SetYieldCallback;
 
 %ignore csoundMessageV;
-%ignore CsoundPerformanceThreadMessage;
+%ignore CsPerfThreadQueue;
 %ignore csoundRegisterSenseEventCallback;
 %ignore csoundSetCscoreCallback;
 %ignore csoundSetDrawGraphCallback;
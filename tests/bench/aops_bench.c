@@ -0,0 +1,167 @@
+/*
+  aops_bench.c:
+
+  Times the aops kernels of every instruction set the CPU supports
+  and prints the speedup of each over the scalar code.
+
+    aops_bench [block size] [milliseconds per kernel] [channels]
+
+  outchn is run as spoutsf() runs it: once per channel over a block of
+  spraw, writing interleaved spout and output buffer frames, with each
+  channel's peak kept from call to call.
+
+  This file is part of Csound.
+
+  The Csound Library is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Csound is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "csoundCore.h"
+#include "aops_simd.h"
+
+#define MAXSETS (8)
+
+enum { K_VV, K_VS, K_SV, K_POW2, K_CPSOCT, K_EXP, K_LOG, K_OUT };
+
+static const struct {
+    const char *name;
+    int32_t kind, op;
+} kernels[] = {
+    { "a+a", K_VV, AOPS_ADD }, { "a-a", K_VV, AOPS_SUB },
+    { "a*a", K_VV, AOPS_MUL }, { "a/a", K_VV, AOPS_DIV },
+    { "a+k", K_VS, AOPS_ADD }, { "a*k", K_VS, AOPS_MUL },
+    { "k-a", K_SV, AOPS_SUB }, { "k/a", K_SV, AOPS_DIV },
+    { "powoftwo", K_POW2, 0 }, { "cpsoct", K_CPSOCT, 0 },
+    { "ampdb", K_EXP, 0 },     { "dbamp", K_LOG, 0 },
+    { "outchn", K_OUT, 0 }
+};
+
+static MYFLT *r, *a, *b, pow2tab[POW2TABSIZI], octtab[OCTRES];
+static MYFLT *spraw, *spout, *outbuf, *maxamp;
+static uint32_t nchnls = 2;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void run(const AOPS_KERNELS *k, int32_t n, uint32_t nsmps)
+{
+    switch (kernels[n].kind) {
+    case K_VV:
+      k->vv[kernels[n].op](r, a, b, nsmps); break;
+    case K_VS:
+      k->vs[kernels[n].op](r, a, FL(0.5), nsmps); break;
+    case K_SV:
+      k->sv[kernels[n].op](r, FL(0.5), b, nsmps); break;
+    case K_POW2:
+      k->pow2(r, a, pow2tab, nsmps); break;
+    case K_CPSOCT:
+      k->cpsoct(r, b, octtab, nsmps); break;
+    case K_EXP:
+      k->expk(r, a, (MYFLT) LOG10D20, FL(1.0), nsmps); break;
+    case K_LOG:
+      k->logk(r, b, (MYFLT) LOG10D20, nsmps); break;
+    case K_OUT:
+      {
+        uint32_t chn;
+        for (chn = 0; chn < nchnls; chn++) {
+          int32_t nover = 0;
+          k->outchn(&spout[chn], &outbuf[chn], nchnls, &spraw[chn*nsmps],
+                    FL(0.5), FL(1.0), &maxamp[chn], &nover, nsmps);
+        }
+      }
+      break;
+    }
+}
+
+/* returns nanoseconds per sample (per channel for outchn) */
+static double bench(const AOPS_KERNELS *k, int32_t n, uint32_t nsmps,
+                    double secs)
+{
+    double  t0, t, per = (kernels[n].kind == K_OUT ? nchnls : 1);
+    long    i, reps = 16, done = 0;
+
+    memset(maxamp, 0, nchnls * sizeof(MYFLT));
+
+    for (i = 0; i < reps; i++) run(k, n, nsmps);       /* warm up */
+    t0 = now();
+    do {
+      for (i = 0; i < reps; i++) run(k, n, nsmps);
+      done += reps;
+      reps *= 2;
+      t = now() - t0;
+    } while (t < secs);
+    return t * 1.0e9 / ((double) done * nsmps * per);
+}
+
+int main(int argc, char **argv)
+{
+    const AOPS_KERNELS *sets[MAXSETS];
+    uint32_t nsmps = argc > 1 ? (uint32_t) atoi(argv[1]) : 64;
+    double  secs = (argc > 2 ? atof(argv[2]) : 200.0) * 1.0e-3;
+    int32_t nsets, i, j;
+
+    if (nsmps < 1) nsmps = 1;
+    if (argc > 3 && atoi(argv[3]) > 0) nchnls = (uint32_t) atoi(argv[3]);
+    r = (MYFLT *) malloc(nsmps * sizeof(MYFLT));
+    a = (MYFLT *) malloc(nsmps * sizeof(MYFLT));
+    b = (MYFLT *) malloc(nsmps * sizeof(MYFLT));
+    for (i = 0; i < (int32_t) nsmps; i++) {
+      a[i] = (MYFLT) (i % 97) * FL(0.125) - FL(6.0);
+      b[i] = (MYFLT) (i % 89) * FL(0.0625) + FL(4.0);
+    }
+    spraw = (MYFLT *) malloc(nchnls * nsmps * sizeof(MYFLT));
+    spout = (MYFLT *) malloc(nchnls * nsmps * sizeof(MYFLT));
+    outbuf = (MYFLT *) malloc(nchnls * nsmps * sizeof(MYFLT));
+    maxamp = (MYFLT *) malloc(nchnls * sizeof(MYFLT));
+    for (i = 0; i < (int32_t) (nchnls * nsmps); i++)
+      spraw[i] = (MYFLT) sin(i * 0.01) * FL(0.8);
+    for (i = 0; i < POW2TABSIZI; i++)
+      pow2tab[i] = (MYFLT) pow(2.0, (double) i / POW2TABSIZI);
+    for (i = 0; i < OCTRES; i++)
+      octtab[i] = (MYFLT) (pow(2.0, (double) i / OCTRES) * 1.02197486); /* ONEPT, A4=440 */
+
+    nsets = aops_kernel_sets(sets, MAXSETS);
+    printf("%d samples per call, %d output channels, %s precision\n\n",
+           (int) nsmps, (int) nchnls,
+           sizeof(MYFLT) == sizeof(double) ? "double" : "single");
+    printf("%-10s", "kernel");
+    for (j = 0; j < nsets; j++) printf("%18s", sets[j]->name);
+    printf("\n");
+    for (i = 0; i < (int32_t) (sizeof(kernels) / sizeof(kernels[0])); i++) {
+      double base = 0.0;
+      printf("%-10s", kernels[i].name);
+      for (j = 0; j < nsets; j++) {
+        double ns = bench(sets[j], i, nsmps, secs);
+        if (j == 0) {
+          base = ns;
+          printf("%12.3f ns   ", ns);
+        }
+        else printf("%12.3f %4.1fx", ns, base / ns);
+      }
+      printf("\n");
+    }
+    free(r); free(a); free(b);
+    free(spraw); free(spout); free(outbuf); free(maxamp);
+    return 0;
+}
@@ -0,0 +1,406 @@
+/*
+  csound_bench.c:
+
+  Throughput benchmarks of the engine: micro-benchmarks of the FFT,
+  arithmetic, instance allocation, channel and oscillator paths, and
+  offline renders of the orchestras in tests/bench/render. Results are
+  written as JSON and can be compared against a stored baseline.
+
+    csound_bench [-t ms] [-o results.json] [-b baseline.json]
+                 [-r percent] [-f filter] [csound options]
+
+  -t   time spent on each benchmark (default 200 ms)
+  -o   write the JSON results to this file instead of stdout; the
+       table of results always goes to stderr
+  -b   compare against a previous results file; exits with status 1
+       if any benchmark is slower by more than -r percent (default 10)
+  -f   only run benchmarks whose name contains filter
+  Other arguments starting with - are passed to each Csound instance.
+
+  This file is part of Csound.
+
+  The Csound Library is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Csound is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "csoundCore.h"
+
+#ifndef BENCH_RENDER_DIR
+#define BENCH_RENDER_DIR "render"
+#endif
+
+#define MAXRESULTS  (64)
+#define MAXOPTS     (16)
+
+typedef struct {
+    char    name[64];
+    const char *unit;
+    int     higher;             /* higher values are better */
+    double  value;
+} RESULT;
+
+static RESULT   results[MAXRESULTS];
+static int      nresults;
+static double   secs = 0.2;
+static const char *filter;
+static const char *opts[MAXOPTS];
+static int      nopts;
+
+static const char *renders[] = {
+    "additive.csd", "fm_reverb.csd", "subtractive_udo.csd", "spectral.csd"
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static int wanted(const char *name)
+{
+    return filter == NULL || strstr(name, filter) != NULL;
+}
+
+static void result(const char *name, const char *unit, int higher,
+                   double value)
+{
+    RESULT *r;
+    if (nresults == MAXRESULTS) return;
+    r = &results[nresults++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->unit = unit;
+    r->higher = higher;
+    r->value = value;
+    fprintf(stderr, "%-28s %14.3f %s\n", name, value, unit);
+}
+
+static void quiet(CSOUND *csound, int attr, const char *fmt, va_list args)
+{
+    (void) csound; (void) attr; (void) fmt; (void) args;
+}
+
+static CSOUND *create(void)
+{
+    CSOUND *csound = csoundCreate(NULL);
+    int     i;
+    csoundSetMessageCallback(csound, quiet);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-m0");
+    for (i = 0; i < nopts; i++)
+      csoundSetOption(csound, opts[i]);
+    return csound;
+}
+
+static CSOUND *start_orc(const char *orc)
+{
+    CSOUND *csound = create();
+    if (csoundCompileOrc(csound, orc) != 0 || csoundStart(csound) != 0) {
+      fprintf(stderr, "could not start orchestra:\n%s\n", orc);
+      exit(2);
+    }
+    return csound;
+}
+
+/* runs body until secs have passed, setting per_call to the seconds
+   per call divided by reps_per_call */
+#define TIMED(reps_per_call, body)                                      \
+  {                                                                     \
+    double  t0_, t_;                                                    \
+    long    i_, reps_ = 1, done_ = 0;                                   \
+    for (i_ = 0; i_ < 4; i_++) { body; }             /* warm up */      \
+    t0_ = now();                                                        \
+    do {                                                                \
+      for (i_ = 0; i_ < reps_; i_++) { body; }                          \
+      done_ += reps_;                                                   \
+      reps_ *= 2;                                                       \
+      t_ = now() - t0_;                                                 \
+    } while (t_ < secs);                                                \
+    per_call = t_ / ((double) done_ * (reps_per_call));                 \
+  }
+
+static void bench_fft(void)
+{
+    static const int sizes[] = { 256, 1024, 4096 };
+    CSOUND  *csound;
+    MYFLT   *buf;
+    int     i, j;
+
+    if (!wanted("fft/")) return;
+    csound = create();
+    buf = (MYFLT *) malloc(4096 * sizeof(MYFLT));
+    for (i = 0; i < 3; i++) {
+      char    name[64];
+      double  per_call;
+      int     n = sizes[i];
+      void    *setup, *isetup;
+      snprintf(name, sizeof(name), "fft/%d", n);
+      if (!wanted(name)) continue;
+      setup = csound->RealFFT2Setup(csound, n, FFT_FWD);
+      isetup = csound->RealFFT2Setup(csound, n, FFT_INV);
+      for (j = 0; j < n; j++)
+        buf[j] = (MYFLT) sin(j * 0.1);
+      /* a forward and an inverse transform, so the data stays bounded */
+      TIMED(2, csound->RealFFT2(csound, setup, buf);
+               csound->RealFFT2(csound, isetup, buf);
+               buf[0] *= FL(1.0) / n);
+      result(name, "ns/transform", 0, per_call * 1.0e9);
+    }
+    free(buf);
+    csoundDestroy(csound);
+}
+
+/* ns per sample and per unit (operator, oscillator) of the k-cycles
+   of an orchestra */
+static void bench_orc(const char *name, const char *orc, double units)
+{
+    CSOUND  *csound;
+    double  per_call;
+    int     ksmps;
+
+    if (!wanted(name)) return;
+    csound = start_orc(orc);
+    ksmps = (int) csoundGetKsmps(csound);
+    TIMED(ksmps * units, csoundPerformKsmps(csound));
+    result(name, "ns/sample", 0, per_call * 1.0e9);
+    csoundDestroy(csound);
+}
+
+static void bench_arith(void)
+{
+    bench_orc("arith/a-rate", "sr=48000\nksmps=256\n0dbfs=1\n"
+              "instr 1\n"
+              "a1 = p4\n"
+              "a2 = p5\n"
+              "a3 = (a1 + a2) * a1 - a2 / (a1 + 2)\n"
+              "a4 = a3 * 0.5 + a1 * a2 - 0.25\n"
+              "a5 = (a4 - a3) * (a4 + a3) / 3\n"
+              "a6 = a5 + a4 * k(p4) - a3 * k(p5)\n"
+              "vincr a1, a6\n"
+              "endin\n"
+              "schedule 1, 0, -1, 0.5, 0.25\n",
+              /* operations, with vincr */ 18);
+}
+
+static void bench_oscil(void)
+{
+    static const char *ops[] = { "oscili", "poscil", "oscil3" };
+    int     i;
+    for (i = 0; i < 3; i++) {
+      char    name[64], orc[512];
+      snprintf(name, sizeof(name), "oscil/%s", ops[i]);
+      snprintf(orc, sizeof(orc), "sr=48000\nksmps=64\n0dbfs=1\n"
+               "gisine ftgen 0, 0, 8192, 10, 1\n"
+               "instr 1\n"
+               "a1 %s 0.01, p4, gisine\n"
+               "endin\n"
+               "instr 2\n"
+               "i1 = 0\n"
+               "while i1 < 64 do\n"
+               "  schedule 1, 0, -1, 100 + i1 * 37\n"
+               "  i1 += 1\n"
+               "od\n"
+               "endin\n"
+               "schedule 2, 0, 0\n", ops[i]);
+      bench_orc(name, orc, 64);
+    }
+}
+
+static void bench_instances(void)
+{
+    CSOUND  *csound;
+    double  per_call;
+    MYFLT   pf[4] = { FL(1.0), FL(0.0), FL(0.0), FL(0.0) };
+    int     i;
+
+    if (!wanted("insert/note")) return;
+    csound = start_orc("sr=48000\nksmps=64\n0dbfs=1\n"
+                       "instr 1\n"
+                       "a1 oscili 0.1, p4\n"
+                       "endin\n");
+    /* notes last one k-cycle: each call starts 32 and ends 32 */
+    pf[2] = FL(64.0) / FL(48000.0);
+    pf[3] = FL(440.0);
+    TIMED(32, for (i = 0; i < 32; i++)
+                csoundScoreEvent(csound, 'i', pf, 4);
+              csoundPerformKsmps(csound));
+    result("insert/note", "ns/note", 0, per_call * 1.0e9);
+    csoundDestroy(csound);
+}
+
+static void bench_channels(void)
+{
+    CSOUND  *csound;
+    CHANNEL_HANDLE h;
+    double  per_call;
+    MYFLT   v = FL(0.0);
+    int     err;
+
+    if (!wanted("channel/")) return;
+    csound = start_orc("sr=48000\nksmps=64\n"
+                       "chn_k \"bench\", 3\n");
+    h = csoundGetChannelHandle(csound, "bench",
+                               CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL |
+                               CSOUND_OUTPUT_CHANNEL);
+    if (wanted("channel/name")) {
+      TIMED(2, csoundSetControlChannel(csound, "bench", v + FL(1.0));
+               v = csoundGetControlChannel(csound, "bench", &err));
+      result("channel/name", "ns/access", 0, per_call * 1.0e9);
+    }
+    if (h != NULL && wanted("channel/handle")) {
+      TIMED(2, csoundSetControlChannelH(csound, h, v + FL(1.0));
+               v = csoundGetControlChannelH(csound, h));
+      result("channel/handle", "ns/access", 0, per_call * 1.0e9);
+    }
+    csoundDestroy(csound);
+}
+
+/* renders a csd offline, how many times faster than real time */
+static void bench_render(const char *file)
+{
+    CSOUND  *csound;
+    char    name[64], path[1024];
+    double  t0, t;
+
+    snprintf(name, sizeof(name), "render/%.*s",
+             (int) (strlen(file) - 4), file);
+    if (!wanted(name)) return;
+    snprintf(path, sizeof(path), "%s/%s", BENCH_RENDER_DIR, file);
+    csound = create();
+    if (csoundCompileCsd(csound, path) != 0 || csoundStart(csound) != 0) {
+      fprintf(stderr, "could not start %s\n", path);
+      exit(2);
+    }
+    t0 = now();
+    while (csoundPerformKsmps(csound) == 0);
+    t = now() - t0;
+    result(name, "x realtime", 1, csoundGetScoreTime(csound) / t);
+    csoundDestroy(csound);
+}
+
+static void write_json(FILE *f)
+{
+    int i;
+    fprintf(f, "{\n  \"precision\": \"%s\",\n  \"results\": [\n",
+            sizeof(MYFLT) == sizeof(double) ? "double" : "float");
+    for (i = 0; i < nresults; i++)
+      fprintf(f, "    {\"name\": \"%s\", \"unit\": \"%s\", "
+              "\"better\": \"%s\", \"value\": %.6g}%s\n",
+              results[i].name, results[i].unit,
+              results[i].higher ? "higher" : "lower", results[i].value,
+              i < nresults - 1 ? "," : "");
+    fprintf(f, "  ]\n}\n");
+}
+
+/* reads the results of a file written by write_json(), one per line */
+static int compare(const char *file, double threshold)
+{
+    FILE    *f = fopen(file, "r");
+    char    line[512];
+    int     regressions = 0, i;
+
+    if (f == NULL) {
+      fprintf(stderr, "cannot open baseline %s\n", file);
+      return 2;
+    }
+    fprintf(stderr, "\n%-28s %14s %14s %9s\n", "compared to baseline",
+            "baseline", "now", "change");
+    while (fgets(line, sizeof(line), f) != NULL) {
+      char    name[64];
+      double  base;
+      const char *s = strstr(line, "\"name\": \"");
+      const char *v = strstr(line, "\"value\": ");
+      if (s == NULL || v == NULL ||
+          sscanf(s + 9, "%63[^\"]", name) != 1 ||
+          sscanf(v + 9, "%lf", &base) != 1 || base <= 0.0)
+        continue;
+      for (i = 0; i < nresults; i++) {
+        double change;
+        if (strcmp(results[i].name, name) != 0) continue;
+        /* positive is an improvement */
+        change = 100.0 * (results[i].value - base) / base;
+        if (!results[i].higher) change = -change;
+        fprintf(stderr, "%-28s %14.3f %14.3f %+8.1f%%%s\n", name, base,
+                results[i].value, change,
+                change < -threshold ? "  REGRESSION" : "");
+        if (change < -threshold) regressions++;
+      }
+    }
+    fclose(f);
+    if (regressions)
+      fprintf(stderr, "%d benchmark(s) slower than the baseline by more "
+              "than %g%%\n", regressions, threshold);
+    return regressions ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *out = NULL, *baseline = NULL;
+    double  threshold = 10.0;
+    int     i, ret = 0;
+
+    for (i = 1; i < argc; i++) {
+      if (!strcmp(argv[i], "-t") && i + 1 < argc)
+        secs = atof(argv[++i]) * 1.0e-3;
+      else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+        out = argv[++i];
+      else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+        baseline = argv[++i];
+      else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+        threshold = atof(argv[++i]);
+      else if (!strcmp(argv[i], "-f") && i + 1 < argc)
+        filter = argv[++i];
+      else if (argv[i][0] == '-' && nopts < MAXOPTS)
+        opts[nopts++] = argv[i];
+      else {
+        fprintf(stderr, "usage: %s [-t ms] [-o results.json] "
+                "[-b baseline.json] [-r percent] [-f filter] "
+                "[csound options]\n", argv[0]);
+        return 2;
+      }
+    }
+
+    csoundInitialize(CSOUNDINIT_NO_SIGNAL_HANDLER | CSOUNDINIT_NO_ATEXIT);
+    fprintf(stderr, "%s precision, %.0f ms per benchmark\n\n",
+            sizeof(MYFLT) == sizeof(double) ? "double" : "single",
+            secs * 1.0e3);
+    bench_fft();
+    bench_arith();
+    bench_oscil();
+    bench_instances();
+    bench_channels();
+    for (i = 0; i < (int) (sizeof(renders) / sizeof(renders[0])); i++)
+      bench_render(renders[i]);
+
+    if (out != NULL) {
+      FILE *f = fopen(out, "w");
+      if (f == NULL) {
+        fprintf(stderr, "cannot write %s\n", out);
+        return 2;
+      }
+      write_json(f);
+      fclose(f);
+    }
+    else write_json(stdout);
+    if (baseline != NULL)
+      ret = compare(baseline, threshold);
+    return ret;
+}
@@ -358,6 +358,62 @@ void test_string_channel(void)
     csoundDestroy(csound);
 }
 
+const char orc_h[] = "ksmps = 16\n"
+        "instr 1\n"
+        "kv chnget \"kin\"\n"
+        "chnset kv*2, \"kout\"\n"
+        "a1 chnget \"ain\"\n"
+        "chnset a1*2, \"aout\"\n"
+        "endin\n";
+
+void test_channel_handles(void)
+{
+    csoundSetGlobalEnv("OPCODE6DIR64", "../../");
+    CSOUND *csound = csoundCreate(0);
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "--logfile=null");
+    csoundCompileOrc(csound, orc_h);
+    int err = csoundStart(csound);
+    CU_ASSERT(err == CSOUND_SUCCESS);
+    CHANNEL_HANDLE h[2];
+    h[0] = csoundGetChannelHandle(csound, "kin",
+                                  CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
+    h[1] = csoundGetChannelHandle(csound, "kout",
+                                  CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL);
+    CU_ASSERT_PTR_NOT_NULL(h[0]);
+    CU_ASSERT_PTR_NOT_NULL(h[1]);
+    CU_ASSERT_PTR_NULL(csoundGetChannelHandle(csound, "kin",
+                                              CSOUND_AUDIO_CHANNEL));
+    CHANNEL_HANDLE ain = csoundGetChannelHandle(csound, "ain",
+                               CSOUND_AUDIO_CHANNEL | CSOUND_INPUT_CHANNEL);
+    CHANNEL_HANDLE aout = csoundGetChannelHandle(csound, "aout",
+                               CSOUND_AUDIO_CHANNEL | CSOUND_OUTPUT_CHANNEL);
+    CU_ASSERT_PTR_NOT_NULL(ain);
+    CU_ASSERT_PTR_NOT_NULL(aout);
+
+    csoundSetControlChannelH(csound, h[0], 3.0);
+    CU_ASSERT_EQUAL(3.0, csoundGetControlChannel(csound, "kin", NULL));
+    MYFLT in[16], out[16], vals[2] = {4.0, 0.0};
+    int i;
+    for (i = 0; i < 16; i++) in[i] = i;
+    csoundSetControlChannels(csound, h, vals, 1);
+    csoundSetAudioChannelH(csound, ain, in);
+    MYFLT pFields[] = {1.0, 0.0, 1.0};
+    csoundScoreEvent(csound, 'i', pFields, 3);
+    err = csoundPerformKsmps(csound);
+    CU_ASSERT(err == CSOUND_SUCCESS);
+    csoundGetControlChannels(csound, h, vals, 2);
+    CU_ASSERT_EQUAL(4.0, vals[0]);
+    CU_ASSERT_EQUAL(8.0, vals[1]);
+    CU_ASSERT_EQUAL(8.0, csoundGetControlChannelH(csound, h[1]));
+    csoundGetAudioChannelH(csound, aout, out);
+    for (i = 0; i < 16; i++) CU_ASSERT_EQUAL(2.0*i, out[i]);
+
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+}
+
 int main(void)
 {
    CU_pSuite pSuite = NULL;
@@ -383,6 +439,7 @@ int main(void)
            || (NULL == CU_add_test(pSuite, "Invalid channels", test_invalid_channel))
            || (NULL == CU_add_test(pSuite, "Channel hints", test_chn_hints))
            || (NULL == CU_add_test(pSuite, "String channel", test_string_channel))
+           || (NULL == CU_add_test(pSuite, "Channel handles", test_channel_handles))
        )
    {
       CU_cleanup_registry();
@@ -147,6 +147,79 @@ void test_cs_hash_table_get_put_key(void) {
     csoundDestroy(csound);
 }
 
+void test_cs_hash_table_grow(void) {
+    CSOUND* csound = csoundCreate(NULL);
+    CS_HASH_TABLE* hashTable = cs_hash_table_create(csound);
+    char key[32];
+    long i;
+
+    /* many more entries than the initial size, then every other one
+       removed, so that removal has to move entries back */
+    for (i = 0; i < 10000; i++) {
+      snprintf(key, sizeof(key), "sym%ld", i);
+      cs_hash_table_put(csound, hashTable, key, (void*) (i + 1));
+    }
+    CU_ASSERT_EQUAL(cs_cons_length(cs_hash_table_keys(csound, hashTable)),
+                    10000);
+    for (i = 0; i < 10000; i += 2) {
+      snprintf(key, sizeof(key), "sym%ld", i);
+      cs_hash_table_remove(csound, hashTable, key);
+    }
+    for (i = 0; i < 10000; i++) {
+      snprintf(key, sizeof(key), "sym%ld", i);
+      if (i % 2) {
+        CU_ASSERT_PTR_EQUAL(cs_hash_table_get(csound, hashTable, key),
+                            (void*) (i + 1));
+      } else {
+        CU_ASSERT_PTR_NULL(cs_hash_table_get(csound, hashTable, key));
+      }
+    }
+    CU_ASSERT_EQUAL(cs_cons_length(cs_hash_table_values(csound, hashTable)),
+                    5000);
+
+    csoundDestroy(csound);
+}
+
+void test_cs_wheel(void) {
+    CSOUND* csound = csoundCreate(NULL);
+    CS_WHEEL* wheel = cs_wheel_create(csound);
+    CS_WHEEL_NODE nodes[6], *n;
+    /* ticks on every level, two pairs due together */
+    uint64_t ticks[6] = { 70000, 3, 3, 300, 5000000000ULL, 70000 };
+    double when[6] = { 0.5, 0.0, 0.0, 0.0, 0.0, 0.25 };
+    int order[6] = { 1, 2, 3, 5, 0, 4 };
+    int i;
+
+    for (i = 0; i < 6; i++) {
+      nodes[i].tick = ticks[i];
+      nodes[i].when = when[i];
+      nodes[i].value = &nodes[i];
+      cs_wheel_insert(wheel, &nodes[i]);
+    }
+    CU_ASSERT_PTR_EQUAL(cs_wheel_first(wheel), &nodes[1]);
+    CU_ASSERT_PTR_NULL(cs_wheel_due(wheel, 2));
+
+    for (i = 0; i < 6; i++) {
+      n = cs_wheel_due(wheel, ticks[order[i]]);
+      CU_ASSERT_PTR_EQUAL(n, &nodes[order[i]]);
+      if (n == NULL) break;
+      cs_wheel_remove(wheel, n);
+    }
+    CU_ASSERT_PTR_NULL(cs_wheel_first(wheel));
+
+    /* ticks already passed are due at once, in order */
+    cs_wheel_insert(wheel, &nodes[3]);
+    cs_wheel_insert(wheel, &nodes[1]);
+    CU_ASSERT_PTR_EQUAL(cs_wheel_due(wheel, ticks[4]), &nodes[1]);
+    cs_wheel_remove(wheel, &nodes[1]);
+    cs_wheel_remove(wheel, &nodes[1]);
+    CU_ASSERT_PTR_EQUAL(cs_wheel_first(wheel), &nodes[3]);
+    cs_wheel_remove(wheel, &nodes[3]);
+    CU_ASSERT_PTR_NULL(cs_wheel_due(wheel, ticks[4] + 1));
+
+    cs_wheel_free(csound, wheel);
+    csoundDestroy(csound);
+}
 
 int main() {
     CU_pSuite pSuite = NULL;
@@ -167,7 +240,9 @@ int main() {
         (NULL == CU_add_test(pSuite, "Test cs_cons_append()", test_cs_cons_append)) ||
         (NULL == CU_add_test(pSuite, "Test cs_hash_table()", test_cs_hash_table)) ||
         (NULL == CU_add_test(pSuite, "Test cs_hash_table_merge()", test_cs_hash_table_merge)) ||
-        (NULL == CU_add_test(pSuite, "Test cs_hash_table_get_put_key()", test_cs_hash_table_get_put_key))) {
+        (NULL == CU_add_test(pSuite, "Test cs_hash_table_get_put_key()", test_cs_hash_table_get_put_key)) ||
+        (NULL == CU_add_test(pSuite, "Test cs_hash_table_grow()", test_cs_hash_table_grow)) ||
+        (NULL == CU_add_test(pSuite, "Test cs_wheel()", test_cs_wheel))) {
         
         CU_cleanup_registry();
         return CU_get_error();
@@ -0,0 +1,239 @@
+/*
+ * File:   csound_plugin_manifest_test.c
+ *
+ * Tests of the plugin manifest and deferred loading of opcode libraries
+ * in Top/csmodule.c: a first instance builds the manifest, a second one
+ * defers the libraries it lists and must end up with the same opcode
+ * lists, in the same order, once csoundLoadDeferredOpcode() has opened
+ * them; a manifest that does not match the libraries is rebuilt.
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include "csoundCore.h"
+#include "csmodule.h"
+#include "CUnit/Basic.h"
+
+#define CACHE_DIR "plugin_manifest_cache"
+
+static char manifest[1024];
+
+int init_suite1(void) {
+    DIR *dir;
+    struct dirent *f;
+    char path[1024];
+
+    /* start without a manifest */
+    if ((dir = opendir(CACHE_DIR)) != NULL) {
+      while ((f = readdir(dir)) != NULL) {
+        if (f->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", CACHE_DIR, f->d_name);
+        remove(path);
+      }
+      closedir(dir);
+    }
+#ifdef WIN32
+    _putenv_s("CS_PLUGIN_CACHE", CACHE_DIR);
+#else
+    setenv("CS_PLUGIN_CACHE", CACHE_DIR, 1);
+#endif
+    csoundSetGlobalEnv("OPCODE6DIR64", "../../");
+    return 0;
+}
+
+int clean_suite1(void) {
+    return 0;
+}
+
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    long n;
+    char *s;
+
+    if (f == NULL) return NULL;
+    fseek(f, 0L, SEEK_END);
+    n = ftell(f);
+    fseek(f, 0L, SEEK_SET);
+    s = (char*) malloc(n + 1);
+    n = (long) fread(s, 1, n, f);
+    s[n] = '\0';
+    fclose(f);
+    return s;
+}
+
+static void write_file(const char *path, const char *s) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) return;
+    fputs(s, f);
+    fclose(f);
+}
+
+/* the manifest written for the plugin directory */
+static int find_manifest(void) {
+    DIR *dir;
+    struct dirent *f;
+    int found = 0;
+
+    if ((dir = opendir(CACHE_DIR)) == NULL) return 0;
+    while ((f = readdir(dir)) != NULL) {
+      size_t n = strlen(f->d_name);
+      if (n > 9 && strcmp(f->d_name + n - 9, ".manifest") == 0) {
+        snprintf(manifest, sizeof(manifest), "%s/%s", CACHE_DIR, f->d_name);
+        found++;
+      }
+    }
+    closedir(dir);
+    return found;
+}
+
+#define TYPES(s) ((s) != NULL ? (s) : "")
+
+/* the opcode list of 'name' in 'b' after loading what it defers is
+   the list of 'a', which opened every library at startup */
+static int same_list(CSOUND *a, CSOUND *b, char *name) {
+    CONS_CELL *ca, *cb;
+
+    csoundLoadDeferredOpcode(b, name);
+    ca = cs_hash_table_get(a, a->opcodes, name);
+    cb = cs_hash_table_get(b, b->opcodes, name);
+    for ( ; ca != NULL && cb != NULL; ca = ca->next, cb = cb->next) {
+      OENTRY *ea = (OENTRY*) ca->value, *eb = (OENTRY*) cb->value;
+      if (strcmp(ea->opname, eb->opname) != 0 ||
+          strcmp(TYPES(ea->outypes), TYPES(eb->outypes)) != 0 ||
+          strcmp(TYPES(ea->intypes), TYPES(eb->intypes)) != 0 ||
+          ea->iopadr != eb->iopadr || ea->kopadr != eb->kopadr ||
+          ea->aopadr != eb->aopadr || ea->dsblksiz != eb->dsblksiz) {
+        printf("%s: %s differs\n", name, ea->opname);
+        return 0;
+      }
+    }
+    if (ca != NULL || cb != NULL) {
+      printf("%s: lists differ in length\n", name);
+      return 0;
+    }
+    return 1;
+}
+
+void test_manifest_deferred(void) {
+    CSOUND *a, *b;
+    CONS_CELL *keys, *c;
+    char *text;
+    int lazy, same = 1;
+
+    a = csoundCreate(NULL);
+    CU_ASSERT_EQUAL(a->startup.ndefer, 0);
+    CU_ASSERT_EQUAL_FATAL(find_manifest(), 1);
+    text = read_file(manifest);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(text);
+    CU_ASSERT_NSTRING_EQUAL(text, "csound plugin manifest ", 23);
+    lazy = (strstr(text, "\nL ") != NULL);
+
+    b = csoundCreate(NULL);
+    /* every library listed with its opcodes is deferred */
+    if (lazy) {
+      CU_ASSERT(b->startup.ndefer > 0);
+      CU_ASSERT(b->startup.nstub > 0);
+    }
+    CU_ASSERT_EQUAL(b->startup.nlate, 0);
+
+    keys = cs_hash_table_keys(a, a->opcodes);
+    for (c = keys; c != NULL; c = c->next)
+      same &= same_list(a, b, (char*) c->value);
+    CU_ASSERT(same);
+    CU_ASSERT_EQUAL(b->startup.nlate, b->startup.ndefer);
+    /* nothing changed, so the manifest was not rewritten */
+    {
+      char *again = read_file(manifest);
+      CU_ASSERT_STRING_EQUAL(again, text);
+      free(again);
+    }
+    cs_cons_free(a, keys);
+    free(text);
+    csoundDestroy(b);
+    csoundDestroy(a);
+}
+
+void test_manifest_stale(void) {
+    CSOUND *csound;
+    char *text, *stale, *s, *again;
+
+    csound = csoundCreate(NULL);
+    csoundDestroy(csound);
+    CU_ASSERT_EQUAL_FATAL(find_manifest(), 1);
+    text = read_file(manifest);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(text);
+
+    /* no library has the recorded modification time */
+    stale = (char*) malloc(strlen(text) * 2 + 1);
+    stale[0] = '\0';
+    for (s = text; *s != '\0'; ) {
+      char *eol = strchr(s, '\n');
+      size_t n = eol != NULL ? (size_t) (eol + 1 - s) : strlen(s);
+      if ((s[0] == 'L' || s[0] == 'E') && s[1] == ' ') {
+        char *sp = strchr(s + 2, ' ');
+        strcat(stale, s[0] == 'L' ? "L 1" : "E 1");
+        strncat(stale, sp, n - (size_t) (sp - s));
+      }
+      else
+        strncat(stale, s, n);
+      s += n;
+    }
+    write_file(manifest, stale);
+    csound = csoundCreate(NULL);
+    CU_ASSERT_EQUAL(csound->startup.ndefer, 0);
+    csoundDestroy(csound);
+    again = read_file(manifest);
+    CU_ASSERT_STRING_EQUAL(again, text);
+    free(again);
+
+    /* a manifest of another version is ignored and rebuilt */
+    s = strchr(stale, '\n');
+    write_file(manifest, "csound plugin manifest 0");
+    {
+      FILE *f = fopen(manifest, "ab");
+      if (f != NULL) { fputs(s, f); fclose(f); }
+    }
+    csound = csoundCreate(NULL);
+    CU_ASSERT_EQUAL(csound->startup.ndefer, 0);
+    csoundDestroy(csound);
+    again = read_file(manifest);
+    CU_ASSERT_STRING_EQUAL(again, text);
+    free(again);
+
+    free(stale);
+    free(text);
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("plugin manifest tests", init_suite1, clean_suite1);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Test deferred loading from manifest",
+                             test_manifest_deferred)) ||
+        (NULL == CU_add_test(pSuite, "Test stale manifest is rebuilt",
+                             test_manifest_stale))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -1,5 +1,6 @@
 #include "csound.h"
 #include <stdio.h>
+#include <string.h>
 #include <CUnit/Basic.h>
 
 #include "time.h"
@@ -54,6 +55,95 @@ void test_compile_async(void)
     csoundDestroy(csound);
 }
 
+void test_memory_stats(void)
+{
+    static const char *names[] = {
+      "other", "compiler", "init", "perf", "aux", "strings", "regions"
+    };
+    CSOUND  *csound;
+    CSOUND_MEMSTAT st[16], st2[16];
+    int     i, n;
+    uint64_t total = 0;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundCompileOrc(csound, "instr 1\n"
+                             "a1 oscili 0.5, 440\n"
+                             "endin\n"
+                             "schedule 1,0,0.1");
+    csoundStart(csound);
+    for (i = 0; i < 100 && csoundPerformKsmps(csound) == 0; i++);
+    n = csoundGetMemoryStats(csound, st, 16);
+    CU_ASSERT_EQUAL(n, 7);
+    for (i = 0; i < n && i < 7; i++) {
+      CU_ASSERT_STRING_EQUAL(st[i].name, names[i]);
+      CU_ASSERT(st[i].allocs >= st[i].frees);
+      CU_ASSERT(st[i].bytes >= 0);
+      total += st[i].allocs;
+    }
+    CU_ASSERT(st[1].allocs > 0);
+    CU_ASSERT(st[1].bytes > 0);
+    /* the engine's own memory is counted under the other names */
+    CU_ASSERT(total > st[1].allocs);
+    /* another note does not compile anything */
+    csoundInputMessage(csound, "i 1 0 0.1");
+    for (i = 0; i < 100 && csoundPerformKsmps(csound) == 0; i++);
+    CU_ASSERT_EQUAL(csoundGetMemoryStats(csound, st2, 16), n);
+    CU_ASSERT_EQUAL(st2[1].allocs, st[1].allocs);
+    CU_ASSERT_EQUAL(csoundGetMemoryStats(csound, st, 1), 1);
+    CU_ASSERT_STRING_EQUAL(st[0].name, "other");
+    csoundDestroy(csound);
+}
+
+void test_profile(void)
+{
+    CSOUND  *csound;
+    CSOUND_PROFILE pr[16];
+    int     i, n, instr = 0, udo = 0;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "--profile");
+    csoundCompileOrc(csound, "opcode Osc, a, k\n"
+                             "kf xin\n"
+                             "a1 oscili 0.5, kf\n"
+                             "xout a1\n"
+                             "endop\n"
+                             "instr 1\n"
+                             "a1 Osc 440\n"
+                             "endin\n"
+                             "schedule 1,0,0.1");
+    csoundStart(csound);
+    for (i = 0; i < 100 && csoundPerformKsmps(csound) == 0; i++);
+    n = csoundGetProfile(csound, pr, 16);
+    CU_ASSERT(n > 0);
+    for (i = 0; i < n; i++) {
+      CU_ASSERT(pr[i].perf_time >= 0.0 && pr[i].init_time >= 0.0);
+      if (i > 0)
+        CU_ASSERT(pr[i].perf_time + pr[i].init_time <=
+                  pr[i-1].perf_time + pr[i-1].init_time);
+      if (pr[i].instr == 1 && pr[i].perfs > 0)
+        instr = 1;
+      if (pr[i].instr == 0 && strcmp(pr[i].name, "Osc") == 0 &&
+          pr[i].inits == 1 && pr[i].perfs > 0)
+        udo = 1;
+    }
+    CU_ASSERT(instr);
+    CU_ASSERT(udo);
+    CU_ASSERT_EQUAL(csoundGetProfile(csound, pr, 1), 1);
+    csoundDestroy(csound);
+
+    /* nothing is recorded without --profile */
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundCompileOrc(csound, "instr 1\n"
+                             "a1 oscili 0.5, 440\n"
+                             "endin\n"
+                             "schedule 1,0,0.1");
+    csoundStart(csound);
+    csoundPerformKsmps(csound);
+    CU_ASSERT_EQUAL(csoundGetProfile(csound, pr, 16), 0);
+    csoundDestroy(csound);
+}
+
 int main()
 {
     CU_pSuite pSuite = NULL;
@@ -73,6 +163,8 @@ int main()
     if ((NULL == CU_add_test(pSuite, "Test daemon mode", test_daemon))
         || (NULL == CU_add_test(pSuite, "Test evalcode", test_eval_code))
 	|| (NULL == CU_add_test(pSuite, "Test compileAsync", test_compile_async)) 
+	|| (NULL == CU_add_test(pSuite, "Test memory stats", test_memory_stats))
+	|| (NULL == CU_add_test(pSuite, "Test profile", test_profile))
 	)
     {
         CU_cleanup_registry();
@@ -0,0 +1,243 @@
+/*
+ * File:   memalloc_test.c
+ *
+ * Tests of Engine/memalloc.c: the counts kept per subsystem, regions
+ * and instance memory, and the blocks of threads that have ended.
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <string.h>
+#include "csoundCore.h"
+#include "CUnit/Basic.h"
+
+#define NBLK 4                          /* one batch of 1792 byte blocks */
+
+typedef struct {
+    CSOUND  *csound;
+    void    *p[NBLK];
+    int     inset;
+} THREAD_ARGS;
+
+int init_suite1(void) {
+    return 0;
+}
+
+int clean_suite1(void) {
+    return 0;
+}
+
+static CSOUND_MEMSTAT stat_of(CSOUND *csound, int tag) {
+    CSOUND_MEMSTAT st[CS_MEM_NTAGS];
+    CU_ASSERT_EQUAL(csoundGetMemoryStats(csound, st, CS_MEM_NTAGS),
+                    CS_MEM_NTAGS);
+    return st[tag];
+}
+
+void test_tag_counts(void) {
+    CSOUND          *csound = csoundCreate(NULL);
+    CSOUND_MEMSTAT  s0, s1;
+    unsigned char   *p[40];
+    size_t          size[40], total = 0;
+    int             i, j, bad = 0;
+
+    s0 = stat_of(csound, CS_MEM_STRING);
+    CU_ASSERT_STRING_EQUAL(s0.name, "strings");
+    /* small blocks of every class, and some large ones */
+    for (i = 0; i < 40; i++) {
+      size[i] = (i < 32 ? (size_t) (i + 1) * 64 - 7 : (size_t) i * 1000);
+      p[i] = (unsigned char*) mmalloc_tag(csound, size[i], CS_MEM_STRING);
+      memset(p[i], i, size[i]);
+      total += size[i];
+    }
+    s1 = stat_of(csound, CS_MEM_STRING);
+    CU_ASSERT_EQUAL(s1.allocs - s0.allocs, 40);
+    CU_ASSERT_EQUAL(s1.frees, s0.frees);
+    CU_ASSERT(s1.bytes - s0.bytes >= (int64_t) total);
+    for (i = 0; i < 40; i++)
+      for (j = 0; j < (int) size[i]; j++)
+        bad += (p[i][j] != (unsigned char) i);
+    CU_ASSERT_EQUAL(bad, 0);
+    /* a small block that grows past the largest class keeps its data */
+    p[0] = (unsigned char*) mrealloc(csound, p[0], 5000);
+    for (j = 0; j < (int) size[0]; j++)
+      bad += (p[0][j] != 0);
+    CU_ASSERT_EQUAL(bad, 0);
+    for (i = 0; i < 40; i++)
+      mfree(csound, p[i]);
+    s1 = stat_of(csound, CS_MEM_STRING);
+    CU_ASSERT_EQUAL(s1.allocs - s0.allocs, 41);
+    CU_ASSERT_EQUAL(s1.frees - s0.frees, 41);
+    CU_ASSERT_EQUAL(s1.bytes, s0.bytes);
+    csoundDestroy(csound);
+}
+
+static int fill_region(CSOUND *csound, void **region) {
+    int   *p[1000];
+    int   i, bad = 0;
+
+    for (i = 0; i < 1000; i++) {
+      p[i] = (int*) csoundRegionAlloc(csound, region, 40);
+      bad += (((uintptr_t) p[i] & 15) != 0);
+      bad += (p[i][0] != 0 || p[i][9] != 0);
+      p[i][0] = p[i][9] = i;
+    }
+    for (i = 0; i < 1000; i++)
+      bad += (p[i][0] != i || p[i][9] != i);
+    return bad;
+}
+
+void test_regions(void) {
+    CSOUND          *csound = csoundCreate(NULL);
+    CSOUND_MEMSTAT  s0, s1, s2;
+    void            *region = NULL;
+
+    s0 = stat_of(csound, CS_MEM_REGION);
+    CU_ASSERT_EQUAL(fill_region(csound, &region), 0);
+    s1 = stat_of(csound, CS_MEM_REGION);
+    CU_ASSERT(s1.allocs - s0.allocs > 1);
+    CU_ASSERT(s1.bytes - s0.bytes >= 40000);
+    /* a reset keeps only the newest chunk */
+    csoundRegionReset(csound, &region);
+    s2 = stat_of(csound, CS_MEM_REGION);
+    CU_ASSERT_EQUAL(s2.frees - s0.frees, s1.allocs - s0.allocs - 1);
+    CU_ASSERT_PTR_NOT_NULL(region);
+    /* and once that chunk holds everything, refilling allocates nothing */
+    CU_ASSERT_EQUAL(fill_region(csound, &region), 0);
+    csoundRegionReset(csound, &region);
+    s1 = stat_of(csound, CS_MEM_REGION);
+    CU_ASSERT_EQUAL(fill_region(csound, &region), 0);
+    csoundRegionReset(csound, &region);
+    CU_ASSERT_EQUAL(fill_region(csound, &region), 0);
+    s2 = stat_of(csound, CS_MEM_REGION);
+    CU_ASSERT_EQUAL(s2.allocs, s1.allocs);
+    CU_ASSERT_EQUAL(s2.frees, s1.frees);
+    csoundRegionFree(csound, &region);
+    CU_ASSERT_PTR_NULL(region);
+    s2 = stat_of(csound, CS_MEM_REGION);
+    CU_ASSERT_EQUAL(s2.allocs - s0.allocs, s2.frees - s0.frees);
+    CU_ASSERT_EQUAL(s2.bytes, s0.bytes);
+    csoundDestroy(csound);
+}
+
+void test_instance_alloc(void) {
+    CSOUND          *csound = csoundCreate(NULL);
+    CSOUND_MEMSTAT  s0, s1;
+    INSDS           ip;
+    MYFLT           *a, *b;
+
+    memset(&ip, 0, sizeof(INSDS));
+    s0 = stat_of(csound, CS_MEM_REGION);
+    a = (MYFLT*) csoundInstanceAlloc(csound, &ip, 100 * sizeof(MYFLT));
+    b = (MYFLT*) csoundInstanceAlloc(csound, &ip, 100 * sizeof(MYFLT));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ip.region);
+    CU_ASSERT(b >= a + 100);
+    CU_ASSERT_EQUAL(a[0] + a[99] + b[0] + b[99], FL(0.0));
+    s1 = stat_of(csound, CS_MEM_REGION);
+    CU_ASSERT_EQUAL(s1.allocs - s0.allocs, 1);
+    csoundRegionFree(csound, &ip.region);
+    CU_ASSERT_PTR_NULL(ip.region);
+    s1 = stat_of(csound, CS_MEM_REGION);
+    CU_ASSERT_EQUAL(s1.frees - s0.frees, 1);
+    CU_ASSERT_EQUAL(s1.bytes, s0.bytes);
+    csoundDestroy(csound);
+}
+
+static uintptr_t alloc_and_free(void *data) {
+    THREAD_ARGS *args = (THREAD_ARGS*) data;
+    int         i;
+
+    for (i = 0; i < NBLK; i++)
+      args->p[i] = mmalloc_tag(args->csound, 1700, CS_MEM_STRING);
+    for (i = 0; i < NBLK; i++)
+      mfree(args->csound, args->p[i]);
+    return 0;
+}
+
+static uintptr_t alloc_again(void *data) {
+    THREAD_ARGS *args = (THREAD_ARGS*) data;
+    THREAD_ARGS *first = (THREAD_ARGS*) args->p[0];
+    void        *p[NBLK];
+    int         i, j;
+
+    for (i = 0; i < NBLK; i++) {
+      p[i] = mmalloc_tag(args->csound, 1700, CS_MEM_STRING);
+      for (j = 0; j < NBLK; j++)
+        args->inset += (p[i] == first->p[j]);
+    }
+    for (i = 0; i < NBLK; i++)
+      mfree(args->csound, p[i]);
+    return 0;
+}
+
+static uintptr_t hold(void *mutex) {
+    csoundLockMutex(mutex);
+    csoundUnlockMutex(mutex);
+    return 0;
+}
+
+/* the blocks a thread freed are used again once it has ended, by a
+   thread that is not running where it did */
+void test_thread_exit(void) {
+    CSOUND          *csound = csoundCreate(NULL);
+    CSOUND_MEMSTAT  s0, s1;
+    THREAD_ARGS     a, b;
+    void            *t, *h, *mutex = csoundCreateMutex(0);
+
+    memset(&a, 0, sizeof(THREAD_ARGS));
+    memset(&b, 0, sizeof(THREAD_ARGS));
+    a.csound = b.csound = csound;
+    b.p[0] = &a;
+    s0 = stat_of(csound, CS_MEM_STRING);
+    t = csoundCreateThread(alloc_and_free, &a);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(t);
+    csoundJoinThread(t);
+    csoundLockMutex(mutex);
+    h = csoundCreateThread(hold, mutex);
+    t = csoundCreateThread(alloc_again, &b);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(t);
+    csoundJoinThread(t);
+    csoundUnlockMutex(mutex);
+    csoundJoinThread(h);
+    csoundDestroyMutex(mutex);
+    CU_ASSERT_EQUAL(b.inset, NBLK);
+    s1 = stat_of(csound, CS_MEM_STRING);
+    CU_ASSERT_EQUAL(s1.allocs - s0.allocs, 2 * NBLK);
+    CU_ASSERT_EQUAL(s1.frees - s0.frees, 2 * NBLK);
+    CU_ASSERT_EQUAL(s1.bytes, s0.bytes);
+    csoundDestroy(csound);
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("memalloc tests", init_suite1, clean_suite1);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Test counts per subsystem",
+                             test_tag_counts)) ||
+        (NULL == CU_add_test(pSuite, "Test regions", test_regions)) ||
+        (NULL == CU_add_test(pSuite, "Test instance memory",
+                             test_instance_alloc)) ||
+        (NULL == CU_add_test(pSuite, "Test blocks of ended threads",
+                             test_thread_exit))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
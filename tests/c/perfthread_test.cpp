@@ -79,6 +79,41 @@ void test_record(void)
     csound.Reset();
 }
 
+void test_message_queue(void)
+{
+    const char  *instrument =
+            "ksmps = 64\n"
+            "gicount init 0\n"
+            "instr 1 \n"
+            "gicount += 1\n"
+            "chnset gicount, \"count\"\n"
+            "endin \n";
+
+    Csound csound;
+    csound.SetOption((char*)"-n");
+    csound.CompileOrc(instrument);
+    csound.ReadScore((char*)"f0 60\n");
+    csound.Start();
+    CsoundPerformanceThread performanceThread1(csound.GetCsound());
+    MYFLT p[3] = { 1, 0, 0.01 };
+    // more events than the queue holds, sent while paused: they wait
+    for (int i = 0; i < 3000; i++)
+        performanceThread1.ScoreEvent(0, 'i', 3, p);
+    performanceThread1.Play();
+    performanceThread1.FlushMessageQueue();
+    CU_ASSERT_EQUAL(performanceThread1.GetDroppedMessages(), 0);
+#if !defined(__WINNT__)
+    sleep(1);
+#else
+    Sleep(1000);
+#endif
+    performanceThread1.Stop();
+    performanceThread1.Join();
+    CU_ASSERT_EQUAL(csound.GetChannel("count"), 3000);
+    csound.Cleanup();
+    csound.Reset();
+}
+
 int main()
 {
     CU_pSuite pSuite = NULL;
@@ -105,6 +140,7 @@ int main()
 
     /* add the tests to the suite */
     if ((NULL == CU_add_test(pSuite, "Test Performance Thread second run", test_perfthread))
+            || (NULL == CU_add_test(pSuite, "Test message queue", test_message_queue))
 //            || (NULL == CU_add_test(pSuite, "Test reuse", test_reuse))
         )
     {
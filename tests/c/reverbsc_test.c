@@ -0,0 +1,153 @@
+/*
+ * File:   reverbsc_test.c
+ *
+ * reverbsc has a per-line scalar loop and an AVX2 loop over all eight
+ * delay lines, picked at init time.  The AVX2 loop must give the scalar
+ * output to the bit, and fast mode must stay within rounding of it.
+ * The opcode source is included so that the scalar loop can be forced.
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "CUnit/Basic.h"
+
+#define reverbsc_init_ reverbsc_init_under_test
+#include "Opcodes/reverbsc.c"
+
+#define KSMPS   32
+#define NKCYCLE (44100 * 20 / KSMPS)
+
+typedef struct {
+    SC_REVERB   p;
+    MYFLT       outL[KSMPS], outR[KSMPS];
+    MYFLT       fb, lp, sr, pm, skip, fast;
+} RUN;
+
+static MYFLT inL[KSMPS], inR[KSMPS];
+static INSDS ins;
+
+int init_suite1(void) {
+    return 0;
+}
+
+int clean_suite1(void) {
+    return 0;
+}
+
+static int run_init(CSOUND *csound, RUN *r, int fast, int scalar,
+                    MYFLT fb, MYFLT pm) {
+    memset(r, 0, sizeof(RUN));
+    r->p.h.insdshead = &ins;
+    r->p.aoutL = r->outL;
+    r->p.aoutR = r->outR;
+    r->p.ainL = inL;
+    r->p.ainR = inR;
+    r->p.kFeedBack = &r->fb;
+    r->p.kLPFreq = &r->lp;
+    r->p.iSampleRate = &r->sr;
+    r->p.iPitchMod = &r->pm;
+    r->p.iSkipInit = &r->skip;
+    r->p.iFast = &r->fast;
+    r->fb = fb;
+    r->lp = FL(8000.0);
+    r->sr = FL(44100.0);
+    r->pm = pm;
+    r->fast = (MYFLT) fast;
+    if (sc_reverb_init(csound, &r->p) != OK)
+      return NOTOK;
+    if (scalar)
+      r->p.lines = sc_reverb_lines;
+    return OK;
+}
+
+/* noise bursts and impulses, with a note starting inside a k-cycle */
+static void compare(MYFLT fb, MYFLT pm) {
+    CSOUND  *csound = csoundCreate(NULL);
+    RUN     *ref = calloc(1, sizeof(RUN));
+    RUN     *vec = calloc(1, sizeof(RUN));
+    RUN     *fst = calloc(1, sizeof(RUN));
+    unsigned seed = 1;
+    long    ndiff = 0;
+    double  maxin = 0.0, maxfast = 0.0, tol;
+    int     k, i;
+
+    memset(&ins, 0, sizeof(INSDS));
+    ins.ksmps = KSMPS;
+    CU_ASSERT_EQUAL_FATAL(run_init(csound, ref, 0, 1, fb, pm), OK);
+    CU_ASSERT_EQUAL_FATAL(run_init(csound, vec, 0, 0, fb, pm), OK);
+    CU_ASSERT_EQUAL_FATAL(run_init(csound, fst, 1, 0, fb, pm), OK);
+    for (k = 0; k < NKCYCLE; k++) {
+      for (i = 0; i < KSMPS; i++) {
+        double x = 0.0;
+        seed = seed * 1103515245U + 12345U;
+        if (k < 44100 * 2 / KSMPS || (k / 1000) % 3 == 0)
+          x = (double) ((seed >> 8) & 0xFFFF) / 65536.0 - 0.5;
+        if (k % 5000 == 7 && i == 0)
+          x = 1.0;
+        inL[i] = (MYFLT) x;
+        inR[i] = (MYFLT) ((k % 7) == 0 ? -x : x * 0.5);
+        if (fabs(x) > maxin) maxin = fabs(x);
+      }
+      if (k == 3000)
+        ref->lp = vec->lp = fst->lp = FL(3000.0);
+      ins.ksmps_offset = (k == 3000 ? 5 : 0);
+      ins.ksmps_no_end = (k == 3001 ? 3 : 0);
+      sc_reverb_perf(csound, &ref->p);
+      sc_reverb_perf(csound, &vec->p);
+      sc_reverb_perf(csound, &fst->p);
+      for (i = 0; i < KSMPS; i++) {
+        ndiff += (memcmp(&ref->outL[i], &vec->outL[i], sizeof(MYFLT)) != 0 ||
+                  memcmp(&ref->outR[i], &vec->outR[i], sizeof(MYFLT)) != 0);
+        maxfast = fmax(maxfast, fabs(ref->outL[i] - fst->outL[i]));
+        maxfast = fmax(maxfast, fabs(ref->outR[i] - fst->outR[i]));
+      }
+    }
+    CU_ASSERT_EQUAL(ndiff, 0);
+    /* see the comment above sc_reverb_perf() */
+    tol = (sizeof(MYFLT) == sizeof(double) ? 1.0e-12 : 1.0e-5 / (1.0 - fb));
+    if (maxfast > tol * maxin)
+      printf("feedback %g: fast mode differs by %g\n", (double) fb, maxfast);
+    CU_ASSERT(maxfast <= tol * maxin);
+    free(fst);
+    free(vec);
+    free(ref);
+    csoundDestroy(csound);
+}
+
+void test_reverbsc_vector(void) {
+    compare(FL(0.6), FL(0.0));
+    compare(FL(0.85), FL(1.0));
+    compare(FL(0.97), FL(2.0));
+    compare(FL(0.999), FL(3.0));
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("reverbsc tests", init_suite1, clean_suite1);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if (NULL == CU_add_test(pSuite, "Test reverbsc vector and scalar loops",
+                            test_reverbsc_vector)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
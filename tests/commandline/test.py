@@ -138,6 +138,20 @@ def runTest():
         ["test_udo_string_array_join.csd", "test udo with S[] arg returning S"],
         ["test_array_function_call.csd", "test synthesizing an array arg from a function-call"],
         ["prints_number_no_crash.csd", "test prints does not crash when given a number arguments"],
+        ["test_fused_arith.csd", "test fused a-rate arithmetic matches unfused result"],
+        ["test_mixer_busses.csd", "test mixer busses sum sends from parallel instances"],
+        ["test_instance_pool.csd", "test instances copied from the template keep their own state"],
+        ["test_event_order.csd", "test queued events start in time order, ties in queue order"],
+        ["test_active_order.csd", "test active notes perform in instrument and p1 order, ties continue held notes"],
+        ["test_midi_held.csd", "test held MIDI notes can be tied to and turned off from the score"],
+        ["test_aux_reuse.csd", "test reused and pooled delay lines start silent"],
+        ["test_aux_reuse_sync.csd", "test delay lines cleared as far as written"],
+        ["test_udo_byref.csd", "test read-only UDO array and string inputs follow the caller"],
+        ["test_reverbsc_fast.csd", "test reverbsc fast mode stays within rounding of the reference"],
+        ["test_disk_buffers.csd", "render to a file through the disk writer thread", 0, "-d"],
+        ["test_disk_buffers_check.csd", "test the file written with --disk-buffers is complete and in order"],
+        ["test_hrtf_shared.csd", "test hrtf opcodes sharing HRTF data, in both phase modes"],
+        ["test_sfload_mmap.csd", "test mapped SoundFonts play as one read into memory"],
     ]
 
     arrayTests = [["arrays/arrays_i_local.csd", "local i[]"],
@@ -173,16 +187,17 @@ def runTest():
     for t in tests:
         filename = t[0]
         desc = t[1]
-        expectedResult = (len(t) == 3) and 1 or 0
+        expectedResult = (len(t) >= 3) and t[2] or 0
+        args = (len(t) == 4) and t[3] or runArgs
 
         if(os.sep == '\\' or os.name == 'nt'):
             executable = (csoundExecutable == "") and "..\csound.exe" or csoundExecutable
-            command = "%s %s %s %s 2> %s"%(executable, parserType, runArgs, filename, tempfile)
+            command = "%s %s %s %s 2> %s"%(executable, parserType, args, filename, tempfile)
             print command
             retVal = os.system(command)
         else:
             executable = (csoundExecutable == "") and "../../csound" or csoundExecutable
-            command = "%s %s %s %s 2> %s"%(executable, parserType, runArgs, filename, tempfile)
+            command = "%s %s %s %s 2> %s"%(executable, parserType, args, filename, tempfile)
             print command
             retVal = os.system(command)
   